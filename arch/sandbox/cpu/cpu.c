@@ -4,9 +4,11 @@
  */
 #define DEBUG
 #include <common.h>
+#include <cpu_work.h>
 #include <errno.h>
 #include <libfdt.h>
 #include <os.h>
+#include <task.h>
 #include <asm/io.h>
 #include <asm/state.h>
 #include <dm/root.h>
@@ -45,6 +47,60 @@ void __udelay(unsigned long usec)
 		os_usleep(usec);
 }
 
+#ifdef CONFIG_CPU_WORK
+/*
+ * Host threads stand in for secondary CPUs. There is always at least one,
+ * so that tests run the parallel code paths even on a single-CPU host.
+ */
+int arch_cpu_work_cpus(void)
+{
+	return max(os_get_cpus() - 1, 1);
+}
+
+/* Secondary CPU number of the host thread, 0 for the main thread */
+static __thread int sandbox_cpu_work_id;
+
+static void sandbox_cpu_work_main(void *arg)
+{
+	sandbox_cpu_work_id = (long)arg;
+	cpu_work_secondary((long)arg);
+}
+
+int arch_cpu_work_start(int cpu, void *stack, ulong size)
+{
+	return os_thread_create(sandbox_cpu_work_main, (void *)(long)cpu,
+				stack, size);
+}
+
+void arch_cpu_work_idle(void)
+{
+	os_usleep(100);
+}
+
+int arch_cpu_work_id(void)
+{
+	return sandbox_cpu_work_id;
+}
+#endif
+
+#ifdef CONFIG_TASK
+void *arch_task_create(void (*func)(void *arg), void *arg, void *stack,
+		       ulong size)
+{
+	return os_context_create(func, arg, stack, size);
+}
+
+void arch_task_switch(void *from, void *to)
+{
+	os_context_switch(from, to);
+}
+
+void arch_task_free(void *ctx)
+{
+	os_context_free(ctx);
+}
+#endif
+
 int cleanup_before_linux(void)
 {
 	return 0;
@@ -7,12 +7,14 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <termios.h>
 #include <time.h>
+#include <ucontext.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -608,3 +610,108 @@ void os_localtime(struct rtc_time *rt)
 	rt->tm_yday = tm->tm_yday;
 	rt->tm_isdst = tm->tm_isdst;
 }
+
+int os_get_cpus(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return cpus > 0 ? cpus : 1;
+}
+
+struct os_thread {
+	void (*func)(void *arg);
+	void *arg;
+};
+
+static void *os_thread_start(void *ptr)
+{
+	struct os_thread thread = *(struct os_thread *)ptr;
+
+	os_free(ptr);
+	thread.func(thread.arg);
+
+	return NULL;
+}
+
+int os_thread_create(void (*func)(void *arg), void *arg, void *stack,
+		     size_t size)
+{
+	struct os_thread *thread;
+	pthread_attr_t attr;
+	pthread_t id;
+	int ret;
+
+	thread = os_malloc(sizeof(*thread));
+	if (!thread)
+		return -ENOMEM;
+	thread->func = func;
+	thread->arg = arg;
+
+	pthread_attr_init(&attr);
+	ret = pthread_attr_setstack(&attr, stack, size);
+	if (!ret)
+		ret = pthread_attr_setdetachstate(&attr,
+						  PTHREAD_CREATE_DETACHED);
+	if (!ret)
+		ret = pthread_create(&id, &attr, os_thread_start, thread);
+	pthread_attr_destroy(&attr);
+	if (ret) {
+		os_free(thread);
+		return -ret;
+	}
+
+	return 0;
+}
+
+struct os_context {
+	ucontext_t uc;
+	void (*func)(void *arg);
+	void *arg;
+};
+
+/* Context being switched to, so that a new one can find its function */
+static struct os_context *os_context_next;
+
+static void os_context_start(void)
+{
+	struct os_context *ctx = os_context_next;
+
+	ctx->func(ctx->arg);
+}
+
+void *os_context_create(void (*func)(void *arg), void *arg, void *stack,
+			size_t size)
+{
+	struct os_context *ctx;
+
+	ctx = os_malloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+	ctx->func = func;
+	ctx->arg = arg;
+	if (func) {
+		if (getcontext(&ctx->uc)) {
+			os_free(ctx);
+			return NULL;
+		}
+		ctx->uc.uc_stack.ss_sp = stack;
+		ctx->uc.uc_stack.ss_size = size;
+		ctx->uc.uc_link = NULL;
+		makecontext(&ctx->uc, os_context_start, 0);
+	}
+
+	return ctx;
+}
+
+void os_context_switch(void *from, void *to)
+{
+	struct os_context *from_ctx = from;
+
+	os_context_next = to;
+	swapcontext(&from_ctx->uc, &os_context_next->uc);
+}
+
+void os_context_free(void *ctx)
+{
+	os_free(ctx);
+}
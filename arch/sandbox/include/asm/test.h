@@ -79,4 +79,13 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_mmc_get_cmd_count() - Get the number of times a command was sent
+ *
+ * @dev:	MMC device
+ * @cmdidx:	Command index (e.g. MMC_CMD_STOP_TRANSMISSION)
+ * @return number of times the emulated card has received the command
+ */
+int sandbox_mmc_get_cmd_count(struct udevice *dev, int cmdidx);
+
 #endif
@@ -15,8 +15,11 @@
 #include <asm/global_data.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdtdec.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <dm/of.h>
+#include <dm/prebind.h>
 
 #define MAX_LEVEL	32		/* how deeply nested we will go */
 #define SCRATCHPAD	1024		/* bytes of scratchpad memory */
@@ -79,6 +82,24 @@ static int fdt_value_setenv(const void *nodep, int len, const char *var)
 /*
  * Flattened Device Tree command, see the help for parameter definitions.
  */
+/*
+ * The live tree, the lookups cached by fdtdec and the check of the prebind
+ * table all depend on the control FDT, so drop them before it is changed or
+ * replaced. Reads then go back to the flat tree.
+ */
+static void fdt_control_changing(void)
+{
+	of_live_drop();
+	fdtdec_cache_invalidate();
+	dm_prebind_invalidate();
+}
+
+/* Subcommands which do not change the working FDT */
+static bool fdt_cmd_reads_only(const char *cmd)
+{
+	return (cmd[0] && strchr("gplh", cmd[0])) || !strncmp(cmd, "che", 3);
+}
+
 static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	if (argc < 2)
@@ -121,6 +142,8 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		blob = map_sysmem(addr, 0);
 		if (!fdt_valid(&blob))
 			return 1;
+		if (control || (argc >= 2 && blob == gd->fdt_blob))
+			fdt_control_changing();
 		if (control)
 			gd->fdt_blob = blob;
 		else
@@ -160,6 +183,9 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return CMD_RET_FAILURE;
 	}
 
+	if (working_fdt == gd->fdt_blob && !fdt_cmd_reads_only(argv[1]))
+		fdt_control_changing();
+
 	/*
 	 * Move the working_fdt
 	 */
@@ -623,6 +649,8 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		if (!fdt_valid(&blob))
 			return 1;
 
+		if (blob != gd->fdt_blob)
+			fdt_control_changing();
 		gd->fdt_blob = blob;
 		cfg_noffset = fit_conf_get_node(working_fdt, NULL);
 		if (!cfg_noffset) {
@@ -44,6 +44,25 @@ U_BOOT_CMD(
 	"      If 'pos' is 0 or omitted, the file is read from the start."
 )
 
+#ifdef CONFIG_FS_DECOMP
+static int do_loadz_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	return do_load_decomp(cmdtp, flag, argc, argv, FS_TYPE_ANY);
+}
+
+U_BOOT_CMD(
+	loadz,	6,	0,	do_loadz_wrapper,
+	"load and decompress a gzip or lz4 file from a filesystem",
+	"<interface> [<dev[:part]> [<addr> [<filename> [maxsize]]]]\n"
+	"    - Load compressed file 'filename' from partition 'part' on\n"
+	"      device type 'interface' instance 'dev' and decompress it to\n"
+	"      address 'addr' in memory, without staging the compressed data.\n"
+	"      'maxsize' limits the uncompressed size in bytes.\n"
+	"      If 'maxsize' is 0 or omitted, the limit is the top of RAM."
+);
+#endif
+
 static int do_save_wrapper(cmd_tbl_t *cmdtp, int flag, int argc,
 				char * const argv[])
 {
@@ -20,6 +20,10 @@ static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
+	if (argc == 4 && !strcmp(argv[1], "bench"))
+		return hash_bench(simple_strtoul(argv[2], NULL, 16),
+				  simple_strtoul(argv[3], NULL, 16));
+
 #ifdef CONFIG_HASH_VERIFY
 	if (argc < 4)
 		return CMD_RET_USAGE;
@@ -47,7 +51,9 @@ U_BOOT_CMD(
 	hash,	HARGS,	1,	do_hash,
 	"compute hash message digest",
 	"algorithm address count [[*]hash_dest]\n"
-		"    - compute message digest [save to env var / *address]"
+		"    - compute message digest [save to env var / *address]\n"
+	"hash bench address count\n"
+		"    - show the speed of each algorithm on a memory area"
 #ifdef CONFIG_HASH_VERIFY
 	"\nhash -v algorithm address count [*]hash\n"
 		"    - verify message digest of memory area to immediate value, \n"
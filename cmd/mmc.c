@@ -39,6 +39,7 @@ static void print_mmcinfo(struct mmc *mmc)
 
 	printf("Bus Width: %d-bit%s\n", mmc->bus_width,
 			mmc->ddr_mode ? " DDR" : "");
+	printf("Mode: %s\n", mmc_mode_name(mmc->selected_mode));
 
 	puts("Erase Group Size: ");
 	print_size(((u64)mmc->erase_grp_size) << 9, "\n");
@@ -295,12 +296,12 @@ static int do_mmc_read(cmd_tbl_t *cmdtp, int flag,
 
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
-static int do_mmc_write(cmd_tbl_t *cmdtp, int flag,
-			int argc, char * const argv[])
+static int mmc_write_common(int argc, char * const argv[], bool reliable)
 {
 	struct mmc *mmc;
 	u32 blk, cnt, n;
 	void *addr;
+	int ret;
 
 	if (argc != 4)
 		return CMD_RET_USAGE;
@@ -320,11 +321,31 @@ static int do_mmc_write(cmd_tbl_t *cmdtp, int flag,
 		printf("Error: card is write protected!\n");
 		return CMD_RET_FAILURE;
 	}
+	if (reliable) {
+		ret = mmc_set_reliable_write(mmc, true);
+		if (ret) {
+			printf("Error: reliable write not supported (%d)\n",
+			       ret);
+			return CMD_RET_FAILURE;
+		}
+	}
 	n = blk_dwrite(mmc_get_blk_desc(mmc), blk, cnt, addr);
+	if (reliable)
+		mmc_set_reliable_write(mmc, false);
 	printf("%d blocks written: %s\n", n, (n == cnt) ? "OK" : "ERROR");
 
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
+static int do_mmc_write(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	return mmc_write_common(argc, argv, false);
+}
+static int do_mmc_rwrite(cmd_tbl_t *cmdtp, int flag,
+			 int argc, char * const argv[])
+{
+	return mmc_write_common(argc, argv, true);
+}
 static int do_mmc_erase(cmd_tbl_t *cmdtp, int flag,
 			int argc, char * const argv[])
 {
@@ -733,6 +754,7 @@ static cmd_tbl_t cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(info, 1, 0, do_mmcinfo, "", ""),
 	U_BOOT_CMD_MKENT(read, 4, 1, do_mmc_read, "", ""),
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
+	U_BOOT_CMD_MKENT(rwrite, 4, 0, do_mmc_rwrite, "", ""),
 	U_BOOT_CMD_MKENT(erase, 3, 0, do_mmc_erase, "", ""),
 	U_BOOT_CMD_MKENT(rescan, 1, 1, do_mmc_rescan, "", ""),
 	U_BOOT_CMD_MKENT(part, 1, 1, do_mmc_part, "", ""),
@@ -783,6 +805,7 @@ U_BOOT_CMD(
 	"info - display info of the current MMC device\n"
 	"mmc read addr blk# cnt\n"
 	"mmc write addr blk# cnt\n"
+	"mmc rwrite addr blk# cnt - reliable write (eMMC only)\n"
 	"mmc erase blk# cnt\n"
 	"mmc rescan\n"
 	"mmc part - lists available partition on current mmc device\n"
@@ -0,0 +1,47 @@
+/*
+ * LZ4 uncompress command, made from cmd/lzmadec.c
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static int do_unlz4(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	unsigned long src, dst;
+	size_t src_len = ~0UL, dst_len;
+	int ret;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+	src = simple_strtoul(argv[1], NULL, 16);
+	dst = simple_strtoul(argv[2], NULL, 16);
+
+	/* The output may fill the rest of RAM, unless limited */
+	if (argc > 3)
+		dst_len = simple_strtoul(argv[3], NULL, 16);
+	else
+		dst_len = dst < gd->ram_top ? gd->ram_top - dst : 0;
+
+	ret = ulz4fn(map_sysmem(src, 0), src_len, map_sysmem(dst, dst_len),
+		     &dst_len);
+	if (ret) {
+		printf("Uncompression failed (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+	printf("Uncompressed size: %ld = 0x%lX\n", (ulong)dst_len,
+	       (ulong)dst_len);
+	setenv_hex("filesize", dst_len);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	unlz4,    4,    1,    do_unlz4,
+	"lz4 uncompress a memory region",
+	"srcaddr dstaddr [dstsize]"
+);
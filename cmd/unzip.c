@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <mapmem.h>
 
 static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -25,7 +26,8 @@ static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			return CMD_RET_USAGE;
 	}
 
-	if (gunzip((void *) dst, dst_len, (void *) src, &src_len) != 0)
+	if (gunzip(map_sysmem(dst, dst_len), dst_len, map_sysmem(src, 0),
+		   &src_len) != 0)
 		return 1;
 
 	printf("Uncompressed size: %ld = 0x%lX\n", src_len, src_len);
@@ -57,8 +59,8 @@ static int do_gzwrite(cmd_tbl_t *cmdtp, int flag,
 	if (ret < 0)
 		return CMD_RET_FAILURE;
 
-	addr = (unsigned char *)simple_strtoul(argv[3], NULL, 16);
 	length = simple_strtoul(argv[4], NULL, 16);
+	addr = map_sysmem(simple_strtoul(argv[3], NULL, 16), length);
 
 	if (5 < argc) {
 		writebuf = simple_strtoul(argv[5], NULL, 16);
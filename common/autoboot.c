@@ -10,6 +10,7 @@
 #include <bootretry.h>
 #include <cli.h>
 #include <console.h>
+#include <dm/root.h>
 #include <fdtdec.h>
 #include <menu.h>
 #include <post.h>
@@ -243,6 +244,7 @@ static int __abortboot(int bootdelay)
 # endif
 				break;
 			}
+			dm_probe_poll();
 			udelay(10000);
 		} while (!abort && get_timer(ts) < 1000);
 
@@ -178,6 +178,10 @@ static int initr_reloc_global_data(void)
 	*/
 	gd->fdt_blob += gd->reloc_off;
 #endif
+#ifdef CONFIG_OF_CACHE
+	/* The cache is in the early malloc() area, which is about to go */
+	gd->fdt_cache = NULL;
+#endif
 #ifdef CONFIG_EFI_LOADER
 	efi_runtime_relocate(gd->relocaddr, NULL);
 #endif
@@ -314,6 +318,20 @@ static int initr_noncached(void)
 }
 #endif
 
+#ifdef CONFIG_OF_LIVE
+static int initr_of_live(void)
+{
+	int ret;
+
+	ret = of_live_build(gd->fdt_blob, &gd->of_root);
+	if (ret)
+		printf("Cannot unflatten device tree (err=%d)\n", ret);
+
+	/* Without the live tree, the flat tree is still used */
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_DM
 static int initr_dm(void)
 {
@@ -322,6 +340,8 @@ static int initr_dm(void)
 	/* Save the pre-reloc driver model and start a new one */
 	gd->dm_root_f = gd->dm_root;
 	gd->dm_root = NULL;
+	gd->dm_compat_table = NULL;
+	gd->uclass_by_id = NULL;
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
 #endif
@@ -333,6 +353,10 @@ static int initr_dm(void)
 	if (ret)
 		return ret;
 #endif
+	/* Devices which fail here are reported again when used */
+	ret = dm_probe_async_all();
+	if (ret)
+		debug("%s: Some devices failed to probe: %d\n", __func__, ret);
 
 	return 0;
 }
@@ -781,6 +805,9 @@ init_fnc_t init_sequence_r[] = {
 	initr_noncached,
 #endif
 	bootstage_relocate,
+#ifdef CONFIG_OF_LIVE
+	initr_of_live,
+#endif
 #ifdef CONFIG_DM
 	initr_dm,
 #endif
@@ -341,10 +341,14 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		       void *load_buf, void *image_buf, ulong image_len,
 		       uint unc_len, ulong *load_end)
 {
+	uint32_t us = 0;
 	int ret = 0;
 
 	*load_end = load;
 	print_decomp_msg(comp, type, load == image_start);
+#ifndef USE_HOSTCC
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+#endif
 
 	/*
 	 * Load the image to the right place, decompressing if needed. After
@@ -410,21 +414,165 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		break;
 	}
 #endif /* CONFIG_LZ4 */
+#ifdef CONFIG_ZSTD
+	case IH_COMP_ZSTD: {
+		size_t size = unc_len;
+
+		ret = zstd_decompress(image_buf, image_len, load_buf, &size);
+		image_len = size;
+		break;
+	}
+#endif /* CONFIG_ZSTD */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
 	}
+#ifndef USE_HOSTCC
+	us = bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+#endif
 
 	if (ret)
 		return handle_decomp_error(comp, image_len, unc_len, ret);
 	*load_end = load + image_len;
 
-	puts("OK\n");
+	/*
+	 * With bootstage, show the speed (bytes per microsecond), unless the
+	 * time is too short to give a useful figure
+	 */
+	if (comp != IH_COMP_NONE && us >= 1000)
+		printf("OK (%lu MB/s)\n", image_len / us);
+	else
+		puts("OK\n");
 
 	return 0;
 }
 
 #ifndef USE_HOSTCC
+#if IMAGE_ENABLE_STREAM_VERIFY
+/* Compressed image data which is hashed as it is decompressed */
+struct bootm_verify_priv {
+	struct fit_hash_stream hs;
+	const char *buf;
+	ulong len;
+	int err;
+};
+
+static long bootm_verify_read(void *priv, const void **bufp)
+{
+	struct bootm_verify_priv *vp = priv;
+	ulong len = min(vp->len, (ulong)CHUNKSZ);
+
+	if (!len)
+		return 0;
+	vp->err = fit_image_hash_update(&vp->hs, vp->buf, len,
+					len == vp->len);
+	if (vp->err)
+		return vp->err;
+	*bufp = vp->buf;
+	vp->buf += len;
+	vp->len -= len;
+
+	return len;
+}
+
+/**
+ * bootm_decomp_verify() - Decompress a FIT image and check its hashes
+ *
+ * This reads the compressed data once, hashing each chunk just before it is
+ * decompressed, rather than first hashing the whole image when it is
+ * selected and then reading it all again to decompress it.
+ *
+ * @images:	Images information; the OS image must be in a FIT
+ * @load_buf:	Buffer to decompress into
+ * @image_buf:	Compressed image data
+ * @load_end:	Returns the end of the uncompressed data
+ * @return 0 if OK, 1 if the hashes do not match, BOOTM_ERR_... on other
+ *	errors
+ */
+static int bootm_decomp_verify(bootm_headers_t *images, void *load_buf,
+			       const void *image_buf, ulong *load_end)
+{
+	image_info_t *os = &images->os;
+	struct bootm_verify_priv vp;
+	ulong len = 0;
+	long ret;
+
+	ret = fit_image_hash_start(images->fit_hdr_os, images->fit_noffset_os,
+				   &vp.hs);
+	if (ret) {
+		/* Fall back to checking the hashes first */
+		puts("   Verifying Hash Integrity ... ");
+		if (!fit_image_verify(images->fit_hdr_os,
+				      images->fit_noffset_os))
+			goto bad_hash;
+		puts("OK\n");
+		return bootm_decomp_image(os->comp, os->load, os->image_start,
+					  os->type, load_buf, (void *)image_buf,
+					  os->image_len, CONFIG_SYS_BOOTM_LEN,
+					  load_end);
+	}
+	*load_end = os->load;
+	vp.buf = image_buf;
+	vp.len = os->image_len;
+	vp.err = 0;
+
+	print_decomp_msg(os->comp, os->type, false);
+	switch (os->comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ret = gunzip_stream(load_buf, CONFIG_SYS_BOOTM_LEN,
+				    bootm_verify_read, &vp, &len);
+		break;
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t size = CONFIG_SYS_BOOTM_LEN;
+
+		ret = ulz4fn_stream(bootm_verify_read, &vp, load_buf, &size);
+		len = size;
+		break;
+	}
+#endif
+	default:
+		ret = -EPROTONOSUPPORT;
+		break;
+	}
+
+	/*
+	 * Hash whatever the decompressor did not read, so that corrupted
+	 * data is reported as such even if it stopped early
+	 */
+	while (!vp.err && vp.len) {
+		const void *buf;
+
+		bootm_verify_read(&vp, &buf);
+	}
+	if (ret || vp.err) {
+		puts("error\n");
+	} else {
+		puts("OK\n");
+		*load_end = os->load + len;
+	}
+
+	puts("   Verifying Hash Integrity ... ");
+	if (!fit_image_hash_finish(&vp.hs))
+		goto bad_hash;
+	puts("OK\n");
+
+	if (ret || vp.err)
+		return handle_decomp_error(os->comp, len, CONFIG_SYS_BOOTM_LEN,
+					   ret ? ret : vp.err);
+
+	return 0;
+
+bad_hash:
+	puts("Bad Data Hash\n");
+	bootstage_error(BOOTSTAGE_ID_FIT_KERNEL_START + BOOTSTAGE_SUB_HASH);
+
+	return 1;
+}
+#endif /* IMAGE_ENABLE_STREAM_VERIFY */
+
 static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 			 int boot_progress)
 {
@@ -440,6 +588,12 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
+#if IMAGE_ENABLE_STREAM_VERIFY
+	if (images->fit_verify_os)
+		err = bootm_decomp_verify(images, load_buf, image_buf,
+					  load_end);
+	else
+#endif
 	err = bootm_decomp_image(os.comp, load, os.image_start, os.type,
 				 load_buf, image_buf, image_len,
 				 CONFIG_SYS_BOOTM_LEN, load_end);
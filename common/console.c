@@ -16,6 +16,8 @@
 #include <stdio_dev.h>
 #include <exports.h>
 #include <environment.h>
+#include <task.h>
+#include <dm/root.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -377,6 +379,14 @@ int getc(void)
 			return 1;
 	}
 #endif
+	/* Let devices finish probing and tasks run while waiting for input */
+	if (CONFIG_IS_ENABLED(DM_PROBE_ASYNC) || CONFIG_IS_ENABLED(TASK)) {
+		while (!tstc()) {
+			dm_probe_poll();
+			task_yield();
+		}
+	}
+
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Get from the standard input */
 		return fgetc(stdin);
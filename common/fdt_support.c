@@ -9,6 +9,7 @@
 
 #include <common.h>
 #include <inttypes.h>
+#include <malloc.h>
 #include <stdio_dev.h>
 #include <linux/ctype.h>
 #include <linux/types.h>
@@ -123,46 +124,798 @@ int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name)
 	return offset;
 }
 
+/* Number of entries by which the arrays in a batch grow */
+#define FDT_BATCH_CHUNK		16
+
+/* Batches with fewer edits than this are made one edit at a time */
+#define FDT_BATCH_MIN_REWRITE	3
+
+/**
+ * struct fdt_batch_node - A node edited or added by a batch
+ *
+ * @offset:	Offset of the node in the FDT, or -1 if the batch adds it
+ * @parent:	Handle of the parent, for a node which the batch adds
+ * @name:	Name of a node which the batch adds
+ */
+struct fdt_batch_node {
+	int offset;
+	int parent;
+	char *name;
+};
+
+/**
+ * struct fdt_batch_prop - A property set or deleted by a batch
+ *
+ * A property which is added, or deleted then set again, goes at the start
+ * of its node as with libfdt. Records for these are kept in the order in
+ * which the properties were added.
+ *
+ * @node:	Handle of the node holding the property
+ * @name:	Name of the property
+ * @nameoff:	Offset of @name in the strings block, if @add, else -1
+ * @val:	New value
+ * @len:	Length of @val in bytes, or -1 if the property is deleted
+ * @exists:	true if the property is in the FDT
+ * @add:	true if the value is for a property added by the batch
+ */
+struct fdt_batch_prop {
+	int node;
+	char *name;
+	int nameoff;
+	void *val;
+	int len;
+	bool exists;
+	bool add;
+};
+
+/**
+ * struct fdt_batch_out - Output buffer used while rewriting an FDT
+ *
+ * @buf:	Start of the buffer
+ * @pos:	Number of bytes written so far
+ * @size:	Size of the buffer in bytes
+ */
+struct fdt_batch_out {
+	char *buf;
+	int pos;
+	int size;
+};
+
+static int fdt_batch_fail(struct fdt_batch *batch, int err)
+{
+	if (!batch->err)
+		batch->err = err;
+
+	return err;
+}
+
+/* Add a cleared entry to one of the arrays in a batch */
+static void *fdt_batch_grow(void **arrayp, int *countp, int size)
+{
+	void *array;
+
+	if (!(*countp % FDT_BATCH_CHUNK)) {
+		array = malloc((*countp + FDT_BATCH_CHUNK) * size);
+		if (!array)
+			return NULL;
+		if (*countp)
+			memcpy(array, *arrayp, *countp * size);
+		free(*arrayp);
+		*arrayp = array;
+	}
+	array = *arrayp + (*countp)++ * size;
+	memset(array, '\0', size);
+
+	return array;
+}
+
+static int fdt_batch_find_node(struct fdt_batch *batch, int nodeoffset)
+{
+	int i;
+
+	for (i = 0; i < batch->nodes; i++) {
+		if (batch->node[i].offset == nodeoffset)
+			return i;
+	}
+
+	return -1;
+}
+
+static int fdt_batch_find_prop(struct fdt_batch *batch, int node,
+			       const char *name)
+{
+	int i;
+
+	for (i = 0; i < batch->props; i++) {
+		if (batch->prop[i].node == node &&
+		    !strcmp(batch->prop[i].name, name))
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Find a string in the strings block, or add it after the block, as libfdt
+ * would. This returns its offset, or -FDT_ERR_NOSPACE.
+ */
+static int fdt_batch_add_string(struct fdt_batch *batch, const char *str)
+{
+	const char *strtab = batch->fdt + fdt_off_dt_strings(batch->fdt);
+	int size = fdt_size_dt_strings(batch->fdt);
+	int len = strlen(str) + 1;
+	char *strings;
+	int i;
+
+	for (i = 0; i <= size - len; i++) {
+		if (!memcmp(strtab + i, str, len))
+			return i;
+	}
+	for (i = 0; i <= batch->strings_size - len; i++) {
+		if (!memcmp(batch->strings + i, str, len))
+			return size + i;
+	}
+
+	strings = malloc(batch->strings_size + len);
+	if (!strings)
+		return -FDT_ERR_NOSPACE;
+	memcpy(strings, batch->strings, batch->strings_size);
+	memcpy(strings + batch->strings_size, str, len);
+	free(batch->strings);
+	batch->strings = strings;
+	batch->strings_size += len;
+
+	return size + batch->strings_size - len;
+}
+
+void fdt_batch_init(struct fdt_batch *batch, void *fdt)
+{
+	memset(batch, '\0', sizeof(*batch));
+	batch->fdt = fdt;
+	batch->rsvs = -1;
+	batch->err = fdt_check_header(fdt);
+}
+
+int fdt_batch_node(struct fdt_batch *batch, int nodeoffset)
+{
+	struct fdt_batch_node *node;
+	int i;
+
+	if (batch->err)
+		return batch->err;
+	i = fdt_batch_find_node(batch, nodeoffset);
+	if (i >= 0)
+		return i;
+	if (nodeoffset < 0 || !fdt_get_name(batch->fdt, nodeoffset, NULL))
+		return fdt_batch_fail(batch, -FDT_ERR_BADOFFSET);
+
+	node = fdt_batch_grow((void **)&batch->node, &batch->nodes,
+			      sizeof(*node));
+	if (!node)
+		return fdt_batch_fail(batch, -FDT_ERR_NOSPACE);
+	node->offset = nodeoffset;
+
+	return batch->nodes - 1;
+}
+
+int fdt_batch_subnode(struct fdt_batch *batch, int node, const char *name)
+{
+	struct fdt_batch_node *sub;
+	int offset, i;
+
+	if (batch->err)
+		return batch->err;
+	if (node < 0 || node >= batch->nodes)
+		return fdt_batch_fail(batch, -FDT_ERR_BADOFFSET);
+
+	offset = batch->node[node].offset;
+	if (offset >= 0) {
+		offset = fdt_subnode_offset(batch->fdt, offset, name);
+		if (offset >= 0)
+			return fdt_batch_node(batch, offset);
+		if (offset != -FDT_ERR_NOTFOUND)
+			return fdt_batch_fail(batch, offset);
+	}
+	for (i = 0; i < batch->nodes; i++) {
+		sub = &batch->node[i];
+		if (sub->offset < 0 && sub->parent == node &&
+		    !strcmp(sub->name, name))
+			return i;
+	}
+
+	sub = fdt_batch_grow((void **)&batch->node, &batch->nodes,
+			     sizeof(*sub));
+	if (!sub)
+		return fdt_batch_fail(batch, -FDT_ERR_NOSPACE);
+	sub->offset = -1;
+	sub->parent = node;
+	sub->name = strdup(name);
+	if (!sub->name) {
+		batch->nodes--;
+		return fdt_batch_fail(batch, -FDT_ERR_NOSPACE);
+	}
+
+	return batch->nodes - 1;
+}
+
+/* Add a record for a property, which starts off deleted */
+static struct fdt_batch_prop *fdt_batch_new_prop(struct fdt_batch *batch,
+						 int node, const char *name)
+{
+	struct fdt_batch_prop *prop;
+	int offset;
+
+	prop = fdt_batch_grow((void **)&batch->prop, &batch->props,
+			      sizeof(*prop));
+	if (!prop)
+		goto err;
+	prop->name = strdup(name);
+	if (!prop->name) {
+		batch->props--;
+		goto err;
+	}
+	offset = batch->node[node].offset;
+	prop->node = node;
+	prop->nameoff = -1;
+	prop->len = -1;
+	prop->exists = offset >= 0 &&
+		       fdt_get_property(batch->fdt, offset, name, NULL);
+
+	return prop;
+err:
+	fdt_batch_fail(batch, -FDT_ERR_NOSPACE);
+
+	return NULL;
+}
+
+int fdt_batch_setprop(struct fdt_batch *batch, int node, const char *name,
+		      const void *val, int len)
+{
+	struct fdt_batch_prop *prop, tmp;
+	bool add;
+	void *copy;
+	int ret, i;
+
+	if (batch->err)
+		return batch->err;
+	if (node < 0 || node >= batch->nodes)
+		return fdt_batch_fail(batch, -FDT_ERR_BADOFFSET);
+
+	i = fdt_batch_find_prop(batch, node, name);
+	if (i >= 0) {
+		prop = &batch->prop[i];
+		add = prop->len < 0;
+	} else {
+		prop = fdt_batch_new_prop(batch, node, name);
+		if (!prop)
+			return batch->err;
+		i = batch->props - 1;
+		add = !prop->exists;
+	}
+
+	/* Adding the property puts it after all those added so far */
+	if (add) {
+		if (prop->nameoff < 0) {
+			ret = fdt_batch_add_string(batch, name);
+			if (ret < 0)
+				return fdt_batch_fail(batch, ret);
+			prop->nameoff = ret;
+		}
+		prop->add = true;
+		tmp = *prop;
+		memmove(prop, prop + 1, (batch->props - i - 1) * sizeof(*prop));
+		prop = &batch->prop[batch->props - 1];
+		*prop = tmp;
+	}
+
+	copy = malloc(max(len, 1));
+	if (!copy)
+		return fdt_batch_fail(batch, -FDT_ERR_NOSPACE);
+	memcpy(copy, val, len);
+	free(prop->val);
+	prop->val = copy;
+	prop->len = len;
+
+	return 0;
+}
+
+int fdt_batch_delprop(struct fdt_batch *batch, int node, const char *name)
+{
+	struct fdt_batch_prop *prop;
+	int i;
+
+	if (batch->err)
+		return batch->err;
+	if (node < 0 || node >= batch->nodes)
+		return fdt_batch_fail(batch, -FDT_ERR_BADOFFSET);
+
+	i = fdt_batch_find_prop(batch, node, name);
+	if (i >= 0) {
+		prop = &batch->prop[i];
+	} else {
+		if (batch->node[node].offset < 0 ||
+		    !fdt_get_property(batch->fdt, batch->node[node].offset,
+				      name, NULL))
+			return 0;
+		prop = fdt_batch_new_prop(batch, node, name);
+		if (!prop)
+			return batch->err;
+	}
+	free(prop->val);
+	prop->val = NULL;
+	prop->len = -1;
+
+	return 0;
+}
+
+/* Copy the memory reserve map into the batch when it is first edited */
+static int fdt_batch_load_rsv(struct fdt_batch *batch)
+{
+	struct fdt_reserve_entry *re;
+	uint64_t addr, size;
+	int total, i;
+
+	if (batch->err)
+		return batch->err;
+	if (batch->rsvs >= 0)
+		return 0;
+
+	batch->rsvs = 0;
+	total = fdt_num_mem_rsv(batch->fdt);
+	for (i = 0; i < total; i++) {
+		fdt_get_mem_rsv(batch->fdt, i, &addr, &size);
+		re = fdt_batch_grow((void **)&batch->rsv, &batch->rsvs,
+				    sizeof(*re));
+		if (!re)
+			return fdt_batch_fail(batch, -FDT_ERR_NOSPACE);
+		re->address = cpu_to_fdt64(addr);
+		re->size = cpu_to_fdt64(size);
+	}
+
+	return 0;
+}
+
+int fdt_batch_add_mem_rsv(struct fdt_batch *batch, u64 address, u64 size)
+{
+	struct fdt_reserve_entry *re;
+	int ret;
+
+	ret = fdt_batch_load_rsv(batch);
+	if (ret)
+		return ret;
+	re = fdt_batch_grow((void **)&batch->rsv, &batch->rsvs, sizeof(*re));
+	if (!re)
+		return fdt_batch_fail(batch, -FDT_ERR_NOSPACE);
+	re->address = cpu_to_fdt64(address);
+	re->size = cpu_to_fdt64(size);
+
+	return 0;
+}
+
+int fdt_batch_del_mem_rsv(struct fdt_batch *batch, u64 address)
+{
+	int ret, i;
+
+	ret = fdt_batch_load_rsv(batch);
+	if (ret)
+		return ret;
+	for (i = 0; i < batch->rsvs; i++) {
+		if (fdt64_to_cpu(batch->rsv[i].address) == address) {
+			batch->rsvs--;
+			memmove(&batch->rsv[i], &batch->rsv[i + 1],
+				(batch->rsvs - i) * sizeof(*batch->rsv));
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/* Add bytes to the output, which are cleared if @data is NULL */
+static void *fdt_batch_put(struct fdt_batch_out *out, const void *data,
+			   int len)
+{
+	void *ptr = out->buf + out->pos;
+
+	if (len > out->size - out->pos)
+		return NULL;
+	if (data)
+		memcpy(ptr, data, len);
+	else
+		memset(ptr, '\0', len);
+	out->pos += len;
+
+	return ptr;
+}
+
+/* Copy part of the FDT to the output unchanged */
+static int fdt_batch_copy(struct fdt_batch_out *out, const void *fdt,
+			  int start, int end)
+{
+	if (!fdt_batch_put(out, fdt + start, end - start))
+		return -FDT_ERR_NOSPACE;
+
+	return 0;
+}
+
+static int fdt_batch_put_tag(struct fdt_batch_out *out, uint32_t tag)
+{
+	fdt32_t *ptr;
+
+	ptr = fdt_batch_put(out, NULL, FDT_TAGSIZE);
+	if (!ptr)
+		return -FDT_ERR_NOSPACE;
+	*ptr = cpu_to_fdt32(tag);
+
+	return 0;
+}
+
+static int fdt_batch_put_prop(struct fdt_batch_out *out, int nameoff,
+			      const void *val, int len)
+{
+	struct fdt_property *prop;
+
+	prop = fdt_batch_put(out, NULL,
+			     sizeof(*prop) + ALIGN(len, FDT_TAGSIZE));
+	if (!prop)
+		return -FDT_ERR_NOSPACE;
+	prop->tag = cpu_to_fdt32(FDT_PROP);
+	prop->len = cpu_to_fdt32(len);
+	prop->nameoff = cpu_to_fdt32(nameoff);
+	memcpy(prop->data, val, len);
+
+	return 0;
+}
+
+/*
+ * libfdt adds each new property at the start of its node, so write them
+ * newest first.
+ */
+static int fdt_batch_put_new_props(struct fdt_batch *batch,
+				   struct fdt_batch_out *out, int node)
+{
+	struct fdt_batch_prop *prop;
+	int ret, i;
+
+	for (i = batch->props - 1; i >= 0; i--) {
+		prop = &batch->prop[i];
+		if (prop->node != node || !prop->add || prop->len < 0)
+			continue;
+		ret = fdt_batch_put_prop(out, prop->nameoff, prop->val,
+					 prop->len);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * libfdt adds each new subnode after the properties of its parent, before
+ * any other subnodes, so write them newest first too.
+ */
+static int fdt_batch_put_new_nodes(struct fdt_batch *batch,
+				   struct fdt_batch_out *out, int parent)
+{
+	struct fdt_batch_node *node;
+	int ret, len, i;
+	char *name;
+
+	for (i = batch->nodes - 1; i >= 0; i--) {
+		node = &batch->node[i];
+		if (node->offset >= 0 || node->parent != parent)
+			continue;
+		ret = fdt_batch_put_tag(out, FDT_BEGIN_NODE);
+		if (ret)
+			return ret;
+		len = strlen(node->name) + 1;
+		name = fdt_batch_put(out, NULL, ALIGN(len, FDT_TAGSIZE));
+		if (!name)
+			return -FDT_ERR_NOSPACE;
+		memcpy(name, node->name, len);
+		ret = fdt_batch_put_new_props(batch, out, i);
+		if (!ret)
+			ret = fdt_batch_put_new_nodes(batch, out, i);
+		if (!ret)
+			ret = fdt_batch_put_tag(out, FDT_END_NODE);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Write the structure block with the edits made */
+static int fdt_batch_put_struct(struct fdt_batch *batch,
+				struct fdt_batch_out *out)
+{
+	const void *fdt = batch->fdt;
+	const void *base = fdt + fdt_off_dt_struct(fdt);
+	const struct fdt_property *old;
+	struct fdt_batch_prop *prop;
+	int offset, next, node, ret, i;
+	bool in_props = false;
+	uint32_t tag;
+
+	node = -1;
+	offset = 0;
+	do {
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (next < 0)
+			return -FDT_ERR_BADSTRUCTURE;
+
+		/* New subnodes go where the properties of their parent end */
+		if (in_props && tag != FDT_PROP && tag != FDT_NOP) {
+			in_props = false;
+			if (node >= 0) {
+				ret = fdt_batch_put_new_nodes(batch, out, node);
+				if (ret)
+					return ret;
+			}
+		}
+
+		ret = 0;
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			ret = fdt_batch_copy(out, base, offset, next);
+			node = fdt_batch_find_node(batch, offset);
+			if (!ret && node >= 0)
+				ret = fdt_batch_put_new_props(batch, out, node);
+			in_props = true;
+			break;
+		case FDT_PROP:
+			old = fdt_offset_ptr(fdt, offset, sizeof(*old));
+			i = -1;
+			if (node >= 0)
+				i = fdt_batch_find_prop(batch, node,
+					fdt_string(fdt,
+						   fdt32_to_cpu(old->nameoff)));
+			prop = i >= 0 ? &batch->prop[i] : NULL;
+			if (!prop)
+				ret = fdt_batch_copy(out, base, offset, next);
+			else if (!prop->add && prop->len >= 0)
+				ret = fdt_batch_put_prop(out,
+						fdt32_to_cpu(old->nameoff),
+						prop->val, prop->len);
+			break;
+		default:
+			ret = fdt_batch_copy(out, base, offset, next);
+			break;
+		}
+		if (ret)
+			return ret;
+		offset = next;
+	} while (tag != FDT_END);
+
+	return 0;
+}
+
+/* Rewrite the FDT into @buf with the edits made */
+static int fdt_batch_write(struct fdt_batch *batch, void *buf)
+{
+	const void *fdt = batch->fdt;
+	struct fdt_batch_out out = {
+		.buf = buf,
+		.size = fdt_totalsize(fdt),
+	};
+	int rsv_end, struct_off, strings_off, ret;
+
+	rsv_end = fdt_off_mem_rsvmap(fdt) +
+		(fdt_num_mem_rsv(fdt) + 1) * sizeof(struct fdt_reserve_entry);
+	if (fdt_version(fdt) < 17)
+		return -FDT_ERR_BADVERSION;
+	if (rsv_end > fdt_off_dt_struct(fdt) ||
+	    fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt) >
+	    fdt_off_dt_strings(fdt))
+		return -FDT_ERR_BADLAYOUT;
+
+	ret = fdt_batch_copy(&out, fdt, 0, fdt_off_mem_rsvmap(fdt));
+	if (ret)
+		return ret;
+	if (batch->rsvs >= 0) {
+		if (!fdt_batch_put(&out, batch->rsv,
+				   batch->rsvs * sizeof(*batch->rsv)) ||
+		    !fdt_batch_put(&out, NULL, sizeof(*batch->rsv)))
+			return -FDT_ERR_NOSPACE;
+	} else {
+		ret = fdt_batch_copy(&out, fdt, fdt_off_mem_rsvmap(fdt),
+				     rsv_end);
+		if (ret)
+			return ret;
+	}
+	ret = fdt_batch_copy(&out, fdt, rsv_end, fdt_off_dt_struct(fdt));
+	if (ret)
+		return ret;
+
+	struct_off = out.pos;
+	ret = fdt_batch_put_struct(batch, &out);
+	if (ret)
+		return ret;
+	fdt_set_off_dt_struct(buf, struct_off);
+	fdt_set_size_dt_struct(buf, out.pos - struct_off);
+
+	ret = fdt_batch_copy(&out, fdt,
+			     fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt),
+			     fdt_off_dt_strings(fdt));
+	if (ret)
+		return ret;
+	strings_off = out.pos;
+	ret = fdt_batch_copy(&out, fdt, fdt_off_dt_strings(fdt),
+			     fdt_off_dt_strings(fdt) +
+			     fdt_size_dt_strings(fdt));
+	if (ret)
+		return ret;
+	if (!fdt_batch_put(&out, batch->strings, batch->strings_size))
+		return -FDT_ERR_NOSPACE;
+	fdt_set_off_dt_strings(buf, strings_off);
+	fdt_set_size_dt_strings(buf, out.pos - strings_off);
+	if (fdt_version(buf) > 17)
+		fdt_set_version(buf, 17);
+
+	return 0;
+}
+
+/* Make the edits to one node, and add its new subnodes */
+static int fdt_batch_apply_node(struct fdt_batch *batch, int node,
+				int offset)
+{
+	struct fdt_batch_prop *prop;
+	int ret, sub, i;
+
+	for (i = 0; i < batch->props; i++) {
+		prop = &batch->prop[i];
+		if (prop->node != node)
+			continue;
+		ret = 0;
+		if (prop->exists && (prop->add || prop->len < 0))
+			ret = fdt_delprop(batch->fdt, offset, prop->name);
+		if (!ret && prop->len >= 0)
+			ret = fdt_setprop(batch->fdt, offset, prop->name,
+					  prop->val, prop->len);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < batch->nodes; i++) {
+		if (batch->node[i].offset >= 0 || batch->node[i].parent != node)
+			continue;
+		sub = fdt_add_subnode(batch->fdt, offset, batch->node[i].name);
+		if (sub < 0)
+			return sub;
+		ret = fdt_batch_apply_node(batch, i, sub);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Make the edits one at a time with libfdt */
+static int fdt_batch_apply(struct fdt_batch *batch)
+{
+	struct fdt_reserve_entry *re;
+	int node, last, offset, ret, i;
+
+	if (batch->rsvs >= 0) {
+		for (i = fdt_num_mem_rsv(batch->fdt); i > 0; i--) {
+			ret = fdt_del_mem_rsv(batch->fdt, 0);
+			if (ret)
+				return ret;
+		}
+		for (i = 0; i < batch->rsvs; i++) {
+			re = &batch->rsv[i];
+			ret = fdt_add_mem_rsv(batch->fdt,
+					      fdt64_to_cpu(re->address),
+					      fdt64_to_cpu(re->size));
+			if (ret)
+				return ret;
+		}
+	}
+
+	/* Work back from the end so the offsets still to use stay valid */
+	for (last = INT_MAX; ; last = batch->node[node].offset) {
+		node = -1;
+		for (i = 0; i < batch->nodes; i++) {
+			offset = batch->node[i].offset;
+			if (offset >= 0 && offset < last &&
+			    (node < 0 || offset > batch->node[node].offset))
+				node = i;
+		}
+		if (node < 0)
+			break;
+		ret = fdt_batch_apply_node(batch, node,
+					   batch->node[node].offset);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int fdt_batch_commit(struct fdt_batch *batch)
+{
+	void *fdt = batch->fdt;
+	void *buf = NULL;
+	int ret, edits, i;
+
+	ret = batch->err;
+	if (ret)
+		goto done;
+
+	edits = batch->props + (batch->rsvs >= 0);
+	for (i = 0; i < batch->nodes; i++) {
+		if (batch->node[i].offset < 0)
+			edits++;
+	}
+	if (!edits)
+		goto done;
+
+	if (edits >= FDT_BATCH_MIN_REWRITE)
+		buf = malloc(fdt_totalsize(fdt));
+	if (buf) {
+		ret = fdt_batch_write(batch, buf);
+		if (!ret)
+			memcpy(fdt, buf, fdt_off_dt_strings(buf) +
+			       fdt_size_dt_strings(buf));
+		free(buf);
+	} else {
+		ret = fdt_batch_apply(batch);
+	}
+done:
+	fdt_batch_abort(batch);
+
+	return ret;
+}
+
+void fdt_batch_abort(struct fdt_batch *batch)
+{
+	int i;
+
+	for (i = 0; i < batch->nodes; i++)
+		free(batch->node[i].name);
+	for (i = 0; i < batch->props; i++) {
+		free(batch->prop[i].name);
+		free(batch->prop[i].val);
+	}
+	free(batch->node);
+	free(batch->prop);
+	free(batch->rsv);
+	free(batch->strings);
+	memset(batch, '\0', sizeof(*batch));
+}
+
 /* rename to CONFIG_OF_STDOUT_PATH ? */
 #if defined(OF_STDOUT_PATH)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch, int chosen)
 {
-	return fdt_setprop(fdt, chosenoff, "linux,stdout-path",
-			      OF_STDOUT_PATH, strlen(OF_STDOUT_PATH) + 1);
+	return fdt_batch_setprop(batch, chosen, "linux,stdout-path",
+				 OF_STDOUT_PATH, strlen(OF_STDOUT_PATH) + 1);
 }
 #elif defined(CONFIG_OF_STDOUT_VIA_ALIAS) && defined(CONFIG_CONS_INDEX)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch, int chosen)
 {
 	int err;
 	int aliasoff;
 	char sername[9] = { 0 };
 	const void *path;
 	int len;
-	char tmp[256]; /* long enough */
 
 	sprintf(sername, "serial%d", CONFIG_CONS_INDEX - 1);
 
-	aliasoff = fdt_path_offset(fdt, "/aliases");
+	aliasoff = fdt_path_offset(batch->fdt, "/aliases");
 	if (aliasoff < 0) {
 		err = aliasoff;
 		goto noalias;
 	}
 
-	path = fdt_getprop(fdt, aliasoff, sername, &len);
+	path = fdt_getprop(batch->fdt, aliasoff, sername, &len);
 	if (!path) {
 		err = len;
 		goto noalias;
 	}
 
-	/* fdt_setprop may break "path" so we copy it to tmp buffer */
-	memcpy(tmp, path, len);
-
-	err = fdt_setprop(fdt, chosenoff, "linux,stdout-path", tmp, len);
-	if (err < 0)
-		printf("WARNING: could not set linux,stdout-path %s.\n",
-		       fdt_strerror(err));
-
-	return err;
+	/* The value is copied, so "path" need not stay valid */
+	return fdt_batch_setprop(batch, chosen, "linux,stdout-path", path, len);
 
 noalias:
 	printf("WARNING: %s: could not read %s alias: %s\n",
@@ -171,136 +924,115 @@ noalias:
 	return 0;
 }
 #else
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch, int chosen)
 {
 	return 0;
 }
 #endif
 
-static inline int fdt_setprop_uxx(void *fdt, int nodeoffset, const char *name,
-				  uint64_t val, int is_u64)
+/* Make the edits in a batch built by one of the fixups below */
+static int fdt_batch_finish(struct fdt_batch *batch, const char *func,
+			    int err)
 {
-	if (is_u64)
-		return fdt_setprop_u64(fdt, nodeoffset, name, val);
-	else
-		return fdt_setprop_u32(fdt, nodeoffset, name, (uint32_t)val);
+	if (err < 0) {
+		fdt_batch_abort(batch);
+		return err;
+	}
+
+	err = fdt_batch_commit(batch);
+	if (err < 0)
+		printf("%s: %s\n", func, fdt_strerror(err));
+
+	return err;
 }
 
-int fdt_root(void *fdt)
+int fdt_batch_root(struct fdt_batch *batch)
 {
 	char *serial;
-	int err;
-
-	err = fdt_check_header(fdt);
-	if (err < 0) {
-		printf("fdt_root: %s\n", fdt_strerror(err));
-		return err;
-	}
 
 	serial = getenv("serial#");
-	if (serial) {
-		err = fdt_setprop(fdt, 0, "serial-number", serial,
-				  strlen(serial) + 1);
-
-		if (err < 0) {
-			printf("WARNING: could not set serial-number %s.\n",
-			       fdt_strerror(err));
-			return err;
-		}
-	}
+	if (serial)
+		fdt_batch_setprop_string(batch, fdt_batch_node(batch, 0),
+					 "serial-number", serial);
 
-	return 0;
+	return batch->err;
 }
 
-int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
+int fdt_root(void *fdt)
 {
-	int   nodeoffset;
-	int   err, j, total;
-	int is_u64;
-	uint64_t addr, size;
+	struct fdt_batch batch;
+
+	fdt_batch_init(&batch, fdt);
+
+	return fdt_batch_finish(&batch, __func__, fdt_batch_root(&batch));
+}
+
+int fdt_batch_initrd(struct fdt_batch *batch, ulong initrd_start,
+		     ulong initrd_end)
+{
+	int chosen;
 
 	/* just return if the size of initrd is zero */
 	if (initrd_start == initrd_end)
 		return 0;
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
-	if (nodeoffset < 0)
-		return nodeoffset;
-
-	total = fdt_num_mem_rsv(fdt);
-
-	/*
-	 * Look for an existing entry and update it.  If we don't find
-	 * the entry, we will j be the next available slot.
-	 */
-	for (j = 0; j < total; j++) {
-		err = fdt_get_mem_rsv(fdt, j, &addr, &size);
-		if (addr == initrd_start) {
-			fdt_del_mem_rsv(fdt, j);
-			break;
-		}
+	chosen = fdt_batch_subnode(batch, fdt_batch_node(batch, 0), "chosen");
+
+	/* Replace any existing entry for the same address */
+	fdt_batch_del_mem_rsv(batch, initrd_start);
+	fdt_batch_add_mem_rsv(batch, initrd_start, initrd_end - initrd_start);
+
+	if (fdt_address_cells(batch->fdt, 0) == 2) {
+		fdt_batch_setprop_u64(batch, chosen, "linux,initrd-start",
+				      initrd_start);
+		fdt_batch_setprop_u64(batch, chosen, "linux,initrd-end",
+				      initrd_end);
+	} else {
+		fdt_batch_setprop_u32(batch, chosen, "linux,initrd-start",
+				      initrd_start);
+		fdt_batch_setprop_u32(batch, chosen, "linux,initrd-end",
+				      initrd_end);
 	}
 
-	err = fdt_add_mem_rsv(fdt, initrd_start, initrd_end - initrd_start);
-	if (err < 0) {
-		printf("fdt_initrd: %s\n", fdt_strerror(err));
-		return err;
-	}
+	return batch->err;
+}
 
-	is_u64 = (fdt_address_cells(fdt, 0) == 2);
+int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
+{
+	struct fdt_batch batch;
 
-	err = fdt_setprop_uxx(fdt, nodeoffset, "linux,initrd-start",
-			      (uint64_t)initrd_start, is_u64);
+	fdt_batch_init(&batch, fdt);
 
-	if (err < 0) {
-		printf("WARNING: could not set linux,initrd-start %s.\n",
-		       fdt_strerror(err));
-		return err;
-	}
+	return fdt_batch_finish(&batch, __func__,
+				fdt_batch_initrd(&batch, initrd_start,
+						 initrd_end));
+}
 
-	err = fdt_setprop_uxx(fdt, nodeoffset, "linux,initrd-end",
-			      (uint64_t)initrd_end, is_u64);
+int fdt_batch_chosen(struct fdt_batch *batch)
+{
+	int chosen;
+	char *str;		/* used to set string properties */
 
-	if (err < 0) {
-		printf("WARNING: could not set linux,initrd-end %s.\n",
-		       fdt_strerror(err));
+	/* find or create "/chosen" node. */
+	chosen = fdt_batch_subnode(batch, fdt_batch_node(batch, 0), "chosen");
 
-		return err;
-	}
+	str = getenv("bootargs");
+	if (str)
+		fdt_batch_setprop_string(batch, chosen, "bootargs", str);
 
-	return 0;
+	fdt_fixup_stdout(batch, chosen);
+
+	return batch->err;
 }
 
 int fdt_chosen(void *fdt)
 {
-	int   nodeoffset;
-	int   err;
-	char  *str;		/* used to set string properties */
-
-	err = fdt_check_header(fdt);
-	if (err < 0) {
-		printf("fdt_chosen: %s\n", fdt_strerror(err));
-		return err;
-	}
-
-	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
-	if (nodeoffset < 0)
-		return nodeoffset;
+	struct fdt_batch batch;
 
-	str = getenv("bootargs");
-	if (str) {
-		err = fdt_setprop(fdt, nodeoffset, "bootargs", str,
-				  strlen(str) + 1);
-		if (err < 0) {
-			printf("WARNING: could not set bootargs %s.\n",
-			       fdt_strerror(err));
-			return err;
-		}
-	}
+	fdt_batch_init(&batch, fdt);
 
-	return fdt_fixup_stdout(fdt, nodeoffset);
+	return fdt_batch_finish(&batch, __func__, fdt_batch_chosen(&batch));
 }
 
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
@@ -414,9 +1146,10 @@ static int fdt_pack_reg(const void *fdt, void *buf, u64 *address, u64 *size,
 #else
 #define MEMORY_BANKS_MAX 4
 #endif
-int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
+int fdt_batch_fixup_memory_banks(struct fdt_batch *batch, u64 start[],
+				 u64 size[], int banks)
 {
-	int err, nodeoffset;
+	int memory;
 	int len;
 	u8 tmp[MEMORY_BANKS_MAX * 16]; /* Up to 64-bit address + 64-bit size */
 
@@ -427,37 +1160,29 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 		return -1;
 	}
 
-	err = fdt_check_header(blob);
-	if (err < 0) {
-		printf("%s: %s\n", __FUNCTION__, fdt_strerror(err));
-		return err;
-	}
-
 	/* find or create "/memory" node. */
-	nodeoffset = fdt_find_or_add_subnode(blob, 0, "memory");
-	if (nodeoffset < 0)
-			return nodeoffset;
+	memory = fdt_batch_subnode(batch, fdt_batch_node(batch, 0), "memory");
 
-	err = fdt_setprop(blob, nodeoffset, "device_type", "memory",
-			sizeof("memory"));
-	if (err < 0) {
-		printf("WARNING: could not set %s %s.\n", "device_type",
-				fdt_strerror(err));
-		return err;
+	fdt_batch_setprop(batch, memory, "device_type", "memory",
+			  sizeof("memory"));
+
+	if (banks && !batch->err) {
+		len = fdt_pack_reg(batch->fdt, tmp, start, size, banks);
+		fdt_batch_setprop(batch, memory, "reg", tmp, len);
 	}
 
-	if (!banks)
-		return 0;
+	return batch->err;
+}
 
-	len = fdt_pack_reg(blob, tmp, start, size, banks);
+int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
+{
+	struct fdt_batch batch;
 
-	err = fdt_setprop(blob, nodeoffset, "reg", tmp, len);
-	if (err < 0) {
-		printf("WARNING: could not set %s %s.\n",
-				"reg", fdt_strerror(err));
-		return err;
-	}
-	return 0;
+	fdt_batch_init(&batch, blob);
+
+	return fdt_batch_finish(&batch, __func__,
+				fdt_batch_fixup_memory_banks(&batch, start,
+							     size, banks));
 }
 
 int fdt_fixup_memory(void *blob, u64 start, u64 size)
@@ -465,33 +1190,26 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 	return fdt_fixup_memory_banks(blob, &start, &size, 1);
 }
 
-void fdt_fixup_ethernet(void *fdt)
+void fdt_batch_fixup_ethernet(struct fdt_batch *batch)
 {
-	int i, j, prop;
+	const void *fdt = batch->fdt;
+	int i, j, node, aliases;
 	char *tmp, *end;
 	char mac[16];
 	const char *path;
 	unsigned char mac_addr[6];
 	int offset;
 
-	if (fdt_path_offset(fdt, "/aliases") < 0)
+	aliases = fdt_path_offset(fdt, "/aliases");
+	if (aliases < 0)
 		return;
 
 	/* Cycle through all aliases */
-	for (prop = 0; ; prop++) {
+	for (offset = fdt_first_property_offset(fdt, aliases); offset >= 0;
+	     offset = fdt_next_property_offset(fdt, offset)) {
 		const char *name;
 		int len = strlen("ethernet");
 
-		/* FDT might have been edited, recompute the offset */
-		offset = fdt_first_property_offset(fdt,
-			fdt_path_offset(fdt, "/aliases"));
-		/* Select property number 'prop' */
-		for (i = 0; i < prop; i++)
-			offset = fdt_next_property_offset(fdt, offset);
-
-		if (offset < 0)
-			break;
-
 		path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
 		if (!strncmp(name, "ethernet", len)) {
 			i = trailing_strtol(name);
@@ -514,14 +1232,32 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			node = fdt_path_offset(fdt, path);
+			if (node < 0) {
+				printf("Unable to update property %s:%s, err=%s\n",
+				       path, "local-mac-address",
+				       fdt_strerror(node));
+				continue;
+			}
+			if (fdt_get_property(fdt, node, "mac-address", NULL))
+				fdt_batch_setprop(batch,
+						  fdt_batch_node(batch, node),
+						  "mac-address", mac_addr, 6);
+			fdt_batch_setprop(batch, fdt_batch_node(batch, node),
+					  "local-mac-address", mac_addr, 6);
 		}
 	}
 }
 
+void fdt_fixup_ethernet(void *fdt)
+{
+	struct fdt_batch batch;
+
+	fdt_batch_init(&batch, fdt);
+	fdt_batch_fixup_ethernet(&batch);
+	fdt_batch_finish(&batch, __func__, 0);
+}
+
 /* Resize the fdt to its actual size + a bit of padding */
 int fdt_shrink_to_minimum(void *blob)
 {
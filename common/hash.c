@@ -28,6 +28,7 @@
 #include <u-boot/crc.h>
 #include <u-boot/sha1.h>
 #include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
 #include <u-boot/md5.h>
 
 #ifdef CONFIG_SHA1
@@ -86,6 +87,53 @@ static int hash_finish_sha256(struct hash_algo *algo, void *ctx, void
 }
 #endif
 
+#ifdef CONFIG_SHA512
+static int hash_init_sha384(struct hash_algo *algo, void **ctxp)
+{
+	sha512_context *ctx = malloc(sizeof(sha512_context));
+	sha384_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_init_sha512(struct hash_algo *algo, void **ctxp)
+{
+	sha512_context *ctx = malloc(sizeof(sha512_context));
+	sha512_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_sha512(struct hash_algo *algo, void *ctx,
+			      const void *buf, unsigned int size, int is_last)
+{
+	sha512_update((sha512_context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_sha384(struct hash_algo *algo, void *ctx, void
+			      *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	sha384_finish((sha512_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+
+static int hash_finish_sha512(struct hash_algo *algo, void *ctx, void
+			      *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	sha512_finish((sha512_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+#endif
+
 static int hash_init_crc32(struct hash_algo *algo, void **ctxp)
 {
 	uint32_t *ctx = malloc(sizeof(uint32_t));
@@ -166,6 +214,28 @@ static struct hash_algo hash_algo[] = {
 		hash_update_sha256,
 		hash_finish_sha256,
 	},
+#endif
+#ifdef CONFIG_SHA384
+	{
+		"sha384",
+		SHA384_SUM_LEN,
+		sha384_csum_wd,
+		CHUNKSZ_SHA384,
+		hash_init_sha384,
+		hash_update_sha512,
+		hash_finish_sha384,
+	},
+#endif
+#ifdef CONFIG_SHA512
+	{
+		"sha512",
+		SHA512_SUM_LEN,
+		sha512_csum_wd,
+		CHUNKSZ_SHA512,
+		hash_init_sha512,
+		hash_update_sha512,
+		hash_finish_sha512,
+	},
 #endif
 	{
 		"crc32",
@@ -178,7 +248,8 @@ static struct hash_algo hash_algo[] = {
 	},
 };
 
-#if defined(CONFIG_SHA256) || defined(CONFIG_CMD_SHA1SUM)
+#if defined(CONFIG_SHA256) || defined(CONFIG_SHA512) || \
+	defined(CONFIG_CMD_SHA1SUM)
 #define MULTI_HASH
 #endif
 
@@ -391,6 +462,30 @@ static void hash_show(struct hash_algo *algo, ulong addr, ulong len, uint8_t *ou
 		printf("%02x", output[i]);
 }
 
+#ifdef CONFIG_CMD_HASH
+int hash_bench(ulong addr, ulong len)
+{
+	uint8_t output[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	ulong start, us;
+	void *buf;
+	int i;
+
+	buf = map_sysmem(addr, len);
+	printf("Hashing %lu bytes at %08lx\n", len, addr);
+	for (i = 0; i < ARRAY_SIZE(hash_algo); i++) {
+		algo = &hash_algo[i];
+		start = timer_get_us();
+		algo->hash_func_ws(buf, len, output, algo->chunk_size);
+		us = max(timer_get_us() - start, 1UL);
+		printf("%-8s %8lu us %6lu MB/s\n", algo->name, us, len / us);
+	}
+	unmap_sysmem(buf);
+
+	return 0;
+}
+#endif
+
 int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 		 int argc, char * const argv[])
 {
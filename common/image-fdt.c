@@ -463,14 +463,27 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 {
 	ulong *initrd_start = &images->initrd_start;
 	ulong *initrd_end = &images->initrd_end;
+	struct fdt_batch batch;
 	int ret = -EPERM;
 	int fdt_ret;
 
-	if (fdt_root(blob) < 0) {
+	/*
+	 * The generic fixups are made in two batches, each rewriting the
+	 * tree once. The first must be done before the hooks below, which
+	 * edit the tree directly and may expect to find /chosen set up.
+	 */
+	fdt_batch_init(&batch, blob);
+	if (fdt_batch_root(&batch) < 0) {
 		printf("ERROR: root node setup failed\n");
+		fdt_batch_abort(&batch);
 		goto err;
 	}
-	if (fdt_chosen(blob) < 0) {
+	fdt_ret = fdt_batch_chosen(&batch);
+	if (fdt_ret < 0)
+		fdt_batch_abort(&batch);
+	else
+		fdt_ret = fdt_batch_commit(&batch);
+	if (fdt_ret < 0) {
 		printf("ERROR: /chosen node create failed\n");
 		goto err;
 	}
@@ -496,7 +509,14 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 			goto err;
 		}
 	}
-	fdt_fixup_ethernet(blob);
+
+	fdt_batch_init(&batch, blob);
+	fdt_batch_fixup_ethernet(&batch);
+	fdt_batch_initrd(&batch, *initrd_start, *initrd_end);
+	fdt_ret = fdt_batch_commit(&batch);
+	if (fdt_ret < 0)
+		printf("WARNING: fdt fixup failed: %s\n",
+		       fdt_strerror(fdt_ret));
 
 	/* Delete the old LMB reservation */
 	if (lmb)
@@ -508,15 +528,10 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		goto err;
 	of_size = ret;
 
-	if (*initrd_start && *initrd_end) {
-		of_size += FDT_RAMDISK_OVERHEAD;
-		fdt_set_totalsize(blob, of_size);
-	}
 	/* Create a new LMB reservation */
 	if (lmb)
 		lmb_reserve(lmb, (ulong)blob, of_size);
 
-	fdt_initrd(blob, *initrd_start, *initrd_end);
 	if (!ft_verify_fdt(blob))
 		goto err;
 
@@ -15,7 +15,9 @@
 #else
 #include <linux/compiler.h>
 #include <common.h>
+#include <cpu_work.h>
 #include <errno.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
 DECLARE_GLOBAL_DATA_PTR;
@@ -941,8 +943,108 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+#if IMAGE_ENABLE_PARALLEL_HASH
+/* Maximum number of hashes calculated in parallel by one verification */
+#define FIT_MAX_HASH_JOBS	16
+
+/* A hash calculated on a secondary CPU */
+struct fit_hash_job {
+	struct cpu_work work;
+	int noffset;
+	const void *data;
+	size_t size;
+	char *algo;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+};
+
+struct fit_hash_jobs {
+	int count;
+	struct fit_hash_job job[FIT_MAX_HASH_JOBS];
+};
+
+static void fit_hash_job_run(void *arg)
+{
+	struct fit_hash_job *job = arg;
+
+	job->ret = calculate_hash(job->data, job->size, job->algo, job->value,
+				  &job->value_len);
+}
+
+/*
+ * Queue calculation of the hashes of an image, so that they can run in
+ * parallel with each other and with any other hashes already queued
+ */
+static void fit_image_queue_hashes(const void *fit, int image_noffset,
+				   struct fit_hash_jobs *jobs)
+{
+	struct fit_hash_job *job;
+	const void *data;
+	size_t size;
+	int noffset;
+	int ignore;
+	char *algo;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size))
+		return;
+
+	fdt_for_each_subnode(fit, noffset, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (jobs->count == FIT_MAX_HASH_JOBS)
+			return;
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)) ||
+		    fit_image_hash_get_algo(fit, noffset, &algo))
+			continue;
+		ignore = 0;
+		if (IMAGE_ENABLE_IGNORE)
+			fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (ignore)
+			continue;
+
+		job = &jobs->job[jobs->count++];
+		job->noffset = noffset;
+		job->data = data;
+		job->size = size;
+		job->algo = algo;
+		job->work.func = fit_hash_job_run;
+		job->work.arg = job;
+		cpu_work_queue(&job->work);
+	}
+}
+
+/* Find the queued calculation for a hash node and wait for it to finish */
+static struct fit_hash_job *fit_hash_job_get(struct fit_hash_jobs *jobs,
+					     int noffset)
+{
+	int i;
+
+	for (i = 0; jobs && i < jobs->count; i++) {
+		if (jobs->job[i].noffset == noffset) {
+			cpu_work_wait(&jobs->job[i].work);
+			return &jobs->job[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void fit_hash_jobs_wait(struct fit_hash_jobs *jobs)
+{
+	int i;
+
+	for (i = 0; i < jobs->count; i++)
+		cpu_work_wait(&jobs->job[i].work);
+}
+#else
+struct fit_hash_jobs;
+#endif /* IMAGE_ENABLE_PARALLEL_HASH */
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
-				size_t size, char **err_msgp)
+				size_t size, struct fit_hash_jobs *jobs,
+				char **err_msgp)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	int value_len;
@@ -950,6 +1052,9 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+#if IMAGE_ENABLE_PARALLEL_HASH
+	struct fit_hash_job *job;
+#endif
 
 	*err_msgp = NULL;
 
@@ -973,6 +1078,17 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
+#if IMAGE_ENABLE_PARALLEL_HASH
+	job = fit_hash_job_get(jobs, noffset);
+	if (job) {
+		if (job->ret) {
+			*err_msgp = "Unsupported hash algorithm";
+			return -1;
+		}
+		memcpy(value, job->value, job->value_len);
+		value_len = job->value_len;
+	} else
+#endif
 	if (calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
@@ -989,6 +1105,172 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	return 0;
 }
 
+#if IMAGE_ENABLE_STREAM_VERIFY
+/* Free the hashing contexts from index @start onwards */
+static void fit_image_hash_free(struct fit_hash_stream *hs, int start)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	struct hash_algo *algo;
+	int i;
+
+	for (i = start; i < hs->count; i++) {
+		algo = hs->algo[i];
+		if (algo && hs->ctx[i])
+			algo->hash_finish(algo, hs->ctx[i], value,
+					  sizeof(value));
+		hs->ctx[i] = NULL;
+	}
+}
+
+int fit_image_hash_start(const void *fit, int image_noffset,
+			 struct fit_hash_stream *hs)
+{
+	const void *sig_blob = gd_fdt_blob();
+	struct hash_algo *algo;
+	int noffset, sig_node;
+	int count = 0;
+	char *name;
+	int ignore;
+	int ret;
+
+	/*
+	 * With a required key, the data must not be decompressed before its
+	 * hash is checked. An image signature needs all the data at once,
+	 * and a configuration signature only covers the hash values.
+	 */
+	sig_node = sig_blob ? fdt_subnode_offset(sig_blob, 0, FIT_SIG_NODENAME) :
+		-FDT_ERR_NOTFOUND;
+	if (IMAGE_ENABLE_VERIFY && sig_node >= 0) {
+		fdt_for_each_subnode(sig_blob, noffset, sig_node) {
+			if (fdt_getprop(sig_blob, noffset, "required", NULL))
+				return -EOPNOTSUPP;
+		}
+	}
+
+	fdt_for_each_subnode(fit, noffset, image_noffset) {
+		name = (char *)fit_get_name(fit, noffset, NULL);
+
+		if (!strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+			return -EOPNOTSUPP;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (count == FIT_MAX_STREAM_HASHES ||
+		    fit_image_hash_get_algo(fit, noffset, &name))
+			return -EOPNOTSUPP;
+
+		ignore = 0;
+		if (IMAGE_ENABLE_IGNORE)
+			fit_image_hash_get_ignore(fit, noffset, &ignore);
+		algo = NULL;
+		if (!ignore && hash_progressive_lookup_algo(name, &algo))
+			return -EOPNOTSUPP;
+		if (hs) {
+			hs->noffset[count] = noffset;
+			hs->algo[count] = algo;
+		}
+		count++;
+	}
+
+	if (!hs)
+		return 0;
+
+	hs->fit = fit;
+	hs->image_noffset = image_noffset;
+	hs->count = count;
+	for (count = 0; count < hs->count; count++) {
+		hs->ctx[count] = NULL;
+		algo = hs->algo[count];
+		if (!algo)
+			continue;
+		ret = algo->hash_init(algo, &hs->ctx[count]);
+		if (ret) {
+			hs->count = count;
+			fit_image_hash_free(hs, 0);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+int fit_image_hash_update(struct fit_hash_stream *hs, const void *buf,
+			  unsigned int size, int is_last)
+{
+	struct hash_algo *algo;
+	int ret;
+	int i;
+
+	for (i = 0; i < hs->count; i++) {
+		algo = hs->algo[i];
+		if (!algo)
+			continue;
+		ret = algo->hash_update(algo, hs->ctx[i], buf, size, is_last);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int fit_image_hash_finish(struct fit_hash_stream *hs)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	const void *fit = hs->fit;
+	struct hash_algo *algo;
+	uint8_t *fit_value;
+	int fit_value_len;
+	char *err_msg = NULL;
+	int noffset = 0;
+	int ret;
+	int i;
+
+	for (i = 0; i < hs->count; i++) {
+		noffset = hs->noffset[i];
+		algo = hs->algo[i];
+		if (!algo) {
+			printf("%s-skipped + ", (char *)fdt_getprop(fit,
+					noffset, FIT_ALGO_PROP, NULL));
+			continue;
+		}
+		printf("%s", algo->name);
+
+		ret = algo->hash_finish(algo, hs->ctx[i], value, sizeof(value));
+		hs->ctx[i] = NULL;
+		if (ret) {
+			err_msg = "Unsupported hash algorithm";
+			break;
+		}
+		/* FIT stores the CRC32 big-endian, as calculate_hash() does */
+		if (!strcmp(algo->name, "crc32"))
+			*(uint32_t *)value = cpu_to_uimage(*(uint32_t *)value);
+
+		if (fit_image_hash_get_value(fit, noffset, &fit_value,
+					     &fit_value_len)) {
+			err_msg = "Can't get hash value property";
+			break;
+		}
+		if (algo->digest_size != fit_value_len) {
+			err_msg = "Bad hash value len";
+			break;
+		} else if (memcmp(value, fit_value, fit_value_len) != 0) {
+			err_msg = "Bad hash value";
+			break;
+		}
+		puts("+ ");
+	}
+
+	if (!err_msg)
+		return 1;
+
+	fit_image_hash_free(hs, i);
+	printf(" error!\n%s for '%s' hash node in '%s' image node\n",
+	       err_msg, fit_get_name(fit, noffset, NULL),
+	       fit_get_name(fit, hs->image_noffset, NULL));
+
+	return 0;
+}
+#endif /* IMAGE_ENABLE_STREAM_VERIFY */
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
@@ -1002,7 +1284,8 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
  *     1, if all hashes are valid
  *     0, otherwise (or on error)
  */
-int fit_image_verify(const void *fit, int image_noffset)
+static int fit_image_verify_jobs(const void *fit, int image_noffset,
+				 struct fit_hash_jobs *jobs)
 {
 	const void	*data;
 	size_t		size;
@@ -1037,7 +1320,7 @@ int fit_image_verify(const void *fit, int image_noffset)
 		if (!strncmp(name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
 			if (fit_image_check_hash(fit, noffset, data, size,
-						 &err_msg))
+						 jobs, &err_msg))
 				goto error;
 			puts("+ ");
 		} else if (IMAGE_ENABLE_VERIFY && verify_all &&
@@ -1073,6 +1356,24 @@ error:
 	return 0;
 }
 
+int fit_image_verify(const void *fit, int image_noffset)
+{
+#if IMAGE_ENABLE_PARALLEL_HASH
+	struct fit_hash_jobs jobs;
+	int ret;
+
+	/* Calculate the hashes in parallel, while checking signatures */
+	jobs.count = 0;
+	fit_image_queue_hashes(fit, image_noffset, &jobs);
+	ret = fit_image_verify_jobs(fit, image_noffset, &jobs);
+	fit_hash_jobs_wait(&jobs);
+
+	return ret;
+#else
+	return fit_image_verify_jobs(fit, image_noffset, NULL);
+#endif
+}
+
 /**
  * fit_all_image_verify - verify data integrity for all images
  * @fit: pointer to the FIT format image header
@@ -1086,10 +1387,12 @@ error:
  */
 int fit_all_image_verify(const void *fit)
 {
+	struct fit_hash_jobs *jobs = NULL;
 	int images_noffset;
 	int noffset;
 	int ndepth;
 	int count;
+	int ret = 1;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1099,6 +1402,15 @@ int fit_all_image_verify(const void *fit)
 		return 0;
 	}
 
+#if IMAGE_ENABLE_PARALLEL_HASH
+	/* Start calculating the hashes of all images at once */
+	jobs = calloc(1, sizeof(*jobs));
+	if (jobs) {
+		fdt_for_each_subnode(fit, noffset, images_noffset)
+			fit_image_queue_hashes(fit, noffset, jobs);
+	}
+#endif
+
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 	       (ulong)fit);
@@ -1115,12 +1427,21 @@ int fit_all_image_verify(const void *fit)
 			       fit_get_name(fit, noffset, NULL));
 			count++;
 
-			if (!fit_image_verify(fit, noffset))
-				return 0;
+			if (!fit_image_verify_jobs(fit, noffset, jobs)) {
+				ret = 0;
+				break;
+			}
 			printf("\n");
 		}
 	}
-	return 1;
+#if IMAGE_ENABLE_PARALLEL_HASH
+	if (jobs) {
+		fit_hash_jobs_wait(jobs);
+		free(jobs);
+	}
+#endif
+
+	return ret;
 }
 
 /**
@@ -1603,6 +1924,30 @@ static const char *fit_get_image_type_property(int type)
 	return "unknown";
 }
 
+/*
+ * Check whether the hashes of a compressed image can be checked while it is
+ * decompressed, so that its data is only read once
+ */
+static int fit_image_can_stream(const void *fit, int noffset)
+{
+#if IMAGE_ENABLE_STREAM_VERIFY
+	uint8_t comp;
+
+	if (fit_image_get_comp(fit, noffset, &comp))
+		return 0;
+	switch (comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4:
+#endif
+		return !fit_image_hash_start(fit, noffset, NULL);
+	}
+#endif
+	return 0;
+}
+
 int fit_image_load(bootm_headers_t *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int image_type, int bootstage_id,
@@ -1618,6 +1963,7 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	ulong load, data, len;
 	uint8_t os;
 	const char *prop_name;
+	int verify;
 	int ret;
 
 	fit = map_sysmem(addr, 0);
@@ -1686,7 +2032,18 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
 
-	ret = fit_image_select(fit, noffset, images->verify);
+	verify = images->verify;
+	if (image_type == IH_TYPE_KERNEL) {
+		images->fit_verify_os = 0;
+		if (IMAGE_ENABLE_STREAM_VERIFY && verify &&
+		    load_op == FIT_LOAD_IGNORED &&
+		    fit_image_can_stream(fit, noffset)) {
+			/* bootm_load_os() checks the hashes as it decompresses */
+			images->fit_verify_os = 1;
+			verify = 0;
+		}
+	}
+	ret = fit_image_select(fit, noffset, verify);
 	if (ret) {
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
 		return ret;
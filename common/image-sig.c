@@ -13,6 +13,7 @@
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 #include <image.h>
+#include <u-boot/ecdsa.h>
 #include <u-boot/rsa.h>
 #include <u-boot/rsa-checksum.h>
 
@@ -60,6 +61,16 @@ struct checksum_algo checksum_algos[] = {
 #endif
 		hash_calculate,
 		padding_sha256_rsa4096,
+	},
+	{
+		"sha256",
+		SHA256_SUM_LEN,
+		SHA256_SUM_LEN,
+#if IMAGE_ENABLE_SIGN
+		EVP_sha256,
+#endif
+		hash_calculate,
+		NULL,
 	}
 
 };
@@ -85,6 +96,13 @@ struct image_sig_algo image_sig_algos[] = {
 		rsa_add_verify_data,
 		rsa_verify,
 		&checksum_algos[2],
+	},
+	{
+		"sha256,ecdsa256",
+		ecdsa_sign,
+		ecdsa_add_verify_data,
+		ecdsa_verify,
+		&checksum_algos[3],
 	}
 
 };
@@ -91,18 +91,21 @@ int device_unbind(struct udevice *dev)
 	if (ret)
 		return ret;
 
-	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
-		dev->platdata = NULL;
+	/* A packed device's data is freed along with the device */
+	if (!(dev->flags & DM_FLAG_PACKED)) {
+		if (dev->flags & DM_FLAG_ALLOC_PDATA)
+			free(dev->platdata);
+		if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA)
+			free(dev->uclass_platdata);
+		if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA)
+			free(dev->parent_platdata);
 	}
-	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+	if (dev->flags & DM_FLAG_ALLOC_PDATA)
+		dev->platdata = NULL;
+	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA)
 		dev->uclass_platdata = NULL;
-	}
-	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev->parent_platdata);
+	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA)
 		dev->parent_platdata = NULL;
-	}
 	ret = uclass_unbind_device(dev);
 	if (ret)
 		return ret;
@@ -125,27 +128,34 @@ int device_unbind(struct udevice *dev)
  */
 void device_free(struct udevice *dev)
 {
+	bool packed = dev->flags & DM_FLAG_PACKED;
 	int size;
 
+	/* A packed device's private data is one block, from the first area */
+	if (packed) {
+		if (dev->driver->priv_auto_alloc_size)
+			free(dev->priv);
+		else if (dev->uclass->uc_drv->per_device_auto_alloc_size)
+			free(dev->uclass_priv);
+		else if (device_child_size(dev->parent, false))
+			free(dev->parent_priv);
+	}
+
 	if (dev->driver->priv_auto_alloc_size) {
-		free(dev->priv);
+		if (!packed)
+			free(dev->priv);
 		dev->priv = NULL;
 	}
 	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
 	if (size) {
-		free(dev->uclass_priv);
+		if (!packed)
+			free(dev->uclass_priv);
 		dev->uclass_priv = NULL;
 	}
-	if (dev->parent) {
-		size = dev->parent->driver->per_child_auto_alloc_size;
-		if (!size) {
-			size = dev->parent->uclass->uc_drv->
-					per_child_auto_alloc_size;
-		}
-		if (size) {
+	if (device_child_size(dev->parent, false)) {
+		if (!packed)
 			free(dev->parent_priv);
-			dev->parent_priv = NULL;
-		}
+		dev->parent_priv = NULL;
 	}
 
 	devres_release_probe(dev);
@@ -189,7 +199,8 @@ int device_remove(struct udevice *dev)
 
 	device_free(dev);
 
-	dev->seq = -1;
+	uclass_set_seq(dev, -1);
+	device_probe_cancel(dev);
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
 	return ret;
@@ -17,8 +17,10 @@
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/ofnode.h>
 #include <dm/pinctrl.h>
 #include <dm/platdata.h>
+#include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -27,6 +29,56 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+int device_child_size(struct udevice *parent, bool plat)
+{
+	int size;
+
+	if (!parent)
+		return 0;
+	if (plat) {
+		size = parent->driver->per_child_platdata_auto_alloc_size;
+		if (!size)
+			size = parent->uclass->uc_drv->
+					per_child_platdata_auto_alloc_size;
+	} else {
+		size = parent->driver->per_child_auto_alloc_size;
+		if (!size)
+			size = parent->uclass->uc_drv->
+					per_child_auto_alloc_size;
+	}
+
+	return size;
+}
+
+/*
+ * A packed device is a single allocation holding struct udevice followed by
+ * the data allocated when it is bound. The data allocated when it is probed
+ * is a second allocation, made by device_alloc_priv_block().
+ */
+static int device_packed_size(int pdata_size, struct uclass *uc,
+			      struct udevice *parent)
+{
+	return DM_PACK_SIZE(sizeof(struct udevice)) +
+		DM_PACK_SIZE(pdata_size) +
+		DM_PACK_SIZE(uc->uc_drv->per_device_platdata_auto_alloc_size) +
+		DM_PACK_SIZE(device_child_size(parent, true));
+}
+
+/* Allocate data for a device being bound, from the device if packed */
+static void *device_alloc_bind(struct udevice *dev, void **nextp, void *end,
+			       int size)
+{
+	void *ptr;
+
+	if (!(dev->flags & DM_FLAG_PACKED))
+		return calloc(1, size);
+	ptr = *nextp;
+	*nextp += DM_PACK_SIZE(size);
+	assert(*nextp <= end);
+
+	return ptr;
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *platdata,
 			      ulong driver_data, int of_offset,
@@ -34,7 +86,10 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 {
 	struct udevice *dev;
 	struct uclass *uc;
+	void *next = NULL, *end = NULL;
 	int size, ret = 0;
+	bool alloc_pdata;
+	bool pack;
 
 	if (devp)
 		*devp = NULL;
@@ -47,9 +102,26 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		return ret;
 	}
 
-	dev = calloc(1, sizeof(struct udevice));
+	/* Drivers needing DMA-aligned private data are allocated separately */
+	pack = CONFIG_IS_ENABLED(DM_PACK) &&
+		!(drv->flags & DM_FLAG_ALLOC_PRIV_DMA);
+
+	/* Allocate platdata unless the caller provides all of it */
+	alloc_pdata = drv->platdata_auto_alloc_size && (!platdata ||
+		(CONFIG_IS_ENABLED(OF_PLATDATA) && of_platdata_size &&
+		 of_platdata_size < drv->platdata_auto_alloc_size));
+	size = pack ? device_packed_size(alloc_pdata ?
+					 drv->platdata_auto_alloc_size : 0,
+					 uc, parent) :
+		sizeof(struct udevice);
+	dev = calloc(1, size);
 	if (!dev)
 		return -ENOMEM;
+	if (pack) {
+		dev->flags |= DM_FLAG_PACKED;
+		next = (void *)dev + DM_PACK_SIZE(sizeof(struct udevice));
+		end = (void *)dev + size;
+	}
 
 	INIT_LIST_HEAD(&dev->sibling_node);
 	INIT_LIST_HEAD(&dev->child_head);
@@ -85,20 +157,12 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	}
 
 	if (drv->platdata_auto_alloc_size) {
-		bool alloc = !platdata;
-
-		if (CONFIG_IS_ENABLED(OF_PLATDATA)) {
-			if (of_platdata_size) {
-				dev->flags |= DM_FLAG_OF_PLATDATA;
-				if (of_platdata_size <
-						drv->platdata_auto_alloc_size)
-					alloc = true;
-			}
-		}
-		if (alloc) {
+		if (CONFIG_IS_ENABLED(OF_PLATDATA) && of_platdata_size)
+			dev->flags |= DM_FLAG_OF_PLATDATA;
+		if (alloc_pdata) {
 			dev->flags |= DM_FLAG_ALLOC_PDATA;
-			dev->platdata = calloc(1,
-					       drv->platdata_auto_alloc_size);
+			dev->platdata = device_alloc_bind(dev, &next, end,
+					drv->platdata_auto_alloc_size);
 			if (!dev->platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc1;
@@ -113,7 +177,8 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	size = uc->uc_drv->per_device_platdata_auto_alloc_size;
 	if (size) {
 		dev->flags |= DM_FLAG_ALLOC_UCLASS_PDATA;
-		dev->uclass_platdata = calloc(1, size);
+		dev->uclass_platdata = device_alloc_bind(dev, &next, end,
+							 size);
 		if (!dev->uclass_platdata) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
@@ -121,14 +186,11 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	}
 
 	if (parent) {
-		size = parent->driver->per_child_platdata_auto_alloc_size;
-		if (!size) {
-			size = parent->uclass->uc_drv->
-					per_child_platdata_auto_alloc_size;
-		}
+		size = device_child_size(parent, true);
 		if (size) {
 			dev->flags |= DM_FLAG_ALLOC_PARENT_PDATA;
-			dev->parent_platdata = calloc(1, size);
+			dev->parent_platdata = device_alloc_bind(dev, &next,
+								 end, size);
 			if (!dev->parent_platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
@@ -191,18 +253,21 @@ fail_uclass_bind:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		list_del(&dev->sibling_node);
 		if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-			free(dev->parent_platdata);
+			if (!pack)
+				free(dev->parent_platdata);
 			dev->parent_platdata = NULL;
 		}
 	}
 fail_alloc3:
 	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+		if (!pack)
+			free(dev->uclass_platdata);
 		dev->uclass_platdata = NULL;
 	}
 fail_alloc2:
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+		if (!pack)
+			free(dev->platdata);
 		dev->platdata = NULL;
 	}
 fail_alloc1:
@@ -264,7 +329,277 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+/* Hand out the next area of a packed device's private data block */
+static void *device_take_priv(void **nextp, void *end, int size)
+{
+	void *ptr;
+
+	if (!size)
+		return NULL;
+	ptr = *nextp;
+	*nextp += DM_PACK_SIZE(size);
+	assert(*nextp <= end);
+
+	return ptr;
+}
+
+/*
+ * Allocate the private data of a packed device being probed, its own then
+ * its uclass's then its parent's, as a single block
+ */
+static int device_alloc_priv_block(struct udevice *dev)
+{
+	int priv_size = dev->driver->priv_auto_alloc_size;
+	int uc_size = dev->uclass->uc_drv->per_device_auto_alloc_size;
+	int parent_size = device_child_size(dev->parent, false);
+	void *next, *end;
+	int size;
+
+	/* Nothing to do if not needed, or if reentered */
+	size = DM_PACK_SIZE(priv_size) + DM_PACK_SIZE(uc_size) +
+		DM_PACK_SIZE(parent_size);
+	if (!size || (priv_size && dev->priv) ||
+	    (uc_size && dev->uclass_priv) ||
+	    (parent_size && dev->parent_priv))
+		return 0;
+	next = calloc(1, size);
+	if (!next)
+		return -ENOMEM;
+	end = next + size;
+
+	dev->priv = device_take_priv(&next, end, priv_size);
+	dev->uclass_priv = device_take_priv(&next, end, uc_size);
+	dev->parent_priv = device_take_priv(&next, end, parent_size);
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/*
+ * Devices whose probe() has returned -EINPROGRESS. These are polled in turn
+ * by dm_probe_poll(), so that their slow operations overlap.
+ */
+static struct udevice *probe_pending[CONFIG_DM_PROBE_ASYNC_MAX];
+static int probe_pending_count;
+static bool probe_polling;
+
+/*
+ * A device being waited for in device_probe_wait(). While the other devices
+ * are polled, one of their probe() methods may wait for the same device and
+ * finish probing it, so this records how that went.
+ */
+struct probe_waiter {
+	struct udevice *dev;
+	int ret;
+	struct probe_waiter *next;
+};
+static struct probe_waiter *probe_waiters;
+
+static int device_probe_find_pending(struct udevice *dev)
+{
+	int i;
+
+	for (i = 0; i < probe_pending_count; i++) {
+		if (probe_pending[i] == dev)
+			return i;
+	}
+
+	return -ENOENT;
+}
+
+void device_probe_cancel(struct udevice *dev)
+{
+	int i;
+
+	dev->flags &= ~DM_FLAG_PROBING;
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+	i = device_probe_find_pending(dev);
+	if (i < 0)
+		return;
+	probe_pending_count--;
+	memmove(&probe_pending[i], &probe_pending[i + 1],
+		(probe_pending_count - i) * sizeof(probe_pending[0]));
+}
+
+/* Add a device to the pending list, returning false if there is no room */
+static bool device_probe_defer(struct udevice *dev)
+{
+	/* The list is in BSS, which is not available before relocation */
+	if (!(gd->flags & GD_FLG_RELOC) ||
+	    probe_pending_count == ARRAY_SIZE(probe_pending))
+		return false;
+	probe_pending[probe_pending_count++] = dev;
+
+	return true;
+}
+
+/* Tell anyone waiting for @dev how probing finished */
+static void device_probe_finished(struct udevice *dev, int ret)
+{
+	struct probe_waiter *waiter;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+	for (waiter = probe_waiters; waiter; waiter = waiter->next) {
+		if (waiter->dev == dev)
+			waiter->ret = ret;
+	}
+}
+#else
+static inline bool device_probe_defer(struct udevice *dev)
+{
+	return false;
+}
+
+static inline void device_probe_finished(struct udevice *dev, int ret)
+{
+}
+
+void device_probe_cancel(struct udevice *dev)
+{
+	dev->flags &= ~DM_FLAG_PROBING;
+}
+#endif
+
+/**
+ * device_probe_done() - Finish probing a device once its probe() is done
+ *
+ * @dev:	Device being probed
+ * @ret:	Return value from the driver's probe() method
+ * @return 0 if OK, -ve on error
+ */
+static int device_probe_done(struct udevice *dev, int ret)
+{
+	if (ret)
+		goto fail;
+
+	ret = uclass_post_probe_device(dev);
+	if (ret)
+		goto fail_uclass;
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
+		pinctrl_select_state(dev, "default");
+
+	return 0;
+fail_uclass:
+	if (device_remove(dev)) {
+		dm_warn("%s: Device '%s' failed to remove on error path\n",
+			__func__, dev->name);
+	}
+fail:
+	dev->flags &= ~DM_FLAG_ACTIVATED;
+
+	uclass_set_seq(dev, -1);
+	device_free(dev);
+
+	return ret;
+}
+
+/**
+ * device_probe_continue() - Call probe() again for a device being probed
+ *
+ * @dev:	Device with DM_FLAG_PROBING set
+ * @return 0 if probing has finished, -EINPROGRESS if not, other -ve value
+ * if probing failed
+ */
+static int device_probe_continue(struct udevice *dev)
+{
+	int ret;
+
+	ret = dev->driver->probe(dev);
+	if (ret == -EINPROGRESS)
+		return ret;
+	device_probe_cancel(dev);
+	ret = device_probe_done(dev, ret);
+	device_probe_finished(dev, ret);
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/* Poll each pending device except @skip, which the caller is polling */
+static void dm_probe_poll_except(struct udevice *skip)
+{
+	struct udevice *pending[ARRAY_SIZE(probe_pending)];
+	int count, i;
+
+	/* A device's probe() may wait for another device */
+	if (!(gd->flags & GD_FLG_RELOC) || probe_polling)
+		return;
+	probe_polling = true;
+
+	/* Devices may finish, or be removed, while the others are polled */
+	count = probe_pending_count;
+	memcpy(pending, probe_pending, count * sizeof(pending[0]));
+	for (i = 0; i < count; i++) {
+		if (pending[i] != skip &&
+		    device_probe_find_pending(pending[i]) >= 0)
+			device_probe_continue(pending[i]);
+	}
+	probe_polling = false;
+}
+
+void dm_probe_poll(void)
+{
+	dm_probe_poll_except(NULL);
+}
+
+/*
+ * Poll the other pending devices while waiting for @dev. Returns false if
+ * one of them waited for @dev and so finished probing it, with the result
+ * in @retp.
+ */
+static bool dm_probe_poll_waiting(struct udevice *dev, int *retp)
+{
+	struct probe_waiter waiter;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return true;
+	/* If @dev is removed before it finishes, it is not there to use */
+	waiter.dev = dev;
+	waiter.ret = -ENODEV;
+	waiter.next = probe_waiters;
+	probe_waiters = &waiter;
+	dm_probe_poll_except(dev);
+	probe_waiters = waiter.next;
+	if (dev->flags & DM_FLAG_PROBING)
+		return true;
+	*retp = device_active(dev) ? 0 : waiter.ret;
+
+	return false;
+}
+#else
+static inline bool dm_probe_poll_waiting(struct udevice *dev, int *retp)
+{
+	return true;
+}
+#endif
+
+/* Wait for a device's probe() to finish, letting other devices progress */
+static int device_probe_wait(struct udevice *dev)
+{
+	int ret;
+
+	for (;;) {
+		ret = device_probe_continue(dev);
+		if (ret != -EINPROGRESS)
+			return ret;
+		if (!dm_probe_poll_waiting(dev, &ret))
+			return ret;
+	}
+}
+
+/**
+ * device_probe_common() - Probe a device, activating it
+ *
+ * @dev:	Device to probe
+ * @wait:	true to wait for a probe() which returns -EINPROGRESS to
+ *		finish, false to leave it to finish in the background
+ * @return 0 if OK, -EINPROGRESS if @wait is false and probing has not
+ * finished, other -ve value on error
+ */
+static int device_probe_common(struct udevice *dev, bool wait)
 {
 	const struct driver *drv;
 	int size = 0;
@@ -274,12 +609,20 @@ int device_probe(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
+	if (dev->flags & DM_FLAG_PROBING)
+		return wait ? device_probe_wait(dev) : -EINPROGRESS;
 	if (dev->flags & DM_FLAG_ACTIVATED)
 		return 0;
 
 	drv = dev->driver;
 	assert(drv);
 
+	if (dev->flags & DM_FLAG_PACKED) {
+		ret = device_alloc_priv_block(dev);
+		if (ret)
+			goto fail;
+	}
+
 	/* Allocate private data if requested and not reentered */
 	if (drv->priv_auto_alloc_size && !dev->priv) {
 		dev->priv = alloc_priv(drv->priv_auto_alloc_size, drv->flags);
@@ -300,11 +643,7 @@ int device_probe(struct udevice *dev)
 
 	/* Ensure all parents are probed */
 	if (dev->parent) {
-		size = dev->parent->driver->per_child_auto_alloc_size;
-		if (!size) {
-			size = dev->parent->uclass->uc_drv->
-					per_child_auto_alloc_size;
-		}
+		size = device_child_size(dev->parent, false);
 		if (size && !dev->parent_priv) {
 			dev->parent_priv = alloc_priv(size, drv->flags);
 			if (!dev->parent_priv) {
@@ -323,8 +662,8 @@ int device_probe(struct udevice *dev)
 		 * (e.g. PCI bridge devices). Test the flags again
 		 * so that we don't mess up the device.
 		 */
-		if (dev->flags & DM_FLAG_ACTIVATED)
-			return 0;
+		if (dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBING))
+			return device_probe_common(dev, wait);
 	}
 
 	seq = uclass_resolve_seq(dev);
@@ -332,7 +671,7 @@ int device_probe(struct udevice *dev)
 		ret = seq;
 		goto fail;
 	}
-	dev->seq = seq;
+	uclass_set_seq(dev, seq);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -363,34 +702,64 @@ int device_probe(struct udevice *dev)
 
 	if (drv->probe) {
 		ret = drv->probe(dev);
-		if (ret) {
-			dev->flags &= ~DM_FLAG_ACTIVATED;
-			goto fail;
+		if (ret == -EINPROGRESS && (drv->flags & DM_FLAG_PROBE_ASYNC)) {
+			dev->flags |= DM_FLAG_PROBING;
+			if (!wait && device_probe_defer(dev))
+				return -EINPROGRESS;
+			return device_probe_wait(dev);
 		}
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
-
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
-		pinctrl_select_state(dev, "default");
-
-	return 0;
-fail_uclass:
-	if (device_remove(dev)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
-	}
+	return device_probe_done(dev, ret);
 fail:
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
-	dev->seq = -1;
+	uclass_set_seq(dev, -1);
 	device_free(dev);
 
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	return device_probe_common(dev, true);
+}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+int device_probe_async(struct udevice *dev)
+{
+	int ret;
+
+	ret = device_probe_common(dev, false);
+
+	return ret == -EINPROGRESS ? 0 : ret;
+}
+
+static int dm_probe_async_children(struct udevice *parent)
+{
+	struct udevice *dev;
+	int ret = 0, err;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node) {
+		if (dev->driver->flags & DM_FLAG_PROBE_ASYNC) {
+			err = device_probe_async(dev);
+			if (err && !ret)
+				ret = err;
+		}
+		err = dm_probe_async_children(dev);
+		if (err && !ret)
+			ret = err;
+	}
+
+	return ret;
+}
+
+int dm_probe_async_all(void)
+{
+	return dm_probe_async_children(gd->dm_root);
+}
+#endif
+
 void *dev_get_platdata(struct udevice *dev)
 {
 	if (!dev) {
@@ -649,7 +1018,8 @@ fdt_addr_t dev_get_addr_index(struct udevice *dev, int index)
 			return FDT_ADDR_T_NONE;
 		}
 
-		reg = fdt_getprop(gd->fdt_blob, dev->of_offset, "reg", &len);
+		reg = ofnode_get_property(offset_to_ofnode(dev->of_offset),
+					  "reg", &len);
 		if (!reg || (len <= (index * sizeof(fdt32_t) * (na + ns)))) {
 			debug("Req index out of range\n");
 			return FDT_ADDR_T_NONE;
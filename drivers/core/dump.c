@@ -7,8 +7,11 @@
 #include <common.h>
 #include <dm.h>
 #include <mapmem.h>
+#include <dm/device-internal.h>
 #include <dm/root.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static void show_devices(struct udevice *dev, int depth, int last_flag)
 {
 	int i, is_last;
@@ -94,3 +97,103 @@ void dm_dump_uclass(void)
 		puts("\n");
 	}
 }
+
+/* Memory used by driver model, in bytes unless noted */
+struct dm_mem_info {
+	int devices;		/* number of devices */
+	int packed;		/* number of devices packed with their data */
+	int uclasses;		/* number of uclasses */
+	int udevice;
+	int priv;
+	int uclass_priv;
+	int parent_priv;
+	int platdata;
+	int uclass_platdata;
+	int parent_platdata;
+};
+
+/* Add up an area of a device, as allocated, returning its size */
+static int dm_add_area(struct udevice *dev, int size, int *total)
+{
+	if (dev->flags & DM_FLAG_PACKED)
+		size = DM_PACK_SIZE(size);
+	*total += size;
+
+	return size;
+}
+
+static void dm_add_mem(struct udevice *dev, struct dm_mem_info *info)
+{
+	struct uclass_driver *uc_drv = dev->uclass->uc_drv;
+	struct udevice *child;
+	int bytes, size;
+
+	info->devices++;
+	if (dev->flags & DM_FLAG_PACKED)
+		info->packed++;
+	bytes = dm_add_area(dev, sizeof(struct udevice), &info->udevice);
+	if (dev->priv)
+		bytes += dm_add_area(dev, dev->driver->priv_auto_alloc_size,
+				     &info->priv);
+	if (dev->uclass_priv)
+		bytes += dm_add_area(dev, uc_drv->per_device_auto_alloc_size,
+				     &info->uclass_priv);
+	if (dev->parent_priv)
+		bytes += dm_add_area(dev, device_child_size(dev->parent, false),
+				     &info->parent_priv);
+	if (dev->flags & DM_FLAG_ALLOC_PDATA)
+		bytes += dm_add_area(dev, dev->driver->platdata_auto_alloc_size,
+				     &info->platdata);
+	size = uc_drv->per_device_platdata_auto_alloc_size;
+	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA)
+		bytes += dm_add_area(dev, size, &info->uclass_platdata);
+	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA)
+		bytes += dm_add_area(dev, device_child_size(dev->parent, true),
+				     &info->parent_platdata);
+	printf("%-20.20s %-20.20s %8d\n", dev->name, dev->driver->name, bytes);
+
+	list_for_each_entry(child, &dev->child_head, sibling_node)
+		dm_add_mem(child, info);
+}
+
+static void dm_show_mem(const char *name, int size, int *total)
+{
+	printf("%-16s %8d\n", name, size);
+	*total += size;
+}
+
+void dm_dump_mem(void)
+{
+	struct dm_mem_info info;
+	struct uclass *uc;
+	int uc_priv = 0;
+	int total = 0;
+
+	if (!dm_root())
+		return;
+	memset(&info, '\0', sizeof(info));
+	printf("Device               Driver                  Bytes\n");
+	printf("--------------------------------------------------\n");
+	dm_add_mem(dm_root(), &info);
+	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
+		info.uclasses++;
+		if (uc->priv)
+			uc_priv += uc->uc_drv->priv_auto_alloc_size;
+	}
+
+	printf("\n%d devices (%d packed), %d uclasses\n", info.devices,
+	       info.packed, info.uclasses);
+	printf("Area                Bytes\n");
+	printf("-------------------------\n");
+	dm_show_mem("udevice", info.udevice, &total);
+	dm_show_mem("priv", info.priv, &total);
+	dm_show_mem("uclass_priv", info.uclass_priv, &total);
+	dm_show_mem("parent_priv", info.parent_priv, &total);
+	dm_show_mem("platdata", info.platdata, &total);
+	dm_show_mem("uclass_platdata", info.uclass_platdata, &total);
+	dm_show_mem("parent_platdata", info.parent_platdata, &total);
+	dm_show_mem("uclass", info.uclasses * sizeof(struct uclass), &total);
+	dm_show_mem("uclass priv", uc_priv, &total);
+	printf("-------------------------\n");
+	printf("%-16s %8d\n", "total", total);
+}
@@ -12,12 +12,16 @@
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/ofnode.h>
 #include <dm/platdata.h>
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 struct driver *lists_driver_lookup_name(const char *name)
 {
 	struct driver *drv =
@@ -101,74 +105,201 @@ int device_bind_driver_to_node(struct udevice *parent, const char *drv_name,
 
 #if CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)
 /**
- * driver_check_compatible() - Check if a driver is compatible with this node
+ * struct lists_compat_slot - A slot in the compatible-string index
  *
- * @param blob:		Device tree pointer
- * @param offset:	Offset of node in device tree
- * @param of_match:	List of compatible strings to match
- * @param of_idp:	Returns the match that was found
- * @return 0 if there is a match, -ENOENT if no match, -ENODEV if the node
- * does not have a compatible string, other error <0 if there is a device
- * tree error
+ * @drv:	Index of the driver in the linker list plus one, or 0 if the
+ *		slot is empty
+ * @match:	Index of the string in the driver's of_match list
+ * @hash:	Hash of the string
  */
-static int driver_check_compatible(const void *blob, int offset,
-				   const struct udevice_id *of_match,
-				   const struct udevice_id **of_idp)
+struct lists_compat_slot {
+	u16 drv;
+	u16 match;
+	u32 hash;
+};
+
+/**
+ * struct lists_compat_table - Index of the drivers by compatible string
+ *
+ * This is an open-addressed hash table with a slot for every of_match entry
+ * of every driver, so that binding a node takes one lookup for each of its
+ * compatible strings, rather than a check of every driver.
+ *
+ * @driver:	First driver in the linker list, which the slots index
+ * @mask:	Number of slots less one, the number being a power of two
+ * @slot:	Slots
+ */
+struct lists_compat_table {
+	struct driver *driver;
+	uint mask;
+	struct lists_compat_slot slot[];
+};
+
+/* FNV-1a */
+static u32 lists_compat_hash(const char *str, int len)
 {
-	int ret;
+	u32 hash = 2166136261U;
 
-	*of_idp = NULL;
-	if (!of_match)
-		return -ENOENT;
+	while (len--) {
+		hash ^= (u8)*str++;
+		hash *= 16777619;
+	}
 
-	while (of_match->compatible) {
-		ret = fdt_node_check_compatible(blob, offset,
-						of_match->compatible);
-		if (!ret) {
-			*of_idp = of_match;
-			return 0;
-		} else if (ret == -FDT_ERR_NOTFOUND) {
-			return -ENODEV;
-		} else if (ret < 0) {
-			return -EINVAL;
+	return hash;
+}
+
+/**
+ * lists_compat_table() - Get the compatible-string index, building it if needed
+ *
+ * The index holds driver indexes rather than pointers, so it stays valid
+ * until relocation, when initr_dm() drops it.
+ *
+ * @return index, or NULL if there is not enough memory for it
+ */
+static struct lists_compat_table *lists_compat_table(void)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct lists_compat_table *table = gd->dm_compat_table;
+	const struct udevice_id *of_match;
+	uint count = 0, size, i;
+	struct driver *entry;
+	size_t bytes;
+	u32 hash;
+	int m;
+
+	if (table)
+		return table;
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match; of_match &&
+		     of_match->compatible; of_match++)
+			count++;
+	}
+	for (size = 16; size < count + count / 2; size *= 2)
+		;
+	bytes = sizeof(*table) + size * sizeof(table->slot[0]);
+
+#ifdef CONFIG_SYS_MALLOC_F_LEN
+	/* Leave most of the early malloc() space for the devices */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT) &&
+	    bytes > (gd->malloc_limit - gd->malloc_ptr) / 4)
+		return NULL;
+#endif
+	table = calloc(1, bytes);
+	if (!table)
+		return NULL;
+	table->driver = driver;
+	table->mask = size - 1;
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		of_match = entry->of_match;
+		for (m = 0; of_match && of_match[m].compatible; m++) {
+			const char *name = of_match[m].compatible;
+
+			hash = lists_compat_hash(name, strlen(name));
+			for (i = hash & table->mask; table->slot[i].drv;
+			     i = (i + 1) & table->mask)
+				;
+			table->slot[i].drv = entry - driver + 1;
+			table->slot[i].match = m;
+			table->slot[i].hash = hash;
 		}
-		of_match++;
 	}
+	gd->dm_compat_table = table;
 
-	return -ENOENT;
+	return table;
 }
 
-int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
-		   struct udevice **devp)
+/**
+ * driver_find_compatible() - Find the next driver compatible with a node
+ *
+ * Drivers are found in linker-list order, checking each of their of_match
+ * strings against the node's compatible strings, but using the
+ * compatible-string index if there is one.
+ *
+ * @compat:	The node's compatible strings, each nul-terminated
+ * @compat_len:	Length of @compat in bytes
+ * @drvp:	Driver to start after, or NULL to start at the first; returns
+ *		the driver found
+ * @of_idp:	Returns the match that was found
+ * @return 0 if there is a match, -ENOENT if no (further) match
+ */
+static int driver_find_compatible(const char *compat, int compat_len,
+				  struct driver **drvp,
+				  const struct udevice_id **of_idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
-	const struct udevice_id *id;
+	int after = *drvp ? *drvp - driver : -1;
+	const char *end = compat + compat_len;
+	struct lists_compat_table *table;
+	const struct udevice_id *of_match;
+	struct lists_compat_slot *slot;
+	int best = n_ents, best_match = 0;
 	struct driver *entry;
-	struct udevice *dev;
-	bool found = false;
 	const char *name;
-	int result = 0;
-	int ret = 0;
+	int d, len;
+	u32 hash;
+	uint i;
 
-	dm_dbg("bind node %s\n", fdt_get_name(blob, offset, NULL));
-	if (devp)
-		*devp = NULL;
-	for (entry = driver; entry != driver + n_ents; entry++) {
-		ret = driver_check_compatible(blob, offset, entry->of_match,
-					      &id);
-		name = fdt_get_name(blob, offset, NULL);
-		if (ret == -ENOENT) {
-			continue;
-		} else if (ret == -ENODEV) {
-			dm_dbg("Device '%s' has no compatible string\n", name);
-			break;
-		} else if (ret) {
-			dm_warn("Device tree error at offset %d\n", offset);
-			result = ret;
-			break;
+	table = lists_compat_table();
+	if (!table) {
+		for (entry = driver + after + 1; entry < driver + n_ents;
+		     entry++) {
+			for (of_match = entry->of_match;
+			     of_match && of_match->compatible; of_match++) {
+				name = of_match->compatible;
+				if (fdt_stringlist_contains(compat, compat_len,
+							    name)) {
+					*drvp = entry;
+					*of_idp = of_match;
+					return 0;
+				}
+			}
+		}
+
+		return -ENOENT;
+	}
+
+	/* Look up each string, keeping the first driver which has any */
+	for (; compat < end; compat += len + 1) {
+		len = strnlen(compat, end - compat);
+		hash = lists_compat_hash(compat, len);
+		for (i = hash & table->mask; table->slot[i].drv;
+		     i = (i + 1) & table->mask) {
+			slot = &table->slot[i];
+			d = slot->drv - 1;
+			if (slot->hash != hash || d <= after || d > best ||
+			    (d == best && slot->match >= best_match))
+				continue;
+			entry = table->driver + d;
+			name = entry->of_match[slot->match].compatible;
+			if (strlen(name) != len || memcmp(name, compat, len))
+				continue;
+			best = d;
+			best_match = slot->match;
 		}
+	}
+	if (best == n_ents)
+		return -ENOENT;
+	entry = table->driver + best;
+	*drvp = entry;
+	*of_idp = entry->of_match + best_match;
+
+	return 0;
+}
+
+int lists_bind_compat(struct udevice *parent, const char *name,
+		      const char *compat, int compat_len, int offset,
+		      struct udevice **devp)
+{
+	const struct udevice_id *id;
+	struct driver *entry = NULL;
+	struct udevice *dev;
+	int ret;
 
+	if (devp)
+		*devp = NULL;
+	while (!driver_find_compatible(compat, compat_len, &entry, &id)) {
 		dm_dbg("   - found match at '%s'\n", entry->name);
 		ret = device_bind_with_driver_data(parent, entry, name,
 						   id->data, offset, &dev);
@@ -180,19 +311,40 @@ int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 			dm_warn("Error binding driver '%s': %d\n", entry->name,
 				ret);
 			return ret;
-		} else {
-			found = true;
-			if (devp)
-				*devp = dev;
 		}
-		break;
+		if (devp)
+			*devp = dev;
+		return 0;
 	}
+	dm_dbg("No match for node '%s'\n", name);
+
+	return 0;
+}
+
+int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
+		   struct udevice **devp)
+{
+	const char *compat, *name;
+	int len;
 
-	if (!found && !result && ret != -ENODEV) {
-		dm_dbg("No match for node '%s'\n",
-		       fdt_get_name(blob, offset, NULL));
+	name = fdt_get_name(blob, offset, NULL);
+	dm_dbg("bind node %s\n", name);
+	if (devp)
+		*devp = NULL;
+	if (blob == gd->fdt_blob)
+		compat = ofnode_get_property(offset_to_ofnode(offset),
+					     "compatible", &len);
+	else
+		compat = fdt_getprop(blob, offset, "compatible", &len);
+	if (!compat) {
+		if (len == -FDT_ERR_NOTFOUND) {
+			dm_dbg("Device '%s' has no compatible string\n", name);
+			return 0;
+		}
+		dm_warn("Device tree error at offset %d\n", offset);
+		return -EINVAL;
 	}
 
-	return result;
+	return lists_bind_compat(parent, name, compat, len, offset, devp);
 }
 #endif
@@ -0,0 +1,127 @@
+/*
+ * Access to device tree nodes, in either the flat or the live tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <fdtdec.h>
+#include <libfdt.h>
+#include <dm/ofnode.h>
+
+const void *ofnode_get_property(ofnode node, const char *propname, int *lenp)
+{
+	struct property *pp;
+
+	if (!of_live_active())
+		return fdt_getprop(gd->fdt_blob, node.of_offset, propname,
+				   lenp);
+
+	pp = node.np ? of_find_property(node.np, propname) : NULL;
+	if (!pp) {
+		if (lenp)
+			*lenp = -FDT_ERR_NOTFOUND;
+		return NULL;
+	}
+	if (lenp)
+		*lenp = pp->length;
+
+	return pp->value;
+}
+
+int ofnode_read_u32(ofnode node, const char *propname, u32 *outp)
+{
+	const fdt32_t *cell;
+	int len;
+
+	cell = ofnode_get_property(node, propname, &len);
+	if (!cell)
+		return -EINVAL;
+	if (len < sizeof(*cell))
+		return -EOVERFLOW;
+	*outp = fdt32_to_cpu(*cell);
+
+	return 0;
+}
+
+int ofnode_read_u32_default(ofnode node, const char *propname, u32 def)
+{
+	ofnode_read_u32(node, propname, &def);
+
+	return def;
+}
+
+const char *ofnode_read_string(ofnode node, const char *propname)
+{
+	const char *str;
+	int len;
+
+	str = ofnode_get_property(node, propname, &len);
+	if (!str || !len || strnlen(str, len) >= len)
+		return NULL;
+
+	return str;
+}
+
+bool ofnode_read_bool(ofnode node, const char *propname)
+{
+	return ofnode_get_property(node, propname, NULL) != NULL;
+}
+
+bool ofnode_is_available(ofnode node)
+{
+	const char *status;
+
+	/* Only "okay" is allowed, as in fdtdec_get_is_enabled() */
+	status = ofnode_get_property(node, "status", NULL);
+
+	return !status || !strcmp(status, "okay");
+}
+
+const char *ofnode_get_name(ofnode node)
+{
+	if (!of_live_active())
+		return fdt_get_name(gd->fdt_blob, node.of_offset, NULL);
+
+	return node.np ? node.np->name : NULL;
+}
+
+ofnode ofnode_first_subnode(ofnode node)
+{
+	ofnode subnode;
+
+	if (!of_live_active()) {
+		subnode.of_offset = fdt_first_subnode(gd->fdt_blob,
+						      node.of_offset);
+		return subnode;
+	}
+	subnode.np = node.np ? node.np->child : NULL;
+
+	return subnode;
+}
+
+ofnode ofnode_next_subnode(ofnode node)
+{
+	ofnode subnode;
+
+	if (!of_live_active()) {
+		subnode.of_offset = fdt_next_subnode(gd->fdt_blob,
+						     node.of_offset);
+		return subnode;
+	}
+	subnode.np = node.np ? node.np->sibling : NULL;
+
+	return subnode;
+}
+
+ofnode ofnode_path(const char *path)
+{
+	return offset_to_ofnode(fdtdec_path_offset(gd->fdt_blob, path));
+}
+
+ofnode ofnode_get_by_phandle(uint phandle)
+{
+	return offset_to_ofnode(fdtdec_node_offset_by_phandle(gd->fdt_blob,
+							       phandle));
+}
@@ -0,0 +1,120 @@
+/*
+ * Binding devices from nodes found at build time
+ *
+ * dtoc lists, for each node of the control device tree, the subnodes that
+ * dm_scan_fdt_node() would bind, along with their compatible strings and
+ * the aliases that could number them. Binding then needs neither a walk of
+ * the subnodes, reading their status and compatible properties, nor a walk
+ * of the aliases for each device. Drivers are still matched at run time,
+ * by their compatible strings, so devices are bound exactly as before.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <libfdt.h>
+#include <dm/lists.h>
+#include <dm/prebind.h>
+#include <dm/util.h>
+#include <u-boot/crc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+bool dm_prebind_valid(void)
+{
+	const void *blob = gd->fdt_blob;
+
+	if (gd->prebind_blob != blob) {
+		gd->prebind_blob = blob;
+		gd->prebind_ok = blob &&
+			fdt_totalsize(blob) == dm_prebind.fdt_size &&
+			crc32(0, blob, dm_prebind.fdt_size) ==
+				dm_prebind.fdt_crc;
+		if (!gd->prebind_ok)
+			debug("Device tree does not match the prebind table\n");
+	}
+
+	return gd->prebind_ok;
+}
+
+void dm_prebind_invalidate(void)
+{
+	gd->prebind_blob = NULL;
+}
+
+/*
+ * Find an entry in a table sorted by offset, given the offset member of
+ * the first entry and the size of each entry
+ */
+static int dm_prebind_find(const void *table, int count, size_t size,
+			   int offset)
+{
+	int lo, hi, mid, val;
+
+	for (lo = 0, hi = count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		val = *(const int *)(table + mid * size);
+		if (val == offset)
+			return mid;
+		if (val < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return -ENOENT;
+}
+
+int dm_prebind_scan(struct udevice *parent, int offset, bool pre_reloc_only)
+{
+	const struct dm_prebind_parent *par;
+	const struct dm_prebind_node *node;
+	int ret = 0, err, i;
+
+	i = dm_prebind_find(&dm_prebind.parent[0].offset,
+			    dm_prebind.num_parents, sizeof(*par), offset);
+	if (i < 0)
+		return 0;
+	par = &dm_prebind.parent[i];
+	for (i = 0; i < par->count; i++) {
+		node = &dm_prebind.node[dm_prebind.child[par->first + i]];
+		if (pre_reloc_only && !(node->flags & DM_PREBIND_PRE_RELOC))
+			continue;
+		err = lists_bind_compat(parent, node->name, node->compat,
+					node->compat_len, node->offset, NULL);
+		if (err && !ret) {
+			ret = err;
+			debug("%s: ret=%d\n", node->name, ret);
+		}
+	}
+
+	if (ret)
+		dm_warn("Some drivers failed to bind\n");
+
+	return ret;
+}
+
+int dm_prebind_alias_seq(const char *base, int offset, int *seqp)
+{
+	int base_len = strlen(base);
+	const char *const *alias;
+	int i, val;
+
+	i = dm_prebind_find(&dm_prebind.node[0].offset, dm_prebind.num_nodes,
+			    sizeof(dm_prebind.node[0]), offset);
+	if (i < 0)
+		return -ENODEV;
+	alias = dm_prebind.node[i].aliases;
+	for (; alias && *alias; alias++) {
+		if (strncmp(*alias, base, base_len))
+			continue;
+		val = trailing_strtol(*alias);
+		if (val != -1) {
+			*seqp = val;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
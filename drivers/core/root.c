@@ -15,7 +15,9 @@
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/ofnode.h>
 #include <dm/platdata.h>
+#include <dm/prebind.h>
 #include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/util.h>
@@ -147,6 +149,13 @@ int dm_init(void)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+	/* Index uclasses by ID, once there is memory to spare for it */
+	if (gd->uclass_by_id)
+		memset(gd->uclass_by_id, '\0',
+		       UCLASS_COUNT * sizeof(*gd->uclass_by_id));
+	else if (gd->flags & GD_FLG_FULL_MALLOC_INIT)
+		gd->uclass_by_id = calloc(UCLASS_COUNT,
+					  sizeof(*gd->uclass_by_id));
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	fix_drivers();
@@ -193,22 +202,25 @@ int dm_scan_fdt_node(struct udevice *parent, const void *blob, int offset,
 		     bool pre_reloc_only)
 {
 	int ret = 0, err;
+	ofnode node;
 
-	for (offset = fdt_first_subnode(blob, offset);
-	     offset > 0;
-	     offset = fdt_next_subnode(blob, offset)) {
+	if (CONFIG_IS_ENABLED(OF_PREBIND) && blob == gd->fdt_blob &&
+	    dm_prebind_valid())
+		return dm_prebind_scan(parent, offset, pre_reloc_only);
+
+	ofnode_for_each_subnode(node, offset_to_ofnode(offset)) {
 		if (pre_reloc_only &&
-		    !fdt_getprop(blob, offset, "u-boot,dm-pre-reloc", NULL))
+		    !ofnode_read_bool(node, "u-boot,dm-pre-reloc"))
 			continue;
-		if (!fdtdec_get_is_enabled(blob, offset)) {
+		if (!ofnode_is_available(node)) {
 			dm_dbg("   - ignoring disabled device\n");
 			continue;
 		}
-		err = lists_bind_fdt(parent, blob, offset, NULL);
+		err = lists_bind_fdt(parent, blob, ofnode_to_offset(node),
+				     NULL);
 		if (err && !ret) {
 			ret = err;
-			debug("%s: ret=%d\n", fdt_get_name(blob, offset, NULL),
-			      ret);
+			debug("%s: ret=%d\n", ofnode_get_name(node), ret);
 		}
 	}
 
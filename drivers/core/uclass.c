@@ -25,11 +25,11 @@ struct uclass *uclass_find(enum uclass_id key)
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+	if (gd->uclass_by_id) {
+		if (key < 0 || key >= UCLASS_COUNT)
+			return NULL;
+		return gd->uclass_by_id[key];
+	}
 	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
 		if (uc->uc_drv->id == key)
 			return uc;
@@ -79,6 +79,10 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, &DM_UCLASS_ROOT_NON_CONST);
+	if (gd->uclass_by_id)
+		gd->uclass_by_id[id] = uc;
+	else
+		uc->seq_size = -1;
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -95,6 +99,8 @@ fail:
 		uc->priv = NULL;
 	}
 	list_del(&uc->sibling_node);
+	if (gd->uclass_by_id)
+		gd->uclass_by_id[id] = NULL;
 fail_mem:
 	free(uc);
 
@@ -128,8 +134,11 @@ int uclass_destroy(struct uclass *uc)
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
 	list_del(&uc->sibling_node);
+	if (gd->uclass_by_id && gd->uclass_by_id[uc_drv->id] == uc)
+		gd->uclass_by_id[uc_drv->id] = NULL;
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
+	free(uc->seq_dev);
 	free(uc);
 
 	return 0;
@@ -240,6 +249,16 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+	/* The table holds every device with a sequence number in its range */
+	if (!find_req_seq && uc->seq_size >= 0 && seq_or_req_seq >= 0 &&
+	    seq_or_req_seq < DM_MAX_SEQ) {
+		if (seq_or_req_seq < uc->seq_size)
+			*devp = uc->seq_dev[seq_or_req_seq];
+		debug("   - %sfound\n", *devp ? "" : "not ");
+
+		return *devp ? 0 : -ENODEV;
+	}
+
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		debug("   - %d %d\n", dev->req_seq, dev->seq);
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
@@ -287,6 +306,7 @@ static int uclass_find_device_by_phandle(enum uclass_id id,
 	struct udevice *dev;
 	struct uclass *uc;
 	int find_phandle;
+	int node;
 	int ret;
 
 	*devp = NULL;
@@ -298,10 +318,12 @@ static int uclass_find_device_by_phandle(enum uclass_id id,
 	if (ret)
 		return ret;
 
+	/* Compare node offsets rather than reading each device's phandle */
+	node = fdtdec_node_offset_by_phandle(gd->fdt_blob, find_phandle);
+	if (node < 0)
+		return -ENODEV;
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
-		uint phandle = fdt_get_phandle(gd->fdt_blob, dev->of_offset);
-
-		if (phandle == find_phandle) {
+		if (dev->of_offset == node) {
 			*devp = dev;
 			return 0;
 		}
@@ -521,6 +543,41 @@ int uclass_resolve_seq(struct udevice *dev)
 	return seq;
 }
 
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+	struct uclass *uc = dev->uclass;
+	struct udevice **table;
+	int size;
+
+	if (dev->seq >= 0 && dev->seq < uc->seq_size &&
+	    uc->seq_dev[dev->seq] == dev)
+		uc->seq_dev[dev->seq] = NULL;
+	dev->seq = seq;
+	if (seq < 0 || seq >= DM_MAX_SEQ || uc->seq_size < 0)
+		return;
+
+	if (seq >= uc->seq_size) {
+		/* realloc() is not available before relocation */
+		size = max(seq + 1, max(uc->seq_size * 2, 4));
+		size = min(size, DM_MAX_SEQ);
+		table = calloc(size, sizeof(*table));
+		if (!table) {
+			/* Give up on the table and search the device list */
+			free(uc->seq_dev);
+			uc->seq_dev = NULL;
+			uc->seq_size = -1;
+			return;
+		}
+		if (uc->seq_size)
+			memcpy(table, uc->seq_dev,
+			       uc->seq_size * sizeof(*table));
+		free(uc->seq_dev);
+		uc->seq_dev = table;
+		uc->seq_size = size;
+	}
+	uc->seq_dev[seq] = dev;
+}
+
 int uclass_pre_probe_device(struct udevice *dev)
 {
 	struct uclass_driver *uc_drv;
@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <fdtdec.h>
 #include <mmc.h>
 #include <dm.h>
 #include <dm/device-internal.h>
@@ -13,6 +14,8 @@
 #include <dm/root.h>
 #include "mmc_private.h"
 
+DECLARE_GLOBAL_DATA_PTR;
+
 #ifdef CONFIG_DM_MMC_OPS
 int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		    struct mmc_data *data)
@@ -77,6 +80,71 @@ int mmc_getcd(struct mmc *mmc)
 {
 	return dm_mmc_get_cd(mmc->dev);
 }
+
+int dm_mmc_execute_tuning(struct udevice *dev, uint opcode)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->execute_tuning)
+		return -ENOSYS;
+	return ops->execute_tuning(dev, opcode);
+}
+
+int mmc_execute_tuning(struct mmc *mmc, uint opcode)
+{
+	return dm_mmc_execute_tuning(mmc->dev, opcode);
+}
+#endif
+
+#if CONFIG_IS_ENABLED(OF_CONTROL)
+int mmc_of_parse(struct udevice *dev, struct mmc_config *cfg)
+{
+	const void *blob = gd->fdt_blob;
+	int node = dev->of_offset;
+	int val;
+
+	val = fdtdec_get_int(blob, node, "bus-width", -1);
+	switch (val) {
+	case -1:
+		break;
+	case 8:
+		cfg->host_caps |= MMC_MODE_8BIT;
+		/* fall through */
+	case 4:
+		cfg->host_caps |= MMC_MODE_4BIT;
+		/* fall through */
+	case 1:
+		if (val < 8)
+			cfg->host_caps &= ~MMC_MODE_8BIT;
+		if (val < 4)
+			cfg->host_caps &= ~MMC_MODE_4BIT;
+		break;
+	default:
+		debug("%s: Invalid bus-width %d\n", dev->name, val);
+		return -EINVAL;
+	}
+
+	cfg->f_max = fdtdec_get_int(blob, node, "max-frequency", cfg->f_max);
+
+	if (fdtdec_get_bool(blob, node, "cap-sd-highspeed"))
+		cfg->host_caps |= MMC_MODE_HS;
+	if (fdtdec_get_bool(blob, node, "cap-mmc-highspeed"))
+		cfg->host_caps |= MMC_MODE_HS | MMC_MODE_HS_52MHz;
+	if (fdtdec_get_bool(blob, node, "sd-uhs-sdr50"))
+		cfg->host_caps |= MMC_MODE_UHS_SDR50;
+	if (fdtdec_get_bool(blob, node, "sd-uhs-sdr104"))
+		cfg->host_caps |= MMC_MODE_UHS_SDR104;
+	if (fdtdec_get_bool(blob, node, "sd-uhs-ddr50"))
+		cfg->host_caps |= MMC_MODE_UHS_DDR50;
+	if (fdtdec_get_bool(blob, node, "mmc-ddr-1_8v"))
+		cfg->host_caps |= MMC_MODE_DDR_52MHz;
+	if (fdtdec_get_bool(blob, node, "mmc-hs200-1_8v"))
+		cfg->host_caps |= MMC_MODE_HS200;
+	if (fdtdec_get_bool(blob, node, "mmc-hs400-1_8v"))
+		cfg->host_caps |= MMC_MODE_HS200 | MMC_MODE_HS400;
+
+	return 0;
+}
 #endif
 
 struct mmc *mmc_get_mmc_dev(struct udevice *dev)
@@ -128,6 +128,102 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 
 	return ret;
 }
+
+static int mmc_set_ios(struct mmc *mmc)
+{
+	if (mmc->cfg->ops->set_ios)
+		mmc->cfg->ops->set_ios(mmc);
+
+	return 0;
+}
+
+int mmc_execute_tuning(struct mmc *mmc, uint opcode)
+{
+	if (!mmc->cfg->ops->execute_tuning)
+		return -ENOSYS;
+
+	return mmc->cfg->ops->execute_tuning(mmc, opcode);
+}
+#endif
+
+#if defined(CONFIG_MMC_UHS_SUPPORT) || defined(CONFIG_MMC_HS200_SUPPORT)
+#define mmc_host_uhs(mmc)	(!mmc_host_is_spi(mmc) && \
+				 ((mmc)->cfg->host_caps & MMC_MODE_UHS))
+
+static int mmc_set_signal_voltage(struct mmc *mmc,
+				  enum mmc_signal_voltage voltage)
+{
+	mmc->signal_voltage = voltage;
+
+	return mmc_set_ios(mmc);
+}
+
+const u8 mmc_tuning_blk_pattern_4bit[MMC_TUNING_BLK_SIZE_4BIT] = {
+	0xff, 0x0f, 0xff, 0x00, 0xff, 0xcc, 0xc3, 0xcc,
+	0xc3, 0x3c, 0xcc, 0xff, 0xfe, 0xff, 0xfe, 0xef,
+	0xff, 0xdf, 0xff, 0xdd, 0xff, 0xfb, 0xff, 0xfb,
+	0xbf, 0xff, 0x7f, 0xff, 0x77, 0xf7, 0xbd, 0xef,
+	0xff, 0xf0, 0xff, 0xf0, 0x0f, 0xfc, 0xcc, 0x3c,
+	0xcc, 0x33, 0xcc, 0xcf, 0xff, 0xef, 0xff, 0xee,
+	0xff, 0xfd, 0xff, 0xfd, 0xdf, 0xff, 0xbf, 0xff,
+	0xbb, 0xff, 0xf7, 0xff, 0xf7, 0x7f, 0x7b, 0xde,
+};
+
+const u8 mmc_tuning_blk_pattern_8bit[MMC_TUNING_BLK_SIZE_8BIT] = {
+	0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00,
+	0xff, 0xff, 0xcc, 0xcc, 0xcc, 0x33, 0xcc, 0xcc,
+	0xcc, 0x33, 0x33, 0xcc, 0xcc, 0xcc, 0xff, 0xff,
+	0xff, 0xee, 0xff, 0xff, 0xff, 0xee, 0xee, 0xff,
+	0xff, 0xff, 0xdd, 0xff, 0xff, 0xff, 0xdd, 0xdd,
+	0xff, 0xff, 0xff, 0xbb, 0xff, 0xff, 0xff, 0xbb,
+	0xbb, 0xff, 0xff, 0xff, 0x77, 0xff, 0xff, 0xff,
+	0x77, 0x77, 0xff, 0x77, 0xbb, 0xdd, 0xee, 0xff,
+	0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00,
+	0x00, 0xff, 0xff, 0xcc, 0xcc, 0xcc, 0x33, 0xcc,
+	0xcc, 0xcc, 0x33, 0x33, 0xcc, 0xcc, 0xcc, 0xff,
+	0xff, 0xff, 0xee, 0xff, 0xff, 0xff, 0xee, 0xee,
+	0xff, 0xff, 0xff, 0xdd, 0xff, 0xff, 0xff, 0xdd,
+	0xdd, 0xff, 0xff, 0xff, 0xbb, 0xff, 0xff, 0xff,
+	0xbb, 0xbb, 0xff, 0xff, 0xff, 0x77, 0xff, 0xff,
+	0xff, 0x77, 0x77, 0xff, 0x77, 0xbb, 0xdd, 0xee,
+};
+
+int mmc_send_tuning(struct mmc *mmc, uint opcode)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, data_buf, MMC_TUNING_BLK_SIZE_8BIT);
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+	const u8 *pattern;
+	int size;
+	int err;
+
+	if (mmc->bus_width == 8) {
+		pattern = mmc_tuning_blk_pattern_8bit;
+		size = MMC_TUNING_BLK_SIZE_8BIT;
+	} else {
+		pattern = mmc_tuning_blk_pattern_4bit;
+		size = MMC_TUNING_BLK_SIZE_4BIT;
+	}
+
+	cmd.cmdidx = opcode;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
+
+	data.dest = (char *)data_buf;
+	data.blocks = 1;
+	data.blocksize = size;
+	data.flags = MMC_DATA_READ;
+
+	memset(data_buf, '\0', size);
+	err = mmc_send_cmd(mmc, &cmd, &data);
+	if (err)
+		return err;
+
+	if (memcmp(data_buf, pattern, size))
+		return -EIO;
+
+	return 0;
+}
 #endif
 
 int mmc_send_status(struct mmc *mmc, int timeout)
@@ -188,11 +284,30 @@ int mmc_set_blocklen(struct mmc *mmc, int len)
 	return mmc_send_cmd(mmc, &cmd, NULL);
 }
 
+int mmc_set_blockcount(struct mmc *mmc, unsigned int blockcount,
+		       bool is_rel_write)
+{
+	struct mmc_cmd cmd = {0};
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blockcount & 0x0000FFFF;
+	if (is_rel_write)
+		cmd.cmdarg |= 1 << 31;
+	cmd.resp_type = MMC_RSP_R1;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 			   lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	/* With a pre-defined block count, no stop command is needed */
+	bool sbc = blkcnt > 1 && (mmc->card_caps & MMC_MODE_CMD23);
+
+	if (sbc && mmc_set_blockcount(mmc, blkcnt, false))
+		return 0;
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -214,7 +329,7 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	if (mmc_send_cmd(mmc, &cmd, &data))
 		return 0;
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -268,8 +383,7 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	}
 
 	do {
-		cur = (blocks_todo > mmc->cfg->b_max) ?
-			mmc->cfg->b_max : blocks_todo;
+		cur = min_t(lbaint_t, blocks_todo, mmc_max_blocks(mmc));
 		if (mmc_read_blocks(mmc, dst, start, cur) != cur) {
 			debug("%s: Failed to read blocks\n", __func__);
 			return 0;
@@ -303,6 +417,36 @@ static int mmc_go_idle(struct mmc *mmc)
 	return 0;
 }
 
+#ifdef CONFIG_MMC_UHS_SUPPORT
+static int sd_switch_voltage(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
+
+	cmd.cmdidx = SD_CMD_SWITCH_UHS18V;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
+
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	if (err)
+		return err;
+
+	if (cmd.response[0] & MMC_STATUS_ERROR)
+		return -EIO;
+
+	/*
+	 * The card now holds CMD and DAT[3:0] low until the host has moved its
+	 * I/O lines to 1.8V. Give it the 5ms the specification requires.
+	 */
+	err = mmc_set_signal_voltage(mmc, MMC_SIGNAL_VOLTAGE_180);
+	if (err)
+		return err;
+	udelay(5000);
+
+	return 0;
+}
+#endif
+
 static int sd_send_op_cond(struct mmc *mmc)
 {
 	int timeout = 1000;
@@ -335,6 +479,12 @@ static int sd_send_op_cond(struct mmc *mmc)
 		if (mmc->version == SD_VERSION_2)
 			cmd.cmdarg |= OCR_HCS;
 
+#ifdef CONFIG_MMC_UHS_SUPPORT
+		/* Ask for 1.8V signalling if we can use any UHS-I mode */
+		if (mmc->version == SD_VERSION_2 && mmc_host_uhs(mmc))
+			cmd.cmdarg |= OCR_S18R;
+#endif
+
 		err = mmc_send_cmd(mmc, &cmd, NULL);
 
 		if (err)
@@ -368,6 +518,16 @@ static int sd_send_op_cond(struct mmc *mmc)
 	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
 	mmc->rca = 0;
 
+#ifdef CONFIG_MMC_UHS_SUPPORT
+	/* The card accepted 1.8V signalling, so switch over now */
+	if (mmc_host_uhs(mmc) &&
+	    (mmc->ocr & (OCR_HCS | OCR_S18R)) == (OCR_HCS | OCR_S18R)) {
+		err = sd_switch_voltage(mmc);
+		if (err)
+			return err;
+	}
+#endif
+
 	return 0;
 }
 
@@ -506,7 +666,7 @@ int mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value)
 static int mmc_change_freq(struct mmc *mmc)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(u8, ext_csd, MMC_MAX_BLOCK_LEN);
-	char cardtype;
+	u8 cardtype;
 	int err;
 
 	mmc->card_caps = 0;
@@ -518,14 +678,14 @@ static int mmc_change_freq(struct mmc *mmc)
 	if (mmc->version < MMC_VERSION_4)
 		return 0;
 
-	mmc->card_caps |= MMC_MODE_4BIT | MMC_MODE_8BIT;
+	mmc->card_caps |= MMC_MODE_4BIT | MMC_MODE_8BIT | MMC_MODE_CMD23;
 
 	err = mmc_send_ext_csd(mmc, ext_csd);
 
 	if (err)
 		return err;
 
-	cardtype = ext_csd[EXT_CSD_CARD_TYPE] & 0xf;
+	cardtype = ext_csd[EXT_CSD_CARD_TYPE];
 
 	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_HS_TIMING, 1);
 
@@ -551,8 +711,104 @@ static int mmc_change_freq(struct mmc *mmc)
 		mmc->card_caps |= MMC_MODE_HS;
 	}
 
+#ifdef CONFIG_MMC_HS200_SUPPORT
+	if (cardtype & EXT_CSD_CARD_TYPE_HS200_1_8V)
+		mmc->card_caps |= MMC_MODE_HS200;
+#endif
+#ifdef CONFIG_MMC_HS400_SUPPORT
+	if (cardtype & EXT_CSD_CARD_TYPE_HS400_1_8V)
+		mmc->card_caps |= MMC_MODE_HS400;
+#endif
+
+	return 0;
+}
+
+#ifdef CONFIG_MMC_HS400_SUPPORT
+/*
+ * HS400 can only be entered from tuned HS200: drop back to high-speed timing
+ * at 52MHz, move the bus to 8-bit DDR and then select HS400 timing.
+ */
+static int mmc_select_hs400(struct mmc *mmc)
+{
+	int err;
+
+	mmc->selected_mode = MMC_HS_52;
+	mmc->tran_speed = 52000000;
+	mmc_set_clock(mmc, mmc->tran_speed);
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_HS_TIMING,
+			 EXT_CSD_TIMING_HS);
+	if (err)
+		return err;
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_BUS_WIDTH,
+			 EXT_CSD_DDR_BUS_WIDTH_8);
+	if (err)
+		return err;
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_HS_TIMING,
+			 EXT_CSD_TIMING_HS400);
+	if (err)
+		return err;
+
+	mmc->ddr_mode = 1;
+	mmc->selected_mode = MMC_HS_400;
+	mmc->tran_speed = 200000000;
+	mmc_set_clock(mmc, mmc->tran_speed);
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_MMC_HS200_SUPPORT
+/*
+ * Move an eMMC already running in high-speed mode on a 4- or 8-bit SDR bus up
+ * to HS200, and then on to HS400 if both sides support it. If the host cannot
+ * find a working sampling point the card is put back into high-speed mode.
+ */
+static int mmc_select_hs200(struct mmc *mmc)
+{
+	int err;
+
+	if (mmc->bus_width < 4 || mmc->ddr_mode)
+		return 0;
+
+	err = mmc_set_signal_voltage(mmc, MMC_SIGNAL_VOLTAGE_180);
+	if (err) {
+		debug("%s: Cannot switch to 1.8V (%d)\n", __func__, err);
+		mmc_set_signal_voltage(mmc, MMC_SIGNAL_VOLTAGE_330);
+		return 0;
+	}
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_HS_TIMING,
+			 EXT_CSD_TIMING_HS200);
+	if (err)
+		return err;
+
+	mmc->selected_mode = MMC_HS_200;
+	mmc->tran_speed = 200000000;
+	mmc_set_clock(mmc, mmc->tran_speed);
+
+	err = mmc_execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK_HS200);
+	if (err) {
+		debug("%s: Tuning failed (%d), using high speed\n", __func__,
+		      err);
+		mmc->selected_mode = MMC_HS_52;
+		mmc->tran_speed = 52000000;
+		mmc_set_clock(mmc, mmc->tran_speed);
+
+		return mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
+				  EXT_CSD_HS_TIMING, EXT_CSD_TIMING_HS);
+	}
+
+#ifdef CONFIG_MMC_HS400_SUPPORT
+	if ((mmc->card_caps & MMC_MODE_HS400) && mmc->bus_width == 8)
+		return mmc_select_hs400(mmc);
+#endif
+
 	return 0;
 }
+#endif
 
 static int mmc_set_capacity(struct mmc *mmc, int part_num)
 {
@@ -902,6 +1158,8 @@ retry_scr:
 
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
+	if (mmc->scr[0] & SD_SCR_CMD23)
+		mmc->card_caps |= MMC_MODE_CMD23;
 
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
@@ -920,6 +1178,20 @@ retry_scr:
 			break;
 	}
 
+#ifdef CONFIG_MMC_UHS_SUPPORT
+	/* UHS-I functions are only usable once the card runs at 1.8V */
+	if (mmc->signal_voltage == MMC_SIGNAL_VOLTAGE_180) {
+		uint fns = __be32_to_cpu(switch_status[3]);
+
+		if (fns & SD_UHS_SDR50_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_SDR50;
+		if (fns & SD_UHS_SDR104_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_SDR104;
+		if (fns & SD_UHS_DDR50_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_DDR50;
+	}
+#endif
+
 	/* If high-speed isn't supported, we return */
 	if (!(__be32_to_cpu(switch_status[3]) & SD_HIGHSPEED_SUPPORTED))
 		return 0;
@@ -945,6 +1217,66 @@ retry_scr:
 	return 0;
 }
 
+#ifdef CONFIG_MMC_UHS_SUPPORT
+/* UHS-I bus speed modes, in order of preference */
+static const struct sd_uhs_mode {
+	uint cap;
+	u8 func;
+	enum mmc_bus_mode mode;
+	uint clock;
+} sd_uhs_modes[] = {
+	{ MMC_MODE_UHS_SDR104, SD_SWITCH_FUNC_SDR104, UHS_SDR104, 208000000 },
+	{ MMC_MODE_UHS_DDR50, SD_SWITCH_FUNC_DDR50, UHS_DDR50, 50000000 },
+	{ MMC_MODE_UHS_SDR50, SD_SWITCH_FUNC_SDR50, UHS_SDR50, 100000000 },
+};
+
+/*
+ * Switch a 1.8V SD card on a 4-bit bus to the fastest UHS-I mode that both
+ * the card and host support, and tune the host for it.
+ */
+static int sd_select_uhs(struct mmc *mmc)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(uint, switch_status, 16);
+	const struct sd_uhs_mode *uhs;
+	int err, i;
+
+	if (mmc->bus_width != 4)
+		return 0;
+
+	for (i = 0; i < ARRAY_SIZE(sd_uhs_modes); i++) {
+		uhs = &sd_uhs_modes[i];
+		if (!(mmc->card_caps & uhs->cap))
+			continue;
+
+		err = sd_switch(mmc, SD_SWITCH_SWITCH, 0, uhs->func,
+				(u8 *)switch_status);
+		if (err)
+			return err;
+
+		if (((__be32_to_cpu(switch_status[4]) >> 24) & 0xf) !=
+		    uhs->func)
+			continue;
+
+		mmc->selected_mode = uhs->mode;
+		mmc->ddr_mode = uhs->mode == UHS_DDR50;
+		mmc->tran_speed = uhs->clock;
+		mmc_set_clock(mmc, mmc->tran_speed);
+
+		if (uhs->mode == UHS_DDR50)
+			return 0;
+
+		err = mmc_execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK);
+		/* Tuning is optional for SDR50 */
+		if (err == -ENOSYS && uhs->mode == UHS_SDR50)
+			err = 0;
+
+		return err;
+	}
+
+	return 0;
+}
+#endif
+
 /* frequency bases */
 /* divided by 10 to be nice to platforms without floating point */
 static const int fbase[] = {
@@ -976,13 +1308,27 @@ static const u8 multipliers[] = {
 	80,
 };
 
-#ifndef CONFIG_DM_MMC_OPS
-static void mmc_set_ios(struct mmc *mmc)
+const char *mmc_mode_name(enum mmc_bus_mode mode)
 {
-	if (mmc->cfg->ops->set_ios)
-		mmc->cfg->ops->set_ios(mmc);
+	static const char *const names[] = {
+		[MMC_LEGACY]	= "MMC legacy",
+		[SD_LEGACY]	= "SD legacy",
+		[MMC_HS]	= "MMC High Speed (26MHz)",
+		[SD_HS]		= "SD High Speed (50MHz)",
+		[MMC_HS_52]	= "MMC High Speed (52MHz)",
+		[MMC_DDR_52]	= "MMC DDR52 (52MHz)",
+		[UHS_SDR50]	= "UHS SDR50 (100MHz)",
+		[UHS_DDR50]	= "UHS DDR50 (50MHz)",
+		[UHS_SDR104]	= "UHS SDR104 (208MHz)",
+		[MMC_HS_200]	= "HS200 (200MHz)",
+		[MMC_HS_400]	= "HS400 (200MHz)",
+	};
+
+	if (mode >= MMC_MODES_END)
+		return "Unknown mode";
+
+	return names[mode];
 }
-#endif
 
 void mmc_set_clock(struct mmc *mmc, uint clock)
 {
@@ -1313,6 +1659,7 @@ static int mmc_startup(struct mmc *mmc)
 			* ext_csd[EXT_CSD_HC_WP_GRP_SIZE];
 
 		mmc->wr_rel_set = ext_csd[EXT_CSD_WR_REL_SET];
+		mmc->wr_rel_param = ext_csd[EXT_CSD_WR_REL_PARAM];
 	}
 
 	err = mmc_set_capacity(mmc, mmc_get_blk_desc(mmc)->hwpart);
@@ -1329,6 +1676,7 @@ static int mmc_startup(struct mmc *mmc)
 
 	/* Restrict card's capabilities by what the host can do */
 	mmc->card_caps &= mmc->cfg->host_caps;
+	mmc->selected_mode = IS_SD(mmc) ? SD_LEGACY : MMC_LEGACY;
 
 	if (IS_SD(mmc)) {
 		if (mmc->card_caps & MMC_MODE_4BIT) {
@@ -1350,10 +1698,18 @@ static int mmc_startup(struct mmc *mmc)
 			mmc_set_bus_width(mmc, 4);
 		}
 
-		if (mmc->card_caps & MMC_MODE_HS)
+		if (mmc->card_caps & MMC_MODE_HS) {
 			mmc->tran_speed = 50000000;
-		else
+			mmc->selected_mode = SD_HS;
+		} else {
 			mmc->tran_speed = 25000000;
+		}
+
+#ifdef CONFIG_MMC_UHS_SUPPORT
+		err = sd_select_uhs(mmc);
+		if (err)
+			return err;
+#endif
 	} else if (mmc->version >= MMC_VERSION_4) {
 		/* Only version 4 of MMC supports wider bus widths */
 		int idx;
@@ -1405,6 +1761,13 @@ static int mmc_startup(struct mmc *mmc)
 			if ((mmc->card_caps & caps) != caps)
 				continue;
 
+#ifdef CONFIG_MMC_HS200_SUPPORT
+			/* HS200 needs an SDR bus; HS400 sets up DDR itself */
+			if ((mmc->card_caps & MMC_MODE_HS200) &&
+			    (caps & MMC_MODE_DDR_52MHz))
+				continue;
+#endif
+
 			err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
 					EXT_CSD_BUS_WIDTH, extw);
 
@@ -1439,11 +1802,23 @@ static int mmc_startup(struct mmc *mmc)
 			return err;
 
 		if (mmc->card_caps & MMC_MODE_HS) {
-			if (mmc->card_caps & MMC_MODE_HS_52MHz)
+			if (mmc->card_caps & MMC_MODE_HS_52MHz) {
 				mmc->tran_speed = 52000000;
-			else
+				mmc->selected_mode = mmc->ddr_mode ?
+					MMC_DDR_52 : MMC_HS_52;
+			} else {
 				mmc->tran_speed = 26000000;
+				mmc->selected_mode = MMC_HS;
+			}
 		}
+
+#ifdef CONFIG_MMC_HS200_SUPPORT
+		if (mmc->card_caps & MMC_MODE_HS200) {
+			err = mmc_select_hs200(mmc);
+			if (err)
+				return err;
+		}
+#endif
 	}
 
 	mmc_set_clock(mmc, mmc->tran_speed);
@@ -1549,6 +1924,9 @@ int mmc_start_init(struct mmc *mmc)
 		return err;
 #endif
 	mmc->ddr_mode = 0;
+	mmc->reliable_write = false;
+	mmc->selected_mode = MMC_LEGACY;
+	mmc->signal_voltage = MMC_SIGNAL_VOLTAGE_330;
 	mmc_set_bus_width(mmc, 1);
 	mmc_set_clock(mmc, 1);
 
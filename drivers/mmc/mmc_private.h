@@ -16,6 +16,44 @@ extern int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 extern int mmc_send_status(struct mmc *mmc, int timeout);
 extern int mmc_set_blocklen(struct mmc *mmc, int len);
+
+/**
+ * mmc_set_blockcount() - Send SET_BLOCK_COUNT (CMD23)
+ *
+ * This sets the number of blocks for the next multi-block transfer, so that
+ * no STOP_TRANSMISSION is needed once it completes.
+ *
+ * @mmc:		MMC device
+ * @blockcount:		Number of blocks (at most MMC_MAX_BLOCK_COUNT)
+ * @is_rel_write:	true to request a reliable write
+ * @return 0 if OK, -ve on error
+ */
+int mmc_set_blockcount(struct mmc *mmc, unsigned int blockcount,
+		       bool is_rel_write);
+
+/**
+ * mmc_max_blocks() - Get the number of blocks to transfer with one command
+ *
+ * @mmc:	MMC device
+ * @return maximum number of blocks for a single read or write command
+ */
+static inline uint mmc_max_blocks(struct mmc *mmc)
+{
+	if ((mmc->card_caps & MMC_MODE_CMD23) &&
+	    mmc->cfg->b_max > MMC_MAX_BLOCK_COUNT)
+		return MMC_MAX_BLOCK_COUNT;
+
+	return mmc->cfg->b_max;
+}
+
+/**
+ * mmc_execute_tuning() - Ask the host controller to tune its sampling point
+ *
+ * @mmc:	MMC device
+ * @opcode:	Tuning command to use
+ * @return 0 if OK, -ENOSYS if the host cannot tune, other -ve on error
+ */
+int mmc_execute_tuning(struct mmc *mmc, uint opcode);
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
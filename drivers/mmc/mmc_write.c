@@ -116,12 +116,29 @@ unsigned long mmc_berase(struct blk_desc *block_dev, lbaint_t start,
 	return blk;
 }
 
+int mmc_set_reliable_write(struct mmc *mmc, bool enable)
+{
+	if (enable && (IS_SD(mmc) || !(mmc->card_caps & MMC_MODE_CMD23) ||
+		       !(mmc->wr_rel_param & EXT_CSD_EN_REL_WR)))
+		return -EOPNOTSUPP;
+
+	mmc->reliable_write = enable;
+
+	return 0;
+}
+
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		lbaint_t blkcnt, const void *src)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout = 1000;
+	/*
+	 * Use a pre-defined block count where possible, so that no stop
+	 * command is needed. Reliable writes always need one.
+	 */
+	bool sbc = mmc->reliable_write ||
+		(blkcnt > 1 && (mmc->card_caps & MMC_MODE_CMD23));
 
 	if ((start + blkcnt) > mmc_get_blk_desc(mmc)->lba) {
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
@@ -131,11 +148,16 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 
 	if (blkcnt == 0)
 		return 0;
-	else if (blkcnt == 1)
+	else if (blkcnt == 1 && !sbc)
 		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
 	else
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
 
+	if (sbc && mmc_set_blockcount(mmc, blkcnt, mmc->reliable_write)) {
+		printf("mmc fail to set block count\n");
+		return 0;
+	}
+
 	if (mmc->high_capacity)
 		cmd.cmdarg = start;
 	else
@@ -156,7 +178,7 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	/* SPI multiblock writes terminate using a special
 	 * token, not a STOP_TRANSMISSION request.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -200,8 +222,7 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 
 	do {
-		cur = (blocks_todo > mmc->cfg->b_max) ?
-			mmc->cfg->b_max : blocks_todo;
+		cur = min_t(lbaint_t, blocks_todo, mmc_max_blocks(mmc));
 		if (mmc_write_blocks(mmc, start, cur, src) != cur)
 			return 0;
 		blocks_todo -= cur;
@@ -20,14 +20,76 @@ struct sandbox_mmc_plat {
 };
 
 /**
- * sandbox_mmc_send_cmd() - Emulate SD commands
+ * struct sandbox_mmc_priv - State of the emulated card
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
+ * @emmc:	true to emulate an eMMC device, false for an SD card
+ * @app_cmd:	true if the previous command was MMC_CMD_APP_CMD
+ * @v18:	true if the SD card has switched to 1.8V signalling
+ * @sd_func:	SD access mode function selected with CMD6
+ * @block_count: Block count set by the last CMD23, or 0 if none
+ * @cmd_count:	Number of times each command has been received
+ * @ext_csd:	EXT_CSD register of the eMMC device
+ */
+struct sandbox_mmc_priv {
+	bool emmc;
+	bool app_cmd;
+	bool v18;
+	uint sd_func;
+	uint block_count;
+	uint cmd_count[64];
+	u8 ext_csd[MMC_MAX_BLOCK_LEN];
+};
+
+int sandbox_mmc_get_cmd_count(struct udevice *dev, int cmdidx)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	return priv->cmd_count[cmdidx];
+}
+
+/* Emulate CMD6 (SWITCH_FUNC) for the access mode group of an SD card */
+static void sandbox_sd_switch(struct sandbox_mmc_priv *priv,
+			      struct mmc_cmd *cmd, struct mmc_data *data)
+{
+	u32 *resp = (u32 *)data->dest;
+	uint func = cmd->cmdarg & 0xf;
+	u32 fns = SD_HIGHSPEED_SUPPORTED;
+
+	if (priv->v18) {
+		fns |= SD_UHS_SDR50_SUPPORTED | SD_UHS_SDR104_SUPPORTED |
+			SD_UHS_DDR50_SUPPORTED;
+	}
+	if (func == 0xf)
+		func = priv->sd_func;
+	else if (!(fns & (1 << (16 + func))))
+		func = 0xf;
+	else if (cmd->cmdarg & (1U << 31))
+		priv->sd_func = func;
+
+	memset(resp, '\0', data->blocksize);
+	resp[3] = cpu_to_be32(fns);
+	resp[4] = cpu_to_be32(func << 24);
+}
+
+/**
+ * sandbox_mmc_send_cmd() - Emulate SD / eMMC commands
+ *
+ * This emulates an SD card version 3 with UHS-I support, or an eMMC 5.0
+ * device supporting HS200 and HS400. Single-block reads result in zero data.
  * Multiple-block reads return a test string.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+	struct mmc *mmc = &plat->mmc;
+	bool app_cmd = priv->app_cmd;
+	uint block_count = priv->block_count;
+
+	priv->app_cmd = false;
+	priv->block_count = 0;
+	priv->cmd_count[cmd->cmdidx & 0x3f]++;
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		break;
@@ -35,8 +97,19 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		cmd->response[0] = 0 << 16; /* mmc->rca */
 	case MMC_CMD_GO_IDLE_STATE:
 		break;
-	case SD_CMD_SEND_IF_COND:
-		cmd->response[0] = 0xaa;
+	case MMC_CMD_SEND_OP_COND:
+		if (!priv->emmc)
+			return -ETIMEDOUT;
+		cmd->response[0] = OCR_BUSY | OCR_HCS | MMC_VDD_165_195;
+		break;
+	case SD_CMD_SEND_IF_COND:	/* MMC_CMD_SEND_EXT_CSD for eMMC */
+		if (!priv->emmc) {
+			cmd->response[0] = 0xaa;
+			break;
+		}
+		if (!data)
+			return -ETIMEDOUT;
+		memcpy(data->dest, priv->ext_csd, sizeof(priv->ext_csd));
 		break;
 	case MMC_CMD_SEND_STATUS:
 		cmd->response[0] = MMC_STATUS_RDY_FOR_DATA;
@@ -44,29 +117,73 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case MMC_CMD_SELECT_CARD:
 		break;
 	case MMC_CMD_SEND_CSD:
-		cmd->response[0] = 0;
+		cmd->response[0] = priv->emmc ? 4 << 26 : 0; /* spec version */
 		cmd->response[1] = 10 << 16;	/* 1 << block_len */
+		cmd->response[3] = 9 << 22;	/* 1 << write_bl_len */
 		break;
-	case SD_CMD_SWITCH_FUNC: {
-		u32 *resp = (u32 *)data->dest;
+	case SD_CMD_SWITCH_FUNC:	/* also MMC_CMD_SWITCH, ACMD6 */
+		if (priv->emmc) {
+			uint index = (cmd->cmdarg >> 16) & 0xff;
+			uint value = (cmd->cmdarg >> 8) & 0xff;
 
-		resp[7] = cpu_to_be32(SD_HIGHSPEED_BUSY);
+			/* HS200 and HS400 need 1.8V signalling */
+			if (index == EXT_CSD_HS_TIMING &&
+			    value >= EXT_CSD_TIMING_HS200 &&
+			    mmc->signal_voltage != MMC_SIGNAL_VOLTAGE_180)
+				return -EIO;
+			priv->ext_csd[index] = value;
+		} else if (!app_cmd) {
+			sandbox_sd_switch(priv, cmd, data);
+		}
+		break;
+	case SD_CMD_SWITCH_UHS18V:
+		priv->v18 = true;
+		break;
+#if defined(CONFIG_MMC_UHS_SUPPORT) || defined(CONFIG_MMC_HS200_SUPPORT)
+	case MMC_CMD_SEND_TUNING_BLOCK:
+	case MMC_CMD_SEND_TUNING_BLOCK_HS200:
+		/* Tuning only makes sense on a fast 1.8V bus */
+		if (mmc->signal_voltage != MMC_SIGNAL_VOLTAGE_180 ||
+		    mmc->clock <= 52000000)
+			return -EIO;
+		if (mmc->bus_width == 8)
+			memcpy(data->dest, mmc_tuning_blk_pattern_8bit,
+			       MMC_TUNING_BLK_SIZE_8BIT);
+		else
+			memcpy(data->dest, mmc_tuning_blk_pattern_4bit,
+			       MMC_TUNING_BLK_SIZE_4BIT);
+		break;
+#endif
+	case MMC_CMD_SET_BLOCK_COUNT:
+		priv->block_count = cmd->cmdarg & MMC_MAX_BLOCK_COUNT;
 		break;
-	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
 		memset(data->dest, '\0', data->blocksize);
 		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
-		strcpy(data->dest, "this is a test");
+	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		/* A pre-defined transfer must match the block count */
+		if (block_count && block_count != data->blocks)
+			return -EIO;
+		if (cmd->cmdidx == MMC_CMD_READ_MULTIPLE_BLOCK)
+			strcpy(data->dest, "this is a test");
+		break;
+	case MMC_CMD_WRITE_SINGLE_BLOCK:
+		/* Written data is discarded */
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
-		cmd->response[0] = OCR_BUSY | OCR_HCS;
+		/* Accept 1.8V signalling if the host asks for it */
+		cmd->response[0] = OCR_BUSY | OCR_HCS |
+			(cmd->cmdarg & OCR_S18R);
 		cmd->response[1] = 0;
 		cmd->response[2] = 0;
 		break;
 	case MMC_CMD_APP_CMD:
+		if (priv->emmc)
+			return -ETIMEDOUT;
+		priv->app_cmd = true;
 		break;
 	case MMC_CMD_SET_BLOCKLEN:
 		debug("block len %d\n", cmd->cmdarg);
@@ -74,7 +191,9 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, 1- and 4-bit bus widths, CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_DATA_4BIT |
+				     1 << 16 | SD_SCR_CMD23);
 		break;
 	}
 	default:
@@ -95,15 +214,43 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 	return 1;
 }
 
+#if defined(CONFIG_MMC_UHS_SUPPORT) || defined(CONFIG_MMC_HS200_SUPPORT)
+static int sandbox_mmc_execute_tuning(struct udevice *dev, uint opcode)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	return mmc_send_tuning(&plat->mmc, opcode);
+}
+#endif
+
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+#if defined(CONFIG_MMC_UHS_SUPPORT) || defined(CONFIG_MMC_HS200_SUPPORT)
+	.execute_tuning = sandbox_mmc_execute_tuning,
+#endif
 };
 
 int sandbox_mmc_probe(struct udevice *dev)
 {
 	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	priv->emmc = fdtdec_get_bool(gd->fdt_blob, dev->of_offset,
+				     "sandbox,emmc");
+	if (priv->emmc) {
+		u8 *ext_csd = priv->ext_csd;
+
+		ext_csd[EXT_CSD_REV] = 7;	/* eMMC 5.0 */
+		ext_csd[EXT_CSD_CARD_TYPE] = EXT_CSD_CARD_TYPE_26 |
+			EXT_CSD_CARD_TYPE_52 | EXT_CSD_CARD_TYPE_DDR_1_8V |
+			EXT_CSD_CARD_TYPE_HS200_1_8V |
+			EXT_CSD_CARD_TYPE_HS400_1_8V;
+		ext_csd[EXT_CSD_SEC_CNT + 2] = 0x80;	/* 4GB */
+		ext_csd[EXT_CSD_WR_REL_PARAM] = EXT_CSD_HS_CTRL_REL |
+			EXT_CSD_EN_REL_WR;
+	}
 
 	return mmc_init(&plat->mmc);
 }
@@ -115,12 +262,17 @@ int sandbox_mmc_bind(struct udevice *dev)
 	int ret;
 
 	cfg->name = dev->name;
-	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT;
+	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT |
+		MMC_MODE_CMD23;
 	cfg->voltages = MMC_VDD_165_195 | MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
 	cfg->b_max = U32_MAX;
 
+	ret = mmc_of_parse(dev, cfg);
+	if (ret)
+		return ret;
+
 	ret = mmc_bind(dev, &plat->mmc, cfg);
 	if (ret)
 		return ret;
@@ -148,5 +300,6 @@ U_BOOT_DRIVER(mmc_sandbox) = {
 	.bind		= sandbox_mmc_bind,
 	.unbind		= sandbox_mmc_unbind,
 	.probe		= sandbox_mmc_probe,
+	.priv_auto_alloc_size = sizeof(struct sandbox_mmc_priv),
 	.platdata_auto_alloc_size = sizeof(struct sandbox_mmc_plat),
 };
@@ -15,6 +15,7 @@
 #include <mapmem.h>
 #include <spi.h>
 #include <spi_flash.h>
+#include <task.h>
 #include <linux/log2.h>
 #include <dma.h>
 
@@ -276,6 +277,7 @@ static int spi_flash_cmd_wait_ready(struct spi_flash *flash,
 			return ret;
 		if (ret)
 			return 0;
+		task_yield();
 	}
 
 	printf("SF: Timeout!\n");
@@ -93,7 +93,7 @@ static int pinctrl_select_state_full(struct udevice *dev, const char *statename)
 	for (i = 0; i < size; i++) {
 		phandle = fdt32_to_cpu(*list++);
 
-		config_node = fdt_node_offset_by_phandle(fdt, phandle);
+		config_node = fdtdec_node_offset_by_phandle(fdt, phandle);
 		if (config_node < 0) {
 			dev_err(dev, "prop %s index %d invalid phandle\n",
 				propname, i);
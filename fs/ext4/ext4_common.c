@@ -195,6 +195,7 @@ int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index)
 			return -1;
 
 		*ptr = *ptr | operand;
+		get_fs()->bg_dirty[index] |= BG_BLOCK_BMAP_DIRTY;
 		return 0;
 	} else {
 		if (remainder == 0) {
@@ -209,6 +210,7 @@ int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index)
 			return -1;
 
 		*ptr = *ptr | operand;
+		get_fs()->bg_dirty[index] |= BG_BLOCK_BMAP_DIRTY;
 		return 0;
 	}
 }
@@ -241,6 +243,7 @@ void ext4fs_reset_block_bmap(long int blockno, unsigned char *buffer, int index)
 		if (status)
 			*ptr = *ptr & ~(operand);
 	}
+	get_fs()->bg_dirty[index] |= BG_BLOCK_BMAP_DIRTY;
 }
 
 int ext4fs_set_inode_bmap(int inode_no, unsigned char *buffer, int index)
@@ -264,6 +267,7 @@ int ext4fs_set_inode_bmap(int inode_no, unsigned char *buffer, int index)
 		return -1;
 
 	*ptr = *ptr | operand;
+	get_fs()->bg_dirty[index] |= BG_INODE_BMAP_DIRTY;
 
 	return 0;
 }
@@ -287,6 +291,7 @@ void ext4fs_reset_inode_bmap(int inode_no, unsigned char *buffer, int index)
 	status = *ptr & operand;
 	if (status)
 		*ptr = *ptr & ~(operand);
+	get_fs()->bg_dirty[index] |= BG_INODE_BMAP_DIRTY;
 }
 
 int ext4fs_checksum_update(unsigned int i)
@@ -355,7 +360,6 @@ void ext4fs_update_parent_dentry(char *filename, int *p_ino, int file_type)
 	int sizeof_void_space = 0;
 	int templength = 0;
 	int inodeno;
-	int status;
 	struct ext_filesystem *fs = get_fs();
 	/* directory entry */
 	struct ext2_dirent *dir;
@@ -386,10 +390,8 @@ restart:
 		previous_blknr = root_blknr;
 	}
 
-	status = ext4fs_devread((lbaint_t)first_block_no_of_root
-				* fs->sect_perblk,
-				0, fs->blksz, root_first_block_buffer);
-	if (status == 0)
+	if (ext4fs_read_metadata(root_first_block_buffer,
+				 first_block_no_of_root))
 		goto fail;
 
 	if (ext4fs_log_journal(root_first_block_buffer, first_block_no_of_root))
@@ -879,6 +881,7 @@ long int ext4fs_get_new_blk_no(void)
 				fs->curr_blkno = fs->curr_blkno +
 						(i * fs->blksz * 8);
 				fs->first_pass_bbmap++;
+				fs->bg_dirty[i] |= BG_BLOCK_BMAP_DIRTY;
 				bgd[i].free_blocks--;
 				fs->sb->free_blocks--;
 				status = ext4fs_devread((lbaint_t)
@@ -969,6 +972,135 @@ fail:
 	return -1;
 }
 
+/* Get the block group of a block and its bit in the group's block bitmap */
+static unsigned int ext4fs_blk_group(long int blknr, unsigned int *bit)
+{
+	unsigned int first_data_blk = ext4fs_root->sblock.first_data_block;
+	unsigned int blk_per_grp = ext4fs_root->sblock.blocks_per_group;
+
+	*bit = (blknr - first_data_blk) % blk_per_grp;
+
+	return (blknr - first_data_blk) / blk_per_grp;
+}
+
+static inline int ext4fs_test_bmap(unsigned char *bmap, unsigned int bit)
+{
+	return bmap[bit / 8] & (1 << (bit % 8));
+}
+
+/*
+ * Allocate up to @count contiguous blocks, continuing from the last block
+ * allocated. The run ends at the first used block or at the end of the
+ * block group, so that the bitmap, its journal backup and the group
+ * counters are updated once for the whole run. Returns the first block of
+ * the run and stores its length in @len, or returns -1 if the partition is
+ * full.
+ */
+long int ext4fs_get_new_blk_run(unsigned int count, unsigned int *len)
+{
+	unsigned int first_data_blk = ext4fs_root->sblock.first_data_block;
+	unsigned int blk_per_grp = ext4fs_root->sblock.blocks_per_group;
+	unsigned int total_blocks = ext4fs_root->sblock.total_blocks;
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd = fs->bgd;
+	unsigned int i, bg_idx, start_idx, bit, start, end;
+	unsigned char *bmap;
+
+	if (fs->first_pass_bbmap)
+		start_idx = ext4fs_blk_group(fs->curr_blkno + 1, &bit);
+	else
+		start_idx = bit = 0;
+	if (start_idx >= fs->no_blkgrp)
+		start_idx = bit = 0;
+
+	/* search to the end of the partition, then wrap around */
+	for (i = 0; i <= fs->no_blkgrp; i++, bit = 0) {
+		bg_idx = (start_idx + i) % fs->no_blkgrp;
+		if (!bgd[bg_idx].free_blocks)
+			continue;
+
+		bmap = fs->blk_bmaps[bg_idx];
+		if (bgd[bg_idx].bg_flags & EXT4_BG_BLOCK_UNINIT) {
+			memset(bmap, '\0', fs->blksz);
+			put_ext4((uint64_t)bgd[bg_idx].block_id * fs->blksz,
+				 bmap, fs->blksz);
+			bgd[bg_idx].bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
+		}
+
+		end = total_blocks - first_data_blk - bg_idx * blk_per_grp;
+		if (end > blk_per_grp)
+			end = blk_per_grp;
+
+		while (bit < end && ext4fs_test_bmap(bmap, bit)) {
+			if (!(bit % 8) && bmap[bit / 8] == 0xff)
+				bit += 8;
+			else
+				bit++;
+		}
+		if (bit >= end)
+			continue;
+
+		if (ext4fs_log_journal_blk(bgd[bg_idx].block_id))
+			return -1;
+
+		start = bit;
+		while (bit < end && bit - start < count &&
+		       !ext4fs_test_bmap(bmap, bit)) {
+			bmap[bit / 8] |= 1 << (bit % 8);
+			bit++;
+		}
+		*len = bit - start;
+
+		bgd[bg_idx].free_blocks -= *len;
+		fs->sb->free_blocks -= *len;
+		fs->bg_dirty[bg_idx] |= BG_BLOCK_BMAP_DIRTY;
+
+		fs->curr_blkno = first_data_blk + bg_idx * blk_per_grp + bit - 1;
+		fs->first_pass_bbmap = 1;
+
+		return fs->curr_blkno - *len + 1;
+	}
+
+	return -1;
+}
+
+/*
+ * Free @count contiguous blocks starting at @blknr, updating each block
+ * group's bitmap and counters once. Returns 0 on success, -ve on error.
+ */
+int ext4fs_free_blk_run(long int blknr, unsigned int count)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd = fs->bgd;
+	unsigned int bg_idx, bit, n;
+	unsigned char *bmap;
+	int ret;
+
+	while (count) {
+		bg_idx = ext4fs_blk_group(blknr, &bit);
+		if (bg_idx >= fs->no_blkgrp)
+			return -EINVAL;
+
+		ret = ext4fs_log_journal_blk(bgd[bg_idx].block_id);
+		if (ret)
+			return ret;
+
+		bmap = fs->blk_bmaps[bg_idx];
+		for (n = 0; n < count &&
+		     bit < ext4fs_root->sblock.blocks_per_group; n++, bit++)
+			bmap[bit / 8] &= ~(1 << (bit % 8));
+
+		bgd[bg_idx].free_blocks += n;
+		fs->sb->free_blocks += n;
+		fs->bg_dirty[bg_idx] |= BG_BLOCK_BMAP_DIRTY;
+
+		blknr += n;
+		count -= n;
+	}
+
+	return 0;
+}
+
 int ext4fs_get_new_inode_no(void)
 {
 	short i;
@@ -1008,6 +1140,7 @@ int ext4fs_get_new_inode_no(void)
 				fs->curr_inode_no = fs->curr_inode_no +
 							(i * inodes_per_grp);
 				fs->first_pass_ibmap++;
+				fs->bg_dirty[i] |= BG_INODE_BMAP_DIRTY;
 				bgd[i].free_inodes--;
 				bgd[i].bg_itable_unused--;
 				fs->sb->free_inodes--;
@@ -41,6 +41,10 @@
 #define SUPERBLOCK_SIZE	1024
 #define F_FILE			1
 
+/* Flags in ext_filesystem.bg_dirty */
+#define BG_BLOCK_BMAP_DIRTY	(1 << 0)
+#define BG_INODE_BMAP_DIRTY	(1 << 1)
+
 static inline void *zalloc(size_t size)
 {
 	void *p = memalign(ARCH_DMA_MINALIGN, size);
@@ -63,6 +67,8 @@ int ext4fs_checksum_update(unsigned int i);
 int ext4fs_get_parent_inode_num(const char *dirname, char *dname, int flags);
 void ext4fs_update_parent_dentry(char *filename, int *p_ino, int file_type);
 long int ext4fs_get_new_blk_no(void);
+long int ext4fs_get_new_blk_run(unsigned int count, unsigned int *len);
+int ext4fs_free_blk_run(long int blknr, unsigned int count);
 int ext4fs_get_new_inode_no(void);
 void ext4fs_reset_block_bmap(long int blockno, unsigned char *buffer,
 					int index);
@@ -168,6 +168,11 @@ int ext4fs_log_journal(char *journal_buffer, long int blknr)
 			return 0;
 	}
 
+	if (gindex >= MAX_JOURNAL_ENTRIES) {
+		printf("Too many meta data blocks in %s\n", __func__);
+		return -ENOSPC;
+	}
+
 	journal_ptr[gindex]->buf = zalloc(fs->blksz);
 	if (!journal_ptr[gindex]->buf)
 		return -ENOMEM;
@@ -179,17 +184,64 @@ int ext4fs_log_journal(char *journal_buffer, long int blknr)
 }
 
 /*
- * This function stores the modified meta data in RAM
+ * This function stores the backup copy of a meta data block, reading it
+ * from disk only if it has not been logged already
+ * blknr -- Block number on disk of the meta data
+ */
+int ext4fs_log_journal_blk(long int blknr)
+{
+	struct ext_filesystem *fs = get_fs();
+	char *journal_buffer;
+	int ret;
+	short i;
+
+	for (i = 0; i < gindex; i++) {
+		if (journal_ptr[i]->blknr == blknr)
+			return 0;
+	}
+
+	journal_buffer = zalloc(fs->blksz);
+	if (!journal_buffer)
+		return -ENOMEM;
+	if (ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0, fs->blksz,
+			   journal_buffer))
+		ret = ext4fs_log_journal(journal_buffer, blknr);
+	else
+		ret = -EIO;
+	free(journal_buffer);
+
+	return ret;
+}
+
+/*
+ * This function stores the modified meta data in RAM. A block which is
+ * stored more than once is only written back once, with its latest contents
  * metadata_buffer -- Buffer containing meta data
  * blknr -- Block number on disk of the meta data buffer
  */
 int ext4fs_put_metadata(char *metadata_buffer, long int blknr)
 {
 	struct ext_filesystem *fs = get_fs();
+	int i;
+
 	if (!metadata_buffer) {
 		printf("Invalid input arguments %s\n", __func__);
 		return -EINVAL;
 	}
+
+	for (i = 0; i < gd_index; i++) {
+		if (dirty_block_ptr[i]->blknr == blknr) {
+			memcpy(dirty_block_ptr[i]->buf, metadata_buffer,
+			       fs->blksz);
+			return 0;
+		}
+	}
+
+	if (gd_index >= MAX_JOURNAL_ENTRIES) {
+		printf("Too many meta data blocks in %s\n", __func__);
+		return -ENOSPC;
+	}
+
 	dirty_block_ptr[gd_index]->buf = zalloc(fs->blksz);
 	if (!dirty_block_ptr[gd_index]->buf)
 		return -ENOMEM;
@@ -199,6 +251,33 @@ int ext4fs_put_metadata(char *metadata_buffer, long int blknr)
 	return 0;
 }
 
+/*
+ * This function reads a meta data block, returning the modified copy stored
+ * by ext4fs_put_metadata() if there is one, so that a block changed earlier
+ * in the same transaction is not read back in its old state from disk
+ * metadata_buffer -- Buffer to read the meta data into
+ * blknr -- Block number on disk of the meta data buffer
+ */
+int ext4fs_read_metadata(char *metadata_buffer, long int blknr)
+{
+	struct ext_filesystem *fs = get_fs();
+	int i;
+
+	for (i = 0; i < gd_index; i++) {
+		if (dirty_block_ptr[i]->blknr == blknr) {
+			memcpy(metadata_buffer, dirty_block_ptr[i]->buf,
+			       fs->blksz);
+			return 0;
+		}
+	}
+
+	if (!ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0, fs->blksz,
+			    metadata_buffer))
+		return -EIO;
+
+	return 0;
+}
+
 void print_revoke_blks(char *revk_blk)
 {
 	int offset;
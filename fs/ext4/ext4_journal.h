@@ -116,7 +116,9 @@ int ext4fs_init_journal(void);
 int ext4fs_log_gdt(char *gd_table);
 int ext4fs_check_journal_state(int recovery_flag);
 int ext4fs_log_journal(char *journal_buffer, long int blknr);
+int ext4fs_log_journal_blk(long int blknr);
 int ext4fs_put_metadata(char *metadata_buffer, long int blknr);
+int ext4fs_read_metadata(char *metadata_buffer, long int blknr);
 void ext4fs_update_journal(void);
 void ext4fs_dump_metadata(void);
 void ext4fs_push_revoke_blk(char *buffer);
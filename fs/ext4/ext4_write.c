@@ -38,18 +38,23 @@ static void ext4fs_update(void)
 	put_ext4((uint64_t)(SUPERBLOCK_SIZE),
 		 (struct ext2_sblock *)fs->sb, (uint32_t)SUPERBLOCK_SIZE);
 
-	/* update block groups */
+	/* update block groups, writing back only the bitmaps that changed */
 	for (i = 0; i < fs->no_blkgrp; i++) {
 		fs->bgd[i].bg_checksum = ext4fs_checksum_update(i);
+		if (!(fs->bg_dirty[i] & BG_BLOCK_BMAP_DIRTY))
+			continue;
 		put_ext4((uint64_t)((uint64_t)fs->bgd[i].block_id * (uint64_t)fs->blksz),
 			 fs->blk_bmaps[i], fs->blksz);
 	}
 
 	/* update inode table groups */
 	for (i = 0; i < fs->no_blkgrp; i++) {
+		if (!(fs->bg_dirty[i] & BG_INODE_BMAP_DIRTY))
+			continue;
 		put_ext4((uint64_t) ((uint64_t)fs->bgd[i].inode_id * (uint64_t)fs->blksz),
 			 fs->inode_bmaps[i], fs->blksz);
 	}
+	memset(fs->bg_dirty, 0, fs->no_blkgrp);
 
 	/* update the block group descriptor table */
 	put_ext4((uint64_t)((uint64_t)fs->gdtable_blkno * (uint64_t)fs->blksz),
@@ -391,6 +396,78 @@ fail:
 	free(journal_buffer);
 }
 
+/* Free the blocks of each extent in a leaf of an extent tree */
+static int ext4fs_free_extents(struct ext4_extent_header *eh)
+{
+	struct ext4_extent *ext = (struct ext4_extent *)(eh + 1);
+	unsigned int len;
+	uint64_t start;
+	int i, ret;
+
+	if (le16_to_cpu(eh->eh_magic) != EXT4_EXT_MAGIC)
+		return -EINVAL;
+
+	for (i = 0; i < le16_to_cpu(eh->eh_entries); i++) {
+		len = le16_to_cpu(ext[i].ee_len);
+		/* uninitialized extents have the top bit of the length set */
+		if (len > EXT4_EXT_INIT_MAX_LEN)
+			len -= EXT4_EXT_INIT_MAX_LEN;
+		start = le16_to_cpu(ext[i].ee_start_hi);
+		start = (start << 32) + le32_to_cpu(ext[i].ee_start_lo);
+		debug("EXT4_EXTENTS releasing %u blocks at %llu\n", len,
+		      (unsigned long long)start);
+		ret = ext4fs_free_blk_run(start, len);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Free the blocks of a file which uses extents, along with its leaf blocks,
+ * an extent at a time. Returns 0 on success, -EOPNOTSUPP for extent trees
+ * more than one level deep, or another -ve error.
+ */
+static int ext4fs_delete_extents(struct ext2_inode *inode)
+{
+	struct ext4_extent_header *eh =
+		(struct ext4_extent_header *)inode->b.blocks.dir_blocks;
+	struct ext4_extent_idx *idx = (struct ext4_extent_idx *)(eh + 1);
+	struct ext_filesystem *fs = get_fs();
+	uint64_t blknr;
+	char *leaf;
+	int i, ret = 0;
+
+	if (le16_to_cpu(eh->eh_magic) != EXT4_EXT_MAGIC)
+		return -EINVAL;
+	if (le16_to_cpu(eh->eh_depth) == 0)
+		return ext4fs_free_extents(eh);
+	if (le16_to_cpu(eh->eh_depth) > 1)
+		return -EOPNOTSUPP;
+
+	leaf = zalloc(fs->blksz);
+	if (!leaf)
+		return -ENOMEM;
+	for (i = 0; i < le16_to_cpu(eh->eh_entries); i++) {
+		blknr = le16_to_cpu(idx[i].ei_leaf_hi);
+		blknr = (blknr << 32) + le32_to_cpu(idx[i].ei_leaf_lo);
+		if (!ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0,
+				    fs->blksz, leaf)) {
+			ret = -EIO;
+			break;
+		}
+		ret = ext4fs_free_extents((struct ext4_extent_header *)leaf);
+		if (!ret)
+			ret = ext4fs_free_blk_run(blknr, 1);
+		if (ret)
+			break;
+	}
+	free(leaf);
+
+	return ret;
+}
+
 static int ext4fs_delete_file(int inodeno)
 {
 	struct ext2_inode inode;
@@ -403,6 +480,7 @@ static int ext4fs_delete_file(int inodeno)
 	char *read_buffer = NULL;
 	char *start_block_address = NULL;
 	unsigned int no_blocks;
+	int ret = 0;
 
 	static int prev_bg_bmap_idx = -1;
 	unsigned int inodes_per_block;
@@ -428,6 +506,13 @@ static int ext4fs_delete_file(int inodeno)
 		no_blocks++;
 
 	if (le32_to_cpu(inode.flags) & EXT4_EXTENTS_FL) {
+		ret = ext4fs_delete_extents(&inode);
+		if (ret && ret != -EOPNOTSUPP)
+			goto fail;
+	}
+
+	if ((le32_to_cpu(inode.flags) & EXT4_EXTENTS_FL) && ret) {
+		/* deeper extent trees are freed a block at a time */
 		struct ext2fs_node *node_inode =
 		    zalloc(sizeof(struct ext2fs_node));
 		if (!node_inode)
@@ -472,8 +557,7 @@ static int ext4fs_delete_file(int inodeno)
 			free(node_inode);
 			node_inode = NULL;
 		}
-	} else {
-
+	} else if (!(le32_to_cpu(inode.flags) & EXT4_EXTENTS_FL)) {
 		delete_single_indirect_block(&inode);
 		delete_double_indirect_block(&inode);
 		delete_triple_indirect_block(&inode);
@@ -561,6 +645,10 @@ static int ext4fs_delete_file(int inodeno)
 	if (ext4fs_log_journal(journal_buffer, bgd[ibmap_idx].inode_id))
 		goto fail;
 
+	/*
+	 * Commit the delete before the blocks can be reused, so that the old
+	 * inode never points at blocks holding the new file's data
+	 */
 	ext4fs_update();
 	ext4fs_deinit();
 	ext4fs_reinit_global();
@@ -656,6 +744,10 @@ int ext4fs_init(void)
 			goto fail;
 	}
 
+	fs->bg_dirty = zalloc(fs->no_blkgrp);
+	if (!fs->bg_dirty)
+		goto fail;
+
 	/*
 	 * check filesystem consistency with free blocks of file system
 	 * some time we observed that superblock freeblocks does not match
@@ -725,6 +817,8 @@ void ext4fs_deinit(void)
 		fs->inode_bmaps = NULL;
 	}
 
+	free(fs->bg_dirty);
+	fs->bg_dirty = NULL;
 
 	free(fs->gdtable);
 	fs->gdtable = NULL;
@@ -818,6 +912,139 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 	return len;
 }
 
+/*
+ * Allocate the blocks of a file as extents and write its contents. Blocks
+ * are allocated in contiguous runs and each extent is written with a single
+ * request. Up to four extents fit in the inode; more are kept in leaf blocks
+ * indexed from the inode. Returns 0 on success, -EFBIG if the free space is
+ * too fragmented to describe with one level of leaf blocks, or another -ve
+ * error.
+ */
+static int ext4fs_write_extents(struct ext2_inode *file_inode,
+				unsigned int total_remaining_blocks,
+				unsigned int *total_no_of_block, const char *buf)
+{
+	struct ext4_extent_header *eh =
+		(struct ext4_extent_header *)file_inode->b.blocks.dir_blocks;
+	struct ext4_extent_idx *idx = (struct ext4_extent_idx *)(eh + 1);
+	struct ext_filesystem *fs = get_fs();
+	unsigned int size = le32_to_cpu(file_inode->size);
+	unsigned int root_max = (sizeof(file_inode->b) - sizeof(*eh)) /
+				sizeof(struct ext4_extent);
+	unsigned int leaf_max = (fs->blksz - sizeof(*eh)) /
+				sizeof(struct ext4_extent);
+	unsigned int nr_ext = 0, nr_leaf, lblk, len, bytes, i;
+	struct ext4_extent *ext, *last;
+	struct ext4_extent_header *leh;
+	long int blknr;
+	char *blk_buf;
+	int ret = -ENOSPC;
+
+	ext = malloc(root_max * leaf_max * sizeof(*ext));
+	blk_buf = zalloc(fs->blksz);
+	if (!ext || !blk_buf) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	for (lblk = 0; lblk < total_remaining_blocks; lblk += len) {
+		blknr = ext4fs_get_new_blk_run(min(total_remaining_blocks - lblk,
+						   (unsigned int)EXT4_EXT_INIT_MAX_LEN),
+					       &len);
+		if (blknr == -1) {
+			printf("no block left to assign\n");
+			goto fail;
+		}
+
+		/* extend the last extent if the run carries straight on */
+		if (nr_ext) {
+			last = &ext[nr_ext - 1];
+			if (le32_to_cpu(last->ee_start_lo) +
+			    le16_to_cpu(last->ee_len) == blknr &&
+			    le16_to_cpu(last->ee_len) + len <=
+			    EXT4_EXT_INIT_MAX_LEN) {
+				last->ee_len = cpu_to_le16(
+					le16_to_cpu(last->ee_len) + len);
+				continue;
+			}
+		}
+		if (nr_ext == root_max * leaf_max) {
+			/* give the blocks back for the caller to try again */
+			ext4fs_free_blk_run(blknr, len);
+			for (i = 0; i < nr_ext; i++)
+				ext4fs_free_blk_run(le32_to_cpu(ext[i].ee_start_lo),
+						    le16_to_cpu(ext[i].ee_len));
+			ret = -EFBIG;
+			goto fail;
+		}
+		ext[nr_ext].ee_block = cpu_to_le32(lblk);
+		ext[nr_ext].ee_len = cpu_to_le16(len);
+		ext[nr_ext].ee_start_hi = 0;
+		ext[nr_ext].ee_start_lo = cpu_to_le32(blknr);
+		nr_ext++;
+	}
+
+	/* write the whole blocks of each extent, then any partial last block */
+	for (i = 0; i < nr_ext; i++) {
+		lblk = le32_to_cpu(ext[i].ee_block);
+		blknr = le32_to_cpu(ext[i].ee_start_lo);
+		bytes = min(le16_to_cpu(ext[i].ee_len) * fs->blksz,
+			    size - lblk * fs->blksz);
+		len = bytes / fs->blksz;
+		if (len)
+			put_ext4((uint64_t)blknr * fs->blksz,
+				 (void *)buf + lblk * fs->blksz,
+				 len * fs->blksz);
+		if (bytes % fs->blksz) {
+			memcpy(blk_buf, buf + (lblk + len) * fs->blksz,
+			       bytes % fs->blksz);
+			put_ext4((uint64_t)(blknr + len) * fs->blksz, blk_buf,
+				 fs->blksz);
+		}
+	}
+
+	eh->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+	eh->eh_max = cpu_to_le16(root_max);
+	if (nr_ext <= root_max) {
+		eh->eh_entries = cpu_to_le16(nr_ext);
+		eh->eh_depth = 0;
+		memcpy(eh + 1, ext, nr_ext * sizeof(*ext));
+	} else {
+		nr_leaf = DIV_ROUND_UP(nr_ext, leaf_max);
+		for (i = 0; i < nr_leaf; i++) {
+			blknr = ext4fs_get_new_blk_run(1, &len);
+			if (blknr == -1) {
+				printf("no block left to assign\n");
+				goto fail;
+			}
+			memset(blk_buf, '\0', fs->blksz);
+			leh = (struct ext4_extent_header *)blk_buf;
+			leh->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+			leh->eh_entries = cpu_to_le16(min(nr_ext - i * leaf_max,
+							  leaf_max));
+			leh->eh_max = cpu_to_le16(leaf_max);
+			memcpy(leh + 1, &ext[i * leaf_max],
+			       le16_to_cpu(leh->eh_entries) * sizeof(*ext));
+			put_ext4((uint64_t)blknr * fs->blksz, blk_buf,
+				 fs->blksz);
+
+			idx[i].ei_block = ext[i * leaf_max].ee_block;
+			idx[i].ei_leaf_lo = cpu_to_le32(blknr);
+			idx[i].ei_leaf_hi = 0;
+		}
+		eh->eh_entries = cpu_to_le16(nr_leaf);
+		eh->eh_depth = cpu_to_le16(1);
+		*total_no_of_block += nr_leaf;
+	}
+	file_inode->flags |= cpu_to_le32(EXT4_EXTENTS_FL);
+	ret = 0;
+fail:
+	free(blk_buf);
+	free(ext);
+
+	return ret;
+}
+
 int ext4fs_write(const char *fname, unsigned char *buffer,
 					unsigned long sizebytes)
 {
@@ -898,9 +1125,19 @@ int ext4fs_write(const char *fname, unsigned char *buffer,
 	file_inode->nlinks = 1;
 	file_inode->size = sizebytes;
 
-	/* Allocate data blocks */
-	ext4fs_allocate_blocks(file_inode, blocks_remaining,
-			       &blks_reqd_for_file);
+	/* Allocate data blocks, writing them straight away if using extents */
+	ret = -EOPNOTSUPP;
+	if (fs->sb->feature_incompat & EXT4_FEATURE_INCOMPAT_EXTENTS)
+		ret = ext4fs_write_extents(file_inode, blocks_remaining,
+					   &blks_reqd_for_file, (char *)buffer);
+	if (ret == -EOPNOTSUPP || ret == -EFBIG) {
+		fs->first_pass_bbmap = 0;
+		fs->curr_blkno = 0;
+		ext4fs_allocate_blocks(file_inode, blocks_remaining,
+				       &blks_reqd_for_file);
+	} else if (ret) {
+		goto fail;
+	}
 	file_inode->blockcnt = (blks_reqd_for_file * fs->blksz) >>
 		fs->dev_desc->log2blksz;
 
@@ -913,8 +1150,8 @@ int ext4fs_write(const char *fname, unsigned char *buffer,
 			(inodeno % __le32_to_cpu(sblock->inodes_per_group)) /
 			inodes_per_block;
 	blkoff = (inodeno % inodes_per_block) * fs->inodesz;
-	ext4fs_devread((lbaint_t)itable_blkno * fs->sect_perblk, 0, fs->blksz,
-		       temp_ptr);
+	if (ext4fs_read_metadata(temp_ptr, itable_blkno))
+		goto fail;
 	if (ext4fs_log_journal(temp_ptr, itable_blkno))
 		goto fail;
 
@@ -922,7 +1159,8 @@ int ext4fs_write(const char *fname, unsigned char *buffer,
 	if (ext4fs_put_metadata(temp_ptr, itable_blkno))
 		goto fail;
 	/* copy the file content into data blocks */
-	if (ext4fs_write_file(file_inode, 0, sizebytes, (char *)buffer) == -1) {
+	if (!(le32_to_cpu(file_inode->flags) & EXT4_EXTENTS_FL) &&
+	    ext4fs_write_file(file_inode, 0, sizebytes, (char *)buffer) == -1) {
 		printf("Error in copying content\n");
 		goto fail;
 	}
@@ -933,9 +1171,8 @@ int ext4fs_write(const char *fname, unsigned char *buffer,
 	     __le32_to_cpu(sblock->inodes_per_group)) / inodes_per_block;
 	blkoff = (parent_inodeno % inodes_per_block) * fs->inodesz;
 	if (parent_itable_blkno != itable_blkno) {
-		memset(temp_ptr, '\0', fs->blksz);
-		ext4fs_devread((lbaint_t)parent_itable_blkno * fs->sect_perblk,
-			       0, fs->blksz, temp_ptr);
+		if (ext4fs_read_metadata(temp_ptr, parent_itable_blkno))
+			goto fail;
 		if (ext4fs_log_journal(temp_ptr, parent_itable_blkno))
 			goto fail;
 
@@ -951,7 +1188,6 @@ int ext4fs_write(const char *fname, unsigned char *buffer,
 		 */
 		memcpy(temp_ptr + blkoff, g_parent_inode,
 		       sizeof(struct ext2_inode));
-		gd_index--;
 		if (ext4fs_put_metadata(temp_ptr, itable_blkno))
 			goto fail;
 		free(temp_ptr);
@@ -102,19 +102,19 @@ static void set_name(dir_entry *dirent, const char *filename)
 
 static __u8 num_of_fats;
 /*
- * Write fat buffer into block device
+ * Write the modified blocks of the fat buffer into block device
  */
 static int flush_fat_buffer(fsdata *mydata)
 {
-	int getsize = FATBUFBLOCKS;
-	__u32 fatlength = mydata->fatlength;
-	__u8 *bufptr = mydata->fatbuf;
-	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS;
+	int first = mydata->fatbuf_dirty_first;
+	int getsize = mydata->fatbuf_dirty_last - first + 1;
+	__u8 *bufptr = mydata->fatbuf + first * mydata->sect_size;
+	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS + first;
 
-	startblock += mydata->fat_sect;
+	if (first < 0)
+		return 0;
 
-	if (getsize > fatlength)
-		getsize = fatlength;
+	startblock += mydata->fat_sect;
 
 	/* Write FAT buf */
 	if (disk_write(startblock, getsize, bufptr) < 0) {
@@ -130,6 +130,7 @@ static int flush_fat_buffer(fsdata *mydata)
 			return -1;
 		}
 	}
+	mydata->fatbuf_dirty_first = -1;
 
 	return 0;
 }
@@ -186,11 +187,9 @@ static __u32 get_fatent_value(fsdata *mydata, __u32 entry)
 		fatlength *= mydata->sect_size;	/* We want it in bytes now */
 		startblock += mydata->fat_sect;	/* Offset from start of disk */
 
-		/* Write back the fatbuf to the disk */
-		if (mydata->fatbufnum != -1) {
-			if (flush_fat_buffer(mydata) < 0)
-				return -1;
-		}
+		/* Write back the fatbuf to the disk, if modified */
+		if (flush_fat_buffer(mydata) < 0)
+			return -1;
 
 		if (disk_read(startblock, getsize, bufptr) < 0) {
 			debug("Error reading FAT blocks\n");
@@ -469,6 +468,7 @@ get_long_file_name(fsdata *mydata, int curclust, __u8 *cluster,
 static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 {
 	__u32 bufnum, offset;
+	int blk;
 
 	switch (mydata->fatsize) {
 	case 32:
@@ -497,10 +497,8 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		if (getsize > fatlength)
 			getsize = fatlength;
 
-		if (mydata->fatbufnum != -1) {
-			if (flush_fat_buffer(mydata) < 0)
-				return -1;
-		}
+		if (flush_fat_buffer(mydata) < 0)
+			return -1;
 
 		if (disk_read(startblock, getsize, bufptr) < 0) {
 			debug("Error reading FAT blocks\n");
@@ -509,6 +507,20 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		mydata->fatbufnum = bufnum;
 	}
 
+	/*
+	 * Track the modified blocks, so that only those are written back
+	 * when the buffer is flushed
+	 */
+	blk = offset * (mydata->fatsize / 8) / mydata->sect_size;
+	if (mydata->fatbuf_dirty_first < 0) {
+		mydata->fatbuf_dirty_first = blk;
+		mydata->fatbuf_dirty_last = blk;
+	} else if (blk < mydata->fatbuf_dirty_first) {
+		mydata->fatbuf_dirty_first = blk;
+	} else if (blk > mydata->fatbuf_dirty_last) {
+		mydata->fatbuf_dirty_last = blk;
+	}
+
 	/* Set the actual entry */
 	switch (mydata->fatsize) {
 	case 32:
@@ -566,21 +578,39 @@ set_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer,
 	debug("clustnum: %d, startsect: %d\n", clustnum, startsect);
 
 	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+		__u32 nsects = min_t(unsigned long, size / mydata->sect_size,
+				     MAX_CLUSTSIZE / mydata->sect_size);
+		__u8 *tmpbuf = NULL;
 
 		printf("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		/* Write via an aligned bounce buffer, several blocks at once */
+		if (nsects) {
+			tmpbuf = memalign(ARCH_DMA_MINALIGN,
+					  nsects * mydata->sect_size);
+			if (!tmpbuf) {
+				debug("Error: allocating bounce buffer\n");
+				return -1;
+			}
+		}
+
 		while (size >= mydata->sect_size) {
-			memcpy(tmpbuf, buffer, mydata->sect_size);
-			ret = disk_write(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+			idx = min_t(unsigned long, size / mydata->sect_size,
+				    nsects);
+			memcpy(tmpbuf, buffer, idx * mydata->sect_size);
+			ret = disk_write(startsect, idx, tmpbuf);
+			if (ret != idx) {
 				debug("Error writing data (got %d)\n", ret);
+				free(tmpbuf);
 				return -1;
 			}
 
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			startsect += idx;
+			idx *= mydata->sect_size;
+			buffer += idx;
+			size -= idx;
 		}
+		free(tmpbuf);
 	} else if (size >= mydata->sect_size) {
 		idx = size / mydata->sect_size;
 		ret = disk_write(startsect, idx, buffer);
@@ -648,9 +678,6 @@ static void flush_dir_table(fsdata *mydata, dir_entry **dentptr)
 
 	dir_curclust = dir_newclust;
 
-	if (flush_fat_buffer(mydata) < 0)
-		return;
-
 	memset(get_dentfromdir_block, 0x00,
 		mydata->clust_size * mydata->sect_size);
 
@@ -677,10 +704,6 @@ static int clear_fatent(fsdata *mydata, __u32 entry)
 		entry = fat_val;
 	}
 
-	/* Flush fat buffer */
-	if (flush_fat_buffer(mydata) < 0)
-		return -1;
-
 	return 0;
 }
 
@@ -1014,6 +1037,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 	}
 
 	mydata->fatbufnum = -1;
+	mydata->fatbuf_dirty_first = -1;
 	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
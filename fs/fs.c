@@ -12,6 +12,7 @@
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
+#include <malloc.h>
 #include <sandboxfs.h>
 #include <ubifs_uboot.h>
 #include <asm/io.h>
@@ -314,6 +315,100 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	return ret;
 }
 
+#ifdef CONFIG_FS_DECOMP
+struct fs_decomp_priv {
+	struct fstype_info *info;
+	const char *filename;
+	void *buf;
+	loff_t pos;
+	loff_t size;
+	bool pending;
+};
+
+static long fs_decomp_in(void *ctx, const void **bufp)
+{
+	struct fs_decomp_priv *priv = ctx;
+	loff_t len, actread;
+
+	*bufp = priv->buf;
+	if (priv->pending) {
+		/* The first chunk was already read to detect the format */
+		priv->pending = false;
+		return priv->pos;
+	}
+
+	len = min_t(loff_t, priv->size - priv->pos, CONFIG_FS_DECOMP_BUF_SIZE);
+	if (!len)
+		return 0;
+	if (priv->info->read(priv->filename, priv->buf, priv->pos, len,
+			     &actread))
+		return -EIO;
+	priv->pos += actread;
+
+	return actread;
+}
+
+int fs_read_decomp(const char *filename, ulong addr, loff_t maxlen,
+		   loff_t *actread)
+{
+	struct fs_decomp_priv priv;
+	const u8 *magic;
+	void *dst;
+	long len;
+	int ret;
+
+	*actread = 0;
+	if (!maxlen && addr < gd->ram_top)
+		maxlen = gd->ram_top - addr;
+	priv.info = fs_get_info(fs_type);
+	priv.filename = filename;
+	priv.pos = 0;
+	priv.pending = false;
+	ret = priv.info->size(filename, &priv.size);
+	if (ret < 0) {
+		printf("** Unable to read file %s **\n", filename);
+		goto out;
+	}
+	priv.buf = malloc(CONFIG_FS_DECOMP_BUF_SIZE);
+	if (!priv.buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	len = fs_decomp_in(&priv, (const void **)&magic);
+	if (len < 4) {
+		ret = -EIO;
+		goto out_free;
+	}
+	priv.pending = true;
+
+	dst = map_sysmem(addr, maxlen);
+	if (magic[0] == 0x1f && magic[1] == 0x8b) {
+		ulong size;
+
+		ret = gunzip_stream(dst, maxlen, fs_decomp_in, &priv, &size);
+		*actread = size;
+#ifdef CONFIG_LZ4
+	} else if (!memcmp(magic, "\x04\x22\x4d\x18", 4)) {
+		size_t size = maxlen;
+
+		ret = ulz4fn_stream(fs_decomp_in, &priv, dst, &size);
+		*actread = size;
+#endif
+	} else {
+		printf("** Unrecognised compression format **\n");
+		ret = -EPROTONOSUPPORT;
+	}
+	unmap_sysmem(dst);
+
+out_free:
+	free(priv.buf);
+out:
+	fs_close();
+
+	return ret;
+}
+#endif
+
 int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	     loff_t *actwrite)
 {
@@ -353,18 +448,61 @@ int do_size(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	return 0;
 }
 
+/*
+ * Get the load address and filename from the arguments common to the load
+ * commands, falling back to the environment
+ */
+static int fs_get_load_args(int argc, char * const argv[], ulong *addrp,
+			    const char **filenamep)
+{
+	const char *addr_str;
+	char *ep;
+
+	if (argc >= 4) {
+		*addrp = simple_strtoul(argv[3], &ep, 16);
+		if (ep == argv[3] || *ep != '\0')
+			return CMD_RET_USAGE;
+	} else {
+		addr_str = getenv("loadaddr");
+		if (addr_str != NULL)
+			*addrp = simple_strtoul(addr_str, NULL, 16);
+		else
+			*addrp = CONFIG_SYS_LOAD_ADDR;
+	}
+	if (argc >= 5) {
+		*filenamep = argv[4];
+	} else {
+		*filenamep = getenv("bootfile");
+		if (!*filenamep) {
+			puts("** No boot file defined **\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void fs_print_load_time(loff_t len_read, unsigned long time)
+{
+	printf("%llu bytes read in %lu ms", len_read, time);
+	if (time > 0) {
+		puts(" (");
+		print_size(div_u64(len_read, time) * 1000, "/s");
+		puts(")");
+	}
+	puts("\n");
+}
+
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype)
 {
 	unsigned long addr;
-	const char *addr_str;
 	const char *filename;
 	loff_t bytes;
 	loff_t pos;
 	loff_t len_read;
 	int ret;
 	unsigned long time;
-	char *ep;
 
 	if (argc < 2)
 		return CMD_RET_USAGE;
@@ -374,26 +512,9 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	if (fs_set_blk_dev(argv[1], (argc >= 3) ? argv[2] : NULL, fstype))
 		return 1;
 
-	if (argc >= 4) {
-		addr = simple_strtoul(argv[3], &ep, 16);
-		if (ep == argv[3] || *ep != '\0')
-			return CMD_RET_USAGE;
-	} else {
-		addr_str = getenv("loadaddr");
-		if (addr_str != NULL)
-			addr = simple_strtoul(addr_str, NULL, 16);
-		else
-			addr = CONFIG_SYS_LOAD_ADDR;
-	}
-	if (argc >= 5) {
-		filename = argv[4];
-	} else {
-		filename = getenv("bootfile");
-		if (!filename) {
-			puts("** No boot file defined **\n");
-			return 1;
-		}
-	}
+	ret = fs_get_load_args(argc, argv, &addr, &filename);
+	if (ret)
+		return ret;
 	if (argc >= 6)
 		bytes = simple_strtoul(argv[5], NULL, 16);
 	else
@@ -409,13 +530,7 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	if (ret < 0)
 		return 1;
 
-	printf("%llu bytes read in %lu ms", len_read, time);
-	if (time > 0) {
-		puts(" (");
-		print_size(div_u64(len_read, time) * 1000, "/s");
-		puts(")");
-	}
-	puts("\n");
+	fs_print_load_time(len_read, time);
 
 	setenv_hex("fileaddr", addr);
 	setenv_hex("filesize", len_read);
@@ -423,6 +538,48 @@ int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	return 0;
 }
 
+#ifdef CONFIG_FS_DECOMP
+int do_load_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
+		   char * const argv[], int fstype)
+{
+	unsigned long addr;
+	const char *filename;
+	loff_t maxlen;
+	loff_t len_read;
+	int ret;
+	unsigned long time;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	if (argc > 6)
+		return CMD_RET_USAGE;
+
+	if (fs_set_blk_dev(argv[1], (argc >= 3) ? argv[2] : NULL, fstype))
+		return 1;
+
+	ret = fs_get_load_args(argc, argv, &addr, &filename);
+	if (ret)
+		return ret;
+	if (argc >= 6)
+		maxlen = simple_strtoul(argv[5], NULL, 16);
+	else
+		maxlen = 0;
+
+	time = get_timer(0);
+	ret = fs_read_decomp(filename, addr, maxlen, &len_read);
+	time = get_timer(time);
+	if (ret < 0)
+		return 1;
+
+	fs_print_load_time(len_read, time);
+
+	setenv_hex("fileaddr", addr);
+	setenv_hex("filesize", len_read);
+
+	return 0;
+}
+#endif
+
 int do_ls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	int fstype)
 {
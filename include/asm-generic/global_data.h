@@ -64,6 +64,8 @@ typedef struct global_data {
 	struct udevice	*dm_root;	/* Root instance for Driver Model */
 	struct udevice	*dm_root_f;	/* Pre-relocation root instance */
 	struct list_head uclass_root;	/* Head of core tree */
+	struct uclass **uclass_by_id;	/* Uclasses by ID, if allocated */
+	struct lists_compat_table *dm_compat_table; /* Drivers by compatible */
 #endif
 #ifdef CONFIG_TIMER
 	struct udevice	*timer;		/* Timer instance for Driver Model */
@@ -72,6 +74,16 @@ typedef struct global_data {
 	const void *fdt_blob;		/* Our device tree, NULL if none */
 	void *new_fdt;			/* Relocated FDT */
 	unsigned long fdt_size;		/* Space reserved for relocated FDT */
+#ifdef CONFIG_OF_CACHE
+	struct fdtdec_cache *fdt_cache;	/* Lookups in fdt_blob */
+#endif
+#ifdef CONFIG_OF_LIVE
+	struct device_node *of_root;	/* Live tree, NULL if not in use */
+#endif
+#ifdef CONFIG_OF_PREBIND
+	const void *prebind_blob;	/* fdt_blob checked against prebind */
+	bool prebind_ok;		/* prebind table matches fdt_blob */
+#endif
 	struct jt_funcs *jt;		/* jump table */
 	char env_buf[32];		/* buffer for getenv() before reloc. */
 #ifdef CONFIG_TRACE
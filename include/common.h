@@ -787,11 +787,40 @@ ulong	usec2ticks    (unsigned long usec);
 ulong	ticks2usec    (unsigned long ticks);
 int	init_timebase (void);
 
+/**
+ * typedef decomp_in_t - Supply the next chunk of input to a decompressor
+ *
+ * This is used by the streaming decompressors so that the compressed data
+ * does not need to be in memory all at once.
+ *
+ * @priv:	Private data passed to the decompressor by its caller
+ * @bufp:	Returns a pointer to the next chunk of compressed data, which
+ *		must remain valid until the next call
+ * @return number of bytes available at *bufp, 0 at the end of the input,
+ *	or -ve on error
+ */
+typedef long (*decomp_in_t)(void *priv, const void **bufp);
+
 /* lib/gunzip.c */
 int gunzip(void *, int, unsigned char *, unsigned long *);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset);
 
+/**
+ * gunzip_stream() - Decompress gzip data supplied in chunks
+ *
+ * The gzip header must be contained in the first chunk.
+ *
+ * @dst:	Destination for the uncompressed data
+ * @dstlen:	Size of the destination buffer
+ * @in:		Function to call to obtain more compressed data
+ * @priv:	Private data for @in
+ * @lenp:	Returns the number of uncompressed bytes
+ * @return 0 if OK, -1 on error
+ */
+int gunzip_stream(void *dst, ulong dstlen, decomp_in_t in, void *priv,
+		  ulong *lenp);
+
 /**
  * gzwrite progress indicators: defined weak to allow board-specific
  * overrides:
@@ -834,6 +863,40 @@ int gzwrite(unsigned char *src, int len,
 /* lib/lz4_wrapper.c */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * ulz4fn_stream() - Decompress an LZ4 frame supplied in chunks
+ *
+ * Blocks which are contained in a single chunk are decompressed directly
+ * from it. Others are first gathered into a buffer of the frame's maximum
+ * block size.
+ *
+ * @in:		Function to call to obtain more compressed data
+ * @priv:	Private data for @in
+ * @dst:	Destination for the uncompressed data
+ * @dstn:	Size of the destination buffer on entry, returns the number of
+ *		uncompressed bytes
+ * @return 0 if OK, -ve on error
+ */
+int ulz4fn_stream(decomp_in_t in, void *priv, void *dst, size_t *dstn);
+
+/**
+ * zstd_decompress() - Decompress Zstandard data
+ *
+ * The data may hold several frames, which are decompressed one after the
+ * other. Skippable frames are ignored.
+ *
+ * @src:	Compressed data
+ * @srcn:	Size of compressed data
+ * @dst:	Destination for the uncompressed data
+ * @dstn:	Size of the destination buffer on entry, returns the number of
+ *		uncompressed bytes, or the size of the buffer if it was too
+ *		small
+ * @return 0 if OK, -ENOSPC if the buffer is too small, -ENOMEM if out of
+ *	memory, -EPROTONOSUPPORT if the data is not supported, -EINVAL if it
+ *	is corrupt
+ */
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn);
+
 /* lib/qsort.c */
 void qsort(void *base, size_t nmemb, size_t size,
 	   int(*compar)(const void *, const void *));
@@ -0,0 +1,180 @@
+/*
+ * Running independent work on secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __CPU_WORK_H
+#define __CPU_WORK_H
+
+#include <errno.h>
+
+/**
+ * struct cpu_work - A piece of work which can run on any CPU
+ *
+ * The work function must not call anything which is not safe to run in
+ * parallel with the boot CPU: in particular it must not allocate memory,
+ * print or access devices. Hashing or copying memory is fine.
+ *
+ * The structure must stay valid until cpu_work_wait() has returned.
+ *
+ * @func:	Function to call
+ * @arg:	Argument to pass to @func
+ * @done:	Set to 1 when @func has returned
+ */
+struct cpu_work {
+	void (*func)(void *arg);
+	void *arg;
+	int done;
+};
+
+#ifdef CONFIG_CPU_WORK
+/**
+ * cpu_work_queue() - Queue work to run on a secondary CPU
+ *
+ * The secondary CPUs are started the first time this is called. If there
+ * are none, or the queue is full, the work is run immediately instead.
+ *
+ * @work:	Work to run, with @func and @arg filled in
+ */
+void cpu_work_queue(struct cpu_work *work);
+
+/**
+ * cpu_work_queue_on() - Queue work to run on a particular secondary CPU
+ *
+ * Each secondary CPU has a mailbox holding one piece of work for it alone,
+ * which it runs before anything in the shared queue.
+ *
+ * @cpu:	Secondary CPU number, starting at 1
+ * @work:	Work to run, with @func and @arg filled in
+ * @return 0 if OK, -ENODEV if there is no such CPU, -EBUSY if the CPU has
+ *	not yet taken the last work queued for it
+ */
+int cpu_work_queue_on(int cpu, struct cpu_work *work);
+
+/**
+ * cpu_work_call_all() - Run a function on every CPU and wait for it
+ *
+ * The function runs once on each secondary CPU and once on the calling CPU,
+ * which then waits for the others to finish. The function can use
+ * cpu_work_id() to decide which part of a job to do. This must be called
+ * on the boot CPU.
+ *
+ * @func:	Function to call
+ * @arg:	Argument to pass to @func
+ * @return number of CPUs which ran @func, including the calling CPU
+ */
+int cpu_work_call_all(void (*func)(void *arg), void *arg);
+
+/**
+ * cpu_work_id() - Get the number of the CPU running the caller
+ *
+ * @return 0 on the boot CPU, else the secondary CPU number, starting at 1
+ */
+int cpu_work_id(void);
+
+/**
+ * cpu_work_wait() - Wait for queued work to finish
+ *
+ * While waiting, the calling CPU runs other queued work itself, and resets
+ * the watchdog. It must be the boot CPU.
+ *
+ * @work:	Work previously passed to cpu_work_queue()
+ */
+void cpu_work_wait(struct cpu_work *work);
+
+/**
+ * cpu_work_cpus() - Get the number of secondary CPUs running work
+ *
+ * The secondary CPUs are started if this has not been done already, so that
+ * callers can decide whether it is worth splitting up their work.
+ *
+ * @return number of secondary CPUs, 0 if there are none
+ */
+int cpu_work_cpus(void);
+
+/**
+ * cpu_work_secondary() - Run queued work on a secondary CPU
+ *
+ * This is called by the architecture code on each secondary CPU, running
+ * on the stack that was passed to arch_cpu_work_start(). It does not
+ * return.
+ *
+ * @cpu:	Secondary CPU number, starting at 1
+ */
+void cpu_work_secondary(int cpu) __attribute__((noreturn));
+
+/**
+ * arch_cpu_work_cpus() - Get the number of secondary CPUs available
+ *
+ * The default implementation returns 0, so that all work runs on the boot
+ * CPU.
+ *
+ * @return number of secondary CPUs which can be started
+ */
+int arch_cpu_work_cpus(void);
+
+/**
+ * arch_cpu_work_start() - Start a secondary CPU
+ *
+ * This must arrange for the CPU to call cpu_work_secondary() on the given
+ * stack.
+ *
+ * @cpu:	Secondary CPU number, starting at 1
+ * @stack:	Base of the stack for the CPU
+ * @size:	Size of the stack in bytes
+ * @return 0 if OK, -ve on error
+ */
+int arch_cpu_work_start(int cpu, void *stack, ulong size);
+
+/**
+ * arch_cpu_work_idle() - Called by a secondary CPU when there is no work
+ *
+ * This can put the CPU into a low-power wait. The default does nothing.
+ */
+void arch_cpu_work_idle(void);
+
+/**
+ * arch_cpu_work_id() - Get the number of the CPU running the caller
+ *
+ * This must return the number passed to cpu_work_secondary() on secondary
+ * CPUs. The default returns 0, which is correct when there are none.
+ *
+ * @return 0 on the boot CPU, else the secondary CPU number
+ */
+int arch_cpu_work_id(void);
+#else
+static inline void cpu_work_queue(struct cpu_work *work)
+{
+	work->func(work->arg);
+	work->done = 1;
+}
+
+static inline void cpu_work_wait(struct cpu_work *work)
+{
+}
+
+static inline int cpu_work_cpus(void)
+{
+	return 0;
+}
+
+static inline int cpu_work_queue_on(int cpu, struct cpu_work *work)
+{
+	return -ENODEV;
+}
+
+static inline int cpu_work_call_all(void (*func)(void *arg), void *arg)
+{
+	func(arg);
+
+	return 1;
+}
+
+static inline int cpu_work_id(void)
+{
+	return 0;
+}
+#endif
+
+#endif
@@ -89,6 +89,28 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_async() - Start probing a device, without waiting for it
+ *
+ * This is the same as device_probe() except that if the driver's probe()
+ * method returns -EINPROGRESS, the device is left to finish probing in the
+ * background, as dm_probe_poll() is called. Probing finishes at the latest
+ * when the device is first used, since device_probe() waits for it.
+ *
+ * @dev: Pointer to device to probe
+ * @return 0 if OK or still in progress, -ve on error
+ */
+int device_probe_async(struct udevice *dev);
+
+/**
+ * device_probe_cancel() - Stop polling a device whose probing is unfinished
+ *
+ * This is called when such a device is removed.
+ *
+ * @dev: Pointer to device
+ */
+void device_probe_cancel(struct udevice *dev);
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
@@ -124,6 +146,21 @@ void device_free(struct udevice *dev);
 static inline void device_free(struct udevice *dev) {}
 #endif
 
+/* Size of an area in a packed device, keeping the next one aligned */
+#define DM_PACK_SIZE(size)	ALIGN(size, 2 * sizeof(size_t))
+
+/**
+ * device_child_size() - Get the size of the data a parent keeps for a child
+ *
+ * The parent's driver can set the size, or else its uclass driver.
+ *
+ * @parent:	Parent device, or NULL if none
+ * @plat:	true for the size of the parent platdata, false for the size
+ *		of the parent private data
+ * @return size in bytes, 0 if none
+ */
+int device_child_size(struct udevice *parent, bool plat);
+
 /**
  * simple_bus_translate() - translate a bus address to a system address
  *
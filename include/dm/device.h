@@ -46,6 +46,15 @@ struct driver_info;
 
 #define DM_FLAG_OF_PLATDATA		(1 << 8)
 
+/* Driver's probe() may return -EINPROGRESS, to be called again later */
+#define DM_FLAG_PROBE_ASYNC		(1 << 9)
+
+/* Device's probe() has returned -EINPROGRESS and has not yet finished */
+#define DM_FLAG_PROBING			(1 << 10)
+
+/* Device's auto-allocated data is part of the device's own allocation */
+#define DM_FLAG_PACKED			(1 << 11)
+
 /**
  * struct udevice - An instance of a driver
  *
@@ -68,7 +77,6 @@ struct driver_info;
  * @platdata: Configuration data for this device
  * @parent_platdata: The parent bus's configuration data for this device
  * @uclass_platdata: The uclass's configuration data for this device
- * @of_offset: Device tree node offset for this device (- for none)
  * @driver_data: Driver data word for the entry that matched this device with
  *		its driver
  * @parent: Parent of this device, or NULL for the top level device
@@ -79,6 +87,7 @@ struct driver_info;
  * @uclass_node: Used by uclass to link its devices
  * @child_head: List of children of this device
  * @sibling_node: Next device in list of all devices
+ * @of_offset: Device tree node offset for this device (- for none)
  * @flags: Flags for this device DM_FLAG_...
  * @req_seq: Requested sequence number for this device (-1 = any)
  * @seq: Allocated sequence number for this device (-1 = none). This is set up
@@ -94,7 +103,6 @@ struct udevice {
 	void *platdata;
 	void *parent_platdata;
 	void *uclass_platdata;
-	int of_offset;
 	ulong driver_data;
 	struct udevice *parent;
 	void *priv;
@@ -104,6 +112,7 @@ struct udevice {
 	struct list_head uclass_node;
 	struct list_head child_head;
 	struct list_head sibling_node;
+	int of_offset;
 	uint32_t flags;
 	int req_seq;
 	int seq;
@@ -119,7 +128,9 @@ struct udevice {
 #define device_get_ops(dev)	(dev->driver->ops)
 
 /* Returns non-zero if the device is active (probed and not removed) */
-#define device_active(dev)	((dev)->flags & DM_FLAG_ACTIVATED)
+#define device_active(dev)	(((dev)->flags & (DM_FLAG_ACTIVATED | \
+						  DM_FLAG_PROBING)) == \
+				 DM_FLAG_ACTIVATED)
 
 /**
  * struct udevice_id - Lists the compatible strings supported by a driver
@@ -155,7 +166,11 @@ struct udevice_id {
  * @of_match: List of compatible strings to match, and any identifying data
  * for each.
  * @bind: Called to bind a device to its driver
- * @probe: Called to probe a device, i.e. activate it
+ * @probe: Called to probe a device, i.e. activate it. If the driver has the
+ * DM_FLAG_PROBE_ASYNC flag, this may start a slow operation and return
+ * -EINPROGRESS, in which case it is called again until it returns something
+ * else. Each call should return quickly, so that other devices can make
+ * progress in the meantime. @remove may be called before probing finishes.
  * @remove: Called to remove a device, i.e. de-activate it
  * @unbind: Called to unbind a device from its driver
  * @ofdata_to_platdata: Called before probe to decode device tree data
@@ -60,6 +60,24 @@ int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 		   struct udevice **devp);
 
+/**
+ * lists_bind_compat() - bind a device tree node, given its compatible strings
+ *
+ * This is lists_bind_fdt() for a node whose compatible strings are already
+ * known, so the device tree is not read.
+ *
+ * @parent: parent device
+ * @name: name of the node, which becomes the name of the device
+ * @compat: compatible strings of the node, each nul-terminated
+ * @compat_len: length of @compat in bytes
+ * @offset: offset of this device tree node
+ * @devp: if non-NULL, returns a pointer to the bound device
+ * @return 0 if OK (including if no driver matches), -ve on error
+ */
+int lists_bind_compat(struct udevice *parent, const char *name,
+		      const char *compat, int compat_len, int offset,
+		      struct udevice **devp);
+
 /**
  * device_bind_driver() - bind a device to a driver
  *
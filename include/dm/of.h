@@ -0,0 +1,115 @@
+/*
+ * Live (unflattened) device tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __DM_OF_H
+#define __DM_OF_H
+
+#include <asm/global_data.h>
+
+/**
+ * struct property - A property of a node in the live tree
+ *
+ * @name:	Property name, pointing into the flat tree
+ * @length:	Length of the value in bytes
+ * @value:	Value, pointing into the flat tree
+ * @next:	Next property of the node, or NULL if none
+ */
+struct property {
+	const char *name;
+	int length;
+	const void *value;
+	struct property *next;
+};
+
+/**
+ * struct device_node - A node in the live tree
+ *
+ * The nodes are held in an array, in the order in which they appear in the
+ * flat tree, so children and siblings follow their parents.
+ *
+ * @name:	Node name including any unit address, pointing into the flat
+ *		tree
+ * @phandle:	Phandle of the node, or 0 if none
+ * @offset:	Offset of the node in the flat tree
+ * @properties:	First property, or NULL if none
+ * @parent:	Parent node, or NULL for the root
+ * @child:	First child node, or NULL if none
+ * @sibling:	Next sibling node, or NULL if none
+ */
+struct device_node {
+	const char *name;
+	uint32_t phandle;
+	int offset;
+	struct property *properties;
+	struct device_node *parent;
+	struct device_node *child;
+	struct device_node *sibling;
+};
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * of_live_active() - Check if the live tree is in use
+ *
+ * Once U-Boot has relocated, the control device tree is unflattened into a
+ * live tree (if CONFIG_OF_LIVE is enabled) and read from there.
+ *
+ * @return true if the live tree is in use, false if the flat tree is
+ */
+static inline bool of_live_active(void)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE)
+	return gd->of_root != NULL;
+#else
+	return false;
+#endif
+}
+
+/**
+ * of_live_build() - Unflatten a device tree into a live tree
+ *
+ * The names and values of the live tree point into the flat tree, which
+ * must not be moved or changed while the live tree is in use.
+ *
+ * @fdt_blob:	Flat device tree to unflatten
+ * @rootp:	Returns the root node of the live tree
+ * @return 0 if OK, -ve on error
+ */
+int of_live_build(const void *fdt_blob, struct device_node **rootp);
+
+/**
+ * of_live_drop() - Stop using the live tree
+ *
+ * This frees the live tree, so that reads go back to the flat tree. It must
+ * be called before the control device tree is changed or moved.
+ */
+#if CONFIG_IS_ENABLED(OF_LIVE)
+void of_live_drop(void);
+#else
+static inline void of_live_drop(void)
+{
+}
+#endif
+
+/**
+ * of_find_node_by_offset() - Find the live node for a flat tree offset
+ *
+ * @offset:	Offset of a node in the flat tree
+ * @return node, or NULL if @offset is not the offset of a node
+ */
+struct device_node *of_find_node_by_offset(int offset);
+
+/**
+ * of_find_property() - Find a property of a live node
+ *
+ * @np:		Node to look in
+ * @name:	Name of the property
+ * @return property, or NULL if not found
+ */
+struct property *of_find_property(const struct device_node *np,
+				  const char *name);
+
+#endif
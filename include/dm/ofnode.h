@@ -0,0 +1,198 @@
+/*
+ * Access to device tree nodes, in either the flat or the live tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __DM_OFNODE_H
+#define __DM_OFNODE_H
+
+#include <dm/of.h>
+
+/**
+ * ofnode - A node in the control device tree
+ *
+ * Before relocation, or if CONFIG_OF_LIVE is not enabled, this holds the
+ * offset of the node in the flat tree (gd->fdt_blob). Once the live tree is
+ * in use it holds a pointer to the live node instead. Either way, the node
+ * can be read with the ofnode_...() functions without knowing which.
+ *
+ * An ofnode refers to the tree that is in use when it is created, so it
+ * should not be kept across relocation.
+ *
+ * @np:		Live tree node, if of_live_active()
+ * @of_offset:	Flat tree offset, if !of_live_active()
+ */
+typedef union ofnode_union {
+	const struct device_node *np;
+	long of_offset;
+} ofnode;
+
+/**
+ * ofnode_valid() - Check if an ofnode refers to a node
+ *
+ * @node:	Node to check
+ * @return true if @node is a node, false if it is a null node
+ */
+static inline bool ofnode_valid(ofnode node)
+{
+	if (of_live_active())
+		return node.np != NULL;
+	else
+		return node.of_offset >= 0;
+}
+
+/**
+ * ofnode_null() - Get a null ofnode, which does not refer to any node
+ */
+static inline ofnode ofnode_null(void)
+{
+	ofnode node;
+
+	if (of_live_active())
+		node.np = NULL;
+	else
+		node.of_offset = -1;
+
+	return node;
+}
+
+/**
+ * ofnode_to_offset() - Get the flat tree offset of a node
+ *
+ * @node:	Node to convert
+ * @return offset of the node in gd->fdt_blob, or -1 if @node is null
+ */
+static inline int ofnode_to_offset(ofnode node)
+{
+	if (of_live_active())
+		return node.np ? node.np->offset : -1;
+
+	return node.of_offset;
+}
+
+/**
+ * offset_to_ofnode() - Get the node at a flat tree offset
+ *
+ * @of_offset:	Offset of the node in gd->fdt_blob
+ * @return node, or a null node if @of_offset is not the offset of a node
+ */
+static inline ofnode offset_to_ofnode(int of_offset)
+{
+	ofnode node;
+
+	if (of_live_active())
+		node.np = of_find_node_by_offset(of_offset);
+	else
+		node.of_offset = of_offset;
+
+	return node;
+}
+
+/**
+ * ofnode_get_property() - Get a property of a node
+ *
+ * @node:	Node to look in
+ * @propname:	Name of the property
+ * @lenp:	If non-NULL, returns the length of the value in bytes, or
+ *		-FDT_ERR_NOTFOUND if the property is not found
+ * @return value of the property, or NULL if not found
+ */
+const void *ofnode_get_property(ofnode node, const char *propname,
+				int *lenp);
+
+/**
+ * ofnode_read_u32() - Read a 32-bit integer from a property
+ *
+ * @node:	Node to look in
+ * @propname:	Name of the property
+ * @outp:	Returns the value, which is left alone on error
+ * @return 0 if OK, -EINVAL if the property is not found, -EOVERFLOW if it
+ * is too small to hold an integer
+ */
+int ofnode_read_u32(ofnode node, const char *propname, u32 *outp);
+
+/**
+ * ofnode_read_u32_default() - Read a 32-bit integer, with a default
+ *
+ * @node:	Node to look in
+ * @propname:	Name of the property
+ * @def:	Value to return if the property cannot be read
+ * @return value of the property, or @def
+ */
+int ofnode_read_u32_default(ofnode node, const char *propname, u32 def);
+
+/**
+ * ofnode_read_string() - Read a string from a property
+ *
+ * @node:	Node to look in
+ * @propname:	Name of the property
+ * @return string, or NULL if the property is not found or is not a
+ * nul-terminated string
+ */
+const char *ofnode_read_string(ofnode node, const char *propname);
+
+/**
+ * ofnode_read_bool() - Check if a node has a property
+ *
+ * @node:	Node to look in
+ * @propname:	Name of the property
+ * @return true if the property exists, whatever its value
+ */
+bool ofnode_read_bool(ofnode node, const char *propname);
+
+/**
+ * ofnode_is_available() - Check if a node is enabled
+ *
+ * @node:	Node to check
+ * @return true unless the node has a "status" property other than "okay"
+ */
+bool ofnode_is_available(ofnode node);
+
+/**
+ * ofnode_get_name() - Get the name of a node
+ *
+ * @node:	Node to look at
+ * @return name, including any unit address, or NULL if @node is null
+ */
+const char *ofnode_get_name(ofnode node);
+
+/**
+ * ofnode_first_subnode() - Get the first subnode of a node
+ *
+ * @node:	Parent node
+ * @return first subnode, or a null node if none
+ */
+ofnode ofnode_first_subnode(ofnode node);
+
+/**
+ * ofnode_next_subnode() - Get the next sibling of a node
+ *
+ * @node:	Node to start from
+ * @return next subnode of the same parent, or a null node if none
+ */
+ofnode ofnode_next_subnode(ofnode node);
+
+/**
+ * ofnode_path() - Find a node by path or alias
+ *
+ * @path:	Full path of the node, or an alias
+ * @return node, or a null node if not found
+ */
+ofnode ofnode_path(const char *path);
+
+/**
+ * ofnode_get_by_phandle() - Find a node by phandle
+ *
+ * @phandle:	Phandle to look for
+ * @return node, or a null node if not found
+ */
+ofnode ofnode_get_by_phandle(uint phandle);
+
+/* Iterate over the subnodes of a node */
+#define ofnode_for_each_subnode(subnode, node) \
+	for (subnode = ofnode_first_subnode(node); \
+	     ofnode_valid(subnode); \
+	     subnode = ofnode_next_subnode(subnode))
+
+#endif
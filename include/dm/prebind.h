@@ -0,0 +1,122 @@
+/*
+ * Device tree nodes found at build time, for binding without the tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __DM_PREBIND_H
+#define __DM_PREBIND_H
+
+/* The node has a "u-boot,dm-pre-reloc" property */
+#define DM_PREBIND_PRE_RELOC	(1 << 0)
+
+/**
+ * struct dm_prebind_node - A node to bind, as found by dtoc
+ *
+ * Only nodes which are enabled and have a compatible string are listed.
+ *
+ * @name:	Node name including any unit address
+ * @compat:	Compatible strings, each nul-terminated
+ * @aliases:	Names of the aliases which fdtdec_get_alias_seq() would
+ *		consider for this node, in order, NULL-terminated, or NULL
+ *		if none
+ * @compat_len:	Length of @compat in bytes
+ * @offset:	Offset of the node in the device tree
+ * @flags:	DM_PREBIND_... flags
+ */
+struct dm_prebind_node {
+	const char *name;
+	const char *compat;
+	const char *const *aliases;
+	int compat_len;
+	int offset;
+	uint flags;
+};
+
+/**
+ * struct dm_prebind_parent - The nodes to bind below a parent node
+ *
+ * @offset:	Offset of the parent node in the device tree
+ * @first:	Index of the first child in dm_prebind.child
+ * @count:	Number of children
+ */
+struct dm_prebind_parent {
+	int offset;
+	int first;
+	int count;
+};
+
+/**
+ * struct dm_prebind - Nodes to bind, generated by 'dtoc bind'
+ *
+ * @fdt_size:	Size of the device tree that the table was generated from
+ * @fdt_crc:	CRC32 of that device tree, which must match the control
+ *		device tree for the table to be used
+ * @node:	Nodes, in order of offset
+ * @num_nodes:	Number of nodes
+ * @parent:	Parents, in order of offset
+ * @num_parents: Number of parents
+ * @child:	Index in @node of each child, grouped by parent
+ */
+struct dm_prebind {
+	u32 fdt_size;
+	u32 fdt_crc;
+	const struct dm_prebind_node *node;
+	int num_nodes;
+	const struct dm_prebind_parent *parent;
+	int num_parents;
+	const u16 *child;
+};
+
+/* Generated by dtoc from the control device tree */
+extern const struct dm_prebind dm_prebind;
+
+/**
+ * dm_prebind_valid() - Check if the table matches the control device tree
+ *
+ * The check is done once for each position of gd->fdt_blob, and again after
+ * dm_prebind_invalidate().
+ *
+ * @return true if the table can be used instead of gd->fdt_blob
+ */
+bool dm_prebind_valid(void);
+
+/**
+ * dm_prebind_invalidate() - Check the table again before it is next used
+ *
+ * This must be called when the control device tree is changed in place.
+ */
+#if CONFIG_IS_ENABLED(OF_PREBIND)
+void dm_prebind_invalidate(void);
+#else
+static inline void dm_prebind_invalidate(void)
+{
+}
+#endif
+
+/**
+ * dm_prebind_scan() - Bind devices for the subnodes of a node
+ *
+ * This does the same as dm_scan_fdt_node(), using the table.
+ *
+ * @parent:	Parent device for the devices that will be created
+ * @offset:	Offset of the node to scan
+ * @pre_reloc_only: If true, bind only nodes with "u-boot,dm-pre-reloc"
+ * @return 0 if OK, -ve on error
+ */
+int dm_prebind_scan(struct udevice *parent, int offset, bool pre_reloc_only);
+
+/**
+ * dm_prebind_alias_seq() - Get the alias sequence number of a node
+ *
+ * This does the same as fdtdec_get_alias_seq(), using the table.
+ *
+ * @base:	Base name for alias (before the number)
+ * @offset:	Offset of the node
+ * @seqp:	Set to the sequence number if one is found
+ * @return 0 if found, -ENOENT if not, -ENODEV if the node is not in the
+ * table
+ */
+int dm_prebind_alias_seq(const char *base, int offset, int *seqp);
+
+#endif
@@ -38,7 +38,7 @@ int dm_scan_platdata(bool pre_reloc_only);
  * This scans the device tree and creates a driver for each node. Only
  * the top-level subnodes are examined.
  *
- * @blob: Pointer to device tree blob
+ * @blob: Pointer to device tree blob, which must be gd->fdt_blob
  * @pre_reloc_only: If true, bind only drivers with the DM_FLAG_PRE_RELOC
  * flag. If false bind all drivers.
  * @return 0 if OK, -ve on error
@@ -52,7 +52,7 @@ int dm_scan_fdt(const void *blob, bool pre_reloc_only);
  * for each one.
  *
  * @parent: Parent device for the devices that will be created
- * @blob: Pointer to device tree blob
+ * @blob: Pointer to device tree blob, which must be gd->fdt_blob
  * @offset: Offset of node to scan
  * @pre_reloc_only: If true, bind only drivers with the DM_FLAG_PRE_RELOC
  * flag. If false bind all drivers.
@@ -105,4 +105,35 @@ int dm_init(void);
  */
 int dm_uninit(void);
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/**
+ * dm_probe_async_all() - Start probing devices which can probe in background
+ *
+ * This calls device_probe_async() for every bound device whose driver has
+ * the DM_FLAG_PROBE_ASYNC flag, so that their slow operations overlap with
+ * each other and with the rest of start-up.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int dm_probe_async_all(void);
+
+/**
+ * dm_probe_poll() - Let devices which are probing in background progress
+ *
+ * This calls the probe() method of each device whose probing is unfinished.
+ * It should be called wherever U-Boot waits for something, such as while
+ * waiting for a key press.
+ */
+void dm_probe_poll(void);
+#else
+static inline int dm_probe_async_all(void)
+{
+	return 0;
+}
+
+static inline void dm_probe_poll(void)
+{
+}
+#endif
+
 #endif
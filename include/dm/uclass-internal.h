@@ -138,6 +138,17 @@ int uclass_unbind_device(struct udevice *dev);
 static inline int uclass_unbind_device(struct udevice *dev) { return 0; }
 #endif
 
+/**
+ * uclass_set_seq() - Set the sequence number of a device
+ *
+ * This sets dev->seq and keeps the uclass's table of devices by sequence
+ * number up to date, so that uclass_find_device_by_seq() can use it.
+ *
+ * @dev:	Pointer to the device
+ * @seq:	New sequence number, or -1 if the device no longer has one
+ */
+void uclass_set_seq(struct udevice *dev, int seq);
+
 /**
  * uclass_pre_probe_device() - Deal with a device that is about to be probed
  *
@@ -30,12 +30,18 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @seq_dev: Active devices indexed by sequence number (dev->seq), for
+ * sequence numbers below @seq_size
+ * @seq_size: Number of entries in @seq_dev, or -1 if the uclass does not
+ * keep this table, in which case its device list is searched instead
  */
 struct uclass {
 	void *priv;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+	struct udevice **seq_dev;
+	int seq_size;
 };
 
 struct driver;
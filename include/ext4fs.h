@@ -30,6 +30,7 @@
 
 #define EXT4_EXTENTS_FL		0x00080000 /* Inode uses extents */
 #define EXT4_EXT_MAGIC			0xf30a
+#define EXT4_EXT_INIT_MAX_LEN		(1 << 15) /* Max blocks in an extent */
 #define EXT4_FEATURE_RO_COMPAT_GDT_CSUM	0x0010
 #define EXT4_FEATURE_INCOMPAT_EXTENTS	0x0040
 #define EXT4_FEATURE_INCOMPAT_64BIT	0x0080
@@ -108,6 +109,9 @@ struct ext_filesystem {
 	int curr_inode_no;
 	uint16_t first_pass_ibmap;
 
+	/* Block groups whose bitmaps must be written back (BG_*_DIRTY) */
+	unsigned char *bg_dirty;
+
 	/* Journal Related */
 
 	/* Block Device Descriptor */
@@ -45,6 +45,165 @@ int fdt_chosen(void *fdt);
  */
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end);
 
+/**
+ * struct fdt_batch - A set of edits to make to an FDT in one pass
+ *
+ * Each fdt_setprop() or fdt_add_subnode() call moves the rest of the tree
+ * to make room, so many fixups on a large tree spend most of their time
+ * in memmove(). Instead, edits can be collected in a batch while the tree
+ * is left untouched, then fdt_batch_commit() rewrites the tree once. The
+ * result is the same as making the edits one at a time with libfdt.
+ *
+ * Nodes are referred to by a handle from fdt_batch_node() or
+ * fdt_batch_subnode(). Since the tree does not change until the commit,
+ * node offsets and property values read from it remain valid while the
+ * batch is being built.
+ *
+ * Errors are remembered and returned by fdt_batch_commit(), so callers
+ * need only check that.
+ *
+ * All members are internal.
+ */
+struct fdt_batch {
+	void *fdt;
+	struct fdt_batch_node *node;
+	int nodes;
+	struct fdt_batch_prop *prop;
+	int props;
+	struct fdt_reserve_entry *rsv;
+	int rsvs;
+	char *strings;
+	int strings_size;
+	int err;
+};
+
+/**
+ * fdt_batch_init() - Start a batch of edits
+ *
+ * @batch:	Batch to set up
+ * @fdt:	FDT to edit
+ */
+void fdt_batch_init(struct fdt_batch *batch, void *fdt);
+
+/**
+ * fdt_batch_node() - Get the handle of an existing node
+ *
+ * @batch:	Batch to update
+ * @nodeoffset:	Offset of the node in the FDT
+ * @return node handle, or -FDT_ERR_... on error
+ */
+int fdt_batch_node(struct fdt_batch *batch, int nodeoffset);
+
+/**
+ * fdt_batch_subnode() - Get the handle of a subnode, adding it if needed
+ *
+ * @batch:	Batch to update
+ * @node:	Handle of the parent node
+ * @name:	Name of the subnode
+ * @return node handle, or -FDT_ERR_... on error
+ */
+int fdt_batch_subnode(struct fdt_batch *batch, int node, const char *name);
+
+/**
+ * fdt_batch_setprop() - Set a property, adding it if needed
+ *
+ * The value is copied, so it need not remain valid.
+ *
+ * @batch:	Batch to update
+ * @node:	Handle of the node
+ * @name:	Name of the property
+ * @val:	Value of the property
+ * @len:	Length of the value in bytes
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_setprop(struct fdt_batch *batch, int node, const char *name,
+		      const void *val, int len);
+
+static inline int fdt_batch_setprop_u32(struct fdt_batch *batch, int node,
+					const char *name, u32 val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return fdt_batch_setprop(batch, node, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_u64(struct fdt_batch *batch, int node,
+					const char *name, u64 val)
+{
+	fdt64_t tmp = cpu_to_fdt64(val);
+
+	return fdt_batch_setprop(batch, node, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_string(struct fdt_batch *batch, int node,
+					   const char *name, const char *str)
+{
+	return fdt_batch_setprop(batch, node, name, str, strlen(str) + 1);
+}
+
+/**
+ * fdt_batch_delprop() - Delete a property, if it exists
+ *
+ * @batch:	Batch to update
+ * @node:	Handle of the node
+ * @name:	Name of the property
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_delprop(struct fdt_batch *batch, int node, const char *name);
+
+/**
+ * fdt_batch_add_mem_rsv() - Add a memory reserve map entry
+ *
+ * @batch:	Batch to update
+ * @address:	Start of the reserved region
+ * @size:	Size of the reserved region in bytes
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_add_mem_rsv(struct fdt_batch *batch, u64 address, u64 size);
+
+/**
+ * fdt_batch_del_mem_rsv() - Delete a memory reserve map entry, if it exists
+ *
+ * Only the first entry with the given address is deleted.
+ *
+ * @batch:	Batch to update
+ * @address:	Start of the reserved region
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_del_mem_rsv(struct fdt_batch *batch, u64 address);
+
+/**
+ * fdt_batch_commit() - Make the edits in a batch and free it
+ *
+ * The FDT is rewritten in a single pass into a temporary buffer and copied
+ * back, so it is not changed if there is an error. A batch with only a few
+ * edits, or which cannot get memory for the buffer, is made one edit at a
+ * time instead, in which case an error may leave some edits made.
+ *
+ * @batch:	Batch to commit
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_commit(struct fdt_batch *batch);
+
+/**
+ * fdt_batch_abort() - Free a batch without making its edits
+ *
+ * @batch:	Batch to free
+ */
+void fdt_batch_abort(struct fdt_batch *batch);
+
+/*
+ * These add the same edits as fdt_root(), fdt_chosen(), fdt_initrd(),
+ * fdt_fixup_memory_banks() and fdt_fixup_ethernet() to a batch.
+ */
+int fdt_batch_root(struct fdt_batch *batch);
+int fdt_batch_chosen(struct fdt_batch *batch);
+int fdt_batch_initrd(struct fdt_batch *batch, ulong initrd_start,
+		     ulong initrd_end);
+int fdt_batch_fixup_memory_banks(struct fdt_batch *batch, u64 start[],
+				 u64 size[], int banks);
+void fdt_batch_fixup_ethernet(struct fdt_batch *batch);
+
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
 		      const void *val, int len, int create);
 void do_fixup_by_path_u32(void *fdt, const char *path, const char *prop,
@@ -653,6 +653,55 @@ const char *fdtdec_get_compatible(enum fdt_compat_id id);
  */
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name);
 
+#if CONFIG_IS_ENABLED(OF_CACHE)
+/**
+ * fdtdec_node_offset_by_phandle() - Find the node with a given phandle
+ *
+ * This is fdt_node_offset_by_phandle(), but for the control device tree
+ * it uses a table built on first use rather than scanning the whole tree.
+ *
+ * @param blob		FDT blob
+ * @param phandle	Phandle to look for
+ * @return node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * fdtdec_path_offset() - Find the node with a given path or alias
+ *
+ * This is fdt_path_offset(), but for the control device tree it remembers
+ * the last few paths looked up.
+ *
+ * @param blob		FDT blob
+ * @param path		Path of the node, or an alias
+ * @return node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_cache_invalidate() - Drop the lookups cached for gd->fdt_blob
+ *
+ * This must be called after changing the control device tree, unless the
+ * change adds or removes a node or property or changes the size of one.
+ */
+void fdtdec_cache_invalidate(void);
+#else
+static inline int fdtdec_node_offset_by_phandle(const void *blob,
+						uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+static inline int fdtdec_path_offset(const void *blob, const char *path)
+{
+	return fdt_path_offset(blob, path);
+}
+
+static inline void fdtdec_cache_invalidate(void)
+{
+}
+#endif
+
 /**
  * Look up a property in a node and return its contents in an integer
  * array of given length. The property must have at least enough data for
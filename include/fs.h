@@ -64,6 +64,23 @@ int fs_size(const char *filename, loff_t *size);
 int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	    loff_t *actread);
 
+/*
+ * fs_read_decomp - Read a gzip or LZ4 compressed file from the partition
+ * previously set by fs_set_blk_dev() and decompress it as it is read
+ *
+ * The file is read in chunks of CONFIG_FS_DECOMP_BUF_SIZE bytes so that the
+ * compressed data never needs to be in memory all at once.
+ *
+ * @filename: Name of file to read from
+ * @addr: The address to decompress into
+ * @maxlen: Maximum number of uncompressed bytes. Maybe 0 to allow up to the
+ *	top of RAM
+ * @actread: Returns the number of uncompressed bytes
+ * @return 0 if ok with valid *actread, non-zero on error conditions
+ */
+int fs_read_decomp(const char *filename, ulong addr, loff_t maxlen,
+		   loff_t *actread);
+
 /*
  * fs_write - Write file to the partition previously set by fs_set_blk_dev()
  * Note that not all filesystem types support offset!=0.
@@ -86,6 +103,8 @@ int do_size(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
 int do_load(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
+int do_load_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
+		   char * const argv[], int fstype);
 int do_ls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
 int file_exists(const char *dev_type, const char *dev_part, const char *file,
@@ -10,7 +10,11 @@
  * Maximum digest size for all algorithms we support. Having this value
  * avoids a malloc() or C99 local declaration in common/cmd_hash.c.
  */
+#ifdef CONFIG_SHA512
+#define HASH_MAX_DIGEST_SIZE	64
+#else
 #define HASH_MAX_DIGEST_SIZE	32
+#endif
 
 enum {
 	HASH_FLAG_VERIFY	= 1 << 0,	/* Enable verify mode */
@@ -114,6 +118,18 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+/**
+ * hash_bench() - Measure the speed of each hash algorithm
+ *
+ * This hashes a block of memory with each algorithm in turn and prints the
+ * time taken and the rate in MB/s.
+ *
+ * @addr:	Address of data to hash
+ * @len:	Length of data to hash in bytes
+ * @return 0 (always)
+ */
+int hash_bench(ulong addr, ulong len);
+
 #endif /* !USE_HOSTCC */
 
 /**
@@ -296,6 +296,7 @@ enum {
 	IH_COMP_LZMA,			/* lzma  Compression Used	*/
 	IH_COMP_LZO,			/* lzo   Compression Used	*/
 	IH_COMP_LZ4,			/* lz4   Compression Used	*/
+	IH_COMP_ZSTD,			/* zstd  Compression Used	*/
 
 	IH_COMP_COUNT,
 };
@@ -353,6 +354,7 @@ typedef struct bootm_headers {
 	void		*fit_hdr_os;	/* os FIT image header */
 	const char	*fit_uname_os;	/* os subimage node unit name */
 	int		fit_noffset_os;	/* os subimage node offset */
+	int		fit_verify_os;	/* check os hashes while loading it */
 
 	void		*fit_hdr_rd;	/* init ramdisk FIT image header */
 	const char	*fit_uname_rd;	/* init ramdisk subimage node unit name */
@@ -1011,6 +1013,89 @@ int fit_check_ramdisk(const void *fit, int os_noffset,
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len);
 
+#if defined(CONFIG_FIT_STREAM_VERIFY) && !defined(USE_HOSTCC)
+# define IMAGE_ENABLE_STREAM_VERIFY	1
+#else
+# define IMAGE_ENABLE_STREAM_VERIFY	0
+#endif
+
+/*
+ * calculate_hash() resets the watchdog as it goes, which must only be done
+ * from the boot CPU, so hashes are not calculated in parallel with one.
+ */
+#if defined(CONFIG_CPU_WORK) && !defined(USE_HOSTCC) && \
+	!defined(CONFIG_SPL_BUILD) && !defined(CONFIG_HW_WATCHDOG) && \
+	!defined(CONFIG_WATCHDOG)
+# define IMAGE_ENABLE_PARALLEL_HASH	1
+#else
+# define IMAGE_ENABLE_PARALLEL_HASH	0
+#endif
+
+/* Maximum number of hash nodes which can be checked progressively */
+#define FIT_MAX_STREAM_HASHES	4
+
+/**
+ * struct fit_hash_stream - Hashes of an image being checked progressively
+ *
+ * @fit:	FIT containing the image
+ * @image_noffset: Offset of the image node
+ * @count:	Number of hash nodes
+ * @noffset:	Offset of each hash node
+ * @algo:	Algorithm of each hash node, NULL if it is to be ignored
+ * @ctx:	Progressive hashing context of each hash node
+ */
+struct fit_hash_stream {
+	const void *fit;
+	int image_noffset;
+	int count;
+	int noffset[FIT_MAX_STREAM_HASHES];
+	struct hash_algo *algo[FIT_MAX_STREAM_HASHES];
+	void *ctx[FIT_MAX_STREAM_HASHES];
+};
+
+/**
+ * fit_image_hash_start() - Start checking the hashes of an image
+ *
+ * This allows the image data to be hashed a chunk at a time, for example
+ * while it is being decompressed, instead of all at once by
+ * fit_image_verify(). Only hash nodes are supported: images with signature
+ * nodes are not, nor is anything when the control FDT has a required key,
+ * since the data must then be checked before it is decompressed.
+ *
+ * @fit:	FIT containing the image
+ * @image_noffset: Offset of the image node
+ * @hs:		Returns the hashing state, or NULL to only check whether the
+ *		image is supported
+ * @return 0 if OK, -EOPNOTSUPP if the image's hashes cannot be checked
+ *	progressively, other -ve on error
+ */
+int fit_image_hash_start(const void *fit, int image_noffset,
+			 struct fit_hash_stream *hs);
+
+/**
+ * fit_image_hash_update() - Add the next chunk of image data to the hashes
+ *
+ * @hs:		Hashing state from fit_image_hash_start()
+ * @buf:	Image data
+ * @size:	Number of bytes in @buf
+ * @is_last:	1 if this is the last chunk of the image, else 0
+ * @return 0 if OK, -ve on error
+ */
+int fit_image_hash_update(struct fit_hash_stream *hs, const void *buf,
+			  unsigned int size, int is_last);
+
+/**
+ * fit_image_hash_finish() - Check the hashes of an image
+ *
+ * This compares the hashes of the data passed to fit_image_hash_update()
+ * with those in the FIT, printing progress as fit_image_verify() does. The
+ * hashing state is freed in any case.
+ *
+ * @hs:		Hashing state from fit_image_hash_start()
+ * @return 1 if all hashes are valid, 0 otherwise (or on error)
+ */
+int fit_image_hash_finish(struct fit_hash_stream *hs);
+
 /*
  * At present we only support signing on the host, and verification on the
  * device
@@ -1019,14 +1104,17 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 # ifdef USE_HOSTCC
 #  define IMAGE_ENABLE_SIGN	1
 #  define IMAGE_ENABLE_VERIFY	1
+#  define IMAGE_ENABLE_VERIFY_ECDSA	1
 # include  <openssl/evp.h>
 #else
 #  define IMAGE_ENABLE_SIGN	0
 #  define IMAGE_ENABLE_VERIFY	1
+#  define IMAGE_ENABLE_VERIFY_ECDSA	CONFIG_IS_ENABLED(ECDSA)
 # endif
 #else
 # define IMAGE_ENABLE_SIGN	0
 # define IMAGE_ENABLE_VERIFY	0
+# define IMAGE_ENABLE_VERIFY_ECDSA	0
 #endif
 
 #ifdef USE_HOSTCC
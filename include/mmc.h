@@ -57,8 +57,18 @@
 #define MMC_MODE_8BIT		(1 << 3)
 #define MMC_MODE_SPI		(1 << 4)
 #define MMC_MODE_DDR_52MHz	(1 << 5)
+#define MMC_MODE_HS200		(1 << 6)
+#define MMC_MODE_HS400		(1 << 7)
+#define MMC_MODE_UHS_SDR50	(1 << 8)
+#define MMC_MODE_UHS_SDR104	(1 << 9)
+#define MMC_MODE_UHS_DDR50	(1 << 10)
+#define MMC_MODE_CMD23		(1 << 11)	/* SET_BLOCK_COUNT usable */
+
+#define MMC_MODE_UHS		(MMC_MODE_UHS_SDR50 | MMC_MODE_UHS_SDR104 | \
+				 MMC_MODE_UHS_DDR50)
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23	0x00000002	/* SET_BLOCK_COUNT supported */
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -81,6 +91,8 @@
 #define MMC_CMD_SET_BLOCKLEN		16
 #define MMC_CMD_READ_SINGLE_BLOCK	17
 #define MMC_CMD_READ_MULTIPLE_BLOCK	18
+#define MMC_CMD_SEND_TUNING_BLOCK	19
+#define MMC_CMD_SEND_TUNING_BLOCK_HS200	21
 #define MMC_CMD_SET_BLOCK_COUNT         23
 #define MMC_CMD_WRITE_SINGLE_BLOCK	24
 #define MMC_CMD_WRITE_MULTIPLE_BLOCK	25
@@ -110,9 +122,19 @@
 /* SCR definitions in different words */
 #define SD_HIGHSPEED_BUSY	0x00020000
 #define SD_HIGHSPEED_SUPPORTED	0x00020000
+#define SD_UHS_SDR50_SUPPORTED	0x00040000
+#define SD_UHS_SDR104_SUPPORTED	0x00080000
+#define SD_UHS_DDR50_SUPPORTED	0x00100000
+
+/* Function numbers in the access mode group (group 1) of CMD6 */
+#define SD_SWITCH_FUNC_HS	1
+#define SD_SWITCH_FUNC_SDR50	2
+#define SD_SWITCH_FUNC_SDR104	3
+#define SD_SWITCH_FUNC_DDR50	4
 
 #define OCR_BUSY		0x80000000
 #define OCR_HCS			0x40000000
+#define OCR_S18R		0x01000000	/* request / accept 1.8V signalling */
 #define OCR_VOLTAGE_MASK	0x007FFF80
 #define OCR_ACCESS_MODE		0x60000000
 
@@ -201,6 +223,15 @@
 #define EXT_CSD_CARD_TYPE_DDR_1_2V	(1 << 3)
 #define EXT_CSD_CARD_TYPE_DDR_52	(EXT_CSD_CARD_TYPE_DDR_1_8V \
 					| EXT_CSD_CARD_TYPE_DDR_1_2V)
+#define EXT_CSD_CARD_TYPE_HS200_1_8V	(1 << 4)	/* 200MHz SDR at 1.8V */
+#define EXT_CSD_CARD_TYPE_HS200_1_2V	(1 << 5)	/* 200MHz SDR at 1.2V */
+#define EXT_CSD_CARD_TYPE_HS400_1_8V	(1 << 6)	/* 200MHz DDR at 1.8V */
+#define EXT_CSD_CARD_TYPE_HS400_1_2V	(1 << 7)	/* 200MHz DDR at 1.2V */
+
+#define EXT_CSD_TIMING_LEGACY	0	/* Backwards compatible timing */
+#define EXT_CSD_TIMING_HS	1	/* High speed (26/52MHz) */
+#define EXT_CSD_TIMING_HS200	2	/* HS200 */
+#define EXT_CSD_TIMING_HS400	3	/* HS400 */
 
 #define EXT_CSD_BUS_WIDTH_1	0	/* Card is in 1 bit mode */
 #define EXT_CSD_BUS_WIDTH_4	1	/* Card is in 4 bit mode */
@@ -227,6 +258,7 @@
 #define EXT_CSD_ENH_GP(x)	(1 << ((x)+1))	/* GP part (x+1) is enhanced */
 
 #define EXT_CSD_HS_CTRL_REL	(1 << 0)	/* host controlled WR_REL_SET */
+#define EXT_CSD_EN_REL_WR	(1 << 2)	/* enhanced reliable write */
 
 #define EXT_CSD_WR_DATA_REL_USR		(1 << 0)	/* user data area WR_REL */
 #define EXT_CSD_WR_DATA_REL_GP(x)	(1 << ((x)+1))	/* GP part (x+1) WR_REL */
@@ -257,9 +289,19 @@
 #define ENHNCD_SUPPORT		(0x2)
 #define PART_ENH_ATTRIB		(0x1f)
 
+/* Size of the tuning block returned by CMD19 / CMD21 for each bus width */
+#define MMC_TUNING_BLK_SIZE_4BIT	64
+#define MMC_TUNING_BLK_SIZE_8BIT	128
+
+extern const u8 mmc_tuning_blk_pattern_4bit[MMC_TUNING_BLK_SIZE_4BIT];
+extern const u8 mmc_tuning_blk_pattern_8bit[MMC_TUNING_BLK_SIZE_8BIT];
+
 /* Maximum block size for MMC */
 #define MMC_MAX_BLOCK_LEN	512
 
+/* Maximum number of blocks which can be given to SET_BLOCK_COUNT */
+#define MMC_MAX_BLOCK_COUNT	0xffff
+
 /* The number of MMC physical partitions.  These consist of:
  * boot partitions (2), general purpose partitions (4) in MMC v4.4.
  */
@@ -317,6 +359,39 @@ struct mmc_data {
 /* forward decl. */
 struct mmc;
 
+/**
+ * enum mmc_bus_mode - Bus timing modes that a card can be operated in
+ *
+ * The mode is selected during mmc_init() from the capabilities of the card
+ * and host. Host drivers should look at mmc->selected_mode in their set_ios()
+ * method to program the matching timing (SDR/DDR, sampling, strobe).
+ */
+enum mmc_bus_mode {
+	MMC_LEGACY,
+	SD_LEGACY,
+	MMC_HS,
+	SD_HS,
+	MMC_HS_52,
+	MMC_DDR_52,
+	UHS_SDR50,
+	UHS_DDR50,
+	UHS_SDR104,
+	MMC_HS_200,
+	MMC_HS_400,
+	MMC_MODES_END
+};
+
+/**
+ * enum mmc_signal_voltage - I/O signalling voltage of the bus
+ *
+ * UHS-I SD modes and eMMC HS200/HS400 require 1.8V signalling. Host drivers
+ * should look at mmc->signal_voltage in their set_ios() method.
+ */
+enum mmc_signal_voltage {
+	MMC_SIGNAL_VOLTAGE_330,
+	MMC_SIGNAL_VOLTAGE_180,
+};
+
 #ifdef CONFIG_DM_MMC_OPS
 struct dm_mmc_ops {
 	/**
@@ -333,6 +408,9 @@ struct dm_mmc_ops {
 	/**
 	 * set_ios() - Set the I/O speed/width for an MMC device
 	 *
+	 * The new settings are in mmc->clock, mmc->bus_width,
+	 * mmc->selected_mode and mmc->signal_voltage.
+	 *
 	 * @dev:	Device to update
 	 * @return 0 if OK, -ve on error
 	 */
@@ -353,6 +431,19 @@ struct dm_mmc_ops {
 	 * @return 0 if write-enabled, 1 if write-protected, -ve on error
 	 */
 	int (*get_wp)(struct udevice *dev);
+
+	/**
+	 * execute_tuning() - Find the optimal sampling point for the bus
+	 *
+	 * This is called after switching to UHS SDR50/SDR104 or HS200 with
+	 * the bus already at its final clock. Drivers normally sweep their
+	 * sampling delay and use mmc_send_tuning() to check each setting.
+	 *
+	 * @dev:	Device to tune
+	 * @opcode:	Tuning command to use (CMD19 for SD, CMD21 for eMMC)
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*execute_tuning)(struct udevice *dev, uint opcode);
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
@@ -362,6 +453,7 @@ int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 int dm_mmc_set_ios(struct udevice *dev);
 int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
+int dm_mmc_execute_tuning(struct udevice *dev, uint opcode);
 
 /* Transition functions for compatibility */
 int mmc_set_ios(struct mmc *mmc);
@@ -376,6 +468,7 @@ struct mmc_ops {
 	int (*init)(struct mmc *mmc);
 	int (*getcd)(struct mmc *mmc);
 	int (*getwp)(struct mmc *mmc);
+	int (*execute_tuning)(struct mmc *mmc, uint opcode);
 };
 #endif
 
@@ -420,6 +513,8 @@ struct mmc {
 	u8 part_support;
 	u8 part_attr;
 	u8 wr_rel_set;
+	u8 wr_rel_param;
+	bool reliable_write;	/* use reliable writes (eMMC only) */
 	char part_config;
 	uint tran_speed;
 	uint read_bl_len;
@@ -440,6 +535,8 @@ struct mmc {
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
 	int ddr_mode;
+	enum mmc_bus_mode selected_mode;	/* current bus timing */
+	enum mmc_signal_voltage signal_voltage;	/* current I/O voltage */
 #ifdef CONFIG_DM_MMC
 	struct udevice *dev;	/* Device for this MMC controller */
 #endif
@@ -490,10 +587,42 @@ void mmc_destroy(struct mmc *mmc);
  * @return 0 if OK, -ve on error
  */
 int mmc_unbind(struct udevice *dev);
+
+/**
+ * mmc_of_parse() - Read the standard MMC host properties from the device tree
+ *
+ * This handles bus-width, max-frequency and the speed-mode properties
+ * (cap-sd-highspeed, cap-mmc-highspeed, sd-uhs-*, mmc-ddr-1_8v,
+ * mmc-hs200-1_8v, mmc-hs400-1_8v), updating @cfg accordingly.
+ *
+ * @dev:	MMC device
+ * @cfg:	MMC configuration to update
+ * @return 0 if OK, -ve on error
+ */
+int mmc_of_parse(struct udevice *dev, struct mmc_config *cfg);
 int mmc_initialize(bd_t *bis);
 int mmc_init(struct mmc *mmc);
 int mmc_read(struct mmc *mmc, u64 src, uchar *dst, int size);
 void mmc_set_clock(struct mmc *mmc, uint clock);
+
+/**
+ * mmc_send_tuning() - Send a tuning command and check the returned pattern
+ *
+ * This is intended for use by a host driver's execute_tuning() method.
+ *
+ * @mmc:	MMC device
+ * @opcode:	Tuning command (MMC_CMD_SEND_TUNING_BLOCK{,_HS200})
+ * @return 0 if the expected tuning block was received, -ve on error
+ */
+int mmc_send_tuning(struct mmc *mmc, uint opcode);
+
+/**
+ * mmc_mode_name() - Get a printable name for a bus mode
+ *
+ * @mode:	Bus mode
+ * @return name of the mode
+ */
+const char *mmc_mode_name(enum mmc_bus_mode mode);
 struct mmc *find_mmc_device(int dev_num);
 int mmc_set_dev(int dev_num);
 void print_mmc_devices(char separator);
@@ -524,6 +653,20 @@ int mmc_set_part_conf(struct mmc *mmc, u8 ack, u8 part_num, u8 access);
 int mmc_set_boot_bus_width(struct mmc *mmc, u8 width, u8 reset, u8 mode);
 /* Function to modify the RST_n_FUNCTION field of EXT_CSD */
 int mmc_set_rst_n_function(struct mmc *mmc, u8 enable);
+
+/**
+ * mmc_set_reliable_write() - Enable or disable reliable writes
+ *
+ * While enabled, all writes to the device are issued as reliable writes
+ * (SET_BLOCK_COUNT with the reliable write flag), so that an interrupted
+ * write leaves either the old or the new data. Only eMMC devices with the
+ * enhanced reliable write feature are supported.
+ *
+ * @mmc:	MMC device
+ * @enable:	true to enable reliable writes, false to disable
+ * @return 0 if OK, -EOPNOTSUPP if the device or host cannot do this
+ */
+int mmc_set_reliable_write(struct mmc *mmc, bool enable);
 /* Functions to read / write the RPMB partition */
 int mmc_rpmb_set_key(struct mmc *mmc, void *key);
 int mmc_rpmb_get_counter(struct mmc *mmc, unsigned long *counter);
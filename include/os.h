@@ -321,4 +321,56 @@ int os_spl_to_uboot(const char *fname);
  */
 void os_localtime(struct rtc_time *rt);
 
+/**
+ * os_get_cpus() - Get the number of host CPUs which are online
+ *
+ * @return number of CPUs, at least 1
+ */
+int os_get_cpus(void);
+
+/**
+ * os_thread_create() - Start a host thread
+ *
+ * The thread runs until the program exits.
+ *
+ * @func:	Function for the thread to run
+ * @arg:	Argument to pass to @func
+ * @stack:	Stack for the thread to use
+ * @size:	Size of the stack in bytes
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_create(void (*func)(void *arg), void *arg, void *stack,
+		     size_t size);
+
+/**
+ * os_context_create() - Set up a host context to run a function on a stack
+ *
+ * The function is first called when the context is switched to, and must
+ * not return. If @func is NULL, this returns an empty context in which to
+ * save the caller's state.
+ *
+ * @func:	Function to call, or NULL
+ * @arg:	Argument to pass to @func
+ * @stack:	Base of the stack to use
+ * @size:	Size of the stack in bytes
+ * @return context, or NULL on error
+ */
+void *os_context_create(void (*func)(void *arg), void *arg, void *stack,
+			size_t size);
+
+/**
+ * os_context_switch() - Save the current state and switch to another context
+ *
+ * @from:	Context to save the current state in
+ * @to:		Context to switch to
+ */
+void os_context_switch(void *from, void *to);
+
+/**
+ * os_context_free() - Free a context set up by os_context_create()
+ *
+ * @ctx:	Context to free
+ */
+void os_context_free(void *ctx);
+
 #endif
@@ -0,0 +1,122 @@
+/*
+ * Cooperative tasks, each running on its own stack
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TASK_H
+#define __TASK_H
+
+#include <linux/list.h>
+
+/**
+ * struct task - A function which runs alongside the rest of U-Boot
+ *
+ * A task runs until it calls task_yield(), directly or by waiting in one of
+ * the helpers which yield, such as udelay(). U-Boot then carries on from
+ * where it last yielded. Only one task runs at a time, so no locking is
+ * needed, but a task must not use a device or a subsystem (such as the
+ * network stack) while something else is part way through using it.
+ *
+ * The structure must stay valid until task_wait() has returned.
+ *
+ * @func:	Function to call
+ * @arg:	Argument to pass to @func
+ * @done:	Set to 1 when @func has returned
+ * @stack:	Stack for the task (internal)
+ * @ctx:	Architecture context for the task (internal)
+ * @node:	Entry in the list of running tasks (internal)
+ */
+struct task {
+	void (*func)(void *arg);
+	void *arg;
+	int done;
+	void *stack;
+	void *ctx;
+	struct list_head node;
+};
+
+#if CONFIG_IS_ENABLED(TASK)
+/**
+ * task_start() - Start running a function as a task
+ *
+ * The task first runs the next time the caller yields. If the task cannot
+ * be set up, e.g. before relocation, when out of memory or because the
+ * architecture does not support tasks, the function is run immediately
+ * instead.
+ *
+ * @task:	Task to start, with @func and @arg filled in
+ */
+void task_start(struct task *task);
+
+/**
+ * task_yield() - Let other tasks run
+ *
+ * Called from a task, this switches back to U-Boot's main flow. Otherwise
+ * it runs each task in turn until it yields or finishes. It does nothing
+ * if there are no tasks, or before relocation.
+ */
+void task_yield(void);
+
+/**
+ * task_wait() - Wait for a task to finish
+ *
+ * This yields until the task has finished. A task must not wait for itself.
+ *
+ * @task:	Task previously passed to task_start()
+ */
+void task_wait(struct task *task);
+
+/**
+ * arch_task_create() - Set up a context to run a function on a stack
+ *
+ * The function is first called when the context is switched to, and must
+ * not return. If @func is NULL, this returns an empty context for the
+ * caller's own flow, to be passed to arch_task_switch() as @from.
+ *
+ * The default implementation returns NULL, so that tasks run immediately
+ * when started.
+ *
+ * @func:	Function to call, or NULL
+ * @arg:	Argument to pass to @func
+ * @stack:	Base of the stack to use
+ * @size:	Size of the stack in bytes
+ * @return context, or NULL if not supported or out of memory
+ */
+void *arch_task_create(void (*func)(void *arg), void *arg, void *stack,
+		       ulong size);
+
+/**
+ * arch_task_switch() - Switch from one context to another
+ *
+ * This saves the current state in @from and continues from @to. It returns
+ * when something switches back to @from.
+ *
+ * @from:	Context to save the current state in
+ * @to:		Context to switch to
+ */
+void arch_task_switch(void *from, void *to);
+
+/**
+ * arch_task_free() - Free a context set up by arch_task_create()
+ *
+ * @ctx:	Context to free, which must not be the current one
+ */
+void arch_task_free(void *ctx);
+#else
+static inline void task_start(struct task *task)
+{
+	task->func(task->arg);
+	task->done = 1;
+}
+
+static inline void task_yield(void)
+{
+}
+
+static inline void task_wait(struct task *task)
+{
+}
+#endif
+
+#endif
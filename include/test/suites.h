@@ -8,9 +8,16 @@
 #ifndef __TEST_SUITES_H__
 #define __TEST_SUITES_H__
 
+int do_ut_cpu_work(cmd_tbl_t *cmdtp, int flag, int argc,
+		   char * const argv[]);
+int do_ut_crc32(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_dm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_env(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_fdt_batch(cmd_tbl_t *cmdtp, int flag, int argc,
+		    char * const argv[]);
 int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_sha512(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_task(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 #endif /* __TEST_SUITES_H__ */
@@ -25,4 +25,55 @@ uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
 void crc32_wd_buf(const unsigned char *input, uint ilen,
 		    unsigned char *output, uint chunk_sz);
 
+/**
+ * crc32c() - Calculate a CRC32C (Castagnoli) checksum
+ *
+ * This uses the same conventions as crc32(), so a CRC can be built up over
+ * several calls by passing the previous result as @crc, starting with 0.
+ *
+ * @crc:	Previous CRC, or 0 to start
+ * @buf:	Data to checksum
+ * @len:	Length of data in bytes
+ * @return updated CRC
+ */
+uint32_t crc32c(uint32_t crc, const unsigned char *buf, uint len);
+
+/**
+ * crc32c_no_comp() - Calculate a CRC32C with no ones complement
+ *
+ * This is the raw form used by ext4 and btrfs, where the caller supplies
+ * the seed (usually ~0) and inverts the result if needed.
+ *
+ * @crc:	Seed or previous CRC
+ * @buf:	Data to checksum
+ * @len:	Length of data in bytes
+ * @return updated CRC
+ */
+uint32_t crc32c_no_comp(uint32_t crc, const unsigned char *buf, uint len);
+
+/**
+ * crc32_arch_no_comp() - Update a CRC32 using CPU-specific instructions
+ *
+ * The default does nothing. Architectures with CRC instructions (such as
+ * the ARMv8 CRC32 extension) or carry-less multiply can override it.
+ *
+ * @crcp:	CRC to update, with no ones complement
+ * @buf:	Data to checksum
+ * @len:	Length of data in bytes
+ * @return number of bytes processed, the rest are processed in software
+ */
+uint crc32_arch_no_comp(uint32_t *crcp, const unsigned char *buf, uint len);
+
+/**
+ * crc32c_arch_no_comp() - Update a CRC32C using CPU-specific instructions
+ *
+ * This is the CRC32C equivalent of crc32_arch_no_comp().
+ *
+ * @crcp:	CRC to update, with no ones complement
+ * @buf:	Data to checksum
+ * @len:	Length of data in bytes
+ * @return number of bytes processed, the rest are processed in software
+ */
+uint crc32c_arch_no_comp(uint32_t *crcp, const unsigned char *buf, uint len);
+
 #endif /* _UBOOT_CRC_H */
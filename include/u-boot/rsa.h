@@ -15,18 +15,33 @@
 #include <errno.h>
 #include <image.h>
 
+/*
+ * Modular exponentiation works on 64-bit words where the compiler can
+ * produce a 128-bit product, which needs a quarter of the multiplications
+ * needed with 32-bit words.
+ */
+#ifdef __SIZEOF_INT128__
+typedef uint64_t rsa_word;
+__extension__ typedef unsigned __int128 rsa_dword;
+#else
+typedef uint32_t rsa_word;
+typedef uint64_t rsa_dword;
+#endif
+
+#define RSA_WORD_BITS	(sizeof(rsa_word) * 8)
+
 /**
  * struct rsa_public_key - holder for a public key
  *
  * An RSA public key consists of a modulus (typically called N), the inverse
- * and R^2, where R is 2^(# key bits).
+ * and R^2, where R is 2^(# words in modulus * RSA_WORD_BITS).
  */
 
 struct rsa_public_key {
-	uint len;		/* len of modulus[] in number of uint32_t */
-	uint32_t n0inv;		/* -1 / modulus[0] mod 2^32 */
-	uint32_t *modulus;	/* modulus as little endian array */
-	uint32_t *rr;		/* R^2 as little endian array */
+	uint len;		/* len of modulus[] in number of rsa_word */
+	rsa_word n0inv;		/* -1 / modulus[0] mod 2^RSA_WORD_BITS */
+	rsa_word *modulus;	/* modulus as little endian array */
+	rsa_word *rr;		/* R^2 as little endian array */
 	uint64_t exponent;	/* public exponent */
 };
 
@@ -27,8 +27,8 @@ extern "C" {
  */
 typedef struct
 {
-    unsigned long total[2];	/*!< number of bytes processed	*/
-    unsigned long state[5];	/*!< intermediate digest state	*/
+    uint32_t total[2];		/*!< number of bytes processed	*/
+    uint32_t state[5];		/*!< intermediate digest state	*/
     unsigned char buffer[64];	/*!< data block being processed */
 }
 sha1_context;
@@ -79,6 +79,21 @@ void sha1_csum(const unsigned char *input, unsigned int ilen,
 void sha1_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * \brief	   Process blocks using CPU-specific instructions
+ *
+ * The default returns 0. Architectures with SHA-1 instructions (such as
+ * the ARMv8 Crypto Extensions) can override it.
+ *
+ * \param state    SHA-1 state to update
+ * \param data     data to process
+ * \param blocks   number of 64-byte blocks at data
+ * \return	   number of blocks processed, the rest are processed in
+ *		   software
+ */
+int sha1_arch_blocks(uint32_t state[5], const unsigned char *data,
+		     unsigned int blocks);
+
 /**
  * \brief	   Output = HMAC-SHA-1( input buffer, hmac key )
  *
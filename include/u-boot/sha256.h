@@ -19,4 +19,18 @@ void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
+/**
+ * sha256_arch_blocks() - Process blocks using CPU-specific instructions
+ *
+ * The default returns 0. Architectures with SHA-256 instructions (such as
+ * the ARMv8 Crypto Extensions or RISC-V Zknh) can override it.
+ *
+ * @state:	Hash state to update
+ * @data:	Data to process
+ * @blocks:	Number of 64-byte blocks at @data
+ * @return number of blocks processed, the rest are processed in software
+ */
+int sha256_arch_blocks(uint32_t state[8], const uint8_t *data,
+		       unsigned int blocks);
+
 #endif /* _SHA256_H */
@@ -0,0 +1,56 @@
+/*
+ * FIPS-180-2 compliant SHA-384/512 implementation
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _SHA512_H
+#define _SHA512_H
+
+#define SHA384_SUM_LEN	48
+#define SHA512_SUM_LEN	64
+
+/* Reset watchdog each time we process this many bytes */
+#define CHUNKSZ_SHA384	(64 * 1024)
+#define CHUNKSZ_SHA512	(64 * 1024)
+
+typedef struct {
+	uint64_t total[2];
+	uint64_t state[8];
+	uint8_t buffer[128];
+} sha512_context;
+
+/* SHA-384 is SHA-512 with a different initial state, truncated */
+#define sha384_context	sha512_context
+
+void sha384_starts(sha512_context *ctx);
+void sha384_update(sha512_context *ctx, const uint8_t *input,
+		   uint32_t length);
+void sha384_finish(sha512_context *ctx, uint8_t digest[SHA384_SUM_LEN]);
+
+void sha384_csum_wd(const unsigned char *input, unsigned int ilen,
+		unsigned char *output, unsigned int chunk_sz);
+
+void sha512_starts(sha512_context *ctx);
+void sha512_update(sha512_context *ctx, const uint8_t *input,
+		   uint32_t length);
+void sha512_finish(sha512_context *ctx, uint8_t digest[SHA512_SUM_LEN]);
+
+void sha512_csum_wd(const unsigned char *input, unsigned int ilen,
+		unsigned char *output, unsigned int chunk_sz);
+
+/**
+ * sha512_arch_blocks() - Process blocks using CPU-specific instructions
+ *
+ * The default returns 0. Architectures with SHA-512 instructions can
+ * override it. This is used for SHA-384 too.
+ *
+ * @state:	Hash state to update
+ * @data:	Data to process
+ * @blocks:	Number of 128-byte blocks at @data
+ * @return number of blocks processed, the rest are processed in software
+ */
+int sha512_arch_blocks(uint64_t state[8], const uint8_t *data,
+		       unsigned int blocks);
+
+#endif /* _SHA512_H */
@@ -1338,6 +1338,17 @@ int BZ_API(BZ2_bzBuffToBuffDecompress)
    if (destLen == NULL || source == NULL)
 	  return BZ_PARAM_ERROR;
 
+#if defined(CONFIG_CPU_WORK) && !defined(CONFIG_HW_WATCHDOG) && \
+	!defined(CONFIG_WATCHDOG)
+   /*
+    * Try decompressing the blocks on several CPUs, unless memory is short.
+    * The watchdog must only be reset from the boot CPU, so this is not
+    * done with a watchdog.
+    */
+   if (!small && !bz_decompress_parallel(dest, destLen, source, sourceLen))
+	  return BZ_OK;
+#endif
+
    strm.bzalloc = NULL;
    strm.bzfree = NULL;
    strm.opaque = NULL;
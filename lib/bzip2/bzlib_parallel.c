@@ -0,0 +1,348 @@
+/*
+ * Parallel decompression of the blocks of a bzip2 stream
+ *
+ * Each bzip2 block is compressed on its own: only the Huffman tables and
+ * the Burrows-Wheeler transform of that block are needed to decompress it.
+ * Blocks start with a 48-bit magic number, but are not byte-aligned, and
+ * nothing records their decompressed sizes. So the stream is first scanned
+ * for the block magic numbers. Each block is then copied, byte-aligned,
+ * into a stream of its own, as bzip2recover does, and these streams are
+ * decompressed on the secondary CPUs, each into a buffer of its own. The
+ * boot CPU copies the output of each block into place in turn.
+ *
+ * A block whose output does not fit in its buffer, which happens with long
+ * runs of the same byte, is paused. The boot CPU finishes it directly into
+ * the output buffer, from the state that the secondary CPU left.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+#include <malloc.h>
+#include "bzlib_private.h"
+
+/* Most blocks decompressed at once, each needing about 4.5MB */
+#define BZ_MAX_JOBS		8
+
+#define BZ_BLOCK_MAGIC		0x314159265359ULL
+#define BZ_EOS_MAGIC		0x177245385090ULL
+#define BZ_MAGIC_BITS		48
+#define BZ_CRC_BITS		32
+
+/* Stream header, block magic, CRC, end-of-stream magic, CRC, padding */
+#define BZ_STREAM_EXTRA		(4 + 2 * (BZ_MAGIC_BITS + BZ_CRC_BITS) / 8 + 1)
+
+/**
+ * struct bz_job - Decompression of one block, as a stream of its own
+ *
+ * @work:	Work to queue
+ * @strm:	Decompression stream, holding the state of the block
+ * @in:		Stream to decompress
+ * @in_len:	Size of @in in bytes
+ * @out:	Buffer for the output
+ * @out_size:	Size of @out in bytes
+ * @out_len:	Returns the number of bytes written to @out
+ * @arena:	Memory for the decompressor: it must not call malloc()
+ * @arena_size:	Size of @arena in bytes
+ * @arena_used:	Number of bytes used from @arena
+ * @ret:	Returns BZ_STREAM_END if done, BZ_OK if @out is full, else
+ *		an error
+ */
+struct bz_job {
+	struct cpu_work work;
+	bz_stream strm;
+	char *in;
+	uint in_len;
+	char *out;
+	uint out_size;
+	uint out_len;
+	char *arena;
+	uint arena_size;
+	uint arena_used;
+	int ret;
+};
+
+static void *bz_arena_alloc(void *opaque, int items, int size)
+{
+	struct bz_job *job = opaque;
+	uint need = ALIGN(items * size, 8);
+	void *ptr;
+
+	if (need > job->arena_size - job->arena_used)
+		return NULL;
+	ptr = job->arena + job->arena_used;
+	job->arena_used += need;
+
+	return ptr;
+}
+
+static void bz_arena_free(void *opaque, void *addr)
+{
+}
+
+static void bz_job_run(void *arg)
+{
+	struct bz_job *job = arg;
+	bz_stream *strm = &job->strm;
+
+	memset(strm, '\0', sizeof(*strm));
+	strm->bzalloc = bz_arena_alloc;
+	strm->bzfree = bz_arena_free;
+	strm->opaque = job;
+	job->arena_used = 0;
+	job->out_len = 0;
+	job->ret = BZ2_bzDecompressInit(strm, 0, 0);
+	if (job->ret != BZ_OK)
+		return;
+	strm->next_in = job->in;
+	strm->avail_in = job->in_len;
+	strm->next_out = job->out;
+	strm->avail_out = job->out_size;
+	job->ret = BZ2_bzDecompress(strm);
+	job->out_len = job->out_size - strm->avail_out;
+}
+
+/* Read @n bits (n <= 32) starting at bit @pos, most significant first */
+static u32 bz_get_bits(const u8 *src, uint len, ulong pos, uint n)
+{
+	ulong byte = pos / 8;
+	u64 val = 0;
+	uint i;
+
+	for (i = 0; i < 5; i++)
+		val = (val << 8) | (byte + i < len ? src[byte + i] : 0);
+
+	return (val >> (40 - pos % 8 - n)) & ((1ULL << n) - 1);
+}
+
+/**
+ * bz_scan() - Find the blocks of a bzip2 stream
+ *
+ * @src:	Stream
+ * @len:	Size of @src in bytes
+ * @posp:	Returns a malloc()ed list of the bit position of each block,
+ *		followed by the position of the end-of-stream marker
+ * @return number of blocks, or -ve if the stream is not as expected
+ */
+static int bz_scan(const u8 *src, uint len, ulong **posp)
+{
+	ulong *pos = NULL, *new;
+	int count = 0, max = 0;
+	u64 win = 0, val;
+	uint i;
+	int k;
+
+	for (i = 0; i < len; i++) {
+		win = (win << 8) | src[i];
+		if (i < 7)
+			continue;
+
+		/* The magic numbers may start at any bit */
+		for (k = 7; k >= 0; k--) {
+			val = (win >> k) & ((1ULL << BZ_MAGIC_BITS) - 1);
+			if (val != BZ_BLOCK_MAGIC && val != BZ_EOS_MAGIC)
+				continue;
+			if (count == max) {
+				max = max ? max * 2 : 16;
+				new = realloc(pos, max * sizeof(*pos));
+				if (!new)
+					goto err;
+				pos = new;
+			}
+			pos[count++] = (i + 1) * 8 - k - BZ_MAGIC_BITS;
+			if (val == BZ_EOS_MAGIC)
+				goto done;
+		}
+	}
+	goto err;
+
+done:
+	/* The first block must follow the header directly */
+	if (count < 2 || pos[0] != 32 ||
+	    pos[count - 1] + BZ_MAGIC_BITS + BZ_CRC_BITS > (ulong)len * 8)
+		goto err;
+	*posp = pos;
+
+	return count - 1;
+err:
+	free(pos);
+
+	return -EINVAL;
+}
+
+/* Copy block @blk of @src into a stream of its own, returning its size */
+static uint bz_make_stream(char *out, const u8 *src, uint len,
+			   const ulong *pos, int blk)
+{
+	ulong bits = pos[blk + 1] - pos[blk], p = pos[blk];
+	u32 crc = bz_get_bits(src, len, p + BZ_MAGIC_BITS, BZ_CRC_BITS);
+	u8 *dst = (u8 *)out;
+	u64 acc = 0;
+	uint n = 0;
+
+	/* Stream header, including the block size */
+	memcpy(dst, src, 4);
+	dst += 4;
+
+	/* The block, then the end-of-stream marker and the combined CRC */
+	for (; bits >= 8; bits -= 8, p += 8)
+		*dst++ = bz_get_bits(src, len, p, 8);
+	acc = bz_get_bits(src, len, p, bits);
+	n = bits;
+	acc = (acc << 24) | (BZ_EOS_MAGIC >> 24);
+	n += 24;
+	while (n >= 8) {
+		n -= 8;
+		*dst++ = acc >> n;
+	}
+	acc = (acc << 24) | (BZ_EOS_MAGIC & 0xffffff);
+	n += 24;
+	while (n >= 8) {
+		n -= 8;
+		*dst++ = acc >> n;
+	}
+	acc = (acc << 32) | crc;
+	n += 32;
+	while (n >= 8) {
+		n -= 8;
+		*dst++ = acc >> n;
+	}
+	if (n)
+		*dst++ = acc << (8 - n);
+
+	return dst - (u8 *)out;
+}
+
+int bz_decompress_parallel(char *dest, unsigned int *destLen,
+			   const char *source, unsigned int sourceLen)
+{
+	const u8 *src = (const u8 *)source;
+	struct bz_job jobs[BZ_MAX_JOBS];
+	uint level, off = 0, size, stream_len;
+	u32 crc, combined = 0;
+	int blocks, slots, queued, i, j;
+	char *streams = NULL;
+	ulong *pos = NULL;
+	uint *start;
+	int ret = -EAGAIN;
+
+	if (sourceLen < 14 || memcmp(src, "BZh", 3) || src[3] < '1' ||
+	    src[3] > '9')
+		return -EAGAIN;
+	level = src[3] - '0';
+
+	/* Blocks are written out of order, so the input must stay intact */
+	if (dest < source + sourceLen && source < dest + *destLen)
+		return -EAGAIN;
+
+	/* There is no point unless blocks can run on other CPUs */
+	slots = cpu_work_cpus() + 1;
+	if (slots < 2)
+		return -EAGAIN;
+	blocks = bz_scan(src, sourceLen, &pos);
+	if (blocks < 2)
+		goto out_pos;
+	slots = min(slots, min(blocks, BZ_MAX_JOBS));
+
+	/* Make a stream for each block, recording where each one starts */
+	stream_len = sourceLen + blocks * (BZ_STREAM_EXTRA + sizeof(uint));
+	streams = malloc(stream_len);
+	if (!streams)
+		goto out_pos;
+	start = (uint *)streams;
+	for (i = 0, size = blocks * sizeof(uint); i < blocks; i++) {
+		start[i] = size;
+		size += bz_make_stream(streams + size, src, sourceLen, pos, i);
+	}
+
+	/* Each slot needs the decompressor state and an output buffer */
+	for (i = 0; i < slots; i++) {
+		struct bz_job *job = &jobs[i];
+
+		job->arena_size = ALIGN(sizeof(DState), 8) +
+			level * 100000 * sizeof(UInt32) + 64;
+		job->out_size = level * 100000;
+		job->arena = malloc(job->arena_size);
+		job->out = malloc(job->out_size);
+		if (!job->arena || !job->out) {
+			free(job->arena);
+			free(job->out);
+			break;
+		}
+	}
+	slots = i;
+	if (slots < 2)
+		goto out_jobs;
+
+	for (queued = 0; queued < slots; queued++) {
+		struct bz_job *job = &jobs[queued];
+
+		job->in = streams + start[queued];
+		job->in_len = (queued + 1 < blocks ? start[queued + 1] : size) -
+			start[queued];
+		job->work.func = bz_job_run;
+		job->work.arg = job;
+		cpu_work_queue(&job->work);
+	}
+
+	/* Collect the blocks in order, queueing the next block in each slot */
+	for (i = 0; i < blocks; i++) {
+		struct bz_job *job = &jobs[i % slots];
+		bz_stream *strm = &job->strm;
+
+		cpu_work_wait(&job->work);
+		if (job->ret != BZ_STREAM_END && (job->ret != BZ_OK ||
+						  strm->avail_out))
+			break;
+		if (job->out_len > *destLen - off)
+			break;
+		memcpy(dest + off, job->out, job->out_len);
+		off += job->out_len;
+
+		/* Finish a paused block straight into the output */
+		if (job->ret == BZ_OK) {
+			strm->next_out = dest + off;
+			strm->avail_out = *destLen - off;
+			job->ret = BZ2_bzDecompress(strm);
+			off = *destLen - strm->avail_out;
+			if (job->ret != BZ_STREAM_END)
+				break;
+		}
+		BZ2_bzDecompressEnd(strm);
+
+		crc = bz_get_bits(src, sourceLen, pos[i] + BZ_MAGIC_BITS,
+				  BZ_CRC_BITS);
+		combined = ((combined << 1) | (combined >> 31)) ^ crc;
+
+		j = i + slots;
+		if (j < blocks) {
+			job->in = streams + start[j];
+			job->in_len = (j + 1 < blocks ? start[j + 1] : size) -
+				start[j];
+			cpu_work_queue(&job->work);
+			queued++;
+		}
+	}
+
+	if (i == blocks && combined == bz_get_bits(src, sourceLen,
+			pos[blocks] + BZ_MAGIC_BITS, BZ_CRC_BITS)) {
+		*destLen = off;
+		ret = 0;
+	}
+
+	/* On error, let the work already queued finish */
+	for (i++; i < queued; i++)
+		cpu_work_wait(&jobs[i % slots].work);
+
+out_jobs:
+	for (i = 0; i < slots; i++) {
+		free(jobs[i].out);
+		free(jobs[i].arena);
+	}
+	free(streams);
+out_pos:
+	free(pos);
+
+	return ret;
+}
@@ -512,6 +512,20 @@ extern void
 BZ2_hbCreateDecodeTables ( Int32*, Int32*, Int32*, UChar*,
 			   Int32,  Int32, Int32 );
 
+/**
+ * bz_decompress_parallel() - Decompress a stream on several CPUs
+ *
+ * @dest:	Output buffer
+ * @destLen:	Size of @dest; returns the number of bytes decompressed
+ * @source:	Stream to decompress
+ * @sourceLen:	Size of @source
+ * @return 0 if OK, -EAGAIN if the stream must be decompressed normally,
+ *	including when it is corrupt
+ */
+extern int
+bz_decompress_parallel ( char *dest, unsigned int *destLen,
+			 const char *source, unsigned int sourceLen );
+
 
 #endif
 
@@ -0,0 +1,191 @@
+/*
+ * Running independent work on secondary CPUs
+ *
+ * Work is placed in a small queue protected by a spin lock. Secondary CPUs
+ * are started the first time work is queued, each on its own stack, and
+ * then take work from the queue until U-Boot exits. Each CPU also has a
+ * mailbox for work which must run on that CPU, which it checks first. The
+ * boot CPU runs work from the queue itself while waiting for a result, so
+ * nothing is left waiting for a CPU which is busy.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+#include <errno.h>
+#include <malloc.h>
+#include <watchdog.h>
+
+#define CPU_WORK_QUEUE_LEN	32
+
+static struct cpu_work *queue[CPU_WORK_QUEUE_LEN];
+static struct cpu_work *mailbox[CONFIG_CPU_WORK_MAX_CPUS + 1];
+static uint queue_head, queue_tail;
+static char queue_lock;
+static int started;
+static int num_cpus;
+
+__weak int arch_cpu_work_cpus(void)
+{
+	return 0;
+}
+
+__weak int arch_cpu_work_start(int cpu, void *stack, ulong size)
+{
+	return -ENOSYS;
+}
+
+__weak void arch_cpu_work_idle(void)
+{
+}
+
+__weak int arch_cpu_work_id(void)
+{
+	return 0;
+}
+
+static void cpu_work_lock(void)
+{
+	while (__atomic_test_and_set(&queue_lock, __ATOMIC_ACQUIRE))
+		;
+}
+
+static void cpu_work_unlock(void)
+{
+	__atomic_clear(&queue_lock, __ATOMIC_RELEASE);
+}
+
+static void cpu_work_run(struct cpu_work *work)
+{
+	work->func(work->arg);
+	__atomic_store_n(&work->done, 1, __ATOMIC_RELEASE);
+}
+
+/* Take the oldest work from the queue, returning NULL if it is empty */
+static struct cpu_work *cpu_work_take(void)
+{
+	struct cpu_work *work = NULL;
+
+	cpu_work_lock();
+	if (queue_head != queue_tail)
+		work = queue[queue_head++ % CPU_WORK_QUEUE_LEN];
+	cpu_work_unlock();
+
+	return work;
+}
+
+/* Start the secondary CPUs, returning the number running */
+static int cpu_work_start(void)
+{
+	int max, cpu;
+	void *stack;
+
+	if (started)
+		return num_cpus;
+	started = 1;
+
+	max = min(arch_cpu_work_cpus(), CONFIG_CPU_WORK_MAX_CPUS);
+	for (cpu = 1; cpu <= max; cpu++) {
+		stack = memalign(ARCH_DMA_MINALIGN, CONFIG_CPU_WORK_STACK_SIZE);
+		if (!stack)
+			break;
+		if (arch_cpu_work_start(cpu, stack,
+					CONFIG_CPU_WORK_STACK_SIZE)) {
+			free(stack);
+			break;
+		}
+		num_cpus++;
+	}
+	debug("%s: %d secondary CPUs started\n", __func__, num_cpus);
+
+	return num_cpus;
+}
+
+void cpu_work_queue(struct cpu_work *work)
+{
+	work->done = 0;
+	if (cpu_work_start()) {
+		cpu_work_lock();
+		if (queue_tail - queue_head < CPU_WORK_QUEUE_LEN) {
+			queue[queue_tail++ % CPU_WORK_QUEUE_LEN] = work;
+			work = NULL;
+		}
+		cpu_work_unlock();
+	}
+
+	/* Run it here if there is nowhere else to run it */
+	if (work)
+		cpu_work_run(work);
+}
+
+void cpu_work_wait(struct cpu_work *work)
+{
+	struct cpu_work *other;
+
+	while (!__atomic_load_n(&work->done, __ATOMIC_ACQUIRE)) {
+		WATCHDOG_RESET();
+		other = cpu_work_take();
+		if (other)
+			cpu_work_run(other);
+	}
+}
+
+int cpu_work_queue_on(int cpu, struct cpu_work *work)
+{
+	struct cpu_work *none = NULL;
+
+	if (cpu < 1 || cpu > cpu_work_start())
+		return -ENODEV;
+	work->done = 0;
+	if (!__atomic_compare_exchange_n(&mailbox[cpu], &none, work, false,
+					 __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		return -EBUSY;
+
+	return 0;
+}
+
+int cpu_work_call_all(void (*func)(void *arg), void *arg)
+{
+	struct cpu_work work[CONFIG_CPU_WORK_MAX_CPUS + 1];
+	int cpus, cpu;
+
+	cpus = cpu_work_start();
+	for (cpu = 1; cpu <= cpus; cpu++) {
+		work[cpu].func = func;
+		work[cpu].arg = arg;
+		while (cpu_work_queue_on(cpu, &work[cpu]) == -EBUSY)
+			;
+	}
+	func(arg);
+	for (cpu = 1; cpu <= cpus; cpu++)
+		cpu_work_wait(&work[cpu]);
+
+	return cpus + 1;
+}
+
+int cpu_work_id(void)
+{
+	return arch_cpu_work_id();
+}
+
+int cpu_work_cpus(void)
+{
+	return cpu_work_start();
+}
+
+void cpu_work_secondary(int cpu)
+{
+	struct cpu_work *work;
+
+	for (;;) {
+		work = __atomic_exchange_n(&mailbox[cpu], NULL,
+					   __ATOMIC_ACQUIRE);
+		if (!work)
+			work = cpu_work_take();
+		if (work)
+			cpu_work_run(work);
+		else
+			arch_cpu_work_idle();
+	}
+}
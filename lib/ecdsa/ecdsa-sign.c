@@ -0,0 +1,357 @@
+/*
+ * ECDSA signing of FIT images using OpenSSL
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "mkimage.h"
+#include <stdio.h>
+#include <string.h>
+#include <image.h>
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <u-boot/ecdsa.h>
+
+#define ECDSA256_POINT_BYTES	(ECDSA256_BYTES / 2)
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+static void ECDSA_SIG_get0(const ECDSA_SIG *sig, const BIGNUM **pr,
+			   const BIGNUM **ps)
+{
+	*pr = sig->r;
+	*ps = sig->s;
+}
+#endif
+
+static int ecdsa_err(const char *msg)
+{
+	unsigned long sslErr = ERR_get_error();
+
+	fprintf(stderr, "%s", msg);
+	fprintf(stderr, ": %s\n",
+		ERR_error_string(sslErr, 0));
+
+	return -1;
+}
+
+/**
+ * ecdsa_check_curve() - Check that a key is on the supported curve
+ *
+ * @ec:		Key to check
+ * @return 0 if OK, -EINVAL if not
+ */
+static int ecdsa_check_curve(EC_KEY *ec)
+{
+	const EC_GROUP *group = EC_KEY_get0_group(ec);
+
+	if (!group ||
+	    EC_GROUP_get_curve_name(group) != NID_X9_62_prime256v1) {
+		fprintf(stderr, "ECDSA key must use the %s curve\n",
+			ECDSA256_CURVE);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * ecdsa_get_pub_key() - read a public key from a .crt file
+ *
+ * @keydir:	Directory containing the key
+ * @name	Name of key file (will have a .crt extension)
+ * @ecp		Returns EC_KEY object, or NULL on failure
+ * @return 0 if ok, -ve on error (in which case *ecp will be set to NULL)
+ */
+static int ecdsa_get_pub_key(const char *keydir, const char *name,
+			     EC_KEY **ecp)
+{
+	char path[1024];
+	EVP_PKEY *key;
+	X509 *cert;
+	EC_KEY *ec;
+	FILE *f;
+	int ret;
+
+	*ecp = NULL;
+	snprintf(path, sizeof(path), "%s/%s.crt", keydir, name);
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Couldn't open ECDSA certificate: '%s': %s\n",
+			path, strerror(errno));
+		return -EACCES;
+	}
+
+	/* Read the certificate */
+	cert = NULL;
+	if (!PEM_read_X509(f, &cert, NULL, NULL)) {
+		ecdsa_err("Couldn't read certificate");
+		ret = -EINVAL;
+		goto err_cert;
+	}
+
+	/* Get the public key from the certificate. */
+	key = X509_get_pubkey(cert);
+	if (!key) {
+		ecdsa_err("Couldn't read public key\n");
+		ret = -EINVAL;
+		goto err_pubkey;
+	}
+
+	/* Convert to an EC key */
+	ec = EVP_PKEY_get1_EC_KEY(key);
+	if (!ec) {
+		ecdsa_err("Couldn't convert to an EC key");
+		ret = -EINVAL;
+		goto err_ec;
+	}
+	fclose(f);
+	EVP_PKEY_free(key);
+	X509_free(cert);
+	*ecp = ec;
+
+	return 0;
+
+err_ec:
+	EVP_PKEY_free(key);
+err_pubkey:
+	X509_free(cert);
+err_cert:
+	fclose(f);
+	return ret;
+}
+
+/**
+ * ecdsa_get_priv_key() - read a private key from a .key file
+ *
+ * @keydir:	Directory containing the key
+ * @name	Name of key file (will have a .key extension)
+ * @ecp		Returns EC_KEY object, or NULL on failure
+ * @return 0 if ok, -ve on error (in which case *ecp will be set to NULL)
+ */
+static int ecdsa_get_priv_key(const char *keydir, const char *name,
+			      EC_KEY **ecp)
+{
+	char path[1024];
+	EVP_PKEY *key;
+	EC_KEY *ec;
+	FILE *f;
+
+	*ecp = NULL;
+	snprintf(path, sizeof(path), "%s/%s.key", keydir, name);
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Couldn't open ECDSA private key: '%s': %s\n",
+			path, strerror(errno));
+		return -ENOENT;
+	}
+
+	key = PEM_read_PrivateKey(f, NULL, NULL, path);
+	fclose(f);
+	if (!key) {
+		ecdsa_err("Failure reading private key");
+		return -EPROTO;
+	}
+	ec = EVP_PKEY_get1_EC_KEY(key);
+	EVP_PKEY_free(key);
+	if (!ec) {
+		ecdsa_err("Private key is not an EC key");
+		return -EPROTO;
+	}
+	*ecp = ec;
+
+	return 0;
+}
+
+/* Write a number as a fixed-size big endian byte array */
+static int ecdsa_bn2bin(const BIGNUM *num, uint8_t *buf, int size)
+{
+	int len = BN_num_bytes(num);
+
+	if (len > size)
+		return -EINVAL;
+	memset(buf, '\0', size - len);
+	BN_bn2bin(num, buf + size - len);
+
+	return 0;
+}
+
+int ecdsa_sign(struct image_sign_info *info,
+	       const struct image_region region[], int region_count,
+	       uint8_t **sigp, uint *sig_len)
+{
+	struct checksum_algo *checksum = info->algo->checksum;
+	uint8_t hash[checksum->checksum_len];
+	const BIGNUM *r, *s;
+	ECDSA_SIG *esig;
+	uint8_t *sig;
+	EC_KEY *ec;
+	int ret;
+
+	ret = ecdsa_get_priv_key(info->keydir, info->keyname, &ec);
+	if (ret)
+		return ret;
+	ret = ecdsa_check_curve(ec);
+	if (ret)
+		goto err_key;
+
+	ret = checksum->calculate(checksum->name, region, region_count, hash);
+	if (ret) {
+		fprintf(stderr, "Failed to hash data for signing\n");
+		ret = -EINVAL;
+		goto err_key;
+	}
+
+	esig = ECDSA_do_sign(hash, checksum->checksum_len, ec);
+	if (!esig) {
+		ret = ecdsa_err("Could not obtain signature");
+		goto err_key;
+	}
+
+	sig = malloc(ECDSA256_BYTES);
+	if (!sig) {
+		fprintf(stderr, "Out of memory for signature (%d bytes)\n",
+			ECDSA256_BYTES);
+		ret = -ENOMEM;
+		goto err_sig;
+	}
+	ECDSA_SIG_get0(esig, &r, &s);
+	if (ecdsa_bn2bin(r, sig, ECDSA256_POINT_BYTES) ||
+	    ecdsa_bn2bin(s, sig + ECDSA256_POINT_BYTES,
+			 ECDSA256_POINT_BYTES)) {
+		fprintf(stderr, "Signature value too large\n");
+		free(sig);
+		ret = -EINVAL;
+		goto err_sig;
+	}
+	*sigp = sig;
+	*sig_len = ECDSA256_BYTES;
+
+err_sig:
+	ECDSA_SIG_free(esig);
+err_key:
+	EC_KEY_free(ec);
+
+	return ret;
+}
+
+/**
+ * ecdsa_add_point() - Add the x and y coordinates of the public key
+ *
+ * @keydest:	Destination FDT blob
+ * @node:	Node to add the properties to
+ * @ec:		Key to add
+ * @return 0 if OK, -FDT_ERR_NOSPACE if out of space, other -ve on error
+ */
+static int ecdsa_add_point(void *keydest, int node, EC_KEY *ec)
+{
+	uint8_t x_buf[ECDSA256_POINT_BYTES], y_buf[ECDSA256_POINT_BYTES];
+	const EC_GROUP *group = EC_KEY_get0_group(ec);
+	BIGNUM *x, *y;
+	int ret;
+
+	x = BN_new();
+	y = BN_new();
+	if (!x || !y) {
+		fprintf(stderr, "Out of memory (bignum)\n");
+		ret = -ENOMEM;
+		goto done;
+	}
+	if (!EC_POINT_get_affine_coordinates_GFp(group,
+						 EC_KEY_get0_public_key(ec),
+						 x, y, NULL) ||
+	    ecdsa_bn2bin(x, x_buf, sizeof(x_buf)) ||
+	    ecdsa_bn2bin(y, y_buf, sizeof(y_buf))) {
+		ret = ecdsa_err("Couldn't get public key point");
+		goto done;
+	}
+
+	ret = fdt_setprop(keydest, node, "ecdsa,x-point", x_buf,
+			  sizeof(x_buf));
+	if (!ret)
+		ret = fdt_setprop(keydest, node, "ecdsa,y-point", y_buf,
+				  sizeof(y_buf));
+done:
+	BN_free(x);
+	BN_free(y);
+
+	return ret;
+}
+
+int ecdsa_add_verify_data(struct image_sign_info *info, void *keydest)
+{
+	int parent, node;
+	char name[100];
+	EC_KEY *ec;
+	int ret;
+
+	debug("%s: Getting verification data\n", __func__);
+	ret = ecdsa_get_pub_key(info->keydir, info->keyname, &ec);
+	if (ret)
+		return ret;
+	ret = ecdsa_check_curve(ec);
+	if (ret)
+		goto err_key;
+
+	parent = fdt_subnode_offset(keydest, 0, FIT_SIG_NODENAME);
+	if (parent == -FDT_ERR_NOTFOUND) {
+		parent = fdt_add_subnode(keydest, 0, FIT_SIG_NODENAME);
+		if (parent < 0) {
+			ret = parent;
+			if (ret != -FDT_ERR_NOSPACE) {
+				fprintf(stderr, "Couldn't create signature node: %s\n",
+					fdt_strerror(parent));
+			}
+		}
+	}
+	if (ret)
+		goto done;
+
+	/* Either create or overwrite the named key node */
+	snprintf(name, sizeof(name), "key-%s", info->keyname);
+	node = fdt_subnode_offset(keydest, parent, name);
+	if (node == -FDT_ERR_NOTFOUND) {
+		node = fdt_add_subnode(keydest, parent, name);
+		if (node < 0) {
+			ret = node;
+			if (ret != -FDT_ERR_NOSPACE) {
+				fprintf(stderr, "Could not create key subnode: %s\n",
+					fdt_strerror(node));
+			}
+		}
+	} else if (node < 0) {
+		fprintf(stderr, "Cannot select keys parent: %s\n",
+			fdt_strerror(node));
+		ret = node;
+	}
+
+	if (!ret) {
+		ret = fdt_setprop_string(keydest, node, "key-name-hint",
+					 info->keyname);
+	}
+	if (!ret)
+		ret = fdt_setprop_string(keydest, node, "ecdsa,curve",
+					 ECDSA256_CURVE);
+	if (!ret)
+		ret = ecdsa_add_point(keydest, node, ec);
+	if (!ret) {
+		ret = fdt_setprop_string(keydest, node, FIT_ALGO_PROP,
+					 info->algo->name);
+	}
+	if (!ret && info->require_keys) {
+		ret = fdt_setprop_string(keydest, node, "required",
+					 info->require_keys);
+	}
+done:
+	if (ret)
+		ret = ret == -FDT_ERR_NOSPACE ? -ENOSPC : -EIO;
+err_key:
+	EC_KEY_free(ec);
+
+	return ret;
+}
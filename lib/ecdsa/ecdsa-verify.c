@@ -0,0 +1,576 @@
+/*
+ * ECDSA signature verification on the NIST P-256 curve (prime256v1)
+ *
+ * Numbers are held as arrays of words, least significant first. The words
+ * are 64 bits wide where the compiler has a 128-bit type for the products,
+ * else 32 bits. Arithmetic modulo the field prime p and the group order n uses
+ * Montgomery multiplication, and points are held in Jacobian coordinates so
+ * that only two inversions are needed for each verification. Since all the
+ * inputs are public, none of this needs to run in constant time.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#include <fdtdec.h>
+#include <asm/errno.h>
+#else
+#include "fdt_host.h"
+#include "mkimage.h"
+#include <fdt_support.h>
+#endif
+#include <u-boot/ecdsa.h>
+
+#ifdef __SIZEOF_INT128__
+typedef uint64_t p256_word;
+__extension__ typedef unsigned __int128 p256_dword;
+#define P256_W(hi, lo)	((uint64_t)(hi) << 32 | (lo))
+#define P256_N0INV_P	0x0000000000000001
+#define P256_N0INV_N	0xccd1c8aaee00bc4f
+#define P256_WORD_BITS	64
+#else
+typedef uint32_t p256_word;
+typedef uint64_t p256_dword;
+#define P256_W(hi, lo)	(lo), (hi)
+#define P256_N0INV_P	0x00000001
+#define P256_N0INV_N	0xee00bc4f
+#define P256_WORD_BITS	32
+#endif
+
+#define P256_BYTES	32
+#define P256_WORDS	(P256_BYTES * 8 / P256_WORD_BITS)
+
+/**
+ * struct p256_mod - a modulus for Montgomery multiplication
+ *
+ * @m:		Modulus
+ * @rr:		R^2 mod m, where R is 2^256
+ * @n0inv:	-1 / m[0] mod 2^P256_WORD_BITS
+ */
+struct p256_mod {
+	p256_word m[P256_WORDS];
+	p256_word rr[P256_WORDS];
+	p256_word n0inv;
+};
+
+/**
+ * struct p256_point - a point in Jacobian coordinates
+ *
+ * The affine point is (x / z^2, y / z^3). Each coordinate is in Montgomery
+ * form modulo p. The point at infinity has z = 0.
+ */
+struct p256_point {
+	p256_word x[P256_WORDS];
+	p256_word y[P256_WORDS];
+	p256_word z[P256_WORDS];
+};
+
+/* The field prime p */
+static const struct p256_mod p256_p = {
+	.m = {
+		P256_W(0xffffffff, 0xffffffff), P256_W(0x00000000, 0xffffffff),
+		P256_W(0x00000000, 0x00000000), P256_W(0xffffffff, 0x00000001)
+	},
+	.rr = {
+		P256_W(0x00000000, 0x00000003), P256_W(0xfffffffb, 0xffffffff),
+		P256_W(0xffffffff, 0xfffffffe), P256_W(0x00000004, 0xfffffffd)
+	},
+	.n0inv = P256_N0INV_P,
+};
+
+/* The order n of the base point */
+static const struct p256_mod p256_n = {
+	.m = {
+		P256_W(0xf3b9cac2, 0xfc632551), P256_W(0xbce6faad, 0xa7179e84),
+		P256_W(0xffffffff, 0xffffffff), P256_W(0xffffffff, 0x00000000)
+	},
+	.rr = {
+		P256_W(0x83244c95, 0xbe79eea2), P256_W(0x4699799c, 0x49bd6fa6),
+		P256_W(0x2845b239, 0x2b6bec59), P256_W(0x66e12d94, 0xf3d95620)
+	},
+	.n0inv = P256_N0INV_N,
+};
+
+/* The curve is y^2 = x^3 - 3x + b */
+static const p256_word p256_b[P256_WORDS] = {
+	P256_W(0x3bce3c3e, 0x27d2604b), P256_W(0x651d06b0, 0xcc53b0f6),
+	P256_W(0xb3ebbd55, 0x769886bc), P256_W(0x5ac635d8, 0xaa3a93e7)
+};
+
+/* The base point G */
+static const p256_word p256_gx[P256_WORDS] = {
+	P256_W(0xf4a13945, 0xd898c296), P256_W(0x77037d81, 0x2deb33a0),
+	P256_W(0xf8bce6e5, 0x63a440f2), P256_W(0x6b17d1f2, 0xe12c4247)
+};
+
+static const p256_word p256_gy[P256_WORDS] = {
+	P256_W(0xcbb64068, 0x37bf51f5), P256_W(0x2bce3357, 0x6b315ece),
+	P256_W(0x8ee7eb4a, 0x7c0f9e16), P256_W(0x4fe342e2, 0xfe1a7f9b)
+};
+
+static const p256_word p256_one[P256_WORDS] = { 1 };
+
+/* Convert a 32-byte big endian number to words */
+static void p256_from_be(p256_word r[], const uint8_t *buf)
+{
+	int i;
+
+	memset(r, '\0', P256_BYTES);
+	for (i = 0; i < P256_BYTES; i++)
+		r[i / sizeof(p256_word)] |= (p256_word)buf[P256_BYTES - 1 - i] <<
+			(i % sizeof(p256_word) * 8);
+}
+
+static int p256_is_zero(const p256_word a[])
+{
+	p256_word acc = 0;
+	int i;
+
+	for (i = 0; i < P256_WORDS; i++)
+		acc |= a[i];
+
+	return !acc;
+}
+
+/* Return -1, 0 or 1 if a is less than, equal to or greater than b */
+static int p256_cmp(const p256_word a[], const p256_word b[])
+{
+	int i;
+
+	for (i = P256_WORDS - 1; i >= 0; i--) {
+		if (a[i] < b[i])
+			return -1;
+		if (a[i] > b[i])
+			return 1;
+	}
+
+	return 0;
+}
+
+/* r = a + b, returning the carry */
+static p256_word p256_add_raw(p256_word r[], const p256_word a[],
+			      const p256_word b[])
+{
+	p256_dword acc = 0;
+	int i;
+
+	for (i = 0; i < P256_WORDS; i++) {
+		acc += (p256_dword)a[i] + b[i];
+		r[i] = (p256_word)acc;
+		acc >>= P256_WORD_BITS;
+	}
+
+	return acc;
+}
+
+/* r = a - b, returning the borrow */
+static p256_word p256_sub_raw(p256_word r[], const p256_word a[],
+			      const p256_word b[])
+{
+	p256_word borrow = 0;
+	p256_dword acc;
+	int i;
+
+	for (i = 0; i < P256_WORDS; i++) {
+		acc = (p256_dword)a[i] - b[i] - borrow;
+		r[i] = (p256_word)acc;
+		borrow = (p256_word)(acc >> P256_WORD_BITS) & 1;
+	}
+
+	return borrow;
+}
+
+/* r = a + b mod m, where a, b < m */
+static void p256_mod_add(p256_word r[], const p256_word a[],
+			 const p256_word b[], const struct p256_mod *mod)
+{
+	if (p256_add_raw(r, a, b) || p256_cmp(r, mod->m) >= 0)
+		p256_sub_raw(r, r, mod->m);
+}
+
+/* r = a - b mod m, where a, b < m */
+static void p256_mod_sub(p256_word r[], const p256_word a[],
+			 const p256_word b[], const struct p256_mod *mod)
+{
+	if (p256_sub_raw(r, a, b))
+		p256_add_raw(r, r, mod->m);
+}
+
+/* r = a * b / R mod m, where a, b < m. Any of r, a and b may be the same */
+static void p256_mont_mul(p256_word r[], const p256_word a[],
+			  const p256_word b[], const struct p256_mod *mod)
+{
+	p256_word t[P256_WORDS + 2];
+	p256_dword acc;
+	p256_word d;
+	int i, j;
+
+	memset(t, '\0', sizeof(t));
+	for (i = 0; i < P256_WORDS; i++) {
+		/* t += a * b[i] */
+		acc = 0;
+		for (j = 0; j < P256_WORDS; j++) {
+			acc += (p256_dword)a[j] * b[i] + t[j];
+			t[j] = (p256_word)acc;
+			acc >>= P256_WORD_BITS;
+		}
+		acc += t[P256_WORDS];
+		t[P256_WORDS] = (p256_word)acc;
+		t[P256_WORDS + 1] = acc >> P256_WORD_BITS;
+
+		/* t = (t + d * m) / 2^P256_WORD_BITS, choosing d so that it is exact */
+		d = t[0] * mod->n0inv;
+		acc = ((p256_dword)d * mod->m[0] + t[0]) >> P256_WORD_BITS;
+		for (j = 1; j < P256_WORDS; j++) {
+			acc += (p256_dword)d * mod->m[j] + t[j];
+			t[j - 1] = (p256_word)acc;
+			acc >>= P256_WORD_BITS;
+		}
+		acc += t[P256_WORDS];
+		t[P256_WORDS - 1] = (p256_word)acc;
+		t[P256_WORDS] = t[P256_WORDS + 1] + (acc >> P256_WORD_BITS);
+	}
+
+	if (t[P256_WORDS] || p256_cmp(t, mod->m) >= 0)
+		p256_sub_raw(t, t, mod->m);
+	memcpy(r, t, P256_BYTES);
+}
+
+/* r = 1 / a mod m, with a and r in Montgomery form. m must be prime */
+static void p256_mod_inv(p256_word r[], const p256_word a[],
+			 const struct p256_mod *mod)
+{
+	p256_word e[P256_WORDS], acc[P256_WORDS];
+	int i;
+
+	/* a^(m - 2) = 1 / a by Fermat's little theorem */
+	memcpy(e, mod->m, P256_BYTES);
+	e[0] -= 2;
+	p256_mont_mul(acc, p256_one, mod->rr, mod);
+	for (i = P256_BYTES * 8 - 1; i >= 0; i--) {
+		p256_mont_mul(acc, acc, acc, mod);
+		if (e[i / P256_WORD_BITS] >> (i % P256_WORD_BITS) & 1)
+			p256_mont_mul(acc, acc, a, mod);
+	}
+	memcpy(r, acc, P256_BYTES);
+}
+
+#define fmul(r, a, b)	p256_mont_mul(r, a, b, &p256_p)
+#define fadd(r, a, b)	p256_mod_add(r, a, b, &p256_p)
+#define fsub(r, a, b)	p256_mod_sub(r, a, b, &p256_p)
+
+/* r = 2a, using dbl-2001-b for a = -3. r may be the same as a */
+static void p256_double(struct p256_point *r, const struct p256_point *a)
+{
+	p256_word delta[P256_WORDS], gamma[P256_WORDS], beta[P256_WORDS];
+	p256_word alpha[P256_WORDS], t[P256_WORDS], t2[P256_WORDS];
+
+	if (p256_is_zero(a->z)) {
+		*r = *a;
+		return;
+	}
+
+	fmul(delta, a->z, a->z);
+	fmul(gamma, a->y, a->y);
+	fmul(beta, a->x, gamma);
+
+	/* alpha = 3 (x - delta) (x + delta) */
+	fsub(t, a->x, delta);
+	fadd(t2, a->x, delta);
+	fmul(alpha, t, t2);
+	fadd(t, alpha, alpha);
+	fadd(alpha, t, alpha);
+
+	/* z3 = (y + z)^2 - gamma - delta */
+	fadd(t, a->y, a->z);
+	fmul(t, t, t);
+	fsub(t, t, gamma);
+	fsub(r->z, t, delta);
+
+	/* x3 = alpha^2 - 8 beta */
+	fadd(beta, beta, beta);
+	fadd(beta, beta, beta);
+	fmul(t, alpha, alpha);
+	fadd(t2, beta, beta);
+	fsub(r->x, t, t2);
+
+	/* y3 = alpha (4 beta - x3) - 8 gamma^2 */
+	fsub(t, beta, r->x);
+	fmul(t, alpha, t);
+	fmul(gamma, gamma, gamma);
+	fadd(gamma, gamma, gamma);
+	fadd(gamma, gamma, gamma);
+	fadd(gamma, gamma, gamma);
+	fsub(r->y, t, gamma);
+}
+
+/* r = a + b, using add-2007-bl. r may be the same as a */
+static void p256_add(struct p256_point *r, const struct p256_point *a,
+		     const struct p256_point *b)
+{
+	p256_word z1z1[P256_WORDS], z2z2[P256_WORDS], u1[P256_WORDS];
+	p256_word u2[P256_WORDS], s1[P256_WORDS], s2[P256_WORDS];
+	p256_word h[P256_WORDS], i[P256_WORDS], j[P256_WORDS];
+	p256_word rr[P256_WORDS], v[P256_WORDS], t[P256_WORDS];
+
+	if (p256_is_zero(a->z)) {
+		*r = *b;
+		return;
+	}
+	if (p256_is_zero(b->z)) {
+		*r = *a;
+		return;
+	}
+
+	fmul(z1z1, a->z, a->z);
+	fmul(z2z2, b->z, b->z);
+	fmul(u1, a->x, z2z2);
+	fmul(u2, b->x, z1z1);
+	fmul(s1, a->y, b->z);
+	fmul(s1, s1, z2z2);
+	fmul(s2, b->y, a->z);
+	fmul(s2, s2, z1z1);
+	fsub(h, u2, u1);
+	fsub(rr, s2, s1);
+	if (p256_is_zero(h)) {
+		if (p256_is_zero(rr))
+			p256_double(r, a);
+		else
+			memset(r, '\0', sizeof(*r));
+		return;
+	}
+
+	fadd(rr, rr, rr);
+	fadd(i, h, h);
+	fmul(i, i, i);
+	fmul(j, h, i);
+	fmul(v, u1, i);
+
+	/* z3 = ((z1 + z2)^2 - z1z1 - z2z2) h */
+	fadd(t, a->z, b->z);
+	fmul(t, t, t);
+	fsub(t, t, z1z1);
+	fsub(t, t, z2z2);
+	fmul(r->z, t, h);
+
+	/* x3 = rr^2 - j - 2v */
+	fmul(t, rr, rr);
+	fsub(t, t, j);
+	fsub(t, t, v);
+	fsub(r->x, t, v);
+
+	/* y3 = rr (v - x3) - 2 s1 j */
+	fsub(t, v, r->x);
+	fmul(t, rr, t);
+	fmul(s1, s1, j);
+	fadd(s1, s1, s1);
+	fsub(r->y, t, s1);
+}
+
+/**
+ * p256_set_point() - Set up a point from affine coordinates
+ *
+ * @r:		Point to set up
+ * @x:		x coordinate, in normal form
+ * @y:		y coordinate, in normal form
+ * @return 0 if OK, -EINVAL if the point is not on the curve
+ */
+static int p256_set_point(struct p256_point *r, const p256_word x[],
+			  const p256_word y[])
+{
+	p256_word lhs[P256_WORDS], rhs[P256_WORDS], t[P256_WORDS];
+
+	if (p256_cmp(x, p256_p.m) >= 0 || p256_cmp(y, p256_p.m) >= 0)
+		return -EINVAL;
+	fmul(r->x, x, p256_p.rr);
+	fmul(r->y, y, p256_p.rr);
+	fmul(r->z, p256_one, p256_p.rr);
+
+	/* Check that y^2 = x^3 - 3x + b */
+	fmul(lhs, r->y, r->y);
+	fmul(rhs, r->x, r->x);
+	fmul(rhs, rhs, r->x);
+	fsub(rhs, rhs, r->x);
+	fsub(rhs, rhs, r->x);
+	fsub(rhs, rhs, r->x);
+	fmul(t, p256_b, p256_p.rr);
+	fadd(rhs, rhs, t);
+	if (p256_cmp(lhs, rhs))
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+ * p256_verify() - Verify an ECDSA P-256 signature
+ *
+ * @hash:	Hash of the signed data (32 bytes)
+ * @sig:	Signature, as the 32-byte big endian values r and s
+ * @qx:		Public key x coordinate, 32 bytes big endian
+ * @qy:		Public key y coordinate, 32 bytes big endian
+ * @return 0 if verified, -EINVAL if the key or signature is invalid,
+ *	-EACCES if the signature does not match
+ */
+static int p256_verify(const uint8_t *hash, const uint8_t *sig,
+		       const uint8_t *qx, const uint8_t *qy)
+{
+	p256_word r[P256_WORDS], s[P256_WORDS], e[P256_WORDS];
+	p256_word u1[P256_WORDS], u2[P256_WORDS], w[P256_WORDS];
+	p256_word x[P256_WORDS], y[P256_WORDS];
+	struct p256_point table[3], acc;
+	int bits, i;
+
+	p256_from_be(r, sig);
+	p256_from_be(s, sig + P256_BYTES);
+	if (p256_is_zero(r) || p256_cmp(r, p256_n.m) >= 0 ||
+	    p256_is_zero(s) || p256_cmp(s, p256_n.m) >= 0) {
+		debug("%s: Signature out of range\n", __func__);
+		return -EINVAL;
+	}
+
+	/* table[] holds G, Q and G + Q */
+	p256_set_point(&table[0], p256_gx, p256_gy);
+	p256_from_be(x, qx);
+	p256_from_be(y, qy);
+	if (p256_set_point(&table[1], x, y)) {
+		debug("%s: Public key is not on the curve\n", __func__);
+		return -EINVAL;
+	}
+	p256_add(&table[2], &table[0], &table[1]);
+
+	/* u1 = e / s and u2 = r / s, mod n */
+	p256_from_be(e, hash);
+	if (p256_cmp(e, p256_n.m) >= 0)
+		p256_sub_raw(e, e, p256_n.m);
+	p256_mont_mul(w, s, p256_n.rr, &p256_n);
+	p256_mod_inv(w, w, &p256_n);
+	p256_mont_mul(u1, e, w, &p256_n);
+	p256_mont_mul(u2, r, w, &p256_n);
+
+	/* acc = u1 G + u2 Q, doing both at once */
+	memset(&acc, '\0', sizeof(acc));
+	for (i = P256_BYTES * 8 - 1; i >= 0; i--) {
+		p256_double(&acc, &acc);
+		bits = (u1[i / P256_WORD_BITS] >> (i % P256_WORD_BITS) & 1) |
+		       (u2[i / P256_WORD_BITS] >> (i % P256_WORD_BITS) & 1) << 1;
+		if (bits)
+			p256_add(&acc, &acc, &table[bits - 1]);
+	}
+	if (p256_is_zero(acc.z))
+		return -EACCES;
+
+	/* The signature is valid if r = x mod n, where x = X / Z^2 */
+	p256_mod_inv(w, acc.z, &p256_p);
+	fmul(w, w, w);
+	fmul(x, acc.x, w);
+	fmul(x, x, p256_one);
+	if (p256_cmp(x, p256_n.m) >= 0)
+		p256_sub_raw(x, x, p256_n.m);
+
+	return p256_cmp(x, r) ? -EACCES : 0;
+}
+
+/**
+ * ecdsa_verify_with_keynode() - Verify a signature using a key in the FDT
+ *
+ * @info:	Specifies key and FIT information
+ * @hash:	Pointer to the expected hash
+ * @sig:	Signature
+ * @sig_len:	Number of bytes in signature
+ * @node:	Node containing the ECDSA key properties
+ * @return 0 if verified, -ve on error
+ */
+static int ecdsa_verify_with_keynode(struct image_sign_info *info,
+				     const void *hash, uint8_t *sig,
+				     uint sig_len, int node)
+{
+	const void *blob = info->fdt_blob;
+	const void *x, *y;
+	const char *curve;
+	int x_len, y_len;
+
+	if (node < 0) {
+		debug("%s: Skipping invalid node", __func__);
+		return -EBADF;
+	}
+
+	curve = fdt_getprop(blob, node, "ecdsa,curve", NULL);
+	x = fdt_getprop(blob, node, "ecdsa,x-point", &x_len);
+	y = fdt_getprop(blob, node, "ecdsa,y-point", &y_len);
+	if (!curve || !x || !y) {
+		debug("%s: Missing ECDSA key info", __func__);
+		return -EFAULT;
+	}
+	if (strcmp(curve, ECDSA256_CURVE) || x_len != P256_BYTES ||
+	    y_len != P256_BYTES) {
+		debug("%s: Unsupported curve '%s'\n", __func__, curve);
+		return -EFAULT;
+	}
+	if (sig_len != ECDSA256_BYTES) {
+		debug("Signature is of incorrect length %d\n", sig_len);
+		return -EINVAL;
+	}
+
+	return p256_verify(hash, sig, x, y);
+}
+
+int ecdsa_verify(struct image_sign_info *info,
+		 const struct image_region region[], int region_count,
+		 uint8_t *sig, uint sig_len)
+{
+	const void *blob = info->fdt_blob;
+	uint8_t hash[P256_BYTES];
+	int ndepth, noffset;
+	int sig_node, node;
+	char name[100];
+	int ret;
+
+	if (info->algo->checksum->checksum_len != P256_BYTES) {
+		debug("%s: invalid checksum-algorithm %s for %s\n",
+		      __func__, info->algo->checksum->name, info->algo->name);
+		return -EINVAL;
+	}
+
+	sig_node = fdt_subnode_offset(blob, 0, FIT_SIG_NODENAME);
+	if (sig_node < 0) {
+		debug("%s: No signature node found\n", __func__);
+		return -ENOENT;
+	}
+
+	ret = info->algo->checksum->calculate(info->algo->checksum->name,
+					region, region_count, hash);
+	if (ret < 0) {
+		debug("%s: Error in checksum calculation\n", __func__);
+		return -EINVAL;
+	}
+
+	/* See if we must use a particular key */
+	if (info->required_keynode != -1) {
+		ret = ecdsa_verify_with_keynode(info, hash, sig, sig_len,
+						info->required_keynode);
+		if (!ret)
+			return ret;
+	}
+
+	/* Look for a key that matches our hint */
+	snprintf(name, sizeof(name), "key-%s", info->keyname);
+	node = fdt_subnode_offset(blob, sig_node, name);
+	ret = ecdsa_verify_with_keynode(info, hash, sig, sig_len, node);
+	if (!ret)
+		return ret;
+
+	/* No luck, so try each of the keys in turn */
+	for (ndepth = 0, noffset = fdt_next_node(blob, sig_node, &ndepth);
+			(noffset >= 0) && (ndepth > 0);
+			noffset = fdt_next_node(blob, noffset, &ndepth)) {
+		if (ndepth == 1 && noffset != node) {
+			ret = ecdsa_verify_with_keynode(info, hash, sig,
+							sig_len, noffset);
+			if (!ret)
+				break;
+		}
+	}
+
+	return ret;
+}
@@ -11,11 +11,27 @@
 #include <libfdt.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
+#include <dm/prebind.h>
 #include <asm/sections.h>
 #include <linux/ctype.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Read a property, from the live tree if it is in use for this blob */
+static const void *fdtdec_getprop(const void *blob, int node,
+				  const char *prop_name, int *lenp)
+{
+	ofnode np;
+
+	if (of_live_active() && blob == gd->fdt_blob) {
+		np = offset_to_ofnode(node);
+		if (ofnode_valid(np))
+			return ofnode_get_property(np, prop_name, lenp);
+	}
+
+	return fdt_getprop(blob, node, prop_name, lenp);
+}
+
 /*
  * Here are the type we know about. One day we might allow drivers to
  * register. For now we just put them here. The COMPAT macro allows us to
@@ -97,7 +113,7 @@ fdt_addr_t fdtdec_get_addr_size_fixed(const void *blob, int node,
 		return FDT_ADDR_T_NONE;
 	}
 
-	prop = fdt_getprop(blob, node, prop_name, &len);
+	prop = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!prop) {
 		debug("(not found)\n");
 		return FDT_ADDR_T_NONE;
@@ -207,7 +223,7 @@ int fdtdec_get_pci_addr(const void *blob, int node, enum fdt_pci_space type,
 	 * #size-cells. They need to be 3 and 2 accordingly. However,
 	 * for simplicity we skip the check here.
 	 */
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		goto fail;
 
@@ -251,7 +267,7 @@ int fdtdec_get_pci_vendev(const void *blob, int node, u16 *vendor, u16 *device)
 	const char *list, *end;
 	int len;
 
-	list = fdt_getprop(blob, node, "compatible", &len);
+	list = fdtdec_getprop(blob, node, "compatible", &len);
 	if (!list)
 		return -ENOENT;
 
@@ -307,7 +323,7 @@ uint64_t fdtdec_get_uint64(const void *blob, int node, const char *prop_name,
 	const uint64_t *cell64;
 	int length;
 
-	cell64 = fdt_getprop(blob, node, prop_name, &length);
+	cell64 = fdtdec_getprop(blob, node, prop_name, &length);
 	if (!cell64 || length < sizeof(*cell64))
 		return default_val;
 
@@ -325,7 +341,7 @@ int fdtdec_get_is_enabled(const void *blob, int node)
 	 *
 	 * http://www.mail-archive.com/u-boot@lists.denx.de/msg71598.html
 	 */
-	cell = fdt_getprop(blob, node, "status", NULL);
+	cell = fdtdec_getprop(blob, node, "status", NULL);
 	if (cell)
 		return 0 == strcmp(cell, "okay");
 	return 1;
@@ -374,7 +390,7 @@ int fdtdec_next_alias(const void *blob, const char *name,
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
+	node = fdtdec_path_offset(blob, str);
 	if (node < 0)
 		return node;
 	err = fdt_node_check_compatible(blob, node, compat_names[id]);
@@ -407,7 +423,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 	int i, j;
 
 	/* find the alias node if present */
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = fdtdec_path_offset(blob, "/aliases");
 
 	/*
 	 * start with nothing, and we can assume that the root node can't
@@ -438,7 +454,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = fdtdec_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -517,11 +533,19 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 	int find_namelen;
 	int prop_offset;
 	int aliases;
+	int ret;
+
+	if (CONFIG_IS_ENABLED(OF_PREBIND) && blob == gd->fdt_blob &&
+	    dm_prebind_valid()) {
+		ret = dm_prebind_alias_seq(base, offset, seqp);
+		if (ret != -ENODEV)
+			return ret;
+	}
 
 	find_name = fdt_get_name(blob, offset, &find_namelen);
 	debug("Looking for '%s' at %d, name %s\n", base, offset, find_name);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -557,8 +581,8 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name)
 
 	if (!blob)
 		return NULL;
-	chosen_node = fdt_path_offset(blob, "/chosen");
-	return fdt_getprop(blob, chosen_node, name, NULL);
+	chosen_node = fdtdec_path_offset(blob, "/chosen");
+	return fdtdec_getprop(blob, chosen_node, name, NULL);
 }
 
 int fdtdec_get_chosen_node(const void *blob, const char *name)
@@ -568,7 +592,7 @@ int fdtdec_get_chosen_node(const void *blob, const char *name)
 	prop = fdtdec_get_chosen_prop(blob, name);
 	if (!prop)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, prop);
+	return fdtdec_path_offset(blob, prop);
 }
 
 int fdtdec_check_fdt(void)
@@ -615,11 +639,11 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	int lookup;
 
 	debug("%s: %s\n", __func__, prop_name);
-	phandle = fdt_getprop(blob, node, prop_name, NULL);
+	phandle = fdtdec_getprop(blob, node, prop_name, NULL);
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -641,7 +665,7 @@ static const void *get_prop_check_min_len(const void *blob, int node,
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		*err = -FDT_ERR_NOTFOUND;
 	else if (len < min_len)
@@ -675,7 +699,7 @@ int fdtdec_get_int_array_count(const void *blob, int node,
 	int i;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		return -FDT_ERR_NOTFOUND;
 	elems = len / sizeof(u32);
@@ -704,7 +728,7 @@ int fdtdec_get_bool(const void *blob, int node, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	return cell != NULL;
 }
 
@@ -721,7 +745,7 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 	int phandle;
 
 	/* Retrieve the phandle list property */
-	list = fdt_getprop(blob, src_node, list_name, &size);
+	list = fdtdec_getprop(blob, src_node, list_name, &size);
 	if (!list)
 		return -ENOENT;
 	list_end = list + size / sizeof(*list);
@@ -747,8 +771,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (!node) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -873,7 +897,7 @@ int fdtdec_get_config_int(const void *blob, const char *prop_name,
 	int config_node;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return default_val;
 	return fdtdec_get_int(blob, config_node, prop_name, default_val);
@@ -885,7 +909,7 @@ int fdtdec_get_config_bool(const void *blob, const char *prop_name)
 	const void *prop;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return 0;
 	prop = fdt_get_property(blob, config_node, prop_name, NULL);
@@ -900,11 +924,11 @@ char *fdtdec_get_config_string(const void *blob, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	nodeoffset = fdt_path_offset(blob, "/config");
+	nodeoffset = fdtdec_path_offset(blob, "/config");
 	if (nodeoffset < 0)
 		return NULL;
 
-	nodep = fdt_getprop(blob, nodeoffset, prop_name, &len);
+	nodep = fdtdec_getprop(blob, nodeoffset, prop_name, &len);
 	if (!nodep)
 		return NULL;
 
@@ -919,7 +943,7 @@ int fdtdec_decode_region(const void *blob, int node, const char *prop_name,
 
 	debug("%s: %s: %s\n", __func__, fdt_get_name(blob, node, NULL),
 	      prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!cell || (len < sizeof(fdt_addr_t) * 2)) {
 		debug("cell=%p, len=%d\n", cell, len);
 		return -1;
@@ -955,10 +979,10 @@ int fdtdec_read_fmap_entry(const void *blob, int node, const char *name,
 	entry->offset = reg[0];
 	entry->length = reg[1];
 	entry->used = fdtdec_get_int(blob, node, "used", entry->length);
-	prop = fdt_getprop(blob, node, "compress", NULL);
+	prop = fdtdec_getprop(blob, node, "compress", NULL);
 	entry->compress_algo = prop && !strcmp(prop, "lzo") ?
 		FMAP_COMPRESS_LZO : FMAP_COMPRESS_NONE;
-	prop = fdt_getprop(blob, node, "hash", &entry->hash_size);
+	prop = fdtdec_getprop(blob, node, "hash", &entry->hash_size);
 	entry->hash_algo = prop ? FMAP_HASH_SHA256 : FMAP_HASH_NONE;
 	entry->hash = (uint8_t *)prop;
 
@@ -1033,7 +1057,7 @@ int fdtdec_decode_memory_region(const void *blob, int config_node,
 	int node;
 
 	if (config_node == -1) {
-		config_node = fdt_path_offset(blob, "/config");
+		config_node = fdtdec_path_offset(blob, "/config");
 		if (config_node < 0) {
 			debug("%s: Cannot find /config node\n", __func__);
 			return -ENOENT;
@@ -1044,14 +1068,14 @@ int fdtdec_decode_memory_region(const void *blob, int config_node,
 
 	snprintf(prop_name, sizeof(prop_name), "%s-memory%s", mem_type,
 		 suffix);
-	mem = fdt_getprop(blob, config_node, prop_name, NULL);
+	mem = fdtdec_getprop(blob, config_node, prop_name, NULL);
 	if (!mem) {
 		debug("%s: No memory type for '%s', using /memory\n", __func__,
 		      prop_name);
 		mem = "/memory";
 	}
 
-	node = fdt_path_offset(blob, mem);
+	node = fdtdec_path_offset(blob, mem);
 	if (node < 0) {
 		debug("%s: Failed to find node '%s': %s\n", __func__, mem,
 		      fdt_strerror(node));
@@ -1089,7 +1113,7 @@ static int decode_timing_property(const void *blob, int node, const char *name,
 	int length, ret = 0;
 	const u32 *prop;
 
-	prop = fdt_getprop(blob, node, name, &length);
+	prop = fdtdec_getprop(blob, node, name, &length);
 	if (!prop) {
 		debug("%s: could not find property %s\n",
 		      fdt_get_name(blob, node, NULL), name);
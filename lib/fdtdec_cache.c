@@ -0,0 +1,196 @@
+/*
+ * Cache of phandle and path lookups in the control device tree
+ *
+ * libfdt finds a phandle by scanning the whole tree, and a path by walking
+ * down from the root, checking the name of each subnode on the way. Drivers
+ * do both over and over while binding and probing, to find their clocks,
+ * resets, GPIOs, pin configuration and aliases. For the control device tree
+ * (gd->fdt_blob) keep a table of the offset of each phandle, built with a
+ * single scan of the tree, and the offsets of the last few paths looked up.
+ *
+ * The offsets are only valid while the tree is unchanged. The cache is
+ * rebuilt if gd->fdt_blob moves, or if the size of its structure block
+ * changes, as it does when a node or property is added or removed or a
+ * property changes size. Code which changes the tree in some other way
+ * must call fdtdec_cache_invalidate().
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <fdtdec.h>
+#include <malloc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define FDTDEC_CACHE_PATHS	16
+#define FDTDEC_CACHE_PATH_LEN	32
+
+/**
+ * struct fdtdec_cache_path - A path that has been looked up
+ *
+ * @offset:	Offset of the node, or -ve FDT_ERR_... if not found
+ * @path:	Path or alias, as passed to fdt_path_offset()
+ */
+struct fdtdec_cache_path {
+	int offset;
+	char path[FDTDEC_CACHE_PATH_LEN];
+};
+
+/**
+ * struct fdtdec_cache - Lookups in the control device tree
+ *
+ * @blob:	Device tree that the cache is for, NULL if it must be rebuilt
+ * @struct_size: Size of the structure block of @blob when the cache was
+ *		built
+ * @max_phandle: Largest phandle in @blob
+ * @phandle:	Offset of the node for each phandle up to @max_phandle, or
+ *		-FDT_ERR_NOTFOUND. This is NULL if the phandles are too sparse
+ *		to be worth a table or if there is not enough memory.
+ * @num_paths:	Number of entries used in @path
+ * @next_path:	Next entry of @path to replace
+ * @path:	Paths looked up most recently
+ */
+struct fdtdec_cache {
+	const void *blob;
+	int struct_size;
+	uint max_phandle;
+	int *phandle;
+	uint num_paths;
+	uint next_path;
+	struct fdtdec_cache_path path[FDTDEC_CACHE_PATHS];
+};
+
+/* Allocate memory, leaving most of the early malloc() space for devices */
+static void *fdtdec_cache_alloc(size_t size)
+{
+#ifdef CONFIG_SYS_MALLOC_F_LEN
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT) &&
+	    size > (gd->malloc_limit - gd->malloc_ptr) / 4)
+		return NULL;
+#endif
+
+	return malloc(size);
+}
+
+/* Build the phandle table with a single scan of the tree */
+static void fdtdec_cache_phandles(struct fdtdec_cache *cache,
+				  const void *blob)
+{
+	uint count = 0, max = 0;
+	uint32_t phandle;
+	int offset;
+	uint i;
+
+	cache->phandle = NULL;
+	cache->max_phandle = 0;
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle && phandle != (uint32_t)-1) {
+			count++;
+			max = max(max, phandle);
+		}
+	}
+
+	/* dtc numbers phandles from 1, so they are normally dense */
+	if (!count || max > count * 4 + 64)
+		return;
+	cache->phandle = fdtdec_cache_alloc((max + 1) * sizeof(int));
+	if (!cache->phandle)
+		return;
+	cache->max_phandle = max;
+	for (i = 0; i <= max; i++)
+		cache->phandle[i] = -FDT_ERR_NOTFOUND;
+
+	/* As with fdt_node_offset_by_phandle(), the first node wins */
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle && phandle <= max &&
+		    cache->phandle[phandle] == -FDT_ERR_NOTFOUND)
+			cache->phandle[phandle] = offset;
+	}
+}
+
+/**
+ * fdtdec_get_cache() - Get the cache for a device tree, building it if needed
+ *
+ * @blob:	Device tree
+ * @return cache, or NULL if @blob is not the control device tree or there
+ * is not enough memory
+ */
+static struct fdtdec_cache *fdtdec_get_cache(const void *blob)
+{
+	struct fdtdec_cache *cache = gd->fdt_cache;
+
+	if (!blob || blob != gd->fdt_blob)
+		return NULL;
+	if (cache && cache->blob == blob &&
+	    cache->struct_size == fdt_size_dt_struct(blob))
+		return cache;
+
+	if (!cache) {
+		cache = fdtdec_cache_alloc(sizeof(*cache));
+		if (!cache)
+			return NULL;
+		gd->fdt_cache = cache;
+	} else {
+		free(cache->phandle);
+	}
+	cache->blob = blob;
+	cache->struct_size = fdt_size_dt_struct(blob);
+	cache->num_paths = 0;
+	cache->next_path = 0;
+	fdtdec_cache_phandles(cache, blob);
+
+	return cache;
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	struct fdtdec_cache *cache = fdtdec_get_cache(blob);
+
+	if (!cache || !cache->phandle || !phandle ||
+	    phandle == (uint32_t)-1)
+		return fdt_node_offset_by_phandle(blob, phandle);
+	if (phandle > cache->max_phandle)
+		return -FDT_ERR_NOTFOUND;
+
+	return cache->phandle[phandle];
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	struct fdtdec_cache *cache = fdtdec_get_cache(blob);
+	struct fdtdec_cache_path *entry;
+	int offset;
+	uint i;
+
+	if (!cache)
+		return fdt_path_offset(blob, path);
+	for (i = 0; i < cache->num_paths; i++) {
+		if (!strcmp(cache->path[i].path, path))
+			return cache->path[i].offset;
+	}
+
+	offset = fdt_path_offset(blob, path);
+	if (strlen(path) < FDTDEC_CACHE_PATH_LEN) {
+		entry = &cache->path[cache->next_path];
+		strcpy(entry->path, path);
+		entry->offset = offset;
+		cache->next_path = (cache->next_path + 1) % FDTDEC_CACHE_PATHS;
+		if (cache->num_paths < FDTDEC_CACHE_PATHS)
+			cache->num_paths++;
+	}
+
+	return offset;
+}
+
+void fdtdec_cache_invalidate(void)
+{
+	struct fdtdec_cache *cache = gd->fdt_cache;
+
+	if (cache)
+		cache->blob = NULL;
+}
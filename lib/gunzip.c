@@ -41,7 +41,8 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/* Returns the size of the gzip header at @src, or -1 if it is not valid */
+static int gunzip_header_len(const unsigned char *src, unsigned long len)
 {
 	int i, flags;
 
@@ -62,14 +63,83 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 			;
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= *lenp) {
+	if (i >= len) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
 
+	return i;
+}
+
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	int i;
+
+	i = gunzip_header_len(src, *lenp);
+	if (i < 0)
+		return (-1);
+
 	return zunzip(dst, dstlen, src, lenp, 1, i);
 }
 
+int gunzip_stream(void *dst, ulong dstlen, decomp_in_t in, void *priv,
+		  ulong *lenp)
+{
+	const void *buf;
+	z_stream s;
+	long len;
+	int err = 0;
+	int i, r;
+
+	*lenp = 0;
+	len = in(priv, &buf);
+	if (len <= 0) {
+		puts("Error: gunzip out of data in header\n");
+		return -1;
+	}
+	i = gunzip_header_len(buf, len);
+	if (i < 0)
+		return -1;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		return -1;
+	}
+	s.next_in = (unsigned char *)buf + i;
+	s.avail_in = len - i;
+	s.next_out = dst;
+	s.avail_out = min(dstlen, (ulong)UINT_MAX);
+
+	/* fetch more input whenever inflate() has consumed the last chunk */
+	do {
+		if (!s.avail_in) {
+			len = in(priv, &buf);
+			if (len <= 0) {
+				puts("Error: gunzip out of data\n");
+				err = -1;
+				break;
+			}
+			s.next_in = (unsigned char *)buf;
+			s.avail_in = len;
+			WATCHDOG_RESET();
+		}
+		r = inflate(&s, Z_NO_FLUSH);
+		if (r != Z_OK && r != Z_STREAM_END) {
+			printf("Error: inflate() returned %d\n", r);
+			err = -1;
+			break;
+		}
+	} while (r != Z_STREAM_END);
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+
+	return err;
+}
+
 #ifdef CONFIG_CMD_UNZIP
 __weak
 void gzwrite_progress_init(u64 expectedsize)
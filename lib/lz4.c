@@ -97,6 +97,10 @@ FORCE_INLINE int LZ4_decompress_generic(
     const int safeDecode = (endOnInput==endOnInputSize);
     const int checkOffset = ((safeDecode) && (dictSize < (int)(64 KB)));
 
+    /* Limits for the shortcut below: maximum literals, offset, maximum match */
+    const BYTE* const shortiend = iend - (endOnInput ? 14 : 8) - 2;
+    BYTE* const shortoend = oend - (endOnInput ? 14 : 8) - 18;
+
 
     /* Special cases */
     if ((partialDecoding) && (oexit> oend-MFLIMIT)) oexit = oend-MFLIMIT;                         /* targetOutputSize too high => decode everything */
@@ -109,11 +113,45 @@ FORCE_INLINE int LZ4_decompress_generic(
     {
         unsigned token;
         size_t length;
+        size_t offset;
         const BYTE* match;
 
         /* get literal length */
         token = *ip++;
-        if ((length=(token>>ML_BITS)) == RUN_MASK)
+        length = token>>ML_BITS;
+
+        /*
+         * Shortcut for the common case of a few literals followed by a short
+         * match which does not overlap itself, away from the end of the
+         * buffers (backported from LZ4 v1.8.2). The literals and the match
+         * are copied with fixed-size copies, without any bounds checks.
+         */
+        if (((endOnInput) ? length != RUN_MASK : length <= 8)
+            && likely(((endOnInput) ? ip < shortiend : 1) & (op <= shortoend)))
+        {
+            /* Copy the literals */
+            memcpy(op, ip, (endOnInput) ? 16 : 8);
+            op += length; ip += length;
+
+            /* Decode the match, which may still need the full treatment */
+            length = token & ML_MASK;
+            offset = LZ4_readLE16(ip); ip += 2;
+            match = op - offset;
+
+            if ((length != ML_MASK) && (offset >= 8)
+                && (dict==withPrefix64k || match >= lowPrefix))
+            {
+                memcpy(op + 0, match + 0, 8);
+                memcpy(op + 8, match + 8, 8);
+                memcpy(op +16, match +16, 2);
+                op += length + MINMATCH;
+                continue;
+            }
+
+            goto _copy_match;
+        }
+
+        if (length == RUN_MASK)
         {
             unsigned s;
             do
@@ -150,11 +188,14 @@ FORCE_INLINE int LZ4_decompress_generic(
         ip += length; op = cpy;
 
         /* get offset */
-        match = cpy - LZ4_readLE16(ip); ip+=2;
-        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
+        offset = LZ4_readLE16(ip); ip+=2;
+        match = op - offset;
 
         /* get matchlength */
         length = token & ML_MASK;
+
+_copy_match:
+        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
         if (length == ML_MASK)
         {
             unsigned s;
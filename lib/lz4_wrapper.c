@@ -6,6 +6,8 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <cpu_work.h>
+#include <malloc.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 
@@ -63,12 +65,183 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
+/*
+ * The watchdog must only be reset from the boot CPU, so as for bzip2, frames
+ * are not decompressed in parallel with one
+ */
+#if defined(CONFIG_CPU_WORK) && !defined(CONFIG_HW_WATCHDOG) && \
+	!defined(CONFIG_WATCHDOG)
+#define LZ4_PARALLEL	1
+#endif
+
+#ifdef LZ4_PARALLEL
+/* Most pieces of work that the blocks of a frame are shared out between */
+#define LZ4_MAX_JOBS	16
+
+/**
+ * struct lz4_job - A run of consecutive blocks, decompressed on one CPU
+ *
+ * @work:	Work to queue
+ * @in:		Header of the first block
+ * @out:	Output position for the first block
+ * @end:	End of the output available to this run
+ * @blocks:	Number of blocks in the run
+ * @has_block_checksum:	true if each block is followed by a checksum
+ * @size:	Returns the number of bytes written
+ * @ret:	Returns 0 if OK, -ve on error
+ */
+struct lz4_job {
+	struct cpu_work work;
+	const void *in;
+	void *out;
+	const void *end;
+	int blocks;
+	int has_block_checksum;
+	size_t size;
+	int ret;
+};
+
+static void lz4_job_run(void *arg)
+{
+	struct lz4_job *job = arg;
+	const void *in = job->in;
+	void *out = job->out;
+	int i, ret;
+
+	job->ret = 0;
+	for (i = 0; i < job->blocks; i++) {
+		struct lz4_block_header b;
+
+		b.raw = le32_to_cpu(*(u32 *)in);
+		in += sizeof(struct lz4_block_header);
+		if (b.not_compressed) {
+			if (b.size > job->end - out) {
+				job->ret = -ENOBUFS;
+				break;
+			}
+			memcpy(out, in, b.size);
+			out += b.size;
+		} else {
+			ret = LZ4_decompress_generic(in, out, b.size,
+					job->end - out, endOnInputSize,
+					full, 0, noDict, out, NULL, 0);
+			if (ret < 0) {
+				job->ret = -EPROTO;
+				break;
+			}
+			out += ret;
+		}
+		in += b.size;
+		if (job->has_block_checksum)
+			in += sizeof(u32);
+	}
+	job->size = out - job->out;
+}
+
+/**
+ * lz4_decomp_parallel() - Decompress the blocks of a frame in parallel
+ *
+ * Runs of blocks are decompressed on secondary CPUs, each into its place in
+ * the output. This relies on every block except the last decompressing to
+ * the maximum block size, as the lz4 tool produces. Frames which do not
+ * follow this, or which are corrupt, are left for the normal, sequential
+ * decompression to deal with.
+ *
+ * @in:		First block header
+ * @left:	Number of bytes of input from @in
+ * @dst:	Output buffer
+ * @end:	End of the output buffer
+ * @max_size:	Maximum block size
+ * @has_block_checksum:	true if each block is followed by a checksum
+ * @sizep:	Returns the number of bytes decompressed
+ * @return 0 if OK, -EAGAIN if the frame must be decompressed sequentially
+ */
+static int lz4_decomp_parallel(const void *in, size_t left, void *dst,
+			       const void *end, size_t max_size,
+			       int has_block_checksum, size_t *sizep)
+{
+	struct lz4_job jobs[LZ4_MAX_JOBS];
+	size_t extra = has_block_checksum ? sizeof(u32) : 0;
+	int blocks, per_job, count, i, j;
+	const void *p;
+	void *out;
+	int ret = 0;
+
+	/* There is no point unless blocks can run on other CPUs */
+	if (!cpu_work_cpus())
+		return -EAGAIN;
+
+	/* Count the blocks, checking that they are all within the input */
+	for (p = in, blocks = 0;; blocks++) {
+		struct lz4_block_header b;
+
+		if (left < sizeof(b))
+			return -EAGAIN;
+		b.raw = le32_to_cpu(*(u32 *)p);
+		p += sizeof(b);
+		left -= sizeof(b);
+		if (!b.size)
+			break;
+		if (b.size > max_size || b.size + extra > left)
+			return -EAGAIN;
+		p += b.size + extra;
+		left -= b.size + extra;
+	}
+	if (blocks < 2 || (blocks - 1) * max_size >= end - dst)
+		return -EAGAIN;
+
+	/*
+	 * With in-place decompression, the output of each block overwrites
+	 * the input of later ones, so they must be done in order
+	 */
+	if (in < end && p > dst)
+		return -EAGAIN;
+
+	count = min(blocks, LZ4_MAX_JOBS);
+	per_job = DIV_ROUND_UP(blocks, count);
+	count = DIV_ROUND_UP(blocks, per_job);
+	for (i = 0, p = in, out = dst; i < count; i++) {
+		struct lz4_job *job = &jobs[i];
+
+		job->in = p;
+		job->out = out;
+		job->blocks = min(per_job, blocks - i * per_job);
+		job->has_block_checksum = has_block_checksum;
+		for (j = 0; j < job->blocks; j++) {
+			struct lz4_block_header b;
+
+			b.raw = le32_to_cpu(*(u32 *)p);
+			p += sizeof(b) + b.size + extra;
+		}
+		out += job->blocks * max_size;
+		job->end = i == count - 1 ? end : out;
+		job->work.func = lz4_job_run;
+		job->work.arg = job;
+		cpu_work_queue(&job->work);
+	}
+
+	/* Each run but the last must have filled its part of the output */
+	for (i = 0; i < count; i++) {
+		cpu_work_wait(&jobs[i].work);
+		if (jobs[i].ret || (i < count - 1 &&
+				    jobs[i].size != jobs[i].blocks * max_size))
+			ret = -EAGAIN;
+	}
+	if (ret)
+		return ret;
+	*sizep = jobs[count - 1].out - dst + jobs[count - 1].size;
+
+	return 0;
+}
+#endif /* LZ4_PARALLEL */
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
 	int has_block_checksum;
+	size_t max_size __maybe_unused;
 	int ret;
 	*dstn = 0;
 
@@ -86,6 +259,7 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		if (!h->independent_blocks)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
 		has_block_checksum = h->has_block_checksum;
+		max_size = 1 << (8 + 2 * h->max_block_size);
 
 		in += sizeof(*h);
 		if (h->has_content_size)
@@ -93,6 +267,18 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		in += sizeof(u8);
 	}
 
+#ifdef LZ4_PARALLEL
+	if (max_size >= 64 << 10) {
+		size_t size;
+
+		if (!lz4_decomp_parallel(in, srcn - (in - src), dst, end,
+					 max_size, has_block_checksum, &size)) {
+			*dstn = size;
+			return 0;
+		}
+	}
+#endif
+
 	while (1) {
 		struct lz4_block_header b;
 
@@ -137,3 +323,149 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+struct lz4_stream {
+	decomp_in_t in;
+	void *priv;
+	const void *buf;
+	size_t left;
+};
+
+/* Make sure that some input is available, fetching a new chunk if needed */
+static int lz4_stream_fill(struct lz4_stream *s)
+{
+	long len;
+
+	if (s->left)
+		return 0;
+	len = s->in(s->priv, &s->buf);
+	if (len < 0)
+		return len;
+	if (!len)
+		return -EINVAL;		/* input overrun */
+	s->left = len;
+
+	return 0;
+}
+
+/* Copy @size bytes of input to @dst (or skip them if NULL) */
+static int lz4_stream_read(struct lz4_stream *s, void *dst, size_t size)
+{
+	while (size) {
+		size_t n;
+		int ret;
+
+		ret = lz4_stream_fill(s);
+		if (ret)
+			return ret;
+		n = min(size, s->left);
+		if (dst) {
+			memcpy(dst, s->buf, n);
+			dst += n;
+		}
+		s->buf += n;
+		s->left -= n;
+		size -= n;
+	}
+
+	return 0;
+}
+
+int ulz4fn_stream(decomp_in_t in, void *priv, void *dst, size_t *dstn)
+{
+	struct lz4_stream s = { .in = in, .priv = priv };
+	struct lz4_frame_header h;
+	const void *end = dst + *dstn;
+	void *out = dst;
+	void *block = NULL;
+	size_t max_size;
+	int has_block_checksum;
+	int ret;
+	*dstn = 0;
+
+	ret = lz4_stream_read(&s, &h, sizeof(h));
+	if (ret)
+		return ret;
+	if (le32_to_cpu(h.magic) != LZ4F_MAGIC || h.version != 1)
+		return -EPROTONOSUPPORT;	/* unknown format */
+	if (h.reserved0 || h.reserved1 || h.reserved2)
+		return -EINVAL;	/* reserved must be zero */
+	if (!h.independent_blocks)
+		return -EPROTONOSUPPORT; /* we can't support this yet */
+	if (h.max_block_size < 4)
+		return -EINVAL;	/* invalid maximum block size */
+	has_block_checksum = h.has_block_checksum;
+	max_size = 1 << (8 + 2 * h.max_block_size);
+
+	ret = lz4_stream_read(&s, NULL, (h.has_content_size ? sizeof(u64) : 0) +
+			      sizeof(u8));
+
+	while (!ret) {
+		struct lz4_block_header b;
+		const void *src;
+
+		ret = lz4_stream_read(&s, &b.raw, sizeof(b.raw));
+		if (ret)
+			break;
+		b.raw = le32_to_cpu(b.raw);
+
+		if (!b.size)
+			break;		/* decompression successful */
+		if (b.size > max_size) {
+			ret = -EINVAL;	/* corrupt block size */
+			break;
+		}
+
+		if (b.not_compressed) {
+			size_t size = min((ptrdiff_t)b.size, end - out);
+
+			ret = lz4_stream_read(&s, out, size);
+			if (ret)
+				break;
+			out += size;
+			if (size < b.size) {
+				ret = -ENOBUFS;	/* output overrun */
+				break;
+			}
+		} else {
+			/* Only gather the block if it spans several chunks */
+			ret = lz4_stream_fill(&s);
+			if (ret)
+				break;
+			if (s.left >= b.size) {
+				src = s.buf;
+				s.buf += b.size;
+				s.left -= b.size;
+			} else {
+				if (!block)
+					block = malloc(max_size);
+				if (!block) {
+					ret = -ENOMEM;
+					break;
+				}
+				ret = lz4_stream_read(&s, block, b.size);
+				if (ret)
+					break;
+				src = block;
+			}
+
+			/* constant folding essential, do not touch params! */
+			ret = LZ4_decompress_generic(src, out, b.size,
+					end - out, endOnInputSize,
+					full, 0, noDict, out, NULL, 0);
+			if (ret < 0) {
+				ret = -EPROTO;	/* decompression error */
+				break;
+			}
+			out += ret;
+			ret = 0;
+		}
+
+		if (has_block_checksum)
+			ret = lz4_stream_read(&s, NULL, sizeof(u32));
+	}
+
+	free(block);
+	*dstn = out - dst;
+	return ret;
+}
@@ -28,6 +28,16 @@
 #define GET_BIT(p, i) GET_BIT2(p, i, ; , ;)
 
 #define TREE_GET_BIT(probs, i) { GET_BIT((probs + i), i); }
+
+#define MATCHED_LITER_DEC \
+  { \
+    unsigned bit; \
+    CLzmaProb *probLit; \
+    matchByte <<= 1; \
+    bit = (matchByte & offs); \
+    probLit = prob + offs + bit + symbol; \
+    GET_BIT2(probLit, symbol, offs &= ~bit, offs &= bit) \
+  }
 #define TREE_DECODE(probs, limit, i) \
   { i = 1; do { TREE_GET_BIT(probs, i); } while (i < limit); i -= limit; }
 
@@ -118,6 +128,9 @@ StopCompilingDueBUG
 
 #define LZMA_DIC_MIN (1 << 12)
 
+/* Most output to decode between watchdog resets */
+#define LZMA_WATCHDOG_CHUNK ((SizeT)1 << 16)
+
 /* First LZMA-symbol is always decoded.
 And it decodes new LZMA-symbols while (buf < bufLimit), but "buf" is without last normalization
 Out:
@@ -176,10 +189,14 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
       {
         state -= (state < 4) ? state : 3;
         symbol = 1;
-
-        WATCHDOG_RESET();
-
-        do { GET_BIT(prob + symbol, symbol) } while (symbol < 0x100);
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
       }
       else
       {
@@ -187,19 +204,14 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
         unsigned offs = 0x100;
         state -= (state < 10) ? 3 : 6;
         symbol = 1;
-
-        WATCHDOG_RESET();
-
-        do
-        {
-          unsigned bit;
-          CLzmaProb *probLit;
-          matchByte <<= 1;
-          bit = (matchByte & offs);
-          probLit = prob + offs + bit + symbol;
-          GET_BIT2(probLit, symbol, offs &= ~bit, offs &= bit)
-        }
-        while (symbol < 0x100);
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
       }
       dic[dicPos++] = (Byte)symbol;
       processedPos++;
@@ -320,9 +332,6 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
             {
               UInt32 mask = 1;
               unsigned i = 1;
-
-              WATCHDOG_RESET();
-
               do
               {
                 GET_BIT2(prob + i, i, ; , distance |= mask);
@@ -334,9 +343,6 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
           else
           {
             numDirectBits -= kNumAlignBits;
-
-            WATCHDOG_RESET();
-
             do
             {
               NORMALIZE
@@ -408,18 +414,17 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
           ptrdiff_t src = (ptrdiff_t)pos - (ptrdiff_t)dicPos;
           const Byte *lim = dest + curLen;
           dicPos += curLen;
-
-          WATCHDOG_RESET();
-
-          do
-            *(dest) = (Byte)*(dest + src);
-          while (++dest != lim);
+          if (curLen >= 16 && src <= -(ptrdiff_t)curLen)
+            memcpy(dest, dest + src, curLen);
+          else if (src == -1)
+            memset(dest, dest[-1], curLen);
+          else
+            do
+              *(dest) = (Byte)*(dest + src);
+            while (++dest != lim);
         }
         else
         {
-
-          WATCHDOG_RESET();
-
           do
           {
             dic[dicPos++] = dic[pos];
@@ -482,10 +487,12 @@ static int MY_FAST_CALL LzmaDec_DecodeReal2(CLzmaDec *p, SizeT limit, const Byte
   do
   {
     SizeT limit2 = limit;
+    if (limit2 - p->dicPos > LZMA_WATCHDOG_CHUNK)
+      limit2 = p->dicPos + LZMA_WATCHDOG_CHUNK;
     if (p->checkDicSize == 0)
     {
       UInt32 rem = p->prop.dicSize - p->processedPos;
-      if (limit - p->dicPos > rem)
+      if (limit2 - p->dicPos > rem)
         limit2 = p->dicPos + rem;
     }
     RINOK(LzmaDec_DecodeReal(p, limit2, bufLimit));
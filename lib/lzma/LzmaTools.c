@@ -34,8 +34,35 @@
 #include <linux/string.h>
 #include <malloc.h>
 
-static void *SzAlloc(void *p, size_t size) { return malloc(size); }
-static void SzFree(void *p, void *address) { free(address); }
+/*
+ * The output buffer is used as the dictionary, so the only memory needed is
+ * the table of probabilities. With lc + lp <= 3, as produced by the lzma and
+ * xz tools, it is LzmaProps_GetNumProbs() = 1846 + (768 << 3) entries, which
+ * a static table holds, so that decompression does not depend on the size
+ * of the malloc() area. Other streams still allocate their table.
+ */
+#define LZMA_STATIC_PROBS       (1846 + (768 << 3))
+
+static CLzmaProb lzma_probs[LZMA_STATIC_PROBS];
+static int lzma_probs_busy;
+
+static void *SzAlloc(void *p, size_t size)
+{
+    if (size <= sizeof(lzma_probs) && !lzma_probs_busy) {
+        lzma_probs_busy = 1;
+        return lzma_probs;
+    }
+
+    return malloc(size);
+}
+
+static void SzFree(void *p, void *address)
+{
+    if (address == lzma_probs)
+        lzma_probs_busy = 0;
+    else
+        free(address);
+}
 
 int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
                   unsigned char *inStream,  SizeT  length)
@@ -0,0 +1,143 @@
+/*
+ * Live (unflattened) device tree
+ *
+ * Reading a property from the flat tree means stepping through the tags of
+ * the node's properties, checking each one and comparing its name in the
+ * strings block, and finding a subnode means stepping over every property
+ * and subnode before it. Once U-Boot has relocated, the control device tree
+ * is unflattened into nodes and properties linked by pointers, so that
+ * driver model and fdtdec can read it directly.
+ *
+ * Nodes keep their offset in the flat tree, which remains the way devices
+ * refer to their nodes, and can be found from it with a binary search.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <dm/of.h>
+
+/**
+ * struct of_live_tree - A live tree, in a single allocation
+ *
+ * @count:	Number of nodes
+ * @node:	Nodes, in flat-tree order, the first being the root
+ */
+struct of_live_tree {
+	int count;
+	struct device_node node[];
+};
+
+int of_live_build(const void *fdt_blob, struct device_node **rootp)
+{
+	struct device_node *parent[FDT_MAX_DEPTH], *prev[FDT_MAX_DEPTH];
+	int nodes = 0, props = 0, offset, poffset, depth;
+	struct property *pp, **tail;
+	struct of_live_tree *tree;
+	struct device_node *np;
+	const char *name;
+	const void *val;
+	int len;
+
+	if (fdt_check_header(fdt_blob))
+		return -EINVAL;
+
+	/* Count the nodes and properties, so they fit in one allocation */
+	for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt_blob, offset, &depth)) {
+		if (depth >= FDT_MAX_DEPTH)
+			return -EINVAL;
+		nodes++;
+		fdt_for_each_property_offset(poffset, fdt_blob, offset)
+			props++;
+	}
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND)
+		return -EINVAL;
+
+	tree = calloc(1, sizeof(*tree) + nodes * sizeof(tree->node[0]) +
+		      props * sizeof(*pp));
+	if (!tree)
+		return -ENOMEM;
+	tree->count = nodes;
+	pp = (struct property *)(tree->node + nodes);
+
+	np = tree->node;
+	for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(fdt_blob, offset, &depth), np++) {
+		np->name = fdt_get_name(fdt_blob, offset, NULL);
+		np->offset = offset;
+		np->parent = depth ? parent[depth - 1] : NULL;
+		/* Before the first child, prev[] holds the parent itself */
+		if (depth && prev[depth] == np->parent)
+			np->parent->child = np;
+		else if (depth)
+			prev[depth]->sibling = np;
+		parent[depth] = np;
+		prev[depth] = np;
+		if (depth + 1 < FDT_MAX_DEPTH)
+			prev[depth + 1] = np;
+
+		tail = &np->properties;
+		fdt_for_each_property_offset(poffset, fdt_blob, offset) {
+			val = fdt_getprop_by_offset(fdt_blob, poffset, &name,
+						    &len);
+			pp->name = name;
+			pp->value = val;
+			pp->length = len;
+			if (len == sizeof(u32) && (!strcmp(name, "phandle") ||
+			    (!np->phandle && !strcmp(name, "linux,phandle"))))
+				np->phandle = fdt32_to_cpu(*(fdt32_t *)val);
+			*tail = pp;
+			tail = &pp->next;
+			pp++;
+		}
+	}
+	*rootp = tree->node;
+
+	return 0;
+}
+
+void of_live_drop(void)
+{
+	if (!gd->of_root)
+		return;
+	free(container_of(gd->of_root, struct of_live_tree, node[0]));
+	gd->of_root = NULL;
+}
+
+struct device_node *of_find_node_by_offset(int offset)
+{
+	struct of_live_tree *tree;
+	int lo, hi, mid;
+
+	if (!gd->of_root || offset < 0)
+		return NULL;
+	tree = container_of(gd->of_root, struct of_live_tree, node[0]);
+	for (lo = 0, hi = tree->count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		if (tree->node[mid].offset == offset)
+			return &tree->node[mid];
+		if (tree->node[mid].offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+struct property *of_find_property(const struct device_node *np,
+				  const char *name)
+{
+	struct property *pp;
+
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (!strcmp(pp->name, name))
+			return pp;
+	}
+
+	return NULL;
+}
@@ -20,29 +20,28 @@
 #include <u-boot/rsa.h>
 #include <u-boot/rsa-mod-exp.h>
 
-#define UINT64_MULT32(v, multby)  (((uint64_t)(v)) * ((uint32_t)(multby)))
-
-#define get_unaligned_be32(a) fdt32_to_cpu(*(uint32_t *)a)
-#define put_unaligned_be32(a, b) (*(uint32_t *)(b) = cpu_to_fdt32(a))
-
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+/* Number of exponent bits handled at once for other public exponents */
+#define RSA_WINDOW_BITS		4
+
 /**
  * subtract_modulus() - subtract modulus from the given value
  *
  * @key:	Key containing modulus to subtract
  * @num:	Number to subtract modulus from, as little endian word array
  */
-static void subtract_modulus(const struct rsa_public_key *key, uint32_t num[])
+static void subtract_modulus(const struct rsa_public_key *key, rsa_word num[])
 {
-	int64_t acc = 0;
+	rsa_dword acc;
+	rsa_word borrow = 0;
 	uint i;
 
 	for (i = 0; i < key->len; i++) {
-		acc += (uint64_t)num[i] - key->modulus[i];
-		num[i] = (uint32_t)acc;
-		acc >>= 32;
+		acc = (rsa_dword)num[i] - key->modulus[i] - borrow;
+		num[i] = (rsa_word)acc;
+		borrow = (rsa_word)(acc >> RSA_WORD_BITS) & 1;
 	}
 }
 
@@ -54,7 +53,7 @@ static void subtract_modulus(const struct rsa_public_key *key, uint32_t num[])
  * @return 0 if num < modulus, 1 if num >= modulus
  */
 static int greater_equal_modulus(const struct rsa_public_key *key,
-				 uint32_t num[])
+				 rsa_word num[])
 {
 	int i;
 
@@ -79,27 +78,29 @@ static int greater_equal_modulus(const struct rsa_public_key *key,
  * @b:		Multiplicand, as little endian word array
  */
 static void montgomery_mul_add_step(const struct rsa_public_key *key,
-		uint32_t result[], const uint32_t a, const uint32_t b[])
+		rsa_word result[], const rsa_word a, const rsa_word b[])
 {
-	uint64_t acc_a, acc_b;
-	uint32_t d0;
+	rsa_dword acc_a, acc_b;
+	rsa_word d0;
 	uint i;
 
-	acc_a = (uint64_t)a * b[0] + result[0];
-	d0 = (uint32_t)acc_a * key->n0inv;
-	acc_b = (uint64_t)d0 * key->modulus[0] + (uint32_t)acc_a;
+	acc_a = (rsa_dword)a * b[0] + result[0];
+	d0 = (rsa_word)acc_a * key->n0inv;
+	acc_b = (rsa_dword)d0 * key->modulus[0] + (rsa_word)acc_a;
 	for (i = 1; i < key->len; i++) {
-		acc_a = (acc_a >> 32) + (uint64_t)a * b[i] + result[i];
-		acc_b = (acc_b >> 32) + (uint64_t)d0 * key->modulus[i] +
-				(uint32_t)acc_a;
-		result[i - 1] = (uint32_t)acc_b;
+		acc_a = (acc_a >> RSA_WORD_BITS) + (rsa_dword)a * b[i] +
+				result[i];
+		acc_b = (acc_b >> RSA_WORD_BITS) +
+				(rsa_dword)d0 * key->modulus[i] +
+				(rsa_word)acc_a;
+		result[i - 1] = (rsa_word)acc_b;
 	}
 
-	acc_a = (acc_a >> 32) + (acc_b >> 32);
+	acc_a = (acc_a >> RSA_WORD_BITS) + (acc_b >> RSA_WORD_BITS);
 
-	result[i - 1] = (uint32_t)acc_a;
+	result[i - 1] = (rsa_word)acc_a;
 
-	if (acc_a >> 32)
+	if (acc_a >> RSA_WORD_BITS)
 		subtract_modulus(key, result);
 }
 
@@ -114,7 +115,7 @@ static void montgomery_mul_add_step(const struct rsa_public_key *key,
  * @b:		Multiplicand, as little endian word array
  */
 static void montgomery_mul(const struct rsa_public_key *key,
-		uint32_t result[], uint32_t a[], const uint32_t b[])
+		rsa_word result[], const rsa_word a[], const rsa_word b[])
 {
 	uint i;
 
@@ -124,6 +125,40 @@ static void montgomery_mul(const struct rsa_public_key *key,
 		montgomery_mul_add_step(key, result, a[i], b);
 }
 
+/**
+ * montgomery_sqr() - Square a number in place, in montgomery form
+ *
+ * @key:	RSA key
+ * @acc:	Number to square, as little endian word array
+ * @tmp:	Scratch space of the same size
+ */
+static void montgomery_sqr(const struct rsa_public_key *key, rsa_word acc[],
+			   rsa_word tmp[])
+{
+	montgomery_mul(key, tmp, acc, acc);
+	memcpy(acc, tmp, key->len * sizeof(acc[0]));
+}
+
+/**
+ * calc_n0inv() - Calculate -1 / modulus[0] mod 2^RSA_WORD_BITS
+ *
+ * Each Newton-Raphson step doubles the number of correct bits. Any odd
+ * number is its own inverse modulo 8, so five steps are enough for 64 bits.
+ *
+ * @n0:		Lowest word of the modulus, which must be odd
+ * @return -1 / n0, modulo the word size
+ */
+static rsa_word calc_n0inv(rsa_word n0)
+{
+	rsa_word inv = n0;
+	int i;
+
+	for (i = 0; i < 5; i++)
+		inv *= 2 - n0 * inv;
+
+	return -inv;
+}
+
 /**
  * num_pub_exponent_bits() - Number of bits in the public exponent
  *
@@ -163,36 +198,82 @@ static int num_public_exponent_bits(const struct rsa_public_key *key,
 static int is_public_exponent_bit_set(const struct rsa_public_key *key,
 		int pos)
 {
-	return key->exponent & (1ULL << pos);
+	return !!(key->exponent & (1ULL << pos));
+}
+
+/**
+ * pow_mod_window() - Raise to any public exponent, a few bits at a time
+ *
+ * This uses sliding windows of up to RSA_WINDOW_BITS bits, so that each
+ * window needs only one multiply, by a precomputed odd power.
+ *
+ * @key:	RSA key
+ * @acc:	Place to put result, in montgomery form
+ * @a_scaled:	Value to raise, in montgomery form
+ * @tmp:	Scratch space, the same size as the modulus
+ * @k:		Number of bits in the public exponent
+ */
+static void pow_mod_window(const struct rsa_public_key *key, rsa_word acc[],
+			   const rsa_word a_scaled[], rsa_word tmp[], int k)
+{
+	/* Odd powers a^1, a^3, a^5 ... in montgomery form */
+	rsa_word table[1 << (RSA_WINDOW_BITS - 1)][key->len];
+	int first = 1;
+	int i, j, len;
+	uint win;
+
+	memcpy(table[0], a_scaled, key->len * sizeof(acc[0]));
+	montgomery_mul(key, tmp, a_scaled, a_scaled);
+	for (i = 1; i < ARRAY_SIZE(table); i++)
+		montgomery_mul(key, table[i], table[i - 1], tmp);
+
+	for (j = k - 1; j >= 0; j -= len) {
+		if (!is_public_exponent_bit_set(key, j)) {
+			montgomery_sqr(key, acc, tmp);
+			len = 1;
+			continue;
+		}
+
+		/* Take the longest window that starts and ends with a 1 */
+		len = j + 1 < RSA_WINDOW_BITS ? j + 1 : RSA_WINDOW_BITS;
+		while (!is_public_exponent_bit_set(key, j - len + 1))
+			len--;
+		win = (key->exponent >> (j - len + 1)) & ((1 << len) - 1);
+
+		if (first) {
+			memcpy(acc, table[win >> 1], key->len * sizeof(acc[0]));
+			first = 0;
+			continue;
+		}
+		for (i = 0; i < len; i++)
+			montgomery_sqr(key, acc, tmp);
+		montgomery_mul(key, tmp, acc, table[win >> 1]);
+		memcpy(acc, tmp, key->len * sizeof(acc[0]));
+	}
 }
 
 /**
  * pow_mod() - in-place public exponentiation
  *
  * @key:	RSA key
- * @inout:	Big-endian word array containing value and result
+ * @inout:	Little endian word array containing value and result
  */
-static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
+static int pow_mod(const struct rsa_public_key *key, rsa_word *inout)
 {
-	uint32_t *result, *ptr;
-	uint i;
+	rsa_word *val = inout, *result;
 	int j, k;
 
-	/* Sanity check for stack size - key->len is in 32-bit words */
-	if (key->len > RSA_MAX_KEY_BITS / 32) {
+	/* Sanity check for stack size */
+	if (key->len > RSA_MAX_KEY_BITS / RSA_WORD_BITS) {
 		debug("RSA key words %u exceeds maximum %d\n", key->len,
-		      RSA_MAX_KEY_BITS / 32);
+		      (int)(RSA_MAX_KEY_BITS / RSA_WORD_BITS));
 		return -EINVAL;
 	}
 
-	uint32_t val[key->len], acc[key->len], tmp[key->len];
-	uint32_t a_scaled[key->len];
+	rsa_word acc[key->len], tmp[key->len];
+	rsa_word a_scaled[key->len];
 	result = tmp;  /* Re-use location. */
 
-	/* Convert from big endian byte array to little endian word array. */
-	for (i = 0, ptr = inout + key->len - 1; i < key->len; i++, ptr--)
-		val[i] = get_unaligned_be32(ptr);
-
 	if (0 != num_public_exponent_bits(key, &k))
 		return -EINVAL;
 
@@ -207,58 +288,109 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 		return -EINVAL;
 	}
 
-	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
-	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
-	/* retain scaled version for intermediate use */
-	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+	montgomery_mul(key, a_scaled, val, key->rr); /* a * RR / R mod n */
 
-	for (j = k - 2; j > 0; --j) {
-		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+	if (key->exponent == RSA_DEFAULT_PUBEXP) {
+		/* 65537 is 2^16 + 1, so square 16 times */
+		memcpy(acc, a_scaled, key->len * sizeof(acc[0]));
+		for (j = 0; j < 16; j++)
+			montgomery_sqr(key, acc, tmp);
 
-		if (is_public_exponent_bit_set(key, j)) {
-			/* acc = tmp * val / R mod n */
-			montgomery_mul(key, acc, tmp, a_scaled);
-		} else {
-			/* e[j] == 0, copy tmp back to acc for next operation */
-			memcpy(acc, tmp, key->len * sizeof(acc[0]));
-		}
-	}
+		/* multiply by a, which also takes out the factor of R */
+		montgomery_mul(key, result, acc, val);
+	} else {
+		pow_mod_window(key, acc, a_scaled, tmp, k);
 
-	/* the bit at e[0] is always 1 */
-	montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
-	montgomery_mul(key, acc, tmp, val); /* acc = tmp * a / R mod M */
-	memcpy(result, acc, key->len * sizeof(result[0]));
+		/* Multiply by 1 to take out the factor of R */
+		memset(val, '\0', key->len * sizeof(val[0]));
+		val[0] = 1;
+		montgomery_mul(key, result, acc, val);
+	}
 
 	/* Make sure result < mod; result is at most 1x mod too large. */
 	if (greater_equal_modulus(key, result))
 		subtract_modulus(key, result);
 
-	/* Convert to bigendian byte array */
-	for (i = key->len - 1, ptr = inout; (int)i >= 0; i--, ptr++)
-		put_unaligned_be32(result[i], ptr);
+	memcpy(inout, result, key->len * sizeof(result[0]));
+
 	return 0;
 }
 
-static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
+/**
+ * rsa_convert_big_endian() - Convert a big endian byte array to words
+ *
+ * @dst:	Place to put little endian word array of @len words
+ * @src:	Big endian byte array
+ * @src_len:	Number of bytes in @src, at most @len words
+ * @len:	Number of words in @dst
+ */
+static void rsa_convert_big_endian(rsa_word *dst, const uint8_t *src,
+				   uint src_len, uint len)
 {
-	int i;
+	uint i;
+
+	memset(dst, '\0', len * sizeof(rsa_word));
+	for (i = 0; i < src_len; i++)
+		dst[i / sizeof(rsa_word)] |= (rsa_word)src[src_len - 1 - i] <<
+				(i % sizeof(rsa_word) * 8);
+}
+
+/**
+ * rsa_convert_to_big_endian() - Convert words to a big endian byte array
+ *
+ * @dst:	Place to put big endian byte array
+ * @src:	Little endian word array
+ * @dst_len:	Number of bytes to write to @dst
+ */
+static void rsa_convert_to_big_endian(uint8_t *dst, const rsa_word *src,
+				      uint dst_len)
+{
+	uint i;
 
-	for (i = 0; i < len; i++)
-		dst[i] = fdt32_to_cpu(src[len - 1 - i]);
+	for (i = 0; i < dst_len; i++)
+		dst[dst_len - 1 - i] = src[i / sizeof(rsa_word)] >>
+				(i % sizeof(rsa_word) * 8);
+}
+
+/**
+ * rsa_double_rr() - Double R^2 for a key with a partial top word
+ *
+ * The R^2 value from the device tree is for R = 2^(# key bits). Where that
+ * is not a whole number of words, we need R = 2^(# words * RSA_WORD_BITS),
+ * so multiply by 2 for each missing bit, twice.
+ *
+ * @key:	RSA key
+ * @bits:	Number of bits to multiply by
+ */
+static void rsa_double_rr(const struct rsa_public_key *key, int bits)
+{
+	rsa_word carry, top;
+	uint i;
+
+	while (bits--) {
+		carry = 0;
+		for (i = 0; i < key->len; i++) {
+			top = key->rr[i] >> (RSA_WORD_BITS - 1);
+			key->rr[i] = key->rr[i] << 1 | carry;
+			carry = top;
+		}
+		if (greater_equal_modulus(key, key->rr))
+			subtract_modulus(key, key->rr);
+	}
 }
 
 int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		struct key_prop *prop, uint8_t *out)
 {
 	struct rsa_public_key key;
+	int num_bits;
 	int ret;
 
 	if (!prop) {
 		debug("%s: Skipping invalid prop", __func__);
 		return -EBADF;
 	}
-	key.n0inv = prop->n0inv;
-	key.len = prop->num_bits;
+	num_bits = prop->num_bits;
 
 	if (!prop->public_exponent)
 		key.exponent = RSA_DEFAULT_PUBEXP;
@@ -266,38 +398,46 @@ int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		key.exponent =
 			fdt64_to_cpu(*((uint64_t *)(prop->public_exponent)));
 
-	if (!key.len || !prop->modulus || !prop->rr) {
+	if (!num_bits || !prop->modulus || !prop->rr) {
 		debug("%s: Missing RSA key info", __func__);
 		return -EFAULT;
 	}
 
 	/* Sanity check for stack size */
-	if (key.len > RSA_MAX_KEY_BITS || key.len < RSA_MIN_KEY_BITS) {
+	if (num_bits > RSA_MAX_KEY_BITS || num_bits < RSA_MIN_KEY_BITS) {
 		debug("RSA key bits %u outside allowed range %d..%d\n",
-		      key.len, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
+		      num_bits, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
 		return -EFAULT;
 	}
-	key.len /= sizeof(uint32_t) * 8;
-	uint32_t key1[key.len], key2[key.len];
+	if (sig_len != num_bits / 8) {
+		debug("%s: Signature length %u does not match key\n", __func__,
+		      sig_len);
+		return -EINVAL;
+	}
+	key.len = (num_bits + RSA_WORD_BITS - 1) / RSA_WORD_BITS;
+	rsa_word key1[key.len], key2[key.len];
 
 	key.modulus = key1;
 	key.rr = key2;
-	rsa_convert_big_endian(key.modulus, (uint32_t *)prop->modulus, key.len);
-	rsa_convert_big_endian(key.rr, (uint32_t *)prop->rr, key.len);
-	if (!key.modulus || !key.rr) {
-		debug("%s: Out of memory", __func__);
-		return -ENOMEM;
+	rsa_convert_big_endian(key.modulus, prop->modulus, num_bits / 8,
+			       key.len);
+	rsa_convert_big_endian(key.rr, prop->rr, num_bits / 8, key.len);
+	if (!(key.modulus[0] & 1)) {
+		debug("%s: RSA modulus must be odd\n", __func__);
+		return -EINVAL;
 	}
+	key.n0inv = calc_n0inv(key.modulus[0]);
+	rsa_double_rr(&key, 2 * (key.len * RSA_WORD_BITS - num_bits));
 
-	uint32_t buf[sig_len / sizeof(uint32_t)];
+	rsa_word buf[key.len];
 
-	memcpy(buf, sig, sig_len);
+	rsa_convert_big_endian(buf, sig, sig_len, key.len);
 
 	ret = pow_mod(&key, buf);
 	if (ret)
 		return ret;
 
-	memcpy(out, buf, sig_len);
+	rsa_convert_to_big_endian(out, buf, sig_len);
 
 	return 0;
 }
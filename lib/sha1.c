@@ -31,10 +31,10 @@
  */
 #ifndef GET_UINT32_BE
 #define GET_UINT32_BE(n,b,i) {				\
-	(n) = ( (unsigned long) (b)[(i)    ] << 24 )	\
-	    | ( (unsigned long) (b)[(i) + 1] << 16 )	\
-	    | ( (unsigned long) (b)[(i) + 2] <<  8 )	\
-	    | ( (unsigned long) (b)[(i) + 3]       );	\
+	(n) = ( (uint32_t) (b)[(i)    ] << 24 )		\
+	    | ( (uint32_t) (b)[(i) + 1] << 16 )		\
+	    | ( (uint32_t) (b)[(i) + 2] <<  8 )		\
+	    | ( (uint32_t) (b)[(i) + 3]       );	\
 }
 #endif
 #ifndef PUT_UINT32_BE
@@ -61,9 +61,22 @@ void sha1_starts (sha1_context * ctx)
 	ctx->state[4] = 0xC3D2E1F0;
 }
 
-static void sha1_process(sha1_context *ctx, const unsigned char data[64])
+#ifndef USE_HOSTCC
+/*
+ * Architectures with SHA-1 instructions can override this to process whole
+ * blocks. It returns the number of blocks processed, which may be 0 if the
+ * CPU turns out not to have them.
+ */
+__weak int sha1_arch_blocks(uint32_t state[5], const unsigned char *data,
+			    unsigned int blocks)
+{
+	return 0;
+}
+#endif
+
+static inline void sha1_block(uint32_t state[5], const unsigned char data[64])
 {
-	unsigned long temp, W[16], A, B, C, D, E;
+	uint32_t temp, W[16], A, B, C, D, E;
 
 	GET_UINT32_BE (W[0], data, 0);
 	GET_UINT32_BE (W[1], data, 4);
@@ -82,7 +95,7 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	GET_UINT32_BE (W[14], data, 56);
 	GET_UINT32_BE (W[15], data, 60);
 
-#define S(x,n)	((x << n) | ((x & 0xFFFFFFFF) >> (32 - n)))
+#define S(x,n)	((x << n) | (x >> (32 - n)))
 
 #define R(t) (						\
 	temp = W[(t -  3) & 0x0F] ^ W[(t - 8) & 0x0F] ^	\
@@ -94,11 +107,11 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	e += S(a,5) + F(b,c,d) + K + x; b = S(b,30);	\
 }
 
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
+	A = state[0];
+	B = state[1];
+	C = state[2];
+	D = state[3];
+	E = state[4];
 
 #define F(x,y,z) (z ^ (x & (y ^ z)))
 #define K 0x5A827999
@@ -208,11 +221,25 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 #undef K
 #undef F
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
+	state[0] += A;
+	state[1] += B;
+	state[2] += C;
+	state[3] += D;
+	state[4] += E;
+}
+
+/* Process whole 64-byte blocks */
+static void sha1_process(uint32_t state[5], const unsigned char *data,
+			 unsigned int blocks)
+{
+#ifndef USE_HOSTCC
+	unsigned int done = sha1_arch_blocks(state, data, blocks);
+
+	data += done * 64;
+	blocks -= done;
+#endif
+	for (; blocks; blocks--, data += 64)
+		sha1_block(state, data);
 }
 
 /*
@@ -222,7 +249,7 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 		 unsigned int ilen)
 {
 	int fill;
-	unsigned long left;
+	uint32_t left;
 
 	if (ilen <= 0)
 		return;
@@ -233,21 +260,21 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 	ctx->total[0] += ilen;
 	ctx->total[0] &= 0xFFFFFFFF;
 
-	if (ctx->total[0] < (unsigned long) ilen)
+	if (ctx->total[0] < ilen)
 		ctx->total[1]++;
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_process(ctx->state, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_process(ctx->state, input, ilen / 64);
+		input += ilen & ~0x3f;
+		ilen &= 0x3f;
 	}
 
 	if (ilen > 0) {
@@ -267,8 +294,8 @@ static const unsigned char sha1_padding[64] = {
  */
 void sha1_finish (sha1_context * ctx, unsigned char output[20])
 {
-	unsigned long last, padn;
-	unsigned long high, low;
+	uint32_t last, padn;
+	uint32_t high, low;
 	unsigned char msglen[8];
 
 	high = (ctx->total[0] >> 29)
@@ -20,10 +20,10 @@
  */
 #ifndef GET_UINT32_BE
 #define GET_UINT32_BE(n,b,i) {				\
-	(n) = ( (unsigned long) (b)[(i)    ] << 24 )	\
-	    | ( (unsigned long) (b)[(i) + 1] << 16 )	\
-	    | ( (unsigned long) (b)[(i) + 2] <<  8 )	\
-	    | ( (unsigned long) (b)[(i) + 3]       );	\
+	(n) = ( (uint32_t) (b)[(i)    ] << 24 )		\
+	    | ( (uint32_t) (b)[(i) + 1] << 16 )		\
+	    | ( (uint32_t) (b)[(i) + 2] <<  8 )		\
+	    | ( (uint32_t) (b)[(i) + 3]       );	\
 }
 #endif
 #ifndef PUT_UINT32_BE
@@ -50,10 +50,23 @@ void sha256_starts(sha256_context * ctx)
 	ctx->state[7] = 0x5BE0CD19;
 }
 
-static void sha256_process(sha256_context *ctx, const uint8_t data[64])
+#ifndef USE_HOSTCC
+/*
+ * Architectures with SHA-256 instructions can override this to process
+ * whole blocks. It returns the number of blocks processed, which may be 0
+ * if the CPU turns out not to have them.
+ */
+__weak int sha256_arch_blocks(uint32_t state[8], const uint8_t *data,
+			      unsigned int blocks)
+{
+	return 0;
+}
+#endif
+
+static inline void sha256_block(uint32_t state[8], const uint8_t data[64])
 {
 	uint32_t temp1, temp2;
-	uint32_t W[64];
+	uint32_t W[16];
 	uint32_t A, B, C, D, E, F, G, H;
 
 	GET_UINT32_BE(W[0], data, 0);
@@ -73,7 +86,7 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	GET_UINT32_BE(W[14], data, 56);
 	GET_UINT32_BE(W[15], data, 60);
 
-#define SHR(x,n) ((x & 0xFFFFFFFF) >> n)
+#define SHR(x,n) (x >> n)
 #define ROTR(x,n) (SHR(x,n) | (x << (32 - n)))
 
 #define S0(x) (ROTR(x, 7) ^ ROTR(x,18) ^ SHR(x, 3))
@@ -85,10 +98,11 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 #define F0(x,y,z) ((x & y) | (z & (x | y)))
 #define F1(x,y,z) (z ^ (x & (y ^ z)))
 
-#define R(t)					\
-(						\
-	W[t] = S1(W[t - 2]) + W[t - 7] +	\
-		S0(W[t - 15]) + W[t - 16]	\
+/* Only the last 16 words of the message schedule are kept */
+#define R(t)						\
+(							\
+	W[t & 15] += S1(W[(t - 2) & 15]) + W[(t - 7) & 15] +	\
+		S0(W[(t - 15) & 15])			\
 )
 
 #define P(a,b,c,d,e,f,g,h,x,K) {		\
@@ -97,14 +111,14 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	d += temp1; h = temp1 + temp2;		\
 }
 
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
-	F = ctx->state[5];
-	G = ctx->state[6];
-	H = ctx->state[7];
+	A = state[0];
+	B = state[1];
+	C = state[2];
+	D = state[3];
+	E = state[4];
+	F = state[5];
+	G = state[6];
+	H = state[7];
 
 	P(A, B, C, D, E, F, G, H, W[0], 0x428A2F98);
 	P(H, A, B, C, D, E, F, G, W[1], 0x71374491);
@@ -171,14 +185,28 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	P(C, D, E, F, G, H, A, B, R(62), 0xBEF9A3F7);
 	P(B, C, D, E, F, G, H, A, R(63), 0xC67178F2);
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
-	ctx->state[5] += F;
-	ctx->state[6] += G;
-	ctx->state[7] += H;
+	state[0] += A;
+	state[1] += B;
+	state[2] += C;
+	state[3] += D;
+	state[4] += E;
+	state[5] += F;
+	state[6] += G;
+	state[7] += H;
+}
+
+/* Process whole 64-byte blocks */
+static void sha256_process(uint32_t state[8], const uint8_t *data,
+			   unsigned int blocks)
+{
+#ifndef USE_HOSTCC
+	unsigned int done = sha256_arch_blocks(state, data, blocks);
+
+	data += done * 64;
+	blocks -= done;
+#endif
+	for (; blocks; blocks--, data += 64)
+		sha256_block(state, data);
 }
 
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
@@ -199,16 +227,16 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		sha256_process(ctx->state, ctx->buffer, 1);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
+	if (length >= 64) {
+		sha256_process(ctx->state, input, length / 64);
+		input += length & ~0x3f;
+		length &= 0x3f;
 	}
 
 	if (length)
@@ -0,0 +1,330 @@
+/*
+ * FIPS-180-2 compliant SHA-384/512 implementation
+ *
+ * This follows the structure of lib/sha256.c, with 64-bit words, 128-byte
+ * blocks and 80 rounds.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#include <linux/string.h>
+#else
+#include <string.h>
+#endif /* USE_HOSTCC */
+#include <watchdog.h>
+#include <u-boot/sha512.h>
+
+/*
+ * 64-bit integer manipulation macros (big endian)
+ */
+#define GET_UINT64_BE(n,b,i) {				\
+	(n) = ( (uint64_t) (b)[(i)    ] << 56 )		\
+	    | ( (uint64_t) (b)[(i) + 1] << 48 )		\
+	    | ( (uint64_t) (b)[(i) + 2] << 40 )		\
+	    | ( (uint64_t) (b)[(i) + 3] << 32 )		\
+	    | ( (uint64_t) (b)[(i) + 4] << 24 )		\
+	    | ( (uint64_t) (b)[(i) + 5] << 16 )		\
+	    | ( (uint64_t) (b)[(i) + 6] <<  8 )		\
+	    | ( (uint64_t) (b)[(i) + 7]       );	\
+}
+#define PUT_UINT64_BE(n,b,i) {				\
+	(b)[(i)    ] = (unsigned char) ( (n) >> 56 );	\
+	(b)[(i) + 1] = (unsigned char) ( (n) >> 48 );	\
+	(b)[(i) + 2] = (unsigned char) ( (n) >> 40 );	\
+	(b)[(i) + 3] = (unsigned char) ( (n) >> 32 );	\
+	(b)[(i) + 4] = (unsigned char) ( (n) >> 24 );	\
+	(b)[(i) + 5] = (unsigned char) ( (n) >> 16 );	\
+	(b)[(i) + 6] = (unsigned char) ( (n) >>  8 );	\
+	(b)[(i) + 7] = (unsigned char) ( (n)       );	\
+}
+
+static const uint64_t sha512_k[80] = {
+	0x428A2F98D728AE22ULL, 0x7137449123EF65CDULL,
+	0xB5C0FBCFEC4D3B2FULL, 0xE9B5DBA58189DBBCULL,
+	0x3956C25BF348B538ULL, 0x59F111F1B605D019ULL,
+	0x923F82A4AF194F9BULL, 0xAB1C5ED5DA6D8118ULL,
+	0xD807AA98A3030242ULL, 0x12835B0145706FBEULL,
+	0x243185BE4EE4B28CULL, 0x550C7DC3D5FFB4E2ULL,
+	0x72BE5D74F27B896FULL, 0x80DEB1FE3B1696B1ULL,
+	0x9BDC06A725C71235ULL, 0xC19BF174CF692694ULL,
+	0xE49B69C19EF14AD2ULL, 0xEFBE4786384F25E3ULL,
+	0x0FC19DC68B8CD5B5ULL, 0x240CA1CC77AC9C65ULL,
+	0x2DE92C6F592B0275ULL, 0x4A7484AA6EA6E483ULL,
+	0x5CB0A9DCBD41FBD4ULL, 0x76F988DA831153B5ULL,
+	0x983E5152EE66DFABULL, 0xA831C66D2DB43210ULL,
+	0xB00327C898FB213FULL, 0xBF597FC7BEEF0EE4ULL,
+	0xC6E00BF33DA88FC2ULL, 0xD5A79147930AA725ULL,
+	0x06CA6351E003826FULL, 0x142929670A0E6E70ULL,
+	0x27B70A8546D22FFCULL, 0x2E1B21385C26C926ULL,
+	0x4D2C6DFC5AC42AEDULL, 0x53380D139D95B3DFULL,
+	0x650A73548BAF63DEULL, 0x766A0ABB3C77B2A8ULL,
+	0x81C2C92E47EDAEE6ULL, 0x92722C851482353BULL,
+	0xA2BFE8A14CF10364ULL, 0xA81A664BBC423001ULL,
+	0xC24B8B70D0F89791ULL, 0xC76C51A30654BE30ULL,
+	0xD192E819D6EF5218ULL, 0xD69906245565A910ULL,
+	0xF40E35855771202AULL, 0x106AA07032BBD1B8ULL,
+	0x19A4C116B8D2D0C8ULL, 0x1E376C085141AB53ULL,
+	0x2748774CDF8EEB99ULL, 0x34B0BCB5E19B48A8ULL,
+	0x391C0CB3C5C95A63ULL, 0x4ED8AA4AE3418ACBULL,
+	0x5B9CCA4F7763E373ULL, 0x682E6FF3D6B2B8A3ULL,
+	0x748F82EE5DEFB2FCULL, 0x78A5636F43172F60ULL,
+	0x84C87814A1F0AB72ULL, 0x8CC702081A6439ECULL,
+	0x90BEFFFA23631E28ULL, 0xA4506CEBDE82BDE9ULL,
+	0xBEF9A3F7B2C67915ULL, 0xC67178F2E372532BULL,
+	0xCA273ECEEA26619CULL, 0xD186B8C721C0C207ULL,
+	0xEADA7DD6CDE0EB1EULL, 0xF57D4F7FEE6ED178ULL,
+	0x06F067AA72176FBAULL, 0x0A637DC5A2C898A6ULL,
+	0x113F9804BEF90DAEULL, 0x1B710B35131C471BULL,
+	0x28DB77F523047D84ULL, 0x32CAAB7B40C72493ULL,
+	0x3C9EBE0A15C9BEBCULL, 0x431D67C49C100D4CULL,
+	0x4CC5D4BECB3E42B6ULL, 0x597F299CFC657E2AULL,
+	0x5FCB6FAB3AD6FAECULL, 0x6C44198C4A475817ULL,
+};
+
+static const uint64_t sha384_init[8] = {
+	0xCBBB9D5DC1059ED8ULL, 0x629A292A367CD507ULL,
+	0x9159015A3070DD17ULL, 0x152FECD8F70E5939ULL,
+	0x67332667FFC00B31ULL, 0x8EB44A8768581511ULL,
+	0xDB0C2E0D64F98FA7ULL, 0x47B5481DBEFA4FA4ULL,
+};
+
+static const uint64_t sha512_init[8] = {
+	0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL,
+	0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+	0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL,
+	0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL,
+};
+
+#ifndef USE_HOSTCC
+/*
+ * Architectures with SHA-512 instructions can override this to process
+ * whole blocks. It returns the number of blocks processed, which may be 0
+ * if the CPU turns out not to have them.
+ */
+__weak int sha512_arch_blocks(uint64_t state[8], const uint8_t *data,
+			      unsigned int blocks)
+{
+	return 0;
+}
+#endif
+
+static inline void sha512_block(uint64_t state[8], const uint8_t data[128])
+{
+	uint64_t temp1, temp2;
+	uint64_t W[16];
+	uint64_t A, B, C, D, E, F, G, H;
+	int i, t;
+
+	for (i = 0; i < 16; i++)
+		GET_UINT64_BE(W[i], data, i * 8);
+
+#define ROTR(x,n) ((x >> n) | (x << (64 - n)))
+
+#define S0(x) (ROTR(x, 1) ^ ROTR(x, 8) ^ (x >> 7))
+#define S1(x) (ROTR(x,19) ^ ROTR(x,61) ^ (x >> 6))
+
+#define S2(x) (ROTR(x,28) ^ ROTR(x,34) ^ ROTR(x,39))
+#define S3(x) (ROTR(x,14) ^ ROTR(x,18) ^ ROTR(x,41))
+
+#define F0(x,y,z) ((x & y) | (z & (x | y)))
+#define F1(x,y,z) (z ^ (x & (y ^ z)))
+
+/* Only the last 16 words of the message schedule are kept */
+#define W(t) ((t) < 16 ? W[t] : (					\
+	W[(t) & 15] += S1(W[((t) - 2) & 15]) + W[((t) - 7) & 15] +	\
+		S0(W[((t) - 15) & 15])))
+
+#define P(a,b,c,d,e,f,g,h,t) {					\
+	temp1 = h + S3(e) + F1(e,f,g) + sha512_k[t] + W(t);	\
+	temp2 = S2(a) + F0(a,b,c);				\
+	d += temp1; h = temp1 + temp2;				\
+}
+
+	A = state[0];
+	B = state[1];
+	C = state[2];
+	D = state[3];
+	E = state[4];
+	F = state[5];
+	G = state[6];
+	H = state[7];
+
+	/* Eight rounds at a time, so that the variables need not rotate */
+	for (t = 0; t < 80; t += 8) {
+		P(A, B, C, D, E, F, G, H, t);
+		P(H, A, B, C, D, E, F, G, t + 1);
+		P(G, H, A, B, C, D, E, F, t + 2);
+		P(F, G, H, A, B, C, D, E, t + 3);
+		P(E, F, G, H, A, B, C, D, t + 4);
+		P(D, E, F, G, H, A, B, C, t + 5);
+		P(C, D, E, F, G, H, A, B, t + 6);
+		P(B, C, D, E, F, G, H, A, t + 7);
+	}
+
+	state[0] += A;
+	state[1] += B;
+	state[2] += C;
+	state[3] += D;
+	state[4] += E;
+	state[5] += F;
+	state[6] += G;
+	state[7] += H;
+}
+
+/* Process whole 128-byte blocks */
+static void sha512_process(uint64_t state[8], const uint8_t *data,
+			   unsigned int blocks)
+{
+#ifndef USE_HOSTCC
+	unsigned int done = sha512_arch_blocks(state, data, blocks);
+
+	data += done * 128;
+	blocks -= done;
+#endif
+	for (; blocks; blocks--, data += 128)
+		sha512_block(state, data);
+}
+
+static void sha512_base_starts(sha512_context *ctx, const uint64_t init[8])
+{
+	ctx->total[0] = 0;
+	ctx->total[1] = 0;
+	memcpy(ctx->state, init, sizeof(ctx->state));
+}
+
+void sha512_starts(sha512_context *ctx)
+{
+	sha512_base_starts(ctx, sha512_init);
+}
+
+void sha384_starts(sha512_context *ctx)
+{
+	sha512_base_starts(ctx, sha384_init);
+}
+
+void sha512_update(sha512_context *ctx, const uint8_t *input, uint32_t length)
+{
+	uint32_t left, fill;
+
+	if (!length)
+		return;
+
+	left = ctx->total[0] & 0x7F;
+	fill = 128 - left;
+
+	ctx->total[0] += length;
+	if (ctx->total[0] < length)
+		ctx->total[1]++;
+
+	if (left && length >= fill) {
+		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
+		sha512_process(ctx->state, ctx->buffer, 1);
+		length -= fill;
+		input += fill;
+		left = 0;
+	}
+
+	if (length >= 128) {
+		sha512_process(ctx->state, input, length / 128);
+		input += length & ~0x7f;
+		length &= 0x7f;
+	}
+
+	if (length)
+		memcpy((void *) (ctx->buffer + left), (void *) input, length);
+}
+
+void sha384_update(sha512_context *ctx, const uint8_t *input, uint32_t length)
+{
+	sha512_update(ctx, input, length);
+}
+
+static const uint8_t sha512_padding[128] = { 0x80 };
+
+static void sha512_base_finish(sha512_context *ctx, uint8_t *digest, int len)
+{
+	uint32_t last, padn;
+	uint64_t high, low;
+	uint8_t msglen[16];
+	int i;
+
+	high = (ctx->total[0] >> 61) | (ctx->total[1] << 3);
+	low = ctx->total[0] << 3;
+
+	PUT_UINT64_BE(high, msglen, 0);
+	PUT_UINT64_BE(low, msglen, 8);
+
+	last = ctx->total[0] & 0x7F;
+	padn = (last < 112) ? (112 - last) : (240 - last);
+
+	sha512_update(ctx, sha512_padding, padn);
+	sha512_update(ctx, msglen, 16);
+
+	for (i = 0; i < len / 8; i++)
+		PUT_UINT64_BE(ctx->state[i], digest, i * 8);
+}
+
+void sha512_finish(sha512_context *ctx, uint8_t digest[SHA512_SUM_LEN])
+{
+	sha512_base_finish(ctx, digest, SHA512_SUM_LEN);
+}
+
+void sha384_finish(sha512_context *ctx, uint8_t digest[SHA384_SUM_LEN])
+{
+	sha512_base_finish(ctx, digest, SHA384_SUM_LEN);
+}
+
+static void sha512_base_csum_wd(const unsigned char *input, unsigned int ilen,
+				unsigned char *output, unsigned int chunk_sz,
+				const uint64_t init[8], int len)
+{
+	sha512_context ctx;
+#if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
+	const unsigned char *end;
+	unsigned char *curr;
+	int chunk;
+#endif
+
+	sha512_base_starts(&ctx, init);
+
+#if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
+	curr = (unsigned char *)input;
+	end = input + ilen;
+	while (curr < end) {
+		chunk = end - curr;
+		if (chunk > chunk_sz)
+			chunk = chunk_sz;
+		sha512_update(&ctx, curr, chunk);
+		curr += chunk;
+		WATCHDOG_RESET();
+	}
+#else
+	sha512_update(&ctx, input, ilen);
+#endif
+
+	sha512_base_finish(&ctx, output, len);
+}
+
+/*
+ * Output = SHA-512( input buffer ). Trigger the watchdog every 'chunk_sz'
+ * bytes of input processed.
+ */
+void sha512_csum_wd(const unsigned char *input, unsigned int ilen,
+		unsigned char *output, unsigned int chunk_sz)
+{
+	sha512_base_csum_wd(input, ilen, output, chunk_sz, sha512_init,
+			    SHA512_SUM_LEN);
+}
+
+/*
+ * Output = SHA-384( input buffer ). Trigger the watchdog every 'chunk_sz'
+ * bytes of input processed.
+ */
+void sha384_csum_wd(const unsigned char *input, unsigned int ilen,
+		unsigned char *output, unsigned int chunk_sz)
+{
+	sha512_base_csum_wd(input, ilen, output, chunk_sz, sha384_init,
+			    SHA384_SUM_LEN);
+}
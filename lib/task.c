@@ -0,0 +1,111 @@
+/*
+ * Cooperative tasks, each running on its own stack
+ *
+ * Each task has a small stack allocated with malloc(). Tasks are kept in a
+ * list and run in turn by task_yield() when it is called from U-Boot's main
+ * flow. A task yielding always switches back to the main flow, which then
+ * runs the next task, so a switch never has to find its way between tasks.
+ * Since the common wait helpers yield, tasks make progress whenever U-Boot
+ * would otherwise just be waiting for hardware.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <task.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static LIST_HEAD(task_list);
+static struct task *task_current;
+static void *task_main_ctx;
+
+__weak void *arch_task_create(void (*func)(void *arg), void *arg,
+			      void *stack, ulong size)
+{
+	return NULL;
+}
+
+__weak void arch_task_switch(void *from, void *to)
+{
+}
+
+__weak void arch_task_free(void *ctx)
+{
+}
+
+static void task_entry(void *arg)
+{
+	struct task *task = arg;
+
+	task->func(task->arg);
+	task->done = 1;
+
+	/* The main flow frees the task, so this does not return */
+	arch_task_switch(task->ctx, task_main_ctx);
+}
+
+static void task_free(struct task *task)
+{
+	list_del(&task->node);
+	arch_task_free(task->ctx);
+	free(task->stack);
+	task->ctx = NULL;
+	task->stack = NULL;
+}
+
+void task_start(struct task *task)
+{
+	task->done = 0;
+	task->stack = NULL;
+	task->ctx = NULL;
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT) {
+		if (!task_main_ctx)
+			task_main_ctx = arch_task_create(NULL, NULL, NULL, 0);
+		if (task_main_ctx)
+			task->stack = malloc(CONFIG_TASK_STACK_SIZE);
+		if (task->stack)
+			task->ctx = arch_task_create(task_entry, task,
+						     task->stack,
+						     CONFIG_TASK_STACK_SIZE);
+		if (task->ctx) {
+			list_add_tail(&task->node, &task_list);
+			return;
+		}
+		free(task->stack);
+		task->stack = NULL;
+	}
+
+	/* Run it here if it cannot run as a task */
+	task->func(task->arg);
+	task->done = 1;
+}
+
+void task_yield(void)
+{
+	struct task *task, *next;
+
+	/* BSS is not usable before relocation, and no tasks can run then */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	if (task_current) {
+		arch_task_switch(task_current->ctx, task_main_ctx);
+		return;
+	}
+
+	list_for_each_entry_safe(task, next, &task_list, node) {
+		task_current = task;
+		arch_task_switch(task_main_ctx, task->ctx);
+		task_current = NULL;
+		if (task->done)
+			task_free(task);
+	}
+}
+
+void task_wait(struct task *task)
+{
+	while (!task->done)
+		task_yield();
+}
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <dm.h>
 #include <errno.h>
+#include <task.h>
 #include <timer.h>
 #include <watchdog.h>
 #include <div64.h>
@@ -149,6 +150,7 @@ void udelay(unsigned long usec)
 
 	do {
 		WATCHDOG_RESET();
+		task_yield();
 		kv = usec > CONFIG_WD_PERIOD ? CONFIG_WD_PERIOD : usec;
 		__udelay (kv);
 		usec -= kv;
@@ -12,24 +12,67 @@
 
 #ifndef ASMINF
 
-/* Allow machine dependent optimization for post-increment or pre-increment.
-   Based on testing to date,
-   Pre-increment preferred for:
-   - PowerPC G3 (Adler)
-   - MIPS R5000 (Randers-Pehrson)
-   Post-increment preferred for:
-   - none
-   No measurable difference:
-   - Pentium III (Anderson)
-   - M68060 (Nikl)
+/*
+   U-Boot: the bit accumulator is refilled a whole word at a time rather than
+   a byte at a time, and matches are copied a word at a time where they do
+   not overlap. hold is an unsigned long, so this uses 64-bit loads on 64-bit
+   machines and 32-bit loads otherwise.
+
+   REFILL() loads a word from the input above the bits already in hold, then
+   advances in by the number of whole bytes that fitted. The bits of a
+   partly-loaded byte are left above the count in bits; they are loaded
+   again next time, and since they have the same value this does no harm.
+   Afterwards there are at least HOLD_BITS - 8 bits available.
  */
-#ifdef POSTINC
-#  define OFF 0
-#  define PUP(a) *(a)++
-#else
-#  define OFF 1
-#  define PUP(a) *++(a)
-#endif
+#define HOLD_BITS       (sizeof(unsigned long) * 8)
+
+#define REFILL() \
+    do { \
+        hold |= (sizeof(hold) == 8 ? \
+                 (unsigned long)get_unaligned_le64(in) : \
+                 (unsigned long)get_unaligned_le32(in)) << bits; \
+        in += (HOLD_BITS - 1 - bits) >> 3; \
+        bits |= HOLD_BITS - 8; \
+    } while (0)
+
+/* Copy len bytes from from to out, where from and out do not overlap */
+local unsigned char FAR *copy_bytes(unsigned char FAR *out,
+                                    const unsigned char FAR *from,
+                                    unsigned len)
+{
+    memcpy(out, from, len);
+    return out + len;
+}
+
+/*
+   Copy a match of len bytes from dist bytes back in the output. Whole words
+   are copied when dist is at least a word, which may write up to a word
+   minus one bytes past the end of the match; inflate_fast() leaves room for
+   this. A run of one byte is common (e.g. zero padding) and uses memset().
+ */
+local unsigned char FAR *copy_match(unsigned char FAR *out, unsigned dist,
+                                    unsigned len)
+{
+    const unsigned char FAR *from = out - dist;
+    unsigned char FAR *end = out + len;
+
+    if (dist >= sizeof(unsigned long)) {
+        do {
+            put_unaligned(get_unaligned((unsigned long *)from),
+                          (unsigned long *)out);
+            out += sizeof(unsigned long);
+            from += sizeof(unsigned long);
+        } while (out < end);
+    } else if (dist == 1) {
+        memset(out, out[-1], len);
+    } else {
+        do {
+            *out++ = *from++;
+        } while (out < end);
+    }
+
+    return end;
+}
 
 /*
    Decode literal, length, and distance codes and write out the resulting
@@ -42,10 +85,9 @@
    Entry assumptions:
 
         state->mode == LEN
-        strm->avail_in >= 6
-        strm->avail_out >= 258
+        strm->avail_in >= INFLATE_FAST_MIN_INPUT
+        strm->avail_out >= INFLATE_FAST_MIN_OUTPUT
         start >= strm->avail_out
-        state->bits < 8
 
    On return, state->mode is one of:
 
@@ -57,14 +99,17 @@
 
     - The maximum input bits used by a length/distance pair is 15 bits for the
       length code, 5 bits for the length extra, 15 bits for the distance code,
-      and 13 bits for the distance extra.  This totals 48 bits, or six bytes.
-      Therefore if strm->avail_in >= 6, then there is enough input to avoid
-      checking for available input while decoding.
+      and 13 bits for the distance extra.  This totals 48 bits. With a 64-bit
+      hold, two literals (30 bits) may be decoded before that, with a second
+      refill before the distance. Each refill reads a word, so the input
+      must have INFLATE_FAST_MIN_INPUT bytes to avoid checking for available
+      input while decoding.
 
     - The maximum bytes that a single length/distance pair can output is 258
-      bytes, which is the maximum length that can be coded.  inflate_fast()
-      requires strm->avail_out >= 258 for each loop to avoid checking for
-      output space.
+      bytes, which is the maximum length that can be coded. With up to two
+      literals before it and a word of slack for copy_match(),
+      inflate_fast() requires strm->avail_out >= INFLATE_FAST_MIN_OUTPUT for
+      each loop to avoid checking for output space.
  */
 void inflate_fast(z_streamp strm, unsigned start)
 /* start: inflate()'s starting value for strm->avail_out */
@@ -97,19 +142,19 @@ void inflate_fast(z_streamp strm, unsigned start)
 
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
-    in = strm->next_in - OFF;
-    last = in + (strm->avail_in - 5);
-    if (in > last && strm->avail_in > 5) {
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
+    if (in > last && strm->avail_in > INFLATE_FAST_MIN_INPUT - 1) {
         /*
          * overflow detected, limit strm->avail_in to the
          * max. possible size and recalculate last
          */
 	strm->avail_in = 0xffffffff - (uintptr_t)in;
-        last = in + (strm->avail_in - 5);
+        last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
     }
-    out = strm->next_out - OFF;
+    out = strm->next_out;
     beg = out - (start - strm->avail_out);
-    end = out + (strm->avail_out - 257);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_OUTPUT - 1));
 #ifdef INFLATE_STRICT
     dmax = state->dmax;
 #endif
@@ -127,13 +172,27 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
-        if (bits < 15) {
-            hold += (unsigned long)(PUP(in)) << bits;
-            bits += 8;
-            hold += (unsigned long)(PUP(in)) << bits;
-            bits += 8;
-        }
+        REFILL();
         this = lcode[hold & lmask];
+        if (sizeof(hold) == 8 && this.op == 0) {
+            /* at least 41 bits remain, enough for two more codes */
+            hold >>= this.bits;
+            bits -= this.bits;
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+            this = lcode[hold & lmask];
+            if (this.op == 0) {
+                hold >>= this.bits;
+                bits -= this.bits;
+                Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                        "inflate:         literal '%c'\n" :
+                        "inflate:         literal 0x%02x\n", this.val));
+                *out++ = (unsigned char)(this.val);
+                this = lcode[hold & lmask];
+            }
+        }
       dolen:
         op = (unsigned)(this.bits);
         hold >>= op;
@@ -143,27 +202,19 @@ void inflate_fast(z_streamp strm, unsigned start)
             Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
                     "inflate:         literal '%c'\n" :
                     "inflate:         literal 0x%02x\n", this.val));
-            PUP(out) = (unsigned char)(this.val);
+            *out++ = (unsigned char)(this.val);
         }
         else if (op & 16) {                     /* length base */
             len = (unsigned)(this.val);
             op &= 15;                           /* number of extra bits */
             if (op) {
-                if (bits < op) {
-                    hold += (unsigned long)(PUP(in)) << bits;
-                    bits += 8;
-                }
                 len += (unsigned)hold & ((1U << op) - 1);
                 hold >>= op;
                 bits -= op;
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
-            if (bits < 15) {
-                hold += (unsigned long)(PUP(in)) << bits;
-                bits += 8;
-                hold += (unsigned long)(PUP(in)) << bits;
-                bits += 8;
-            }
+            if (bits < 15 + 13)
+                REFILL();
             this = dcode[hold & dmask];
           dodist:
             op = (unsigned)(this.bits);
@@ -173,14 +224,8 @@ void inflate_fast(z_streamp strm, unsigned start)
             if (op & 16) {                      /* distance base */
                 dist = (unsigned)(this.val);
                 op &= 15;                       /* number of extra bits */
-                if (bits < op) {
-                    hold += (unsigned long)(PUP(in)) << bits;
-                    bits += 8;
-                    if (bits < op) {
-                        hold += (unsigned long)(PUP(in)) << bits;
-                        bits += 8;
-                    }
-                }
+                if (sizeof(hold) < 8 && bits < op)
+                    REFILL();
                 dist += (unsigned)hold & ((1U << op) - 1);
 #ifdef INFLATE_STRICT
                 if (dist > dmax) {
@@ -200,100 +245,34 @@ void inflate_fast(z_streamp strm, unsigned start)
                         state->mode = BAD;
                         break;
                     }
-                    from = window - OFF;
+                    from = window;
                     if (write == 0) {           /* very common case */
                         from += wsize - op;
-                        if (op < len) {         /* some from window */
-                            len -= op;
-                            do {
-                                PUP(out) = PUP(from);
-                            } while (--op);
-                            from = out - dist;  /* rest from output */
-                        }
                     }
                     else if (write < op) {      /* wrap around window */
                         from += wsize + write - op;
                         op -= write;
                         if (op < len) {         /* some from end of window */
                             len -= op;
-                            do {
-                                PUP(out) = PUP(from);
-                            } while (--op);
-                            from = window - OFF;
-                            if (write < len) {  /* some from start of window */
-                                op = write;
-                                len -= op;
-                                do {
-                                    PUP(out) = PUP(from);
-                                } while (--op);
-                                from = out - dist;      /* rest from output */
-                            }
+                            out = copy_bytes(out, from, op);
+                            from = window;
+                            op = write;
                         }
                     }
                     else {                      /* contiguous in window */
                         from += write - op;
-                        if (op < len) {         /* some from window */
-                            len -= op;
-                            do {
-                                PUP(out) = PUP(from);
-                            } while (--op);
-                            from = out - dist;  /* rest from output */
-                        }
                     }
-                    while (len > 2) {
-                        PUP(out) = PUP(from);
-                        PUP(out) = PUP(from);
-                        PUP(out) = PUP(from);
-                        len -= 3;
+                    if (op < len) {             /* some from window */
+                        len -= op;
+                        out = copy_bytes(out, from, op);
+                        out = copy_match(out, dist, len);   /* rest */
                     }
-                    if (len) {
-                        PUP(out) = PUP(from);
-                        if (len > 1)
-                            PUP(out) = PUP(from);
+                    else {
+                        out = copy_bytes(out, from, len);
                     }
                 }
                 else {
-		    unsigned short *sout;
-		    unsigned long loops;
-
-                    from = out - dist;          /* copy direct from output */
-                    /* minimum length is three */
-		    /* Align out addr */
-		    if (!((long)(out - 1 + OFF) & 1)) {
-			PUP(out) = PUP(from);
-			len--;
-		    }
-		    sout = (unsigned short *)(out - OFF);
-		    if (dist > 2 ) {
-			unsigned short *sfrom;
-
-			sfrom = (unsigned short *)(from - OFF);
-			loops = len >> 1;
-			do
-			    PUP(sout) = get_unaligned(++sfrom);
-			while (--loops);
-			out = (unsigned char *)sout + OFF;
-			from = (unsigned char *)sfrom + OFF;
-		    } else { /* dist == 1 or dist == 2 */
-			unsigned short pat16;
-
-			pat16 = *(sout-2+2*OFF);
-			if (dist == 1)
-#if defined(__BIG_ENDIAN)
-			    pat16 = (pat16 & 0xff) | ((pat16 & 0xff ) << 8);
-#elif defined(__LITTLE_ENDIAN)
-			    pat16 = (pat16 & 0xff00) | ((pat16 & 0xff00 ) >> 8);
-#else
-#error __BIG_ENDIAN nor __LITTLE_ENDIAN is defined
-#endif
-			loops = len >> 1;
-			do
-			    PUP(sout) = pat16;
-			while (--loops);
-			out = (unsigned char *)sout + OFF;
-		    }
-		    if (len & 1)
-			PUP(out) = PUP(from);
+                    out = copy_match(out, dist, len);
                 }
             }
             else if ((op & 64) == 0) {          /* 2nd level distance code */
@@ -322,18 +301,21 @@ void inflate_fast(z_streamp strm, unsigned start)
         }
     } while (in < last && out < end);
 
-    /* return unused bytes (on entry, bits < 8, so in won't go too far back) */
+    /* return unused bytes (bits may hold several whole bytes) */
     len = bits >> 3;
     in -= len;
     bits -= len << 3;
     hold &= (1U << bits) - 1;
 
     /* update state and return */
-    strm->next_in = in + OFF;
-    strm->next_out = out + OFF;
-    strm->avail_in = (unsigned)(in < last ? 5 + (last - in) : 5 - (in - last));
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_INPUT - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_INPUT - 1) - (in - last));
     strm->avail_out = (unsigned)(out < end ?
-                                 257 + (end - out) : 257 - (out - end));
+                                 (INFLATE_FAST_MIN_OUTPUT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_OUTPUT - 1) - (out - end));
     state->hold = hold;
     state->bits = bits;
     return;
@@ -8,4 +8,13 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/*
+   inflate_fast() reads the input and copies matches a word at a time, so it
+   may read a little past the last code that it decodes and write a little
+   past the last byte of a match. This is the input and output it needs to
+   be able to decode two literals and a length/distance pair.
+ */
+#define INFLATE_FAST_MIN_INPUT  24
+#define INFLATE_FAST_MIN_OUTPUT 272
+
 void inflate_fast OF((z_streamp strm, unsigned start));
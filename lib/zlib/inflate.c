@@ -701,7 +701,10 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             /* build code tables */
             state->next = state->codes;
             state->lencode = (code const FAR *)(state->next);
-            state->lenbits = 9;
+            /* U-Boot: 10 rather than 9 index bits for fewer 2nd level
+               lookups in inflate_fast(). This needs at most 1332 entries,
+               within ENOUGH - MAXD. */
+            state->lenbits = 10;
             ret = inflate_table(LENS, state->lens, state->nlen, &(state->next),
                                 &(state->lenbits), state->work);
             if (ret) {
@@ -722,7 +725,8 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             state->mode = LEN;
         case LEN:
 	    WATCHDOG_RESET();
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_INPUT &&
+                left >= INFLATE_FAST_MIN_OUTPUT) {
                 RESTORE();
                 inflate_fast(strm, out);
                 LOAD();
@@ -0,0 +1,696 @@
+/*
+ * Zstandard decompression (RFC 8878)
+ *
+ * This decodes whole frames into a flat output buffer, which also serves as
+ * the window, so the memory needed does not depend on the window size that
+ * the data was compressed with. Apart from the output buffer, decoding uses
+ * a single allocation of about 140KB: the entropy tables and a buffer for
+ * one block's literals. Dictionaries are not supported.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include "zstd_internal.h"
+
+#define ZSTD_MAGIC		0xfd2fb528
+#define ZSTD_SKIPPABLE_MAGIC	0x184d2a50
+#define ZSTD_SKIPPABLE_MASK	0xfffffff0
+
+enum {
+	BLOCK_RAW,
+	BLOCK_RLE,
+	BLOCK_COMPRESSED,
+	BLOCK_RESERVED,
+};
+
+enum {
+	LIT_RAW,
+	LIT_RLE,
+	LIT_COMPRESSED,
+	LIT_TREELESS,
+};
+
+enum {
+	SEQ_PREDEFINED,
+	SEQ_RLE,
+	SEQ_COMPRESSED,
+	SEQ_REPEAT,
+};
+
+/**
+ * struct zstd_ctx - State carried from one block to the next in a frame
+ *
+ * @ll:		Literal-length decoding table
+ * @ml:		Match-length decoding table
+ * @of:		Offset decoding table
+ * @ll_log:	Accuracy log of @ll, or -1 if not yet set up
+ * @ml_log:	Accuracy log of @ml, or -1 if not yet set up
+ * @of_log:	Accuracy log of @of, or -1 if not yet set up
+ * @huf:	Huffman table for literals
+ * @huf_log:	Longest prefix code in @huf, or 0 if not yet set up
+ * @rep:	Repeat offsets
+ * @lit:	Buffer for the literals of a block, when they are not raw
+ */
+struct zstd_ctx {
+	struct fse_entry ll[1 << LL_MAX_LOG];
+	struct fse_entry ml[1 << ML_MAX_LOG];
+	struct fse_entry of[1 << OF_MAX_LOG];
+	int ll_log;
+	int ml_log;
+	int of_log;
+	struct huf_entry huf[1 << HUF_MAX_LOG];
+	uint huf_log;
+	u32 rep[3];
+	u8 lit[ZSTD_BLOCK_MAX];
+};
+
+/* Predefined distributions (RFC 8878 section 3.1.1.3.2.2) */
+static const s16 ll_default[LL_MAX_CODE + 1] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1
+};
+
+static const s16 ml_default[ML_MAX_CODE + 1] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1
+};
+
+static const s16 of_default[29] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1
+};
+
+/* Baseline and number of extra bits for each length code */
+static const u32 ll_base[LL_MAX_CODE + 1] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048,
+	4096, 8192, 16384, 32768, 65536
+};
+
+static const u8 ll_bits[LL_MAX_CODE + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16
+};
+
+static const u32 ml_base[ML_MAX_CODE + 1] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027,
+	2051, 4099, 8195, 16387, 32771, 65539
+};
+
+static const u8 ml_bits[ML_MAX_CODE + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16
+};
+
+static u64 rotl64(u64 val, uint n)
+{
+	return (val << n) | (val >> (64 - n));
+}
+
+#define XXH_PRIME64_1	0x9e3779b185ebca87ULL
+#define XXH_PRIME64_2	0xc2b2ae3d27d4eb4fULL
+#define XXH_PRIME64_3	0x165667b19e3779f9ULL
+#define XXH_PRIME64_4	0x85ebca77c2b2ae63ULL
+#define XXH_PRIME64_5	0x27d4eb2f165667c5ULL
+
+static u64 xxh64_round(u64 acc, u64 val)
+{
+	return rotl64(acc + val * XXH_PRIME64_2, 31) * XXH_PRIME64_1;
+}
+
+static u64 xxh64_merge(u64 acc, u64 val)
+{
+	return (acc ^ xxh64_round(0, val)) * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+/* XXH64 with a seed of 0, as used for the frame content checksum */
+static u64 xxh64(const u8 *p, size_t len)
+{
+	const u8 *end = p + len;
+	u64 h;
+
+	if (len >= 32) {
+		u64 v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+		u64 v2 = XXH_PRIME64_2;
+		u64 v3 = 0;
+		u64 v4 = -XXH_PRIME64_1;
+
+		for (; end - p >= 32; p += 32) {
+			v1 = xxh64_round(v1, get_unaligned_le64(p));
+			v2 = xxh64_round(v2, get_unaligned_le64(p + 8));
+			v3 = xxh64_round(v3, get_unaligned_le64(p + 16));
+			v4 = xxh64_round(v4, get_unaligned_le64(p + 24));
+		}
+		h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) +
+			rotl64(v4, 18);
+		h = xxh64_merge(h, v1);
+		h = xxh64_merge(h, v2);
+		h = xxh64_merge(h, v3);
+		h = xxh64_merge(h, v4);
+	} else {
+		h = XXH_PRIME64_5;
+	}
+	h += len;
+
+	for (; end - p >= 8; p += 8) {
+		h ^= xxh64_round(0, get_unaligned_le64(p));
+		h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (end - p >= 4) {
+		h ^= get_unaligned_le32(p) * XXH_PRIME64_1;
+		h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= *p * XXH_PRIME64_5;
+		h = rotl64(h, 11) * XXH_PRIME64_1;
+	}
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+/**
+ * zstd_literals() - Decode the literals section of a compressed block
+ *
+ * @ctx:	Decoder context
+ * @src:	Start of the block
+ * @len:	Size of the block
+ * @litp:	Returns a pointer to the literals
+ * @lit_len:	Returns the number of literals
+ * @return number of bytes used from @src, or -EINVAL if invalid
+ */
+static int zstd_literals(struct zstd_ctx *ctx, const u8 *src, size_t len,
+			 const u8 **litp, size_t *lit_len)
+{
+	static const u8 raw_hdr_size[] = { 1, 2, 1, 3 };
+	uint type = src[0] & 3, format = (src[0] >> 2) & 3;
+	size_t regen, size, hdr, total;
+	u64 val;
+	int ret;
+
+	if (type == LIT_RAW || type == LIT_RLE) {
+		/* 5, 12 or 20 bits of size */
+		hdr = raw_hdr_size[format];
+		if (hdr > len)
+			return -EINVAL;
+		if (hdr == 1)
+			regen = src[0] >> 3;
+		else if (hdr == 2)
+			regen = (src[0] >> 4) | (src[1] << 4);
+		else
+			regen = (src[0] >> 4) | (src[1] << 4) | (src[2] << 12);
+		if (regen > ZSTD_BLOCK_MAX)
+			return -EINVAL;
+		if (type == LIT_RAW) {
+			if (hdr + regen > len)
+				return -EINVAL;
+			*litp = src + hdr;
+			*lit_len = regen;
+			return hdr + regen;
+		}
+		if (hdr + 1 > len)
+			return -EINVAL;
+		memset(ctx->lit, src[hdr], regen);
+		*litp = ctx->lit;
+		*lit_len = regen;
+		return hdr + 1;
+	}
+
+	/* Both sizes use 10, 10, 14 or 18 bits, after the first four */
+	hdr = format < 2 ? 3 : format + 2;
+	if (hdr > len)
+		return -EINVAL;
+	val = 0;
+	for (ret = 0; ret < hdr; ret++)
+		val |= (u64)src[ret] << (ret * 8);
+	val >>= 4;
+	if (format < 2) {
+		regen = val & 0x3ff;
+		size = (val >> 10) & 0x3ff;
+	} else {
+		uint bits = format == 2 ? 14 : 18;
+
+		regen = val & ((1 << bits) - 1);
+		size = val >> bits;
+	}
+	total = hdr + size;
+	if (regen > ZSTD_BLOCK_MAX || total > len)
+		return -EINVAL;
+	src += hdr;
+
+	if (type == LIT_COMPRESSED) {
+		ret = huf_read_table(ctx->huf, &ctx->huf_log, src, size);
+		if (ret < 0)
+			return ret;
+		src += ret;
+		size -= ret;
+	} else if (!ctx->huf_log) {
+		return -EINVAL;
+	}
+	ret = huf_decode(ctx->huf, ctx->huf_log, ctx->lit, regen, src, size,
+			 format != 0);
+	if (ret)
+		return ret;
+	*litp = ctx->lit;
+	*lit_len = regen;
+
+	return total;
+}
+
+/**
+ * zstd_seq_table() - Set up the decoding table for one sequence field
+ *
+ * @dt:		Decoding table to set up
+ * @logp:	Accuracy log of @dt, -1 if not yet set up
+ * @mode:	Compression mode (SEQ_...)
+ * @max_code:	Largest code allowed
+ * @max_log:	Largest accuracy log allowed
+ * @def:	Predefined distribution
+ * @def_len:	Number of codes in @def
+ * @def_log:	Accuracy log of @def
+ * @src:	Table description, if any
+ * @len:	Number of bytes available at @src
+ * @return number of bytes used from @src, or -EINVAL if invalid
+ */
+static int zstd_seq_table(struct fse_entry *dt, int *logp, uint mode,
+			  uint max_code, uint max_log, const s16 *def,
+			  uint def_len, uint def_log, const u8 *src, size_t len)
+{
+	uint log;
+	int ret;
+
+	switch (mode) {
+	case SEQ_PREDEFINED:
+		ret = fse_build_table(dt, def, def_len, def_log);
+		if (ret)
+			return ret;
+		*logp = def_log;
+		return 0;
+	case SEQ_RLE:
+		if (!len || src[0] > max_code)
+			return -EINVAL;
+		dt[0].symbol = src[0];
+		dt[0].bits = 0;
+		dt[0].base = 0;
+		*logp = 0;
+		return 1;
+	case SEQ_COMPRESSED:
+		ret = fse_read_table(dt, &log, max_log, max_code, src, len);
+		if (ret < 0)
+			return ret;
+		*logp = log;
+		return ret;
+	default:
+		return *logp < 0 ? -EINVAL : 0;
+	}
+}
+
+/*
+ * Copy @len bytes eight at a time, writing up to seven bytes past the end.
+ * The source may overlap the destination if it is at least eight bytes
+ * behind it.
+ */
+static inline void zstd_wildcopy(u8 *dst, const u8 *src, size_t len)
+{
+	u8 *end = dst + len;
+
+	do {
+		put_unaligned(get_unaligned((u64 *)src), (u64 *)dst);
+		dst += sizeof(u64);
+		src += sizeof(u64);
+	} while (dst < end);
+}
+
+/* Copy a match, which may overlap its destination */
+static void zstd_copy_match(u8 *out, size_t offset, size_t len)
+{
+	const u8 *from = out - offset;
+
+	if (offset == 1) {
+		memset(out, *from, len);
+		return;
+	}
+	if (offset >= sizeof(u64)) {
+		for (; len >= sizeof(u64); len -= sizeof(u64)) {
+			put_unaligned(get_unaligned((u64 *)from), (u64 *)out);
+			from += sizeof(u64);
+			out += sizeof(u64);
+		}
+	}
+	while (len--)
+		*out++ = *from++;
+}
+
+/**
+ * zstd_sequences() - Decode and execute the sequences of a compressed block
+ *
+ * @ctx:	Decoder context
+ * @src:	Sequences section
+ * @len:	Size of the sequences section
+ * @lit:	Literals of the block
+ * @lit_len:	Number of literals
+ * @outp:	Output position, updated on exit
+ * @out_end:	End of the output buffer
+ * @frame:	Start of the frame's output, the limit for match offsets
+ * @return 0 if OK, -ENOSPC if the output buffer is too small, -EINVAL if
+ *	the data is invalid
+ */
+static int zstd_sequences(struct zstd_ctx *ctx, const u8 *src, size_t len,
+			  const u8 *lit, size_t lit_len, u8 **outp,
+			  u8 *out_end, u8 *frame)
+{
+	const u8 *lit_end = lit + lit_len;
+	const u8 *end = src + len;
+	uint nseq, modes, ll_state, ml_state, of_state;
+	u8 *out = *outp;
+	struct bit_rev br;
+	u32 rep[3];
+	int ret;
+
+	if (!len)
+		return -EINVAL;
+	nseq = *src++;
+	if (nseq >= 128) {
+		if (end - src < (nseq == 255 ? 2 : 1))
+			return -EINVAL;
+		if (nseq == 255) {
+			nseq = get_unaligned_le16(src) + 0x7f00;
+			src += 2;
+		} else {
+			nseq = ((nseq - 128) << 8) + *src++;
+		}
+	}
+
+	if (!nseq) {
+		if (src != end)
+			return -EINVAL;
+		goto done;
+	}
+
+	if (src == end)
+		return -EINVAL;
+	modes = *src++;
+	if (modes & 3)
+		return -EINVAL;
+	ret = zstd_seq_table(ctx->ll, &ctx->ll_log, modes >> 6,
+			     LL_MAX_CODE, LL_MAX_LOG, ll_default,
+			     ARRAY_SIZE(ll_default), 6, src, end - src);
+	if (ret < 0)
+		return ret;
+	src += ret;
+	ret = zstd_seq_table(ctx->of, &ctx->of_log, (modes >> 4) & 3,
+			     OF_MAX_CODE, OF_MAX_LOG, of_default,
+			     ARRAY_SIZE(of_default), 5, src, end - src);
+	if (ret < 0)
+		return ret;
+	src += ret;
+	ret = zstd_seq_table(ctx->ml, &ctx->ml_log, (modes >> 2) & 3,
+			     ML_MAX_CODE, ML_MAX_LOG, ml_default,
+			     ARRAY_SIZE(ml_default), 6, src, end - src);
+	if (ret < 0)
+		return ret;
+	src += ret;
+
+	if (bit_rev_init(&br, src, end - src))
+		return -EINVAL;
+	ll_state = bit_rev_read(&br, ctx->ll_log);
+	of_state = bit_rev_read(&br, ctx->of_log);
+	ml_state = bit_rev_read(&br, ctx->ml_log);
+	bit_rev_reload(&br);
+	memcpy(rep, ctx->rep, sizeof(rep));
+
+	while (nseq--) {
+		const struct fse_entry *ll = &ctx->ll[ll_state];
+		const struct fse_entry *ml = &ctx->ml[ml_state];
+		const struct fse_entry *of = &ctx->of[of_state];
+		uint ll_extra = ll_bits[ll->symbol];
+		uint ml_extra = ml_bits[ml->symbol];
+		bool long_seq = of->symbol + ll_extra + ml_extra > 31;
+		size_t lit_size, match_size;
+		u32 offset;
+		uint idx;
+
+		/*
+		 * Extra bits come offset first, then match and literal length.
+		 * With the state updates they usually fit in one reload.
+		 */
+		offset = (1U << of->symbol) + bit_rev_read(&br, of->symbol);
+		if (long_seq)
+			bit_rev_reload(&br);
+		match_size = ml_base[ml->symbol] + bit_rev_read(&br, ml_extra);
+		lit_size = ll_base[ll->symbol] + bit_rev_read(&br, ll_extra);
+		if (long_seq)
+			bit_rev_reload(&br);
+
+		/*
+		 * Offset values 1-3 select a repeat offset, shifted by one if
+		 * there are no literals, in which case 3 means rep[0] - 1
+		 */
+		if (offset > 3) {
+			offset -= 3;
+			rep[2] = rep[1];
+			rep[1] = rep[0];
+			rep[0] = offset;
+		} else {
+			idx = offset - 1 + !lit_size;
+			if (idx == 0) {
+				offset = rep[0];
+			} else {
+				offset = idx == 3 ? rep[0] - 1 : rep[idx];
+				if (idx != 1)
+					rep[2] = rep[1];
+				rep[1] = rep[0];
+				rep[0] = offset;
+			}
+		}
+
+		if (nseq) {
+			ll_state = ll->base + bit_rev_read(&br, ll->bits);
+			ml_state = ml->base + bit_rev_read(&br, ml->bits);
+			of_state = of->base + bit_rev_read(&br, of->bits);
+			bit_rev_reload(&br);
+		}
+		if (bit_rev_overflow(&br))
+			return -EINVAL;
+
+		if (lit_size > lit_end - lit)
+			return -EINVAL;
+		if (lit_size + match_size > out_end - out)
+			return -ENOSPC;
+		if (!offset || offset > out + lit_size - frame)
+			return -EINVAL;
+
+		/* Use whole words when there is room for the overrun */
+		if (lit_size + match_size + sizeof(u64) <= out_end - out &&
+		    lit_size + sizeof(u64) <= lit_end - lit) {
+			zstd_wildcopy(out, lit, lit_size);
+			out += lit_size;
+			lit += lit_size;
+			if (offset >= sizeof(u64)) {
+				zstd_wildcopy(out, out - offset, match_size);
+				out += match_size;
+				continue;
+			}
+		} else {
+			memcpy(out, lit, lit_size);
+			out += lit_size;
+			lit += lit_size;
+		}
+		zstd_copy_match(out, offset, match_size);
+		out += match_size;
+	}
+	memcpy(ctx->rep, rep, sizeof(rep));
+	if (!bit_rev_done(&br))
+		return -EINVAL;
+
+done:
+	/* The rest of the literals follow the last sequence */
+	if (lit_end - lit > out_end - out)
+		return -ENOSPC;
+	memcpy(out, lit, lit_end - lit);
+	*outp = out + (lit_end - lit);
+
+	return 0;
+}
+
+/**
+ * zstd_frame() - Decode a Zstandard frame
+ *
+ * @ctx:	Decoder context
+ * @srcp:	Start of the frame, just after the magic number. Updated to
+ *		point just past the frame on exit.
+ * @src_end:	End of the input
+ * @outp:	Output position, updated on exit
+ * @out_end:	End of the output buffer
+ * @return 0 if OK, -ENOSPC if the output buffer is too small, -EINVAL if
+ *	the data is invalid
+ */
+static int zstd_frame(struct zstd_ctx *ctx, const u8 **srcp,
+		      const u8 *src_end, u8 **outp, u8 *out_end)
+{
+	static const u8 dict_id_size[] = { 0, 1, 2, 4 };
+	const u8 *src = *srcp;
+	u8 *frame = *outp, *out = frame;
+	uint desc, fcs_size, i;
+	u64 content_size = 0;
+	bool last;
+	int ret;
+
+	if (src == src_end)
+		return -EINVAL;
+	desc = *src++;
+	if (desc & 0x08)
+		return -EINVAL;	/* reserved bit */
+	fcs_size = desc >> 6 ? 1 << (desc >> 6) : (desc >> 5) & 1;
+	i = !(desc & 0x20) + dict_id_size[desc & 3] + fcs_size;
+	if (i > src_end - src)
+		return -EINVAL;
+	src += !(desc & 0x20);	/* window descriptor: the window is @dst */
+	for (i = 0; i < dict_id_size[desc & 3]; i++) {
+		if (*src++) {
+			debug("zstd: dictionaries are not supported\n");
+			return -EPROTONOSUPPORT;
+		}
+	}
+	for (i = 0; i < fcs_size; i++)
+		content_size |= (u64)*src++ << (i * 8);
+	if (fcs_size == 2)
+		content_size += 256;
+	if (fcs_size && content_size > out_end - out)
+		return -ENOSPC;
+
+	ctx->ll_log = -1;
+	ctx->ml_log = -1;
+	ctx->of_log = -1;
+	ctx->huf_log = 0;
+	ctx->rep[0] = 1;
+	ctx->rep[1] = 4;
+	ctx->rep[2] = 8;
+
+	do {
+		u32 hdr;
+		size_t size;
+
+		if (src_end - src < 3)
+			return -EINVAL;
+		hdr = src[0] | src[1] << 8 | src[2] << 16;
+		src += 3;
+		last = hdr & 1;
+		size = hdr >> 3;
+		if (size > ZSTD_BLOCK_MAX)
+			return -EINVAL;
+
+		switch ((hdr >> 1) & 3) {
+		case BLOCK_RAW:
+			if (size > src_end - src)
+				return -EINVAL;
+			if (size > out_end - out)
+				return -ENOSPC;
+			memcpy(out, src, size);
+			out += size;
+			src += size;
+			break;
+		case BLOCK_RLE:
+			if (src == src_end)
+				return -EINVAL;
+			if (size > out_end - out)
+				return -ENOSPC;
+			memset(out, *src++, size);
+			out += size;
+			break;
+		case BLOCK_COMPRESSED: {
+			const u8 *lit = NULL;
+			size_t lit_len = 0;
+
+			if (!size || size > src_end - src)
+				return -EINVAL;
+			ret = zstd_literals(ctx, src, size, &lit, &lit_len);
+			if (ret < 0)
+				return ret;
+			ret = zstd_sequences(ctx, src + ret, size - ret, lit,
+					     lit_len, &out, out_end, frame);
+			if (ret)
+				return ret;
+			src += size;
+			break;
+		}
+		default:
+			return -EINVAL;
+		}
+	} while (!last);
+
+	if (fcs_size && out - frame != content_size)
+		return -EINVAL;
+	if (desc & 0x04) {
+		if (src_end - src < 4)
+			return -EINVAL;
+		if (get_unaligned_le32(src) != (u32)xxh64(frame, out - frame)) {
+			debug("zstd: bad content checksum\n");
+			return -EINVAL;
+		}
+		src += 4;
+	}
+	*srcp = src;
+	*outp = out;
+
+	return 0;
+}
+
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const u8 *in = src, *in_end = in + srcn;
+	u8 *out = dst, *out_end = out + *dstn;
+	struct zstd_ctx *ctx;
+	int ret = -EINVAL;
+	u32 magic;
+
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+
+	/* Frames may be concatenated, with skippable frames in between */
+	while (in < in_end) {
+		if (in_end - in < 4) {
+			ret = -EINVAL;
+			break;
+		}
+		magic = get_unaligned_le32(in);
+		in += 4;
+		if ((magic & ZSTD_SKIPPABLE_MASK) == ZSTD_SKIPPABLE_MAGIC) {
+			if (in_end - in < 4 ||
+			    get_unaligned_le32(in) > in_end - in - 4) {
+				ret = -EINVAL;
+				break;
+			}
+			in += 4 + get_unaligned_le32(in);
+			continue;
+		}
+		if (magic != ZSTD_MAGIC) {
+			ret = -EPROTONOSUPPORT;
+			break;
+		}
+		ret = zstd_frame(ctx, &in, in_end, &out, out_end);
+		if (ret)
+			break;
+	}
+	free(ctx);
+
+	*dstn = ret == -ENOSPC ? out_end - (u8 *)dst : out - (u8 *)dst;
+
+	return ret;
+}
@@ -0,0 +1,324 @@
+/*
+ * Zstandard FSE and Huffman decoding (RFC 8878 section 4)
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include "zstd_internal.h"
+
+int fse_build_table(struct fse_entry *dt, const s16 *norm, uint nsym,
+		    uint log)
+{
+	uint size = 1 << log, mask = size - 1;
+	uint step = (size >> 1) + (size >> 3) + 3;
+	uint high = size - 1, pos = 0, total = 0;
+	u16 next[FSE_MAX_SYMBOLS];
+	uint s, i;
+
+	if (nsym > FSE_MAX_SYMBOLS)
+		return -EINVAL;
+	for (s = 0; s < nsym; s++)
+		total += norm[s] == -1 ? 1 : norm[s];
+	if (total != size)
+		return -EINVAL;
+
+	/* 'Less than 1' symbols take a single state each, at the top */
+	for (s = 0; s < nsym; s++) {
+		if (norm[s] == -1) {
+			dt[high--].symbol = s;
+			next[s] = 1;
+		} else {
+			next[s] = norm[s];
+		}
+	}
+
+	/* Spread the other symbols over the rest of the table */
+	for (s = 0; s < nsym; s++) {
+		for (i = 0; i < (norm[s] > 0 ? norm[s] : 0); i++) {
+			dt[pos].symbol = s;
+			do
+				pos = (pos + step) & mask;
+			while (pos > high);
+		}
+	}
+	if (pos)
+		return -EINVAL;
+
+	for (i = 0; i < size; i++) {
+		uint state = next[dt[i].symbol]++;
+		uint bits = log + 1 - fls(state);
+
+		dt[i].bits = bits;
+		dt[i].base = (state << bits) - size;
+	}
+
+	return 0;
+}
+
+/* Read @n bits (n <= 16) from a forward bitstream, as zero past the end */
+static uint bits_fwd(const u8 *src, size_t len, size_t pos, uint n)
+{
+	size_t byte = pos >> 3;
+	u32 val = 0;
+	uint i;
+
+	for (i = 0; i < 4 && byte + i < len; i++)
+		val |= (u32)src[byte + i] << (i * 8);
+
+	return (val >> (pos & 7)) & ((1 << n) - 1);
+}
+
+int fse_read_table(struct fse_entry *dt, uint *logp, uint max_log,
+		   uint max_symbol, const u8 *src, size_t len)
+{
+	s16 norm[FSE_MAX_SYMBOLS];
+	int remaining, threshold, count, max;
+	uint log, bits, sym = 0, rep, i;
+	size_t pos = 4;
+	int ret;
+
+	if (!len)
+		return -EINVAL;
+	log = (src[0] & 0xf) + 5;
+	if (log > max_log)
+		return -EINVAL;
+	remaining = (1 << log) + 1;
+	threshold = 1 << log;
+	bits = log + 1;
+
+	/*
+	 * Each count uses just enough bits to hold the probability remaining,
+	 * with the smaller values taking one bit less. Zero counts are
+	 * followed by 2-bit repeat fields giving the number of further zeros.
+	 */
+	while (remaining > 1) {
+		if (sym > max_symbol)
+			return -EINVAL;
+		max = 2 * threshold - 1 - remaining;
+		count = bits_fwd(src, len, pos, bits);
+		if ((count & (threshold - 1)) < max) {
+			count &= threshold - 1;
+			pos += bits - 1;
+		} else {
+			if (count >= threshold)
+				count -= max;
+			pos += bits;
+		}
+		count--;
+		remaining -= count < 0 ? -count : count;
+		norm[sym++] = count;
+		if (!count) {
+			do {
+				rep = bits_fwd(src, len, pos, 2);
+				pos += 2;
+				if (sym + rep > max_symbol + 1)
+					return -EINVAL;
+				for (i = 0; i < rep; i++)
+					norm[sym++] = 0;
+			} while (rep == 3);
+		}
+		if (remaining < 1)
+			return -EINVAL;
+		while (remaining < threshold) {
+			bits--;
+			threshold >>= 1;
+		}
+	}
+	if (remaining != 1 || (pos + 7) / 8 > len)
+		return -EINVAL;
+
+	ret = fse_build_table(dt, norm, sym, log);
+	if (ret)
+		return ret;
+	*logp = log;
+
+	return (pos + 7) / 8;
+}
+
+/* Decode Huffman weights, compressed with FSE using two interleaved states */
+static int huf_read_weights(u8 *weights, const u8 *src, size_t len)
+{
+	struct fse_entry dt[1 << HUF_WEIGHT_MAX_LOG];
+	struct fse_entry *e;
+	struct bit_rev br;
+	uint log, state[2];
+	int ret, n = 0, i = 0;
+
+	ret = fse_read_table(dt, &log, HUF_WEIGHT_MAX_LOG, HUF_MAX_LOG, src,
+			     len);
+	if (ret < 0)
+		return ret;
+	if (bit_rev_init(&br, src + ret, len - ret))
+		return -EINVAL;
+	state[0] = bit_rev_read(&br, log);
+	state[1] = bit_rev_read(&br, log);
+
+	/* When the stream runs out, the other state gives the last weight */
+	for (;;) {
+		if (n >= HUF_MAX_SYMBOLS - 1)
+			return -EINVAL;
+		e = &dt[state[i]];
+		weights[n++] = e->symbol;
+		state[i] = e->base + bit_rev_read(&br, e->bits);
+		bit_rev_reload(&br);
+		i ^= 1;
+		if (bit_rev_overflow(&br)) {
+			if (n >= HUF_MAX_SYMBOLS - 1)
+				return -EINVAL;
+			weights[n++] = dt[state[i]].symbol;
+			break;
+		}
+	}
+
+	return n;
+}
+
+int huf_read_table(struct huf_entry *dt, uint *logp, const u8 *src,
+		   size_t len)
+{
+	u8 weights[HUF_MAX_SYMBOLS];
+	uint rank[HUF_MAX_LOG + 1];
+	uint total = 0, log, rest, w, s, i;
+	int n, used;
+
+	if (!len)
+		return -EINVAL;
+	if (src[0] >= 128) {
+		/* Weights stored directly, four bits each */
+		n = src[0] - 127;
+		used = 1 + (n + 1) / 2;
+		if (used > len)
+			return -EINVAL;
+		for (i = 0; i < n; i++)
+			weights[i] = (src[1 + i / 2] >> (i & 1 ? 0 : 4)) & 0xf;
+	} else {
+		used = 1 + src[0];
+		if (used > len)
+			return -EINVAL;
+		n = huf_read_weights(weights, src + 1, src[0]);
+		if (n < 0)
+			return n;
+	}
+
+	/* The last weight is implied: it makes the total a power of two */
+	memset(rank, '\0', sizeof(rank));
+	for (i = 0; i < n; i++) {
+		if (weights[i] > HUF_MAX_LOG)
+			return -EINVAL;
+		rank[weights[i]]++;
+		if (weights[i])
+			total += 1 << (weights[i] - 1);
+	}
+	if (!total)
+		return -EINVAL;
+	log = fls(total);
+	if (log > HUF_MAX_LOG)
+		return -EINVAL;
+	rest = (1 << log) - total;
+	if (rest & (rest - 1))
+		return -EINVAL;
+	w = fls(rest);
+	weights[n++] = w;
+	rank[w]++;
+
+	/*
+	 * Codes are assigned in order of increasing weight, then of symbol,
+	 * each filling 1 << (weight - 1) entries of the table
+	 */
+	for (total = 0, w = 1; w <= log; w++) {
+		uint count = rank[w] << (w - 1);
+
+		rank[w] = total;
+		total += count;
+	}
+	for (s = 0; s < n; s++) {
+		w = weights[s];
+		if (!w)
+			continue;
+		for (i = 0; i < 1 << (w - 1); i++) {
+			dt[rank[w] + i].symbol = s;
+			dt[rank[w] + i].bits = log + 1 - w;
+		}
+		rank[w] += 1 << (w - 1);
+	}
+	*logp = log;
+
+	return used;
+}
+
+static int huf_decode_stream(const struct huf_entry *dt, uint log, u8 *dst,
+			     size_t dstn, const u8 *src, size_t srcn)
+{
+	u8 *end = dst + dstn;
+	const struct huf_entry *e;
+	struct bit_rev br;
+
+	if (bit_rev_init(&br, src, srcn))
+		return -EINVAL;
+
+	/* Four codes of up to 11 bits fit in the 57 bits after a reload */
+	while (end - dst >= 4) {
+		bit_rev_reload(&br);
+		e = &dt[bit_rev_peek(&br, log)];
+		bit_rev_skip(&br, e->bits);
+		dst[0] = e->symbol;
+		e = &dt[bit_rev_peek(&br, log)];
+		bit_rev_skip(&br, e->bits);
+		dst[1] = e->symbol;
+		e = &dt[bit_rev_peek(&br, log)];
+		bit_rev_skip(&br, e->bits);
+		dst[2] = e->symbol;
+		e = &dt[bit_rev_peek(&br, log)];
+		bit_rev_skip(&br, e->bits);
+		dst[3] = e->symbol;
+		dst += 4;
+		if (bit_rev_overflow(&br))
+			return -EINVAL;
+	}
+	bit_rev_reload(&br);
+	while (dst < end) {
+		e = &dt[bit_rev_peek(&br, log)];
+		bit_rev_skip(&br, e->bits);
+		*dst++ = e->symbol;
+	}
+
+	return bit_rev_done(&br) ? 0 : -EINVAL;
+}
+
+int huf_decode(const struct huf_entry *dt, uint log, u8 *dst, size_t dstn,
+	       const u8 *src, size_t srcn, bool four)
+{
+	size_t seg, len[4];
+	int ret, i;
+
+	if (!four)
+		return huf_decode_stream(dt, log, dst, dstn, src, srcn);
+
+	/* A jump table gives the sizes of the first three streams */
+	if (srcn < 6)
+		return -EINVAL;
+	len[0] = get_unaligned_le16(src);
+	len[1] = get_unaligned_le16(src + 2);
+	len[2] = get_unaligned_le16(src + 4);
+	src += 6;
+	srcn -= 6;
+	if (len[0] + len[1] + len[2] > srcn)
+		return -EINVAL;
+	len[3] = srcn - len[0] - len[1] - len[2];
+	seg = (dstn + 3) / 4;
+	if (seg * 3 > dstn)
+		return -EINVAL;
+
+	for (i = 0; i < 4; i++) {
+		size_t n = i < 3 ? seg : dstn - seg * 3;
+
+		ret = huf_decode_stream(dt, log, dst, n, src, len[i]);
+		if (ret)
+			return ret;
+		dst += n;
+		src += len[i];
+	}
+
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Internal definitions for the Zstandard decoder
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __ZSTD_INTERNAL_H
+#define __ZSTD_INTERNAL_H
+
+#include <errno.h>
+#include <asm/unaligned.h>
+#include <linux/bitops.h>
+#include <linux/types.h>
+
+/* Largest block, whatever the window size (RFC 8878 section 3.1.1.2.4) */
+#define ZSTD_BLOCK_MAX		(128 << 10)
+
+/* Limits on the entropy tables */
+#define HUF_MAX_LOG		11
+#define HUF_MAX_SYMBOLS		256
+#define HUF_WEIGHT_MAX_LOG	6
+#define FSE_MAX_SYMBOLS		53
+#define LL_MAX_CODE		35
+#define ML_MAX_CODE		52
+#define OF_MAX_CODE		31
+#define LL_MAX_LOG		9
+#define ML_MAX_LOG		9
+#define OF_MAX_LOG		8
+
+/**
+ * struct fse_entry - An entry in an FSE decoding table
+ *
+ * @base:	Added to the @bits read from the stream to give the next state
+ * @symbol:	Symbol decoded in this state
+ * @bits:	Number of bits to read for the next state
+ */
+struct fse_entry {
+	u16 base;
+	u8 symbol;
+	u8 bits;
+};
+
+/**
+ * struct huf_entry - An entry in a Huffman decoding table
+ *
+ * The table is indexed by the next HUF_MAX_LOG (or fewer) bits of the stream
+ *
+ * @symbol:	Symbol decoded
+ * @bits:	Length of its prefix code
+ */
+struct huf_entry {
+	u8 symbol;
+	u8 bits;
+};
+
+/**
+ * struct bit_rev - Reader for a bitstream which is read backwards
+ *
+ * Zstandard's entropy-coded streams are written forwards and read from the
+ * end, starting just below the highest set bit of the last byte. The bits
+ * are held in a 64-bit container, which is loaded from @ptr and consumed
+ * from the top. After bit_rev_reload() there are at least 57 bits left to
+ * read, unless the start of the stream is reached.
+ *
+ * @start:	Start of the stream
+ * @ptr:	Position from which @bits was loaded
+ * @bits:	Container
+ * @used:	Number of bits consumed from the top of @bits. This exceeds 64
+ *		if the stream is overread, which means that it is corrupt.
+ */
+struct bit_rev {
+	const u8 *start;
+	const u8 *ptr;
+	u64 bits;
+	uint used;
+};
+
+static inline int bit_rev_init(struct bit_rev *br, const u8 *src, size_t len)
+{
+	uint i;
+
+	if (!len || !src[len - 1])
+		return -EINVAL;
+	br->start = src;
+	if (len >= sizeof(u64)) {
+		br->ptr = src + len - sizeof(u64);
+		br->bits = get_unaligned_le64(br->ptr);
+		br->used = 0;
+	} else {
+		br->ptr = src;
+		br->bits = 0;
+		for (i = 0; i < len; i++)
+			br->bits |= (u64)src[i] << (i * 8);
+		br->used = (sizeof(u64) - len) * 8;
+	}
+	/* Skip the padding, up to and including the highest set bit */
+	br->used += 9 - fls(src[len - 1]);
+
+	return 0;
+}
+
+/* Return the next @n bits (n <= 57) without consuming them */
+static inline u64 bit_rev_peek(struct bit_rev *br, uint n)
+{
+	return (br->bits << (br->used & 63)) >> 1 >> (63 - n);
+}
+
+static inline void bit_rev_skip(struct bit_rev *br, uint n)
+{
+	br->used += n;
+}
+
+static inline u64 bit_rev_read(struct bit_rev *br, uint n)
+{
+	u64 val = bit_rev_peek(br, n);
+
+	bit_rev_skip(br, n);
+
+	return val;
+}
+
+static inline void bit_rev_reload(struct bit_rev *br)
+{
+	size_t n = br->used >> 3;
+
+	if (n > br->ptr - br->start)
+		n = br->ptr - br->start;
+	if (n) {
+		br->ptr -= n;
+		br->used -= n * 8;
+		br->bits = get_unaligned_le64(br->ptr);
+	}
+}
+
+static inline bool bit_rev_overflow(struct bit_rev *br)
+{
+	return br->used > 64;
+}
+
+/* Check that the whole stream has been read, no more and no less */
+static inline bool bit_rev_done(struct bit_rev *br)
+{
+	return br->ptr == br->start && br->used == 64;
+}
+
+/**
+ * fse_build_table() - Build an FSE decoding table from its distribution
+ *
+ * @dt:		Returns the table, of 1 << @log entries
+ * @norm:	Normalised count for each symbol, where -1 means 'less than 1'
+ * @nsym:	Number of symbols in @norm
+ * @log:	Accuracy log: the counts add up to 1 << @log
+ * @return 0 if OK, -EINVAL if the distribution is invalid
+ */
+int fse_build_table(struct fse_entry *dt, const s16 *norm, uint nsym,
+		    uint log);
+
+/**
+ * fse_read_table() - Read an FSE table description and build the table
+ *
+ * @dt:		Returns the table, of up to 1 << @max_log entries
+ * @logp:	Returns the accuracy log of the table
+ * @max_log:	Largest accuracy log allowed
+ * @max_symbol:	Largest symbol allowed
+ * @src:	Table description
+ * @len:	Number of bytes available at @src
+ * @return number of bytes used from @src, or -EINVAL if invalid
+ */
+int fse_read_table(struct fse_entry *dt, uint *logp, uint max_log,
+		   uint max_symbol, const u8 *src, size_t len);
+
+/**
+ * huf_read_table() - Read a Huffman tree description and build the table
+ *
+ * @dt:		Returns the table, of up to 1 << HUF_MAX_LOG entries
+ * @logp:	Returns the length of the longest prefix code
+ * @src:	Tree description
+ * @len:	Number of bytes available at @src
+ * @return number of bytes used from @src, or -EINVAL if invalid
+ */
+int huf_read_table(struct huf_entry *dt, uint *logp, const u8 *src,
+		   size_t len);
+
+/**
+ * huf_decode() - Decode Huffman-coded literals
+ *
+ * @dt:		Decoding table from huf_read_table()
+ * @log:	Length of the longest prefix code
+ * @dst:	Destination for the literals
+ * @dstn:	Number of literals to decode
+ * @src:	Huffman-coded streams
+ * @srcn:	Size of the streams, including the jump table if any
+ * @four:	true if there are four streams, false if one
+ * @return 0 if OK, -EINVAL if the streams are corrupt
+ */
+int huf_decode(const struct huf_entry *dt, uint log, u8 *dst, size_t dstn,
+	       const u8 *src, size_t srcn, bool four);
+
+#endif
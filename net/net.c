@@ -92,6 +92,7 @@
 #include <miiphy.h>
 #include <status_led.h>
 #endif
+#include <task.h>
 #include <watchdog.h>
 #include <linux/compiler.h>
 #include "arp.h"
@@ -539,6 +540,7 @@ restart:
 	 */
 	for (;;) {
 		WATCHDOG_RESET();
+		task_yield();
 #ifdef CONFIG_SHOW_ACTIVITY
 		show_activity(1);
 #endif
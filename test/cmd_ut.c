@@ -13,15 +13,32 @@ static int do_ut_all(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 static cmd_tbl_t cmd_ut_sub[] = {
 	U_BOOT_CMD_MKENT(all, CONFIG_SYS_MAXARGS, 1, do_ut_all, "", ""),
+#ifdef CONFIG_UT_CPU_WORK
+	U_BOOT_CMD_MKENT(cpu_work, CONFIG_SYS_MAXARGS, 1, do_ut_cpu_work, "",
+			 ""),
+#endif
+#ifdef CONFIG_UT_CRC32
+	U_BOOT_CMD_MKENT(crc32, CONFIG_SYS_MAXARGS, 1, do_ut_crc32, "", ""),
+#endif
 #if defined(CONFIG_UT_DM)
 	U_BOOT_CMD_MKENT(dm, CONFIG_SYS_MAXARGS, 1, do_ut_dm, "", ""),
 #endif
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_UT_FDT_BATCH
+	U_BOOT_CMD_MKENT(fdt_batch, CONFIG_SYS_MAXARGS, 1, do_ut_fdt_batch, "",
+			 ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
+#ifdef CONFIG_UT_SHA512
+	U_BOOT_CMD_MKENT(sha512, CONFIG_SYS_MAXARGS, 1, do_ut_sha512, "", ""),
+#endif
+#ifdef CONFIG_UT_TASK
+	U_BOOT_CMD_MKENT(task, CONFIG_SYS_MAXARGS, 1, do_ut_task, "", ""),
+#endif
 #ifdef CONFIG_UT_TIME
 	U_BOOT_CMD_MKENT(time, CONFIG_SYS_MAXARGS, 1, do_ut_time, "", ""),
 #endif
@@ -65,15 +82,30 @@ static int do_ut(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #ifdef CONFIG_SYS_LONGHELP
 static char ut_help_text[] =
 	"all - execute all enabled tests\n"
+#ifdef CONFIG_UT_CPU_WORK
+	"ut cpu_work - Test running work on secondary CPUs\n"
+#endif
+#ifdef CONFIG_UT_CRC32
+	"ut crc32 - Test and benchmark CRC32 and CRC32C\n"
+#endif
 #ifdef CONFIG_UT_DM
 	"ut dm [test-name]\n"
 #endif
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_UT_FDT_BATCH
+	"ut fdt_batch - Test and benchmark batched FDT edits\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
+#ifdef CONFIG_UT_SHA512
+	"ut sha512 - Test SHA-384 and SHA-512 against known answers\n"
+#endif
+#ifdef CONFIG_UT_TASK
+	"ut task - Test running cooperative tasks\n"
+#endif
 #ifdef CONFIG_UT_TIME
 	"ut time - Very basic test of time functions\n"
 #endif
@@ -12,6 +12,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -117,6 +118,25 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+#ifdef CONFIG_ZSTD
+/* zstd -19 -c /tmp/plain.txt > /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+#endif
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -282,6 +302,90 @@ static int uncompress_using_lz4(void *in, unsigned long in_size,
 	return (ret != 0);
 }
 
+#ifdef CONFIG_ZSTD
+static int compress_using_zstd(void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	assert(in_size == strlen(plain));
+	assert(memcmp(plain, in, in_size) == 0);
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	int ret;
+	size_t output_size = out_max;
+
+	ret = zstd_decompress(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return ret != 0;
+}
+#endif
+
+/* Supplies compressed data to the streaming decompressors in small chunks */
+struct stream_priv {
+	const char *buf;
+	unsigned long left;
+};
+
+#define STREAM_CHUNK_SIZE	16
+
+static long stream_in(void *ctx, const void **bufp)
+{
+	struct stream_priv *priv = ctx;
+	long len = min(priv->left, (unsigned long)STREAM_CHUNK_SIZE);
+
+	*bufp = priv->buf;
+	priv->buf += len;
+	priv->left -= len;
+
+	return len;
+}
+
+static int uncompress_using_gzip_stream(void *in, unsigned long in_size,
+					void *out, unsigned long out_max,
+					unsigned long *out_size)
+{
+	struct stream_priv priv = { in, in_size };
+	unsigned long size;
+	int ret;
+
+	ret = gunzip_stream(out, out_max, stream_in, &priv, &size);
+	if (out_size)
+		*out_size = size;
+
+	return ret;
+}
+
+static int uncompress_using_lz4_stream(void *in, unsigned long in_size,
+				       void *out, unsigned long out_max,
+				       unsigned long *out_size)
+{
+	struct stream_priv priv = { in, in_size };
+	size_t output_size = out_max;
+	int ret;
+
+	ret = ulz4fn_stream(stream_in, &priv, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -371,6 +475,190 @@ out:
 	return ret;
 }
 
+/* Block sizes for the lz4 multi-block test: full, but for the last */
+static const int lz4_block_sizes[] = { 65536, 65536, 65536, 65536, 65536,
+				       1000 };
+
+/*
+ * Write an lz4 block of @size copies of @c: a one-byte literal, a match at
+ * offset 1 for the rest, then the five literals which must end a block
+ */
+static int lz4_fill_block(u8 *p, int c, int size, bool stored)
+{
+	int len, i;
+
+	if (stored) {
+		put_unaligned_le32(size | 0x80000000, p);
+		memset(p + 4, c, size);
+		return 4 + size;
+	}
+	len = 4;
+	p[len++] = 0x1f;
+	p[len++] = c;
+	p[len++] = 1;
+	p[len++] = 0;
+	for (i = size - 1 - 5 - 4 - 15; i >= 255; i -= 255)
+		p[len++] = 255;
+	p[len++] = i;
+	p[len++] = 0x50;
+	memset(p + len, c, 5);
+	len += 5;
+	put_unaligned_le32(len - 4, p);
+
+	return len;
+}
+
+/* Build an lz4 frame with 64KiB blocks and return its size */
+static int lz4_make_frame(u8 *p, const int *sizes, int count, void *plain)
+{
+	int len = 7, i;
+
+	put_unaligned_le32(0x184d2204, p);
+	p[4] = 0x60;	/* version 1, independent blocks */
+	p[5] = 4 << 4;	/* 64KiB maximum block size */
+	p[6] = 0;	/* header checksum, which is not checked */
+	for (i = 0; i < count; i++) {
+		len += lz4_fill_block(p + len, 'a' + i, sizes[i], i % 4 == 3);
+		memset(plain, 'a' + i, sizes[i]);
+		plain += sizes[i];
+	}
+	put_unaligned_le32(0, p + len);
+
+	return len + 4;
+}
+
+/*
+ * Frames with several blocks may be decompressed in parallel. Check that
+ * this gives the same result as decompressing them in order, including when
+ * a block before the last is not full, so that the output is not where
+ * expected.
+ */
+static int run_lz4_blocks_test(void)
+{
+	int sizes[ARRAY_SIZE(lz4_block_sizes)];
+	int count = ARRAY_SIZE(sizes);
+	size_t total = 0, out_size;
+	u8 *frame = NULL;
+	void *plain = NULL, *out = NULL;
+	int i, len, ret;
+
+	printf(" testing lz4 blocks ...\n");
+	memcpy(sizes, lz4_block_sizes, sizeof(sizes));
+	for (i = 0; i < count; i++)
+		total += sizes[i];
+	frame = malloc(total + 1024);
+	errcheck(frame != NULL);
+	plain = malloc(total);
+	errcheck(plain != NULL);
+	out = malloc(total + 1);
+	errcheck(out != NULL);
+
+	len = lz4_make_frame(frame, sizes, count, plain);
+	out_size = total + 1;
+	memset(out, 'A', total + 1);
+	errcheck(ulz4fn(frame, len, out, &out_size) == 0);
+	errcheck(out_size == total);
+	errcheck(memcmp(out, plain, total) == 0);
+	errcheck(((char *)out)[total] == 'A');
+
+	/* Uncompresses with exactly the right size output buffer */
+	out_size = total;
+	errcheck(ulz4fn(frame, len, out, &out_size) == 0);
+	errcheck(out_size == total);
+	errcheck(memcmp(out, plain, total) == 0);
+
+	/* Does not over-run */
+	memset(out, 'A', total + 1);
+	out_size = total - 1;
+	errcheck(ulz4fn(frame, len, out, &out_size) != 0);
+	errcheck(((char *)out)[total - 1] == 'A');
+
+	/* A short block in the middle moves the rest of the output */
+	sizes[2] = 1000;
+	total -= 65536 - 1000;
+	len = lz4_make_frame(frame, sizes, count, plain);
+	out_size = total + 1;
+	errcheck(ulz4fn(frame, len, out, &out_size) == 0);
+	errcheck(out_size == total);
+	errcheck(memcmp(out, plain, total) == 0);
+
+	ret = 0;
+out:
+	printf(" lz4 blocks: %s\n", ret == 0 ? "ok" : "FAILED");
+
+	free(out);
+	free(plain);
+	free(frame);
+
+	return ret;
+}
+
+/*
+ * bzip2 streams with several blocks may be decompressed in parallel. Check
+ * the result, including for a block whose output is far larger than the
+ * block size, which is finished by the boot CPU, and for corrupt streams.
+ */
+static int run_bzip2_blocks_test(void)
+{
+	const uint text_size = 300000, zero_size = 1 << 20;
+	uint plain_size = 2 * text_size + zero_size;
+	char *plain = NULL, *comp = NULL, *out = NULL;
+	uint comp_size, out_size, seed = 1, i;
+	int ret;
+
+	printf(" testing bzip2 blocks ...\n");
+	plain = malloc(plain_size);
+	errcheck(plain != NULL);
+	comp = malloc(plain_size);
+	errcheck(comp != NULL);
+	out = malloc(plain_size + 1);
+	errcheck(out != NULL);
+
+	/* Text which compresses a little, with a long run of zeroes */
+	for (i = 0; i < plain_size; i++) {
+		seed = seed * 1103515245 + 12345;
+		plain[i] = 'a' + (seed >> 16) % 16;
+	}
+	memset(plain + text_size, '\0', zero_size);
+
+	/* Use 100KB blocks, to get several of them */
+	comp_size = plain_size;
+	errcheck(BZ2_bzBuffToBuffCompress(comp, &comp_size, plain, plain_size,
+					  1, 0, 0) == BZ_OK);
+	printf("\tcompressed_size:%u\n", comp_size);
+
+	memset(out, 'A', plain_size + 1);
+	out_size = plain_size + 1;
+	errcheck(BZ2_bzBuffToBuffDecompress(out, &out_size, comp, comp_size,
+					    0, 0) == BZ_OK);
+	errcheck(out_size == plain_size);
+	errcheck(memcmp(out, plain, plain_size) == 0);
+	errcheck(out[plain_size] == 'A');
+
+	/* Does not over-run */
+	memset(out, 'A', plain_size + 1);
+	out_size = plain_size - 1;
+	errcheck(BZ2_bzBuffToBuffDecompress(out, &out_size, comp, comp_size,
+					    0, 0) != BZ_OK);
+	errcheck(out[plain_size - 1] == 'A');
+
+	/* Reports a corrupt block */
+	comp[comp_size / 2] ^= 0x10;
+	out_size = plain_size;
+	errcheck(BZ2_bzBuffToBuffDecompress(out, &out_size, comp, comp_size,
+					    0, 0) != BZ_OK);
+
+	ret = 0;
+out:
+	printf(" bzip2 blocks: %s\n", ret == 0 ? "ok" : "FAILED");
+
+	free(out);
+	free(comp);
+	free(plain);
+
+	return ret;
+}
+
 static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 			     char *const argv[])
 {
@@ -381,6 +669,15 @@ static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
 	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
 	err += run_test("lz4", compress_using_lz4, uncompress_using_lz4);
+#ifdef CONFIG_ZSTD
+	err += run_test("zstd", compress_using_zstd, uncompress_using_zstd);
+#endif
+	err += run_test("gzip_stream", compress_using_gzip,
+			uncompress_using_gzip_stream);
+	err += run_test("lz4_stream", compress_using_lz4,
+			uncompress_using_lz4_stream);
+	err += run_lz4_blocks_test();
+	err += run_bzip2_blocks_test();
 
 	printf("ut_compression %s\n", err == 0 ? "ok" : "FAILED");
 
@@ -458,6 +755,9 @@ static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 	err |= run_bootm_test(IH_COMP_LZMA, compress_using_lzma);
 	err |= run_bootm_test(IH_COMP_LZO, compress_using_lzo);
 	err |= run_bootm_test(IH_COMP_LZ4, compress_using_lz4);
+#ifdef CONFIG_ZSTD
+	err |= run_bootm_test(IH_COMP_ZSTD, compress_using_zstd);
+#endif
 	err |= run_bootm_test(IH_COMP_NONE, compress_using_none);
 
 	printf("ut_image_decomp %s\n", err == 0 ? "ok" : "FAILED");
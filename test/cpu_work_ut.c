@@ -0,0 +1,186 @@
+/*
+ * Tests for running work on secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <cpu_work.h>
+#include <errno.h>
+#include <malloc.h>
+#include <test/suites.h>
+#include <u-boot/crc.h>
+
+#define TEST_JOBS	100
+#define TEST_SLICES	16
+#define TEST_SLICE_SIZE	(1 << 20)
+
+struct test_job {
+	struct cpu_work work;
+	const void *data;
+	uint size;
+	uint32_t crc;
+};
+
+static void test_job_run(void *arg)
+{
+	struct test_job *job = arg;
+
+	job->crc = crc32(0, job->data, job->size);
+}
+
+static void test_job_init(struct test_job *job, const void *data, uint size)
+{
+	job->data = data;
+	job->size = size;
+	job->crc = 0;
+	job->work.func = test_job_run;
+	job->work.arg = job;
+}
+
+/* Check that more work than fits in the queue all gets done, correctly */
+static int test_cpu_work_many(const u8 *buf)
+{
+	struct test_job *jobs;
+	int i, ret = 0;
+
+	jobs = calloc(TEST_JOBS, sizeof(*jobs));
+	if (!jobs)
+		return -ENOMEM;
+	for (i = 0; i < TEST_JOBS; i++) {
+		test_job_init(&jobs[i], buf + i * 1000, 1000 + i);
+		cpu_work_queue(&jobs[i].work);
+	}
+	for (i = TEST_JOBS - 1; i >= 0; i--) {
+		cpu_work_wait(&jobs[i].work);
+		if (jobs[i].crc != crc32(0, buf + i * 1000, 1000 + i)) {
+			printf("%s: job %d has the wrong result\n", __func__,
+			       i);
+			ret = -EINVAL;
+		}
+	}
+	free(jobs);
+
+	return ret;
+}
+
+static void test_cpu_id_run(void *arg)
+{
+	int *ids = arg;
+
+	__atomic_add_fetch(&ids[cpu_work_id()], 1, __ATOMIC_RELAXED);
+}
+
+static void test_cpu_id_one(void *arg)
+{
+	int *id = arg;
+
+	*id = cpu_work_id();
+}
+
+/* Check that work queued for a CPU runs there, and on every CPU */
+static int test_cpu_work_on(void)
+{
+	int ids[CONFIG_CPU_WORK_MAX_CPUS + 1];
+	struct cpu_work work;
+	int cpus, cpu, id;
+	int ret = 0;
+
+	cpus = cpu_work_cpus();
+	if (cpu_work_queue_on(0, &work) != -ENODEV ||
+	    cpu_work_queue_on(cpus + 1, &work) != -ENODEV) {
+		printf("%s: work was queued for a missing CPU\n", __func__);
+		ret = -EINVAL;
+	}
+	for (cpu = 1; cpu <= cpus; cpu++) {
+		id = -1;
+		work.func = test_cpu_id_one;
+		work.arg = &id;
+		if (cpu_work_queue_on(cpu, &work)) {
+			printf("%s: cannot queue work for CPU %d\n", __func__,
+			       cpu);
+			return -EINVAL;
+		}
+		cpu_work_wait(&work);
+		if (id != cpu) {
+			printf("%s: work for CPU %d ran on CPU %d\n", __func__,
+			       cpu, id);
+			ret = -EINVAL;
+		}
+	}
+
+	memset(ids, '\0', sizeof(ids));
+	if (cpu_work_call_all(test_cpu_id_run, ids) != cpus + 1) {
+		printf("%s: wrong number of CPUs called\n", __func__);
+		ret = -EINVAL;
+	}
+	for (cpu = 0; cpu <= cpus; cpu++) {
+		if (ids[cpu] != 1) {
+			printf("%s: CPU %d called %d times\n", __func__, cpu,
+			       ids[cpu]);
+			ret = -EINVAL;
+		}
+	}
+
+	return ret;
+}
+
+/* Compare hashing slices of a buffer one at a time and in parallel */
+static int test_cpu_work_speed(const u8 *buf)
+{
+	struct test_job jobs[TEST_SLICES];
+	uint32_t crc[TEST_SLICES];
+	ulong serial, parallel;
+	int i, ret = 0;
+
+	serial = timer_get_us();
+	for (i = 0; i < TEST_SLICES; i++)
+		crc[i] = crc32(0, buf + i * TEST_SLICE_SIZE, TEST_SLICE_SIZE);
+	serial = timer_get_us() - serial;
+
+	parallel = timer_get_us();
+	for (i = 0; i < TEST_SLICES; i++) {
+		test_job_init(&jobs[i], buf + i * TEST_SLICE_SIZE,
+			      TEST_SLICE_SIZE);
+		cpu_work_queue(&jobs[i].work);
+	}
+	for (i = 0; i < TEST_SLICES; i++)
+		cpu_work_wait(&jobs[i].work);
+	parallel = timer_get_us() - parallel;
+
+	for (i = 0; i < TEST_SLICES; i++) {
+		if (jobs[i].crc != crc[i]) {
+			printf("%s: slice %d has the wrong result\n", __func__,
+			       i);
+			ret = -EINVAL;
+		}
+	}
+	printf("%s: %d MiB on 1 CPU: %lu us, on %d CPUs: %lu us\n", __func__,
+	       TEST_SLICES * TEST_SLICE_SIZE >> 20, serial,
+	       cpu_work_cpus() + 1, parallel);
+
+	return ret;
+}
+
+int do_ut_cpu_work(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	u8 *buf;
+	int ret = 0;
+	int i;
+
+	buf = malloc(TEST_SLICES * TEST_SLICE_SIZE);
+	if (!buf)
+		return CMD_RET_FAILURE;
+	for (i = 0; i < TEST_SLICES * TEST_SLICE_SIZE; i++)
+		buf[i] = i * 7 + (i >> 12);
+
+	ret |= test_cpu_work_many(buf);
+	ret |= test_cpu_work_on();
+	ret |= test_cpu_work_speed(buf);
+	free(buf);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*
+ * Tests and benchmark for CRC32 and CRC32C
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <test/suites.h>
+#include <u-boot/crc.h>
+
+#define TEST_BUF_SIZE	(16 << 20)
+#define TEST_CHECK_SIZE	1024
+
+static const unsigned char test_str[] = "123456789";
+
+/* Calculate a CRC a bit at a time, to check against */
+static uint32_t test_crc_bitwise(uint32_t poly, uint32_t crc,
+				 const unsigned char *buf, uint len)
+{
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *buf++;
+		for (k = 0; k < 8; k++)
+			crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
+	}
+
+	return ~crc;
+}
+
+/* Check the standard check values for each CRC */
+static int test_crc32_check_values(void)
+{
+	uint32_t crc;
+	int ret = 0;
+
+	crc = crc32(0, test_str, 9);
+	if (crc != 0xcbf43926) {
+		printf("%s: crc32 is %08x, expected cbf43926\n", __func__, crc);
+		ret = -EINVAL;
+	}
+	crc = crc32c(0, test_str, 9);
+	if (crc != 0xe3069283) {
+		printf("%s: crc32c is %08x, expected e3069283\n", __func__,
+		       crc);
+		ret = -EINVAL;
+	}
+	crc = crc32c_no_comp(~0, test_str, 9);
+	if (crc != ~0xe3069283) {
+		printf("%s: crc32c_no_comp is %08x, expected %08x\n", __func__,
+		       crc, ~0xe3069283);
+		ret = -EINVAL;
+	}
+
+	return ret;
+}
+
+/*
+ * Check every length and alignment up to a few words, and that a CRC can be
+ * built up in pieces
+ */
+static int test_crc32_lengths(const unsigned char *buf)
+{
+	uint32_t expect, crc;
+	uint start, len;
+
+	for (start = 0; start < 8; start++) {
+		for (len = 0; len < 80; len++) {
+			expect = test_crc_bitwise(0xedb88320, 0, buf + start,
+						  len);
+			crc = crc32(0, buf + start, len);
+			if (crc != expect)
+				goto err;
+			expect = test_crc_bitwise(0x82f63b78, 0, buf + start,
+						  len);
+			crc = crc32c(0, buf + start, len);
+			if (crc != expect)
+				goto err;
+		}
+	}
+
+	expect = crc32(0, buf, TEST_CHECK_SIZE);
+	for (len = 1; len < TEST_CHECK_SIZE; len += 37) {
+		crc = crc32(0, buf, len);
+		crc = crc32(crc, buf + len, TEST_CHECK_SIZE - len);
+		if (crc != expect)
+			goto err;
+	}
+
+	return 0;
+err:
+	printf("%s: start %u len %u: got %08x, expected %08x\n", __func__,
+	       start, len, crc, expect);
+
+	return -EINVAL;
+}
+
+static void test_crc32_speed(const unsigned char *buf)
+{
+	ulong start, crc32_us, crc32c_us;
+
+	start = timer_get_us();
+	crc32(0, buf, TEST_BUF_SIZE);
+	crc32_us = max(timer_get_us() - start, 1UL);
+
+	start = timer_get_us();
+	crc32c(0, buf, TEST_BUF_SIZE);
+	crc32c_us = max(timer_get_us() - start, 1UL);
+
+	printf("%s: %d MiB: crc32 %lu us (%lu MB/s), crc32c %lu us (%lu MB/s)\n",
+	       __func__, TEST_BUF_SIZE >> 20, crc32_us,
+	       TEST_BUF_SIZE / crc32_us, crc32c_us, TEST_BUF_SIZE / crc32c_us);
+}
+
+int do_ut_crc32(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	unsigned char *buf;
+	int ret = 0;
+	int i;
+
+	buf = malloc(TEST_BUF_SIZE);
+	if (!buf)
+		return CMD_RET_FAILURE;
+	for (i = 0; i < TEST_BUF_SIZE; i++)
+		buf[i] = i * 7 + (i >> 12);
+
+	ret |= test_crc32_check_values();
+	ret |= test_crc32_lengths(buf);
+	test_crc32_speed(buf);
+	free(buf);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -82,13 +82,16 @@ static int dm_test_blk_usb(struct unit_test_state *uts)
 	ut_assertok(blk_get_device(IF_TYPE_USB, 0, &dev));
 	ut_asserteq_ptr(usb_dev, dev_get_parent(dev));
 
-	/* Check we have one block device for each mass storage device */
-	ut_asserteq(4, count_blk_devices());
+	/*
+	 * Check we have one block device for each mass storage device, as
+	 * well as one for each MMC device
+	 */
+	ut_asserteq(5, count_blk_devices());
 
 	/* Now go around again, making sure the old devices were unbound */
 	ut_assertok(usb_stop());
 	ut_assertok(usb_init());
-	ut_asserteq(4, count_blk_devices());
+	ut_asserteq(5, count_blk_devices());
 	ut_assertok(usb_stop());
 
 	return 0;
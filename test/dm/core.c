@@ -276,6 +276,40 @@ static int dm_test_platdata(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_platdata, DM_TESTF_SCAN_PDATA);
 
+#if CONFIG_IS_ENABLED(DM_PACK)
+/* Test that a device's data is allocated in one block when bound and probed */
+static int dm_test_pack(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	void *priv;
+
+	/* Only the platform data is allocated with the device */
+	ut_assertok(uclass_find_device(UCLASS_TEST, 0, &dev));
+	ut_assert(dev->flags & DM_FLAG_PACKED);
+	ut_assert(!(dev->flags & DM_FLAG_ALLOC_PDATA));
+	ut_asserteq_ptr((void *)dev + DM_PACK_SIZE(sizeof(*dev)),
+			dev->uclass_platdata);
+	ut_assert(!dev_get_priv(dev));
+	ut_assert(!dev_get_uclass_priv(dev));
+
+	/* The private data is allocated together when it is probed */
+	ut_assertok(device_probe(dev));
+	priv = dev_get_priv(dev);
+	ut_assertnonnull(priv);
+	ut_asserteq_ptr(priv + DM_PACK_SIZE(sizeof(struct dm_test_priv)),
+			dev_get_uclass_priv(dev));
+
+	ut_assertok(device_remove(dev));
+	ut_assert(!dev_get_priv(dev));
+	ut_assert(!dev_get_uclass_priv(dev));
+	ut_assertok(device_probe(dev));
+	ut_assertnonnull(dev_get_priv(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_pack, DM_TESTF_SCAN_PDATA);
+#endif
+
 /* Test that we can bind, probe, remove, unbind a driver */
 static int dm_test_lifecycle(struct unit_test_state *uts)
 {
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <dm.h>
 #include <mmc.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -44,3 +45,82 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Check that the emulated cards are brought up in their fastest modes */
+static int dm_test_mmc_modes(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	struct mmc *mmc;
+
+	/* SD card: 1.8V signalling, 4-bit bus, tuned SDR104 */
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assert(IS_SD(mmc));
+	ut_asserteq(UHS_SDR104, mmc->selected_mode);
+	ut_asserteq(MMC_SIGNAL_VOLTAGE_180, mmc->signal_voltage);
+	ut_asserteq(4, mmc->bus_width);
+	ut_asserteq(0, mmc->ddr_mode);
+	ut_asserteq(208000000, mmc->clock);
+
+	/* eMMC: HS400 reached via tuned HS200 on an 8-bit DDR bus */
+	ut_assertok(uclass_get_device(UCLASS_MMC, 1, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assert(IS_MMC(mmc));
+	ut_asserteq(MMC_HS_400, mmc->selected_mode);
+	ut_asserteq(MMC_SIGNAL_VOLTAGE_180, mmc->signal_voltage);
+	ut_asserteq(8, mmc->bus_width);
+	ut_asserteq(1, mmc->ddr_mode);
+	ut_asserteq(200000000, mmc->clock);
+	ut_asserteq_str("HS400 (200MHz)", mmc_mode_name(mmc->selected_mode));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_modes, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_BLK
+/* Check that multi-block transfers use CMD23 instead of a stop command */
+static int dm_test_mmc_cmd23(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct mmc *mmc;
+	char buf[1024];
+	int sbc, stop;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 1, &dev));
+	ut_asserteq(1, blk_get_device_by_str("mmc", "1", &dev_desc));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assert(mmc->card_caps & MMC_MODE_CMD23);
+
+	sbc = sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT);
+	stop = sandbox_mmc_get_cmd_count(dev, MMC_CMD_STOP_TRANSMISSION);
+	ut_asserteq(2, blk_dread(dev_desc, 0, 2, buf));
+	ut_assertok(strcmp(buf, "this is a test"));
+	ut_asserteq(2, blk_dwrite(dev_desc, 0, 2, buf));
+	ut_asserteq(sbc + 2,
+		    sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+
+	/* Single-block transfers need neither */
+	ut_asserteq(1, blk_dread(dev_desc, 0, 1, buf));
+	ut_asserteq(1, blk_dwrite(dev_desc, 0, 1, buf));
+	ut_asserteq(sbc + 2,
+		    sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+
+	/* A reliable write always goes through CMD23 */
+	ut_assertok(mmc_set_reliable_write(mmc, true));
+	ut_asserteq(1, blk_dwrite(dev_desc, 0, 1, buf));
+	ut_asserteq(sbc + 3,
+		    sandbox_mmc_get_cmd_count(dev, MMC_CMD_SET_BLOCK_COUNT));
+	ut_assertok(mmc_set_reliable_write(mmc, false));
+	ut_asserteq(stop,
+		    sandbox_mmc_get_cmd_count(dev, MMC_CMD_STOP_TRANSMISSION));
+
+	/* SD cards do not support reliable writes */
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_asserteq(-EOPNOTSUPP, mmc_set_reliable_write(mmc, true));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_cmd23, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Tests for probing devices in the background
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+/*
+ * Number of calls to probe() needed, to simulate a slow device, and another
+ * device to wait for on the call numbered @wait_poll
+ */
+struct slow_probe_platdata {
+	int polls;
+	int fail;
+	struct udevice *wait_for;
+	int wait_poll;
+	int wait_ret;
+};
+
+struct slow_probe_priv {
+	int polls;
+};
+
+static int slow_probe_probe(struct udevice *dev)
+{
+	struct slow_probe_platdata *plat = dev_get_platdata(dev);
+	struct slow_probe_priv *priv = dev_get_priv(dev);
+
+	if (++priv->polls == plat->wait_poll)
+		plat->wait_ret = device_probe(plat->wait_for);
+	if (priv->polls < plat->polls)
+		return -EINPROGRESS;
+
+	return plat->fail;
+}
+
+U_BOOT_DRIVER(test_slow_probe) = {
+	.name	= "test_slow_probe",
+	.id	= UCLASS_TEST,
+	.probe	= slow_probe_probe,
+	.priv_auto_alloc_size = sizeof(struct slow_probe_priv),
+	.flags	= DM_FLAG_PROBE_ASYNC,
+};
+
+static int bind_slow(struct unit_test_state *uts, const char *name,
+		     struct slow_probe_platdata *plat, struct udevice **devp)
+{
+	struct dm_test_state *dms = uts->priv;
+
+	dms->skip_post_probe = 1;
+	ut_assertok(device_bind(dms->root,
+				lists_driver_lookup_name("test_slow_probe"),
+				name, plat, -1, devp));
+
+	return 0;
+}
+
+static int get_polls(struct udevice *dev)
+{
+	struct slow_probe_priv *priv = dev_get_priv(dev);
+
+	return priv->polls;
+}
+
+/* Test that slow devices probe together, and that users wait for them */
+static int dm_test_probe_async(struct unit_test_state *uts)
+{
+	struct slow_probe_platdata plat_a = { .polls = 3 };
+	struct slow_probe_platdata plat_b = { .polls = 5 };
+	struct udevice *a, *b;
+
+	ut_assertok(bind_slow(uts, "slow-a", &plat_a, &a));
+	ut_assertok(bind_slow(uts, "slow-b", &plat_b, &b));
+
+	ut_assertok(device_probe_async(a));
+	ut_assertok(device_probe_async(b));
+	ut_assert(a->flags & DM_FLAG_PROBING);
+	ut_assert(!device_active(a));
+	ut_asserteq(1, get_polls(a));
+	ut_asserteq(1, get_polls(b));
+
+	/* Waiting for one device lets the other one progress too */
+	ut_assertok(device_probe(a));
+	ut_assert(device_active(a));
+	ut_asserteq(3, get_polls(a));
+	ut_asserteq(2, get_polls(b));
+	ut_assert(b->flags & DM_FLAG_PROBING);
+
+	dm_probe_poll();
+	dm_probe_poll();
+	ut_asserteq(4, get_polls(b));
+	ut_assert(!device_active(b));
+	dm_probe_poll();
+	ut_asserteq(5, get_polls(b));
+	ut_assert(device_active(b));
+
+	/* Nothing is left to poll */
+	dm_probe_poll();
+	ut_asserteq(3, get_polls(a));
+	ut_asserteq(5, get_polls(b));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async, 0);
+
+/* Test removing a device before it finishes probing, and failures */
+static int dm_test_probe_async_remove(struct unit_test_state *uts)
+{
+	struct slow_probe_platdata plat_a = { .polls = 3 };
+	struct slow_probe_platdata plat_b = { .polls = 2, .fail = -EIO };
+	struct udevice *a, *b;
+
+	ut_assertok(bind_slow(uts, "slow-a", &plat_a, &a));
+	ut_assertok(bind_slow(uts, "slow-b", &plat_b, &b));
+
+	ut_assertok(device_probe_async(a));
+	ut_assertok(device_remove(a));
+	ut_assert(!(a->flags & (DM_FLAG_PROBING | DM_FLAG_ACTIVATED)));
+	dm_probe_poll();
+
+	/* Probing starts again from the beginning */
+	ut_assertok(device_probe_async(a));
+	ut_asserteq(1, get_polls(a));
+
+	ut_assertok(device_probe_async(b));
+	ut_asserteq(-EIO, device_probe(b));
+	ut_assert(!(b->flags & (DM_FLAG_PROBING | DM_FLAG_ACTIVATED)));
+
+	ut_assertok(device_probe(a));
+	ut_assert(device_active(a));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_remove, 0);
+
+/* Test that a device is probed once when another device's probe() waits too */
+static int dm_test_probe_async_nested(struct unit_test_state *uts)
+{
+	struct slow_probe_platdata plat_a = { .polls = 3 };
+	struct slow_probe_platdata plat_b = { .polls = 5, .wait_poll = 2 };
+	struct slow_probe_platdata plat_c = { .polls = 3, .fail = -EIO };
+	struct slow_probe_platdata plat_d = { .polls = 5, .wait_poll = 2 };
+	struct udevice *a, *b, *c, *d;
+
+	ut_assertok(bind_slow(uts, "slow-a", &plat_a, &a));
+	ut_assertok(bind_slow(uts, "slow-b", &plat_b, &b));
+	plat_b.wait_for = a;
+
+	/* Polling b while waiting for a makes b wait for a, which finishes */
+	ut_assertok(device_probe_async(a));
+	ut_assertok(device_probe_async(b));
+	ut_assertok(device_probe(a));
+	ut_assert(device_active(a));
+	ut_asserteq(3, get_polls(a));
+	ut_asserteq(0, plat_b.wait_ret);
+	ut_assertok(device_probe(b));
+	ut_asserteq(5, get_polls(b));
+
+	/* The same, with a device which fails to probe */
+	ut_assertok(bind_slow(uts, "slow-c", &plat_c, &c));
+	ut_assertok(bind_slow(uts, "slow-d", &plat_d, &d));
+	plat_d.wait_for = c;
+	ut_assertok(device_probe_async(c));
+	ut_assertok(device_probe_async(d));
+	ut_asserteq(-EIO, device_probe(c));
+	ut_asserteq(-EIO, plat_d.wait_ret);
+	ut_assert(!(c->flags & (DM_FLAG_PROBING | DM_FLAG_ACTIVATED)));
+	ut_assertok(device_probe(d));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_nested, 0);
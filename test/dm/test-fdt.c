@@ -10,6 +10,7 @@
 #include <fdtdec.h>
 #include <malloc.h>
 #include <asm/io.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
 #include <dm/root.h>
 #include <dm/uclass-internal.h>
@@ -238,6 +239,47 @@ static int dm_test_fdt_uclass_seq(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_fdt_uclass_seq, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test that sequence numbers are found again after removing devices */
+static int dm_test_fdt_uclass_seq_remove(struct unit_test_state *uts)
+{
+	struct udevice *dev, *found;
+	struct uclass *uc;
+
+	ut_assertok(uclass_get(UCLASS_TEST_FDT, &uc));
+	ut_asserteq_ptr(uc, uclass_find(UCLASS_TEST_FDT));
+
+	/* a-test asks for seq 8 */
+	ut_assertok(uclass_get_device_by_seq(UCLASS_TEST_FDT, 8, &dev));
+	ut_asserteq_str("a-test", dev->name);
+	ut_asserteq_ptr(uc, dev->uclass);
+
+	for (uclass_first_device(UCLASS_TEST_FDT, &dev);
+	     dev;
+	     uclass_next_device(&dev)) {
+		ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT,
+						      dev->seq, false,
+						      &found));
+		ut_asserteq_ptr(dev, found);
+	}
+
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, 8, false,
+					      &dev));
+	ut_assertok(device_remove(dev));
+	ut_asserteq(-1, dev->seq);
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST_FDT, 8,
+						       false, &found));
+
+	ut_assertok(device_probe(dev));
+	ut_asserteq(8, dev->seq);
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, 8, false,
+					      &found));
+	ut_asserteq_ptr(dev, found);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_uclass_seq_remove,
+	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* Test that we can find a device by device tree offset */
 static int dm_test_fdt_offset(struct unit_test_state *uts)
 {
@@ -266,3 +308,127 @@ static int dm_test_fdt_offset(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fdt_offset, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that cached phandle and path lookups match libfdt */
+static int dm_test_fdt_cache(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	int size = fdt_totalsize(blob);
+	uint32_t phandle, last = 0;
+	int node, found, ret;
+	void *copy;
+
+	/* Every node with a phandle, then some phandles which are missing */
+	for (node = fdt_next_node(blob, -1, NULL); node >= 0;
+	     node = fdt_next_node(blob, node, NULL)) {
+		phandle = fdt_get_phandle(blob, node);
+		if (!phandle)
+			continue;
+		ut_asserteq(node, fdtdec_node_offset_by_phandle(blob, phandle));
+		last = phandle;
+	}
+	ut_assert(last);
+	ut_asserteq(fdt_node_offset_by_phandle(blob, 0),
+		    fdtdec_node_offset_by_phandle(blob, 0));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_phandle(blob, 0x7fffffff));
+
+	/* Paths and aliases, twice so that the second comes from the cache */
+	for (node = 0; node < 2; node++) {
+		ut_asserteq(fdt_path_offset(blob, "/some-bus/c-test@5"),
+			    fdtdec_path_offset(blob, "/some-bus/c-test@5"));
+		ut_asserteq(fdt_path_offset(blob, "/e-test"),
+			    fdtdec_path_offset(blob, "testfdt6"));
+		ut_asserteq(-FDT_ERR_NOTFOUND,
+			    fdtdec_path_offset(blob, "/no-such-node"));
+	}
+
+	/* Changing a phandle in place needs the cache to be invalidated */
+	copy = malloc(size);
+	ut_assertnonnull(copy);
+	memcpy(copy, blob, size);
+	gd->fdt_blob = copy;
+	node = fdtdec_node_offset_by_phandle(copy, last);
+	ret = fdt_setprop_inplace_u32(copy, node, "phandle", 0x7fffffff);
+	fdtdec_cache_invalidate();
+	found = fdtdec_node_offset_by_phandle(copy, 0x7fffffff);
+	gd->fdt_blob = blob;
+	free(copy);
+	ut_assertok(ret);
+	ut_asserteq(node, found);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_cache, 0);
+
+/* Test that the ofnode functions read the same tree as libfdt */
+static int dm_test_fdt_ofnode(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	const void *val, *live_val;
+	int offset, poffset, sub;
+	const char *name;
+	int len, live_len;
+	ofnode node, subnode;
+
+	ut_asserteq(IS_ENABLED(CONFIG_OF_LIVE), of_live_active());
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		node = offset_to_ofnode(offset);
+		ut_assert(ofnode_valid(node));
+		ut_asserteq(offset, ofnode_to_offset(node));
+		ut_asserteq_str(fdt_get_name(blob, offset, NULL),
+				ofnode_get_name(node));
+
+		fdt_for_each_property_offset(poffset, blob, offset) {
+			val = fdt_getprop_by_offset(blob, poffset, &name, &len);
+			live_val = ofnode_get_property(node, name, &live_len);
+			ut_asserteq_ptr(val, live_val);
+			ut_asserteq(len, live_len);
+		}
+		ut_asserteq_ptr(NULL, ofnode_get_property(node, "no-such-prop",
+							  &len));
+		ut_asserteq(-FDT_ERR_NOTFOUND, len);
+
+		sub = fdt_first_subnode(blob, offset);
+		ofnode_for_each_subnode(subnode, node) {
+			ut_asserteq(sub, ofnode_to_offset(subnode));
+			sub = fdt_next_subnode(blob, sub);
+		}
+		ut_assert(sub < 0);
+	}
+	if (of_live_active())
+		ut_assert(!ofnode_valid(offset_to_ofnode(1)));
+
+	node = ofnode_path("/e-test");
+	ut_asserteq(fdt_path_offset(blob, "/e-test"), ofnode_to_offset(node));
+	ut_asserteq(6, ofnode_read_u32_default(node, "ping-add", 5));
+	ut_asserteq(5, ofnode_read_u32_default(node, "no-such-prop", 5));
+	ut_asserteq_str("google,another-fdt-test",
+			ofnode_read_string(node, "compatible"));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_ofnode, 0);
+
+#ifdef CONFIG_OF_LIVE
+/* Test that nodes are read from the flat tree once the live tree is dropped */
+static int dm_test_fdt_live_drop(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	ofnode node;
+
+	of_live_drop();
+	ut_assert(!of_live_active());
+	node = ofnode_path("/e-test");
+	ut_asserteq(fdt_path_offset(blob, "/e-test"), ofnode_to_offset(node));
+	ut_asserteq(6, ofnode_read_u32_default(node, "ping-add", 5));
+
+	/* Put it back for the tests which follow */
+	ut_assertok(of_live_build(blob, &gd->of_root));
+	ut_assert(of_live_active());
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_live_drop, 0);
+#endif
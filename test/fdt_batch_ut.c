@@ -0,0 +1,354 @@
+/*
+ * Tests for batched FDT edits
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <test/suites.h>
+
+#define TEST_FDT_SIZE	0x1000
+#define TEST_RSV_SIZE	0x100
+#define TEST_BIG_NODES	1000
+#define TEST_BIG_SIZE	(TEST_BIG_NODES * 256)
+
+enum {
+	EDIT_SET,
+	EDIT_DEL,
+	EDIT_NODE,
+	EDIT_RSV_ADD,
+	EDIT_RSV_DEL,
+};
+
+/**
+ * struct test_edit - An edit to make both directly and in a batch
+ *
+ * @op:		Operation (EDIT_...)
+ * @path:	Path of the node to edit
+ * @name:	Name of the property, or of the subnode to add
+ * @val:	String value of the property
+ * @addr:	Address of the memory reserve map entry
+ */
+struct test_edit {
+	int op;
+	const char *path;
+	const char *name;
+	const char *val;
+	u64 addr;
+};
+
+/* Edits which exercise the ordering rules libfdt follows */
+static const struct test_edit test_edits[] = {
+	{ EDIT_SET, "/", "model", "test-board" },
+	{ EDIT_NODE, "/", "chosen" },
+	{ EDIT_SET, "/chosen", "bootargs", "console=ttyS0" },
+	{ EDIT_SET, "/node@1", "compatible", "vendor,a-longer-compatible" },
+	{ EDIT_SET, "/node@1", "status", "fail" },
+	{ EDIT_DEL, "/node@2", "status" },
+	{ EDIT_SET, "/node@2", "new-prop", "two" },
+	{ EDIT_DEL, "/node@1", "label" },
+	{ EDIT_NODE, "/node@1", "sub-a" },
+	{ EDIT_SET, "/node@1/sub-a", "new-prop", "a" },
+	{ EDIT_SET, "/node@1", "label", "again" },
+	{ EDIT_NODE, "/node@1", "sub-b" },
+	{ EDIT_NODE, "/node@1/sub-a", "deep" },
+	{ EDIT_SET, "/node@1/sub-a/deep", "compatible", "deep" },
+	{ EDIT_SET, "/node@1/sub-a", "new-prop", "a-longer-value" },
+	{ EDIT_DEL, "/node@2", "new-prop" },
+	{ EDIT_SET, "/node@2", "new-prop", "2" },
+	{ EDIT_SET, "/chosen", "stdout-path", "serial0" },
+	{ EDIT_RSV_DEL, .addr = 0x1000 },
+	{ EDIT_RSV_ADD, .addr = 0x3000 },
+	{ EDIT_RSV_ADD, .addr = 0x1000 },
+};
+
+/* A batch this small is made one edit at a time */
+static const struct test_edit test_small_edits[] = {
+	{ EDIT_NODE, "/node@2", "extra" },
+	{ EDIT_NODE, "/node@2/extra", "inner" },
+};
+
+static int test_fdt_base(void *fdt)
+{
+	char name[20];
+	int node, ret, i;
+
+	ret = fdt_create_empty_tree(fdt, TEST_FDT_SIZE);
+	ret |= fdt_setprop_string(fdt, 0, "compatible", "test");
+	for (i = 1; i <= 2; i++) {
+		sprintf(name, "node@%d", i);
+		node = fdt_add_subnode(fdt, 0, name);
+		if (node < 0)
+			return node;
+		ret |= fdt_setprop_string(fdt, node, "compatible",
+					  "vendor,node");
+		ret |= fdt_setprop_string(fdt, node, "status", "okay");
+		ret |= fdt_setprop_string(fdt, node, "label", name);
+		ret |= fdt_setprop_string(fdt, node, "removed", "yes");
+		ret |= fdt_nop_property(fdt, node, "removed");
+		ret |= fdt_add_subnode(fdt, node, "child") < 0;
+	}
+	ret |= fdt_add_mem_rsv(fdt, 0x1000, TEST_RSV_SIZE);
+	ret |= fdt_add_mem_rsv(fdt, 0x2000, TEST_RSV_SIZE);
+
+	return ret ? -EINVAL : 0;
+}
+
+static int test_edit_direct(void *fdt, const struct test_edit *edit)
+{
+	uint64_t addr, size;
+	int node, i;
+
+	switch (edit->op) {
+	case EDIT_RSV_ADD:
+		return fdt_add_mem_rsv(fdt, edit->addr, TEST_RSV_SIZE);
+	case EDIT_RSV_DEL:
+		for (i = 0; i < fdt_num_mem_rsv(fdt); i++) {
+			fdt_get_mem_rsv(fdt, i, &addr, &size);
+			if (addr == edit->addr)
+				return fdt_del_mem_rsv(fdt, i);
+		}
+		return 0;
+	}
+
+	node = fdt_path_offset(fdt, edit->path);
+	if (node < 0)
+		return node;
+	switch (edit->op) {
+	case EDIT_SET:
+		return fdt_setprop_string(fdt, node, edit->name, edit->val);
+	case EDIT_DEL:
+		return fdt_delprop(fdt, node, edit->name);
+	default:
+		node = fdt_add_subnode(fdt, node, edit->name);
+		return node < 0 ? node : 0;
+	}
+}
+
+static int test_edit_batch(struct fdt_batch *batch,
+			   const struct test_edit *edit)
+{
+	char path[64], *rest, *name;
+	int node;
+
+	switch (edit->op) {
+	case EDIT_RSV_ADD:
+		return fdt_batch_add_mem_rsv(batch, edit->addr, TEST_RSV_SIZE);
+	case EDIT_RSV_DEL:
+		return fdt_batch_del_mem_rsv(batch, edit->addr);
+	}
+
+	/* The node may only exist in the batch, so find it from the root */
+	node = fdt_batch_node(batch, 0);
+	strcpy(path, edit->path);
+	rest = path + 1;
+	while ((name = strsep(&rest, "/")) && *name)
+		node = fdt_batch_subnode(batch, node, name);
+	switch (edit->op) {
+	case EDIT_SET:
+		return fdt_batch_setprop_string(batch, node, edit->name,
+						edit->val);
+	case EDIT_DEL:
+		return fdt_batch_delprop(batch, node, edit->name);
+	default:
+		node = fdt_batch_subnode(batch, node, edit->name);
+		return node < 0 ? node : 0;
+	}
+}
+
+/*
+ * libfdt leaves old bytes in the padding after a property value, where a
+ * batch writes zeroes, so clear the padding before comparing trees.
+ */
+static void test_fdt_clear_padding(void *fdt)
+{
+	const struct fdt_property *prop;
+	int offset, next, end;
+	uint32_t tag;
+
+	for (offset = 0; ; offset = next) {
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (tag == FDT_END)
+			break;
+		if (tag != FDT_PROP)
+			continue;
+		prop = fdt_offset_ptr(fdt, offset, sizeof(*prop));
+		end = offset + sizeof(*prop) + fdt32_to_cpu(prop->len);
+		memset(fdt + fdt_off_dt_struct(fdt) + end, '\0', next - end);
+	}
+}
+
+static int test_fdt_compare(const char *what, void *expect, void *fdt)
+{
+	int len = fdt_off_dt_strings(expect) + fdt_size_dt_strings(expect);
+
+	test_fdt_clear_padding(expect);
+	test_fdt_clear_padding(fdt);
+	if (fdt_totalsize(fdt) != fdt_totalsize(expect) ||
+	    fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt) != len ||
+	    memcmp(fdt, expect, len)) {
+		printf("%s: %s: batch does not match single edits\n", __func__,
+		       what);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Check that a batch gives the same tree as making its edits directly */
+static int test_fdt_batch_edits(const char *what,
+				const struct test_edit *edits, int count)
+{
+	char expect[TEST_FDT_SIZE], fdt[TEST_FDT_SIZE];
+	struct fdt_batch batch;
+	int ret, i;
+
+	ret = test_fdt_base(expect);
+	if (ret)
+		return ret;
+	memcpy(fdt, expect, TEST_FDT_SIZE);
+
+	fdt_batch_init(&batch, fdt);
+	for (i = 0; i < count; i++) {
+		ret = test_edit_direct(expect, &edits[i]);
+		if (!ret)
+			ret = test_edit_batch(&batch, &edits[i]);
+		if (ret) {
+			printf("%s: %s: edit %d failed: %s\n", __func__, what,
+			       i, fdt_strerror(ret));
+			fdt_batch_abort(&batch);
+			return -EINVAL;
+		}
+	}
+	ret = fdt_batch_commit(&batch);
+	if (ret) {
+		printf("%s: %s: commit failed: %s\n", __func__, what,
+		       fdt_strerror(ret));
+		return -EINVAL;
+	}
+
+	return test_fdt_compare(what, expect, fdt);
+}
+
+/* Check that an error leaves the tree as it was */
+static int test_fdt_batch_nospace(void)
+{
+	char expect[TEST_FDT_SIZE], fdt[TEST_FDT_SIZE];
+	char big[TEST_FDT_SIZE];
+	struct fdt_batch batch;
+	int ret, i;
+
+	ret = test_fdt_base(expect);
+	if (ret)
+		return ret;
+	memcpy(fdt, expect, TEST_FDT_SIZE);
+	memset(big, 'x', sizeof(big));
+
+	fdt_batch_init(&batch, fdt);
+	for (i = 0; i < ARRAY_SIZE(test_edits); i++)
+		test_edit_batch(&batch, &test_edits[i]);
+	fdt_batch_setprop(&batch, fdt_batch_node(&batch, 0), "big", big,
+			  sizeof(big));
+	ret = fdt_batch_commit(&batch);
+	if (ret != -FDT_ERR_NOSPACE) {
+		printf("%s: expected %s, got %s\n", __func__,
+		       fdt_strerror(-FDT_ERR_NOSPACE), fdt_strerror(ret));
+		return -EINVAL;
+	}
+
+	return test_fdt_compare(__func__, expect, fdt);
+}
+
+static int test_fdt_big(void *fdt)
+{
+	char name[20];
+	int node, ret, i;
+
+	ret = fdt_create_empty_tree(fdt, TEST_BIG_SIZE);
+	for (i = TEST_BIG_NODES - 1; i >= 0; i--) {
+		sprintf(name, "node@%x", i);
+		node = fdt_add_subnode(fdt, 0, name);
+		if (node < 0)
+			return node;
+		ret |= fdt_setprop_string(fdt, node, "compatible",
+					  "vendor,node");
+		ret |= fdt_setprop_u32(fdt, node, "reg", i);
+	}
+
+	return ret ? -EINVAL : 0;
+}
+
+/* Compare the time taken for many edits to a large tree */
+static int test_fdt_batch_speed(void)
+{
+	struct fdt_batch batch;
+	ulong single, batched;
+	void *expect, *fdt;
+	int node, ret, i;
+
+	expect = malloc(TEST_BIG_SIZE);
+	fdt = malloc(TEST_BIG_SIZE);
+	ret = -ENOMEM;
+	if (!expect || !fdt)
+		goto out;
+	ret = test_fdt_big(expect);
+	if (ret)
+		goto out;
+	memcpy(fdt, expect, TEST_BIG_SIZE);
+
+	i = 0;
+	single = timer_get_us();
+	fdt_for_each_subnode(expect, node, 0) {
+		ret = fdt_setprop_string(expect, node, "status", "okay");
+		ret |= fdt_setprop_u64(expect, node, "reg", i++);
+		if (ret)
+			goto out;
+	}
+	single = timer_get_us() - single;
+
+	i = 0;
+	batched = timer_get_us();
+	fdt_batch_init(&batch, fdt);
+	fdt_for_each_subnode(fdt, node, 0) {
+		fdt_batch_setprop_string(&batch, fdt_batch_node(&batch, node),
+					 "status", "okay");
+		fdt_batch_setprop_u64(&batch, fdt_batch_node(&batch, node),
+				      "reg", i++);
+	}
+	ret = fdt_batch_commit(&batch);
+	batched = timer_get_us() - batched;
+	if (ret)
+		goto out;
+
+	printf("%s: %d edits to a %d-byte tree: one by one: %lu us, in a batch: %lu us\n",
+	       __func__, TEST_BIG_NODES * 2, fdt_totalsize(fdt), single,
+	       batched);
+	ret = test_fdt_compare(__func__, expect, fdt);
+out:
+	if (ret)
+		printf("%s: failed: %d\n", __func__, ret);
+	free(fdt);
+	free(expect);
+
+	return ret;
+}
+
+int do_ut_fdt_batch(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret = 0;
+
+	ret |= test_fdt_batch_edits("rewrite", test_edits,
+				    ARRAY_SIZE(test_edits));
+	ret |= test_fdt_batch_edits("single", test_small_edits,
+				    ARRAY_SIZE(test_small_edits));
+	ret |= test_fdt_batch_nospace();
+	ret |= test_fdt_batch_speed();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
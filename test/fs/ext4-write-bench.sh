@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# SPDX-License-Identifier:	GPL-2.0+
+
+# This script measures the speed of U-Boot's ext4 write support, using a
+# sandbox host file as the block device.
+#
+# Writes used to allocate a file one block at a time through indirect
+# blocks, and write back every block and inode bitmap in the filesystem.
+# On filesystems with the extents feature, files are now allocated in
+# contiguous runs described by extents. This benchmark exercises those
+# paths: a large file, the same file overwritten, and a batch of small files
+# followed by another large file.
+#
+# To execute the benchmark, simply run it from the U-Boot source root
+# directory:
+#
+#    cd u-boot
+#    ./test/fs/ext4-write-bench.sh
+#
+# The file size (in MiB) and block size (in bytes) can be changed with the
+# SIZE_MB and BLOCK_SIZE environment variables. The file, and a second copy
+# used to check it, must fit in sandbox RAM.
+#
+# The output lists the time taken by each write, then PASS or FAILURE
+# depending on whether the large file read back matches what was written,
+# and the result of checking the filesystem with e2fsck.
+#
+# All temporary files used by this script are created in ./sandbox to avoid
+# polluting the source tree, as with test/fs/fat-noncontig-test.sh
+
+odir=sandbox
+img=${odir}/ext4-write-bench.img
+data=${odir}/ext4-write-bench.bin
+size_mb=${SIZE_MB:-32}
+block_size=${BLOCK_SIZE:-4096}
+srcaddr=1000000
+readaddr=3000000
+
+for prereq in fallocate mkfs.ext4 e2fsck dd; do
+    if [ ! -x "`which $prereq`" ]; then
+        echo "Missing $prereq binary. Exiting!"
+        exit 1
+    fi
+done
+
+make O=${odir} -s sandbox_defconfig && make O=${odir} -s -j8
+
+rm -f ${img}
+fallocate -l 512M ${img}
+if [ $? -ne 0 ]; then
+    echo fallocate failed - using dd instead
+    dd if=/dev/zero of=${img} bs=1024 count=$((512 * 1024))
+    if [ $? -ne 0 ]; then
+        echo Could not create empty disk image
+        exit $?
+    fi
+fi
+# U-Boot does not support 64-bit block numbers or metadata checksums
+mkfs.ext4 -q -F -b ${block_size} -O ^64bit,^metadata_csum ${img}
+if [ $? -ne 0 ]; then
+    echo Could not create ext4 filesystem
+    exit $?
+fi
+
+dd if=/dev/urandom of=${data} bs=1M count=${size_mb} >/dev/null 2>&1
+
+./${odir}/u-boot -c "
+host bind 0 ${img};
+load hostfs - ${srcaddr} ${data};
+echo large file:;
+save host 0:0 ${srcaddr} /large.bin \$filesize;
+echo overwrite:;
+save host 0:0 ${srcaddr} /large.bin \$filesize;
+echo small files:;
+for i in 0 1 2 3 4 5 6 7 8 9 a b c d e f; do
+    save host 0:0 ${srcaddr} /small\$i.bin 3000;
+done;
+echo large file after small files:;
+save host 0:0 ${srcaddr} /large2.bin \$filesize;
+load host 0:0 ${readaddr} /large2.bin;
+if cmp.b ${srcaddr} ${readaddr} \$filesize; then echo PASS;
+else echo FAILURE; fi
+" | grep -e "^[a-z ]*:" -e "written in" -e PASS -e FAILURE
+
+e2fsck -fn ${img}
@@ -0,0 +1,94 @@
+#!/bin/bash
+
+# SPDX-License-Identifier:	GPL-2.0+
+
+# This script measures the speed of U-Boot's gzip decompression (inflate),
+# using sandbox and the 'unzip' command on real images, such as kernels.
+#
+# Most of the time is spent in inflate_fast(), which now refills its bit
+# buffer a word at a time and copies matches a word at a time. To measure
+# the difference, set BASE to a git revision: a second sandbox is then built
+# from the committed tree with lib/zlib taken from that revision, and both
+# are timed on the same images.
+#
+# To execute the benchmark, run it from the U-Boot source root directory,
+# giving one or more images, compressed with gzip or not (in which case they
+# are compressed with gzip -9 first):
+#
+#    cd u-boot
+#    BASE=v2016.09 ./test/gunzip-bench.sh /boot/vmlinuz-* Image
+#
+# Each image is decompressed REPEAT times (default 5) and the best time is
+# reported, with PASS or FAILURE depending on whether the CRC32 of the output
+# matches the one in the gzip trailer. The uncompressed image must fit in
+# sandbox RAM above 32MiB.
+#
+# All temporary files used by this script are created in ./sandbox to avoid
+# polluting the source tree, as with test/fs/fat-noncontig-test.sh
+
+odir=sandbox
+base_odir=sandbox-gunzip-base
+repeat=${REPEAT:-5}
+srcaddr=100000
+dstaddr=2000000
+
+if [ $# -eq 0 ]; then
+    echo "Usage: [BASE=<rev>] [REPEAT=<n>] $0 <image>..."
+    exit 1
+fi
+
+for prereq in gzip od; do
+    if [ ! -x "`which $prereq`" ]; then
+        echo "Missing $prereq binary. Exiting!"
+        exit 1
+    fi
+done
+
+make O=${odir} -s sandbox_defconfig && make O=${odir} -s -j8 || exit 1
+ubs=./${odir}/u-boot
+
+if [ -n "${BASE}" ]; then
+    src=${odir}/gunzip-base-src
+    rm -rf ${src} && mkdir -p ${src}
+    git archive HEAD | tar -x -C ${src} &&
+        git archive ${BASE} lib/zlib | tar -x -C ${src} || exit 1
+    make -C ${src} O=$(pwd)/${base_odir} -s sandbox_defconfig &&
+        make -C ${src} O=$(pwd)/${base_odir} -s -j8 || exit 1
+    ubs="./${base_odir}/u-boot ${ubs}"
+fi
+
+# Print the best time in seconds from the output of several 'time' commands
+best_time() {
+    grep "^time:" | awk '{ if (min == "" || $2 < min) min = $2 } END { print min }'
+}
+
+for image in "$@"; do
+    name=$(basename ${image})
+    if [ "$(od -An -tx1 -N2 ${image} | tr -d ' ')" = "1f8b" ]; then
+        gz=${image}
+    else
+        gz=${odir}/${name}.gz
+        gzip -9 -c ${image} > ${gz}
+    fi
+    # The gzip trailer holds the CRC32 and size of the uncompressed data
+    crc=$(od -An -tx4 -j $(($(stat -c %s ${gz}) - 8)) -N4 ${gz} | tr -d ' ')
+    size=$(od -An -tu4 -j $(($(stat -c %s ${gz}) - 4)) -N4 ${gz} | tr -d ' ')
+
+    for ub in ${ubs}; do
+        out=$(${ub} -c "
+load hostfs - ${srcaddr} ${gz};
+for i in $(seq -s ' ' ${repeat}); do
+    time unzip ${srcaddr} ${dstaddr};
+done;
+crc32 ${dstaddr} \${filesize}
+")
+        secs=$(echo "${out}" | best_time)
+        mbs=$(awk "BEGIN { if (${secs} > 0) printf \"%d\", ${size} / ${secs} / 1000000 }")
+        if echo "${out}" | grep -q "==> ${crc}"; then
+            result=PASS
+        else
+            result=FAILURE
+        fi
+        echo "${ub}: ${name}: ${size} bytes in ${secs}s (${mbs:-?} MB/s) ${result}"
+    done
+done
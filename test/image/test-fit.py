@@ -13,6 +13,7 @@
 # ./test/image/test-fit.py -u sandbox/u-boot
 
 import doctest
+import gzip
 from optparse import OptionParser
 import os
 import shutil
@@ -44,9 +45,10 @@ base_its = '''
                         type = "kernel";
                         arch = "sandbox";
                         os = "linux";
-                        compression = "none";
+                        compression = "%(kernel_comp)s";
                         load = <0x40000>;
                         entry = <0x8>;
+                        %(kernel_hash)s
                 };
                 kernel@2 {
                         data = /incbin/("%(loadables1)s");
@@ -229,6 +231,20 @@ def make_kernel(filename, text):
         print >>fd, data
     return fname
 
+def make_gzip(filename, src):
+    """Make a gzip-compressed copy of a file
+
+    Args:
+        filename: the name of the file you want to create
+        src: the file to compress
+    Returns:
+        Full path and filename of the file it created
+    """
+    fname = make_fname(filename)
+    with gzip.open(fname, 'wb') as fd:
+        fd.write(read_file(src))
+    return fname
+
 def make_ramdisk(filename, text):
     """Make a sample ramdisk with test data
 
@@ -343,6 +359,8 @@ def run_fit_test(mkimage, u_boot):
         'kernel_out' : kernel_out,
         'kernel_addr' : 0x40000,
         'kernel_size' : filesize(kernel),
+        'kernel_comp' : 'none',
+        'kernel_hash' : '',
 
         'fdt_out' : fdt_out,
         'fdt_addr' : 0x80000,
@@ -436,6 +454,38 @@ def run_fit_test(mkimage, u_boot):
     if read_file(loadables2) != read_file(loadables2_out):
         fail('Loadables2 (ramdisk) not loaded', stdout)
 
+    # A compressed kernel with hashes, which are checked as it is
+    # decompressed when CONFIG_FIT_STREAM_VERIFY is enabled
+    set_test('Compressed kernel with hashes')
+    params['loadables_config'] = ''
+    params['kernel'] = make_gzip('test-kernel.bin.gz', kernel)
+    params['kernel_comp'] = 'gzip'
+    params['kernel_hash'] = '''hash@1 {
+                                algo = "sha1";
+                        };
+                        hash@2 {
+                                algo = "crc32";
+                        };'''
+    fit = make_fit(mkimage, params)
+    stdout = command.Output(u_boot, '-d', control_dtb, '-c', cmd)
+    debug_stdout(stdout)
+    if read_file(kernel) != read_file(kernel_out):
+        fail('Kernel not loaded', stdout)
+    if 'sha1+ crc32+ OK' not in stdout:
+        fail('Kernel hashes not checked', stdout)
+
+    # Now corrupt the compressed data: the kernel must not be booted
+    set_test('Compressed kernel with bad hash')
+    data = read_file(fit)
+    comp = read_file(params['kernel'])
+    pos = data.find(comp) + len(comp) / 2
+    with open(fit, 'wb') as fd:
+        fd.write(data[:pos] + chr(ord(data[pos]) ^ 1) + data[pos + 1:])
+    stdout = command.Output(u_boot, '-d', control_dtb, '-c', cmd)
+    debug_stdout(stdout)
+    if 'Bad Data Hash' not in stdout:
+        fail('Bad hash not detected', stdout)
+
 def run_tests():
     """Parse options, run the FIT tests and print the result"""
     global base_path, base_dir
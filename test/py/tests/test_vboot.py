@@ -22,7 +22,8 @@ For configuration verification:
 - Corrupt the signature
 - Check that image verification no-longer works
 
-Tests run with both SHA1 and SHA256 hashing.
+Tests run with both SHA1 and SHA256 hashing, using RSA, and with SHA256
+hashing using ECDSA.
 """
 
 import pytest
@@ -84,7 +85,7 @@ def test_vboot(u_boot_console):
         util.run_and_log(cons, [mkimage, '-D', dtc_args, '-f',
                                 '%s%s' % (datadir, its), fit])
 
-    def sign_fit(sha_algo):
+    def sign_fit(sha_algo, keydir):
         """Sign the FIT
 
         Signs the FIT and writes the signature into it. It also writes the
@@ -93,21 +94,32 @@ def test_vboot(u_boot_console):
         Args:
             sha_algo: Either 'sha1' or 'sha256', to select the algorithm to
                     use.
+            keydir: Directory containing the dev key and certificate
         """
         cons.log.action('%s: Sign images' % sha_algo)
-        util.run_and_log(cons, [mkimage, '-F', '-k', tmpdir, '-K', dtb,
+        util.run_and_log(cons, [mkimage, '-F', '-k', keydir, '-K', dtb,
                                 '-r', fit])
 
-    def test_with_algo(sha_algo):
+    def test_with_algo(sha_algo, key_algo='rsa'):
         """Test verified boot with the given hash algorithm.
 
         This is the main part of the test code. The same procedure is followed
-        for both hashing algorithms.
+        for all algorithms.
 
         Args:
             sha_algo: Either 'sha1' or 'sha256', to select the algorithm to
                     use.
+            key_algo: Either 'rsa' or 'ecdsa', to select the signing
+                    algorithm to use. The .its files for ECDSA have an
+                    '-ecdsa' suffix.
         """
+        if key_algo == 'rsa':
+            its_suffix = sha_algo
+            keydir = tmpdir
+        else:
+            its_suffix = '%s-%s' % (sha_algo, key_algo)
+            keydir = '%s%s/' % (tmpdir, key_algo)
+
         # Compile our device tree files for kernel and U-Boot. These are
         # regenerated here since mkimage will modify them (by adding a
         # public key) below.
@@ -116,27 +128,27 @@ def test_vboot(u_boot_console):
 
         # Build the FIT, but don't sign anything yet
         cons.log.action('%s: Test FIT with signed images' % sha_algo)
-        make_fit('sign-images-%s.its' % sha_algo)
+        make_fit('sign-images-%s.its' % its_suffix)
         run_bootm(sha_algo, 'unsigned images', 'dev-')
 
         # Sign images with our dev keys
-        sign_fit(sha_algo)
+        sign_fit(sha_algo, keydir)
         run_bootm(sha_algo, 'signed images', 'dev+')
 
         # Create a fresh .dtb without the public keys
         dtc('sandbox-u-boot.dts')
 
         cons.log.action('%s: Test FIT with signed configuration' % sha_algo)
-        make_fit('sign-configs-%s.its' % sha_algo)
+        make_fit('sign-configs-%s.its' % its_suffix)
         run_bootm(sha_algo, 'unsigned config', '%s+ OK' % sha_algo)
 
         # Sign images with our dev keys
-        sign_fit(sha_algo)
+        sign_fit(sha_algo, keydir)
         run_bootm(sha_algo, 'signed config', 'dev+')
 
         cons.log.action('%s: Check signed config on the host' % sha_algo)
 
-        util.run_and_log(cons, [fit_check_sign, '-f', fit, '-k', tmpdir,
+        util.run_and_log(cons, [fit_check_sign, '-f', fit, '-k', keydir,
                                 '-k', dtb])
 
         # Increment the first byte of the signature, which should cause failure
@@ -177,6 +189,14 @@ def test_vboot(u_boot_console):
     util.run_and_log(cons, 'openssl req -batch -new -x509 -key %sdev.key -out '
                      '%sdev.crt' % (tmpdir, tmpdir))
 
+    # Create an ECDSA key pair and certificate, with the same name
+    ecdsa_dir = tmpdir + 'ecdsa/'
+    util.run_and_log(cons, 'mkdir -p %s' % ecdsa_dir)
+    util.run_and_log(cons, 'openssl ecparam -name prime256v1 -genkey -noout '
+                     '-out %sdev.key' % ecdsa_dir)
+    util.run_and_log(cons, 'openssl req -batch -new -x509 -key %sdev.key -out '
+                     '%sdev.crt' % (ecdsa_dir, ecdsa_dir))
+
     # Create a number kernel image with zeroes
     with open('%stest-kernel.bin' % tmpdir, 'w') as fd:
         fd.write(5000 * chr(0))
@@ -188,6 +208,7 @@ def test_vboot(u_boot_console):
         cons.config.dtb = dtb
         test_with_algo('sha1')
         test_with_algo('sha256')
+        test_with_algo('sha256', 'ecdsa')
     finally:
         # Go back to the original U-Boot with the correct dtb.
         cons.config.dtb = old_dtb
@@ -0,0 +1,172 @@
+/*
+ * Known-answer tests for SHA-384 and SHA-512
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <test/suites.h>
+#include <u-boot/sha512.h>
+
+/* Length of the message of 'a' characters in the last vector */
+#define TEST_MILLION	1000000
+
+/* Size of each update for the long message, to cross block boundaries */
+#define TEST_STEP	997
+
+/**
+ * struct test_sha512 - A FIPS 180-2 test vector
+ *
+ * @msg:	Message, or NULL for TEST_MILLION 'a' characters
+ * @sha384:	Expected SHA-384 digest, in hex
+ * @sha512:	Expected SHA-512 digest, in hex
+ */
+struct test_sha512 {
+	const char *msg;
+	const char *sha384;
+	const char *sha512;
+};
+
+static const struct test_sha512 test_vectors[] = {
+	{
+		"",
+		"38b060a751ac96384cd9327eb1b1e36a21fdb71114be0743"
+		"4c0cc7bf63f6e1da274edebfe76f65fbd51ad2f14898b95b",
+		"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+		"47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+	},
+	{
+		"abc",
+		"cb00753f45a35e8bb5a03d699ac65007272c32ab0eded163"
+		"1a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+		"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+		"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+	},
+	{
+		"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+		"hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+		"09330c33f71147e83d192fc782cd1b4753111b173b3b05d2"
+		"2fa08086e3b0f712fcc7c71a557e2db966c3e9fa91746039",
+		"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+		"501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+	},
+	{
+		NULL,
+		"9d0e1809716474cb086e834e310a4a1ced149e9c00f24852"
+		"7972cec5704c2a5b07b8b3dc38ecc4ebae97ddd87f3d8985",
+		"e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+		"de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b",
+	},
+};
+
+static int test_sha512_check(const char *algo, int index, const uint8_t *sum,
+			     int len, const char *expect)
+{
+	char hex[SHA512_SUM_LEN * 2 + 1];
+	int i;
+
+	for (i = 0; i < len; i++)
+		sprintf(hex + i * 2, "%02x", sum[i]);
+	if (strcmp(hex, expect)) {
+		printf("%s: %s vector %d is %s, expected %s\n", __func__, algo,
+		       index, hex, expect);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Hash a million 'a' characters in pieces which do not fit the blocks */
+static void test_sha512_million(sha512_context *ctx,
+				void (*update)(sha512_context *ctx,
+					       const uint8_t *input,
+					       uint32_t length))
+{
+	uint8_t buf[TEST_STEP];
+	int left;
+
+	memset(buf, 'a', sizeof(buf));
+	for (left = TEST_MILLION; left > 0; left -= TEST_STEP)
+		update(ctx, buf, min(left, TEST_STEP));
+}
+
+static int test_sha512_vectors(void)
+{
+	const struct test_sha512 *vec;
+	uint8_t sum[SHA512_SUM_LEN];
+	sha512_context ctx;
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(test_vectors); i++) {
+		vec = &test_vectors[i];
+		sha512_starts(&ctx);
+		if (vec->msg)
+			sha512_update(&ctx, (const uint8_t *)vec->msg,
+				      strlen(vec->msg));
+		else
+			test_sha512_million(&ctx, sha512_update);
+		sha512_finish(&ctx, sum);
+		ret |= test_sha512_check("sha512", i, sum, SHA512_SUM_LEN,
+					 vec->sha512);
+		if (!vec->msg)
+			continue;
+
+		/* The one-shot form, which hashes in chunks with a watchdog */
+		sha512_csum_wd((const unsigned char *)vec->msg,
+			       strlen(vec->msg), sum, 1);
+		ret |= test_sha512_check("sha512_csum_wd", i, sum,
+					 SHA512_SUM_LEN, vec->sha512);
+	}
+
+	return ret;
+}
+
+#ifdef CONFIG_SHA384
+static int test_sha384_vectors(void)
+{
+	const struct test_sha512 *vec;
+	uint8_t sum[SHA384_SUM_LEN];
+	sha384_context ctx;
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(test_vectors); i++) {
+		vec = &test_vectors[i];
+		sha384_starts(&ctx);
+		if (vec->msg)
+			sha384_update(&ctx, (const uint8_t *)vec->msg,
+				      strlen(vec->msg));
+		else
+			test_sha512_million(&ctx, sha384_update);
+		sha384_finish(&ctx, sum);
+		ret |= test_sha512_check("sha384", i, sum, SHA384_SUM_LEN,
+					 vec->sha384);
+		if (!vec->msg)
+			continue;
+
+		sha384_csum_wd((const unsigned char *)vec->msg,
+			       strlen(vec->msg), sum, 1);
+		ret |= test_sha512_check("sha384_csum_wd", i, sum,
+					 SHA384_SUM_LEN, vec->sha384);
+	}
+
+	return ret;
+}
+#endif
+
+int do_ut_sha512(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret = 0;
+
+	ret |= test_sha512_vectors();
+#ifdef CONFIG_SHA384
+	ret |= test_sha384_vectors();
+#endif
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
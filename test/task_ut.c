@@ -0,0 +1,169 @@
+/*
+ * Tests for cooperative tasks
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <task.h>
+#include <test/suites.h>
+
+#define TEST_TASKS	3
+#define TEST_STEPS	4
+#define TEST_WAIT_US	100000
+
+struct test_task {
+	struct task task;
+	int id;
+	char *log;
+	int *pos;
+	struct test_task *child;
+	ulong until;
+};
+
+static void test_task_steps(void *arg)
+{
+	struct test_task *tt = arg;
+	int i;
+
+	for (i = 0; i < TEST_STEPS; i++) {
+		tt->log[(*tt->pos)++] = '0' + tt->id;
+		task_yield();
+	}
+}
+
+/* Check that tasks take turns to run and are tidied up when finished */
+static int test_task_turns(void)
+{
+	struct test_task tasks[TEST_TASKS];
+	char log[TEST_TASKS * TEST_STEPS + 1];
+	const char *expect = "012012012012";
+	int i, pos = 0;
+	int ret = 0;
+
+	for (i = 0; i < TEST_TASKS; i++) {
+		tasks[i].id = i;
+		tasks[i].log = log;
+		tasks[i].pos = &pos;
+		tasks[i].task.func = test_task_steps;
+		tasks[i].task.arg = &tasks[i];
+		task_start(&tasks[i].task);
+	}
+	for (i = 0; i < TEST_TASKS; i++)
+		task_wait(&tasks[i].task);
+	log[pos] = '\0';
+
+	if (strcmp(log, expect)) {
+		printf("%s: tasks ran in order '%s', expected '%s'\n",
+		       __func__, log, expect);
+		ret = -EINVAL;
+	}
+	for (i = 0; i < TEST_TASKS; i++) {
+		if (tasks[i].task.stack) {
+			printf("%s: task %d was not freed\n", __func__, i);
+			ret = -EINVAL;
+		}
+	}
+
+	return ret;
+}
+
+static void test_task_parent(void *arg)
+{
+	struct test_task *tt = arg;
+
+	task_start(&tt->child->task);
+	tt->log[(*tt->pos)++] = 'p';
+	task_wait(&tt->child->task);
+	tt->log[(*tt->pos)++] = 'P';
+}
+
+/* Check that a task can start another task and wait for it */
+static int test_task_nested(void)
+{
+	struct test_task parent, child;
+	char log[TEST_STEPS + 3];
+	const char *expect = "p0000P";
+	int pos = 0;
+
+	child.id = 0;
+	child.log = log;
+	child.pos = &pos;
+	child.task.func = test_task_steps;
+	child.task.arg = &child;
+	parent.log = log;
+	parent.pos = &pos;
+	parent.child = &child;
+	parent.task.func = test_task_parent;
+	parent.task.arg = &parent;
+	task_start(&parent.task);
+	task_wait(&parent.task);
+	log[pos] = '\0';
+
+	if (strcmp(log, expect)) {
+		printf("%s: tasks ran in order '%s', expected '%s'\n",
+		       __func__, log, expect);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Poll for something which is ready at a given time, as a driver would */
+static void test_task_poll(void *arg)
+{
+	struct test_task *tt = arg;
+
+	while (timer_get_us() < tt->until)
+		udelay(100);
+}
+
+/* Compare waiting for hardware one device at a time and in tasks */
+static int test_task_overlap(void)
+{
+	struct test_task tasks[TEST_TASKS];
+	ulong serial, parallel;
+	int i;
+
+	serial = timer_get_us();
+	for (i = 0; i < TEST_TASKS; i++) {
+		tasks[i].until = timer_get_us() + TEST_WAIT_US;
+		test_task_poll(&tasks[i]);
+	}
+	serial = timer_get_us() - serial;
+
+	parallel = timer_get_us();
+	for (i = 0; i < TEST_TASKS; i++) {
+		tasks[i].until = timer_get_us() + TEST_WAIT_US;
+		tasks[i].task.func = test_task_poll;
+		tasks[i].task.arg = &tasks[i];
+		task_start(&tasks[i].task);
+	}
+	for (i = 0; i < TEST_TASKS; i++)
+		task_wait(&tasks[i].task);
+	parallel = timer_get_us() - parallel;
+
+	printf("%s: %d waits of %d ms one by one: %lu us, in tasks: %lu us\n",
+	       __func__, TEST_TASKS, TEST_WAIT_US / 1000, serial, parallel);
+	if (parallel > serial / 2) {
+		printf("%s: the waits did not overlap\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int do_ut_task(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret = 0;
+
+	ret |= test_task_turns();
+	ret |= test_task_nested();
+	ret |= test_task_overlap();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
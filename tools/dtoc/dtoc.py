@@ -30,6 +30,7 @@ except ImportError:
     import fdt_fallback as fdt
 
 import struct
+import zlib
 
 # When we see these properties we ignore them - i.e. do not create a structure member
 PROP_IGNORE_LIST = [
@@ -51,6 +52,14 @@ TYPE_NAMES = {
     fdt_util.TYPE_BOOL: 'bool',
 };
 
+# Flattened device tree magic number and structure block tags
+FDT_MAGIC = 0xd00dfeed
+FDT_BEGIN_NODE = 1
+FDT_END_NODE = 2
+FDT_PROP = 3
+FDT_NOP = 4
+FDT_END = 9
+
 STRUCT_PREFIX = 'dtd_'
 VAL_PREFIX = 'dtv_'
 
@@ -73,6 +82,54 @@ def TabTo(num_tabs, str):
         return str + ' '
     return str + '\t' * (num_tabs - len(str) / 8)
 
+def CString(data):
+    """Convert bytes to a C string literal
+
+    Args:
+        data: Bytes to convert, which may include nul characters
+    Return:
+        String containing the C literal, with octal escapes where needed
+    """
+    out = ''
+    for ch in bytearray(data):
+        if ch in (ord('"'), ord('\\')) or ch < 0x20 or ch > 0x7e:
+            out += '\\%03o' % ch
+        else:
+            out += chr(ch)
+    return '"%s"' % out
+
+class RawNode:
+    """A node read directly from the device tree binary
+
+    Properties:
+        name: Node name, including any unit address
+        offset: Offset of the node in the structure block, as used by libfdt
+        props: List of (name, value) tuples, in the order they appear
+        subnodes: List of RawNode objects
+        aliases: Name of the C array of aliases for this node, or None
+    """
+    def __init__(self, name, offset):
+        self.name = name
+        self.offset = offset
+        self.props = []
+        self.subnodes = []
+        self.aliases = None
+
+    def GetProp(self, name):
+        """Get the value of a property, or None if the node does not have it"""
+        for pname, value in self.props:
+            if pname == name:
+                return value
+        return None
+
+    def IsBindable(self):
+        """Check if dm_scan_fdt_node() would try to bind this node"""
+        status = self.GetProp('status')
+        if status is not None and status.split(b'\0')[0] not in (b'okay',
+                                                                 b'ok'):
+            return False
+        return self.GetProp('compatible') is not None
+
 class DtbPlatdata:
     """Provide a means to convert device tree binary data to platform data
 
@@ -363,6 +420,167 @@ class DtbPlatdata:
         for node_txt in node_txt_list:
             self.Out(''.join(node_txt))
 
+    def ScanRawTree(self):
+        """Read the nodes and properties from the device tree binary
+
+        This reads the structure block directly, since the binding table
+        needs the offset of each node as libfdt sees it, and the properties
+        in the order in which they appear. Neither libfdt nor fdtget is
+        needed.
+
+        Returns:
+            RawNode object for the root node
+        """
+        with open(self._dtb_fname, 'rb') as fd:
+            self._dtb = fd.read()
+        (magic, totalsize, off_struct, off_strings) = struct.unpack_from(
+                '>LLLL', self._dtb)
+        if magic != FDT_MAGIC or totalsize > len(self._dtb):
+            raise ValueError("'%s' is not a valid device tree" %
+                             self._dtb_fname)
+        self._dtb = self._dtb[:totalsize]
+
+        def GetString(data, pos):
+            return data[pos:data.index(b'\0', pos)].decode('latin-1')
+
+        root = None
+        stack = []
+        pos = off_struct
+        while True:
+            (tag,) = struct.unpack_from('>L', self._dtb, pos)
+            if tag == FDT_BEGIN_NODE:
+                name = GetString(self._dtb, pos + 4)
+                node = RawNode(name, pos - off_struct)
+                if stack:
+                    stack[-1].subnodes.append(node)
+                else:
+                    root = node
+                stack.append(node)
+                pos += 4 + len(name) + 1
+            elif tag == FDT_END_NODE:
+                stack.pop()
+                pos += 4
+            elif tag == FDT_PROP:
+                (size, nameoff) = struct.unpack_from('>LL', self._dtb,
+                                                     pos + 4)
+                name = GetString(self._dtb, off_strings + nameoff)
+                stack[-1].props.append((name,
+                                        self._dtb[pos + 12:pos + 12 + size]))
+                pos += 12 + size
+            elif tag == FDT_NOP:
+                pos += 4
+            elif tag == FDT_END:
+                break
+            else:
+                raise ValueError("Bad tag %#x at offset %#x" % (tag, pos))
+            pos = (pos + 3) & ~3
+        return root
+
+    def GetAliases(self, root, node):
+        """Get the aliases which may give the sequence number of a node
+
+        This follows fdtdec_get_alias_seq(), which looks at each alias in
+        turn and considers those whose path ends in the node name.
+
+        Args:
+            root: RawNode object for the root node
+            node: RawNode object to check
+        Returns:
+            List of alias names, in the order they appear
+        """
+        aliases = [sub for sub in root.subnodes if sub.name == 'aliases']
+        if not aliases:
+            return []
+        names = []
+        for name, value in aliases[0].props:
+            if (len(value) < len(node.name) or value[:1] != b'/' or
+                    value[-1:] != b'\0'):
+                continue
+            path = value.split(b'\0')[0].decode('latin-1')
+            if path[path.rfind('/') + 1:] == node.name:
+                names.append(name)
+        return names
+
+    def GenerateBind(self):
+        """Generate a table of the nodes to bind
+
+        This writes out the nodes that dm_scan_fdt_node() would bind below
+        each node of the device tree, for use with CONFIG_OF_PREBIND. See
+        include/dm/prebind.h for the format.
+        """
+        root = self.ScanRawTree()
+        nodes = []
+        parents = []
+        todo = [root]
+        while todo:
+            parent = todo.pop()
+            todo += parent.subnodes
+            children = [sub for sub in parent.subnodes if sub.IsBindable()]
+            if children:
+                parents.append((parent, children))
+                nodes += children
+        nodes.sort(key=lambda node: node.offset)
+        parents.sort(key=lambda item: item[0].offset)
+        index = dict((node.offset, i) for i, node in enumerate(nodes))
+        if len(nodes) > 0xffff:
+            raise ValueError('Too many nodes to bind (%d)' % len(nodes))
+
+        self.Out('#include <common.h>\n')
+        self.Out('#include <dm.h>\n')
+        self.Out('#include <dm/prebind.h>\n')
+        self.Out('\n')
+        for i, node in enumerate(nodes):
+            aliases = self.GetAliases(root, node)
+            if aliases:
+                node.aliases = 'dtb_aliases_%d' % i
+                self.Out('static const char *const %s[] = {' % node.aliases)
+                self.Out(''.join([' %s,' % CString(name.encode('latin-1'))
+                                  for name in aliases]))
+                self.Out(' NULL };\n')
+        if nodes:
+            self.Out('\nstatic const struct dm_prebind_node dtb_node[] = {\n')
+            for node in nodes:
+                compat = node.GetProp('compatible')
+                self.Out('\t{\n')
+                self.Out('\t\t.name\t\t= %s,\n' %
+                         CString(node.name.encode('latin-1')))
+                self.Out('\t\t.compat\t\t= %s,\n' % CString(compat))
+                self.Out('\t\t.compat_len\t= %d,\n' % len(compat))
+                self.Out('\t\t.offset\t\t= %#x,\n' % node.offset)
+                if node.GetProp('u-boot,dm-pre-reloc') is not None:
+                    self.Out('\t\t.flags\t\t= DM_PREBIND_PRE_RELOC,\n')
+                if node.aliases:
+                    self.Out('\t\t.aliases\t= %s,\n' % node.aliases)
+                self.Out('\t},\n')
+            self.Out('};\n\n')
+
+            self.Out('static const struct dm_prebind_parent dtb_parent[] = {\n')
+            first = 0
+            for parent, children in parents:
+                self.Out('\t{ %#x, %d, %d },\n' %
+                         (parent.offset, first, len(children)))
+                first += len(children)
+            self.Out('};\n\n')
+
+            self.Out('static const u16 dtb_child[] = {\n')
+            for parent, children in parents:
+                indexes = ['%d,' % index[node.offset] for node in children]
+                for i in range(0, len(indexes), 8):
+                    self.Out('\t%s\n' % ' '.join(indexes[i:i + 8]))
+            self.Out('};\n\n')
+
+        self.Out('const struct dm_prebind dm_prebind = {\n')
+        self.Out('\t.fdt_size\t= %#x,\n' % len(self._dtb))
+        self.Out('\t.fdt_crc\t= %#x,\n' % (zlib.crc32(self._dtb) &
+                                              0xffffffff))
+        if nodes:
+            self.Out('\t.node\t\t= dtb_node,\n')
+            self.Out('\t.num_nodes\t= ARRAY_SIZE(dtb_node),\n')
+            self.Out('\t.parent\t\t= dtb_parent,\n')
+            self.Out('\t.num_parents\t= ARRAY_SIZE(dtb_parent),\n')
+            self.Out('\t.child\t\t= dtb_child,\n')
+        self.Out('};\n')
+
 
 if __name__ != "__main__":
     pass
@@ -377,18 +595,23 @@ parser.add_option('-o', '--output', action='store', default='-',
 (options, args) = parser.parse_args()
 
 if not args:
-    raise ValueError('Please specify a command: struct, platdata')
+    raise ValueError('Please specify a command: struct, platdata, bind')
 
 plat = DtbPlatdata(options.dtb_file, options)
-plat.ScanDtb()
-plat.ScanTree()
+cmds = args[0].split(',')
+if 'struct' in cmds or 'platdata' in cmds:
+    plat.ScanDtb()
+    plat.ScanTree()
+    structs = plat.ScanStructs()
 plat.SetupOutput(options.output)
-structs = plat.ScanStructs()
 
-for cmd in args[0].split(','):
+for cmd in cmds:
     if cmd == 'struct':
         plat.GenerateStructs(structs)
     elif cmd == 'platdata':
         plat.GenerateTables()
+    elif cmd == 'bind':
+        plat.GenerateBind()
     else:
-        raise ValueError("Unknown command '%s': (use: struct, platdata)" % cmd)
+        raise ValueError("Unknown command '%s': (use: struct, platdata, bind)"
+                         % cmd)